@@ -0,0 +1,247 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rosflight_gcs
+{
+/**
+ * @brief Compact encoding of rosflight_io telemetry for slow links, shared by the two ends of the
+ * telemetry relay.
+ *
+ * Each frame starts with a 7 byte header (version, mask of the sections present, sequence number,
+ * and the low 24 bits of the send time in ms). The sections follow in priority order. Values are
+ * quantized to integers and written as zigzag varints. Each section is either a keyframe, holding
+ * the quantized values themselves, or a delta against the section's last keyframe. Deltas refer to
+ * the keyframe rather than to the previous frame, so a lost frame only loses its own data. A lost
+ * keyframe makes the following deltas undecodable until the next keyframe.
+ *
+ * Sections that don't fit in the byte budget are left out and sent in a later frame. A section
+ * that was left out goes ahead of the others in the next frame, so a tight budget delays the low
+ * priority sections rather than starving them. The sections are still written in Section order.
+ */
+namespace telemetry
+{
+constexpr uint8_t FRAME_VERSION = 1;
+constexpr size_t FRAME_HEADER_SIZE = 7;
+constexpr size_t MAX_ERROR_MESSAGE = 48; //!< longer error messages are truncated
+
+enum Section
+{
+  STATUS,
+  ERROR,
+  ATTITUDE,
+  BATTERY,
+  GNSS,
+  NUM_SECTIONS
+};
+
+struct Status
+{
+  bool armed = false;
+  bool failsafe = false;
+  bool rc_override = false;
+  bool offboard = false;
+  uint8_t control_mode = 0;
+  uint8_t error_code = 0;
+  int16_t num_errors = 0;
+  int16_t loop_time_us = 0;
+};
+
+struct Error
+{
+  std::string message;
+  uint32_t code = 0;
+  uint32_t reset_count = 0;
+  bool rearm = false;
+  uint32_t pc = 0;
+};
+
+struct Attitude
+{
+  double w = 1, x = 0, y = 0, z = 0; //!< quantized to 1e-4
+  std::array<double, 3> angular_velocity{}; //!< rad/s, quantized to 1e-3
+};
+
+struct Battery
+{
+  double voltage = 0; //!< V, quantized to mV
+  double current = 0; //!< A, quantized to mA
+};
+
+struct Gnss
+{
+  uint8_t fix = 0;
+  int64_t time_sec = 0;
+  uint32_t time_nanos = 0;            //!< quantized to ms
+  std::array<double, 3> position{};   //!< m, ECEF, quantized to cm
+  std::array<double, 3> velocity{};   //!< m/s, ECEF, quantized to cm/s
+  double horizontal_accuracy = 0;     //!< m, quantized to cm
+  double vertical_accuracy = 0;       //!< m, quantized to cm
+  double speed_accuracy = 0;          //!< m/s, quantized to cm/s
+};
+
+/**
+ * @brief Decoded contents of a frame. Only the sections in mask are valid.
+ */
+struct Frame
+{
+  uint16_t sequence = 0;
+  uint32_t stamp_ms = 0; //!< low 24 bits of the sender's time in ms
+  uint8_t mask = 0;      //!< bit i set if Section i is present
+  Status status;
+  Error error;
+  Attitude attitude;
+  Battery battery;
+  Gnss gnss;
+
+  bool has(Section section) const { return mask & (1 << section); }
+};
+
+constexpr size_t MAX_FIELDS = 14;
+
+/**
+ * @brief Quantized values of a section, and the keyframe they are encoded against
+ */
+struct SectionState
+{
+  std::array<int64_t, MAX_FIELDS> value{};
+  std::array<int64_t, MAX_FIELDS> key{};
+  bool has_key = false;
+  uint8_t key_id = 0;     //!< 7 bit id of the current keyframe
+  unsigned since_key = 0; //!< frames sent since the last keyframe
+  bool updated = false;   //!< new value not yet sent
+  unsigned deferred = 0;  //!< frames the pending value was left out of
+};
+
+} // namespace telemetry
+
+/**
+ * @brief Aircraft side: holds the latest value of each section and packs them into frames.
+ */
+class TelemetryEncoder
+{
+public:
+  /**
+   * @param keyframe_interval A section is sent as a keyframe at least once every this many times
+   * it is sent
+   */
+  explicit TelemetryEncoder(unsigned keyframe_interval);
+
+  void set_status(const telemetry::Status & status);
+  /**
+   * @brief Queues an error. It is repeated in the next few frames, since frames can be lost.
+   */
+  void set_error(const telemetry::Error & error);
+  void set_attitude(const telemetry::Attitude & attitude);
+  void set_battery(const telemetry::Battery & battery);
+  void set_gnss(const telemetry::Gnss & gnss);
+
+  /**
+   * @brief Packs the sections updated since they were last sent into a frame.
+   *
+   * @param stamp_ms Current time in ms
+   * @param buffer Output buffer
+   * @param budget Maximum size of the frame, at most the size of the buffer
+   * @return Size of the frame, or 0 if nothing was updated or nothing fit
+   */
+  size_t encode(uint64_t stamp_ms, uint8_t * buffer, size_t budget);
+
+private:
+  static constexpr unsigned ERROR_REPEATS = 3;
+
+  //! Longest encoded section, with the error message at its longest
+  static constexpr size_t MAX_SECTION_SIZE =
+    4 + telemetry::MAX_FIELDS * 10 + telemetry::MAX_ERROR_MESSAGE;
+
+  /**
+   * @brief Encodes a pending section into out, without marking it as sent
+   * @return Encoded size, or 0 if the section has nothing to send
+   */
+  size_t encode_section(telemetry::Section section, uint8_t * out);
+  //! Marks a section encoded by encode_section() as sent
+  void commit_section(telemetry::Section section, const uint8_t * encoded);
+
+  unsigned keyframe_interval_;
+  uint16_t sequence_ = 0;
+  std::array<telemetry::SectionState, telemetry::NUM_SECTIONS> sections_;
+  telemetry::Error error_;
+  uint8_t error_id_; //!< starts at random, see the constructor
+  unsigned error_repeats_ = 0;
+};
+
+/**
+ * @brief Ground side: rebuilds the sections from frames.
+ */
+class TelemetryDecoder
+{
+public:
+  /**
+   * @brief Decodes a frame.
+   *
+   * @param data Frame
+   * @param size Size of the frame
+   * @param frame Decoded sections. Sections whose keyframe was lost are left out of the mask.
+   * @return False if the frame is malformed
+   *
+   * Frames older than the newest one received are dropped. After STALE_FRAMES_BEFORE_RESYNC of
+   * them in a row, the encoder is taken to have restarted with a new sequence, and the decoder
+   * starts over from the next frame.
+   */
+  bool decode(const uint8_t * data, size_t size, telemetry::Frame & frame);
+
+  uint64_t frames_received() const { return frames_received_; }
+  uint64_t frames_lost() const { return frames_lost_; }
+  uint64_t sections_undecodable() const { return sections_undecodable_; }
+
+  static constexpr unsigned STALE_FRAMES_BEFORE_RESYNC = 3;
+
+private:
+  std::array<telemetry::SectionState, telemetry::NUM_SECTIONS> sections_;
+  bool have_sequence_ = false;
+  uint16_t last_sequence_ = 0;
+  unsigned stale_frames_ = 0; //!< consecutive frames older than the newest one
+  bool have_error_id_ = false;
+  uint8_t last_error_id_ = 0;
+
+  uint64_t frames_received_ = 0;
+  uint64_t frames_lost_ = 0;
+  uint64_t sections_undecodable_ = 0;
+};
+
+} // namespace rosflight_gcs
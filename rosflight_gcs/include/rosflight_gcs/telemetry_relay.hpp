@@ -0,0 +1,118 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+
+#include <rclcpp/rclcpp.hpp>
+#include <rosflight_msgs/msg/attitude.hpp>
+#include <rosflight_msgs/msg/battery_status.hpp>
+#include <rosflight_msgs/msg/error.hpp>
+#include <rosflight_msgs/msg/gnss.hpp>
+#include <rosflight_msgs/msg/status.hpp>
+
+#include <rosflight_gcs/telemetry_codec.hpp>
+
+namespace rosflight_gcs
+{
+/**
+ * @brief Aircraft side of the telemetry relay. Subscribes to the rosflight_io telemetry and sends
+ * it to the ground side as one compact UDP datagram per frame.
+ */
+class TelemetryRelayAir : public rclcpp::Node
+{
+public:
+  TelemetryRelayAir();
+  ~TelemetryRelayAir() override;
+
+private:
+  rclcpp::Subscription<rosflight_msgs::msg::Status>::SharedPtr status_sub_;
+  rclcpp::Subscription<rosflight_msgs::msg::Error>::SharedPtr error_sub_;
+  rclcpp::Subscription<rosflight_msgs::msg::Attitude>::SharedPtr attitude_sub_;
+  rclcpp::Subscription<rosflight_msgs::msg::BatteryStatus>::SharedPtr battery_sub_;
+  rclcpp::Subscription<rosflight_msgs::msg::GNSS>::SharedPtr gnss_sub_;
+  rclcpp::TimerBase::SharedPtr frame_timer_;
+
+  TelemetryEncoder encoder_;
+  size_t max_frame_bytes_;
+  int socket_ = -1;
+  sockaddr_storage remote_{};
+  socklen_t remote_len_ = 0;
+  uint64_t bytes_sent_ = 0;
+
+  void statusCallback(const rosflight_msgs::msg::Status & msg);
+  void errorCallback(const rosflight_msgs::msg::Error & msg);
+  void attitudeCallback(const rosflight_msgs::msg::Attitude & msg);
+  void batteryCallback(const rosflight_msgs::msg::BatteryStatus & msg);
+  void gnssCallback(const rosflight_msgs::msg::GNSS & msg);
+  void frameTimerCallback();
+};
+
+/**
+ * @brief Ground side of the telemetry relay. Receives frames from the aircraft side and publishes
+ * them as the same messages rosflight_io publishes.
+ */
+class TelemetryRelayGround : public rclcpp::Node
+{
+public:
+  TelemetryRelayGround();
+  ~TelemetryRelayGround() override;
+
+private:
+  rclcpp::Publisher<rosflight_msgs::msg::Status>::SharedPtr status_pub_;
+  rclcpp::Publisher<rosflight_msgs::msg::Error>::SharedPtr error_pub_;
+  rclcpp::Publisher<rosflight_msgs::msg::Attitude>::SharedPtr attitude_pub_;
+  rclcpp::Publisher<rosflight_msgs::msg::BatteryStatus>::SharedPtr battery_pub_;
+  rclcpp::Publisher<rosflight_msgs::msg::GNSS>::SharedPtr gnss_pub_;
+
+  TelemetryDecoder decoder_;
+  int socket_ = -1;
+  std::thread receive_thread_;
+  std::atomic<bool> running_{true};
+
+  void receive_loop();
+  void publish(const telemetry::Frame & frame);
+  /**
+   * @brief Rebuilds the sender's time from the 24 bits of ms in a frame, assuming the clocks of
+   * the two sides agree to within a couple of hours.
+   */
+  rclcpp::Time frame_time(uint32_t stamp_ms);
+};
+
+} // namespace rosflight_gcs
@@ -35,19 +35,56 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
-#include <geometry_msgs/msg/point.hpp>
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <rosflight_msgs/msg/attitude.hpp>
 #include <sensor_msgs/msg/magnetic_field.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
 #include <tf2/LinearMath/Quaternion.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
-#include <visualization_msgs/msg/marker.hpp>
 
 namespace rosflight_gcs
 {
+/**
+ * @brief Fixed-capacity set of magnetometer samples, deduplicated on a voxel grid. Only the first
+ * sample to land in each voxel is kept, and once the capacity is reached the oldest point is
+ * replaced, so memory and the size of the published cloud stay bounded during long calibrations.
+ */
+class MagPointCloud
+{
+public:
+  struct Point
+  {
+    float x, y, z;
+  };
+
+  MagPointCloud(double voxel_size, size_t capacity);
+
+  /**
+   * @brief Adds a sample if its voxel is not already occupied.
+   *
+   * @return True if the sample was added
+   */
+  bool add(double x, double y, double z);
+
+  const std::vector<Point> & points() const { return points_; }
+
+private:
+  int64_t voxel_key(double x, double y, double z) const;
+
+  double inv_voxel_size_;
+  size_t capacity_;
+  std::vector<Point> points_; // ring buffer once full
+  std::vector<int64_t> keys_; // voxel of each point, to free it on eviction
+  size_t next_ = 0;           // slot the next point is written to
+  std::unordered_set<int64_t> voxels_;
+};
+
 class Viz : public rclcpp::Node
 {
 public:
@@ -57,20 +94,27 @@ private:
   // Magnetometer visualization pubs and subs
   rclcpp::Subscription<sensor_msgs::msg::MagneticField>::SharedPtr mag_sub_;
   rclcpp::Publisher<geometry_msgs::msg::PoseStamped>::SharedPtr mag_pub_;
-  rclcpp::Publisher<visualization_msgs::msg::Marker>::SharedPtr pts_pub_;
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr pts_pub_;
 
   // Attitude visualization pubs and subs
   rclcpp::Subscription<rosflight_msgs::msg::Attitude>::SharedPtr att_sub_;
   rclcpp::Publisher<geometry_msgs::msg::PoseStamped>::SharedPtr pose_pub_;
 
+  // Everything is published from this timer, at the display rate
+  rclcpp::TimerBase::SharedPtr display_timer_;
+
   // Variables
-  std::vector<geometry_msgs::msg::Point> pts_list_;
-  int mag_throttle_, mag_skip_;
+  MagPointCloud mag_cloud_;
+  bool cloud_changed_ = false;
+  geometry_msgs::msg::PoseStamped mag_pose_, att_pose_;
+  bool mag_pose_pending_ = false, att_pose_pending_ = false;
   std::string fixed_frame_ = "fixed_frame";
 
   // Functions
   void magCallback(const sensor_msgs::msg::MagneticField::ConstSharedPtr & msg);
   void attCallback(const rosflight_msgs::msg::Attitude::ConstSharedPtr & msg);
+  void displayTimerCallback();
+  void publishCloud(const std::vector<MagPointCloud::Point> & points);
 };
 
 } // namespace rosflight_gcs
@@ -0,0 +1,390 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <rosflight_gcs/telemetry_codec.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace rosflight_gcs
+{
+using namespace telemetry;
+
+namespace
+{
+constexpr size_t FIELD_COUNT[NUM_SECTIONS] = {5, 0, 7, 2, 11};
+
+int64_t quantize(double value, double scale) { return std::llround(value * scale); }
+
+uint8_t * write_varint(uint8_t * out, int64_t value)
+{
+  // Zigzag, so small negative deltas stay small
+  uint64_t v = ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+  while (v >= 0x80) {
+    *out++ = (uint8_t) (v | 0x80);
+    v >>= 7;
+  }
+  *out++ = (uint8_t) v;
+  return out;
+}
+
+bool read_varint(const uint8_t * & in, const uint8_t * end, int64_t & value)
+{
+  uint64_t v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (in == end) {
+      return false;
+    }
+    uint8_t byte = *in++;
+    v |= (uint64_t) (byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      value = (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace
+
+TelemetryEncoder::TelemetryEncoder(unsigned keyframe_interval)
+    : keyframe_interval_(std::max(1u, keyframe_interval))
+    // A restarted relay must not reuse the id of the last error it sent, or the ground side takes
+    // its first error for a repeat
+    , error_id_((uint8_t) std::random_device{}())
+{}
+
+void TelemetryEncoder::set_status(const Status & status)
+{
+  SectionState & s = sections_[STATUS];
+  s.value[0] = status.armed | status.failsafe << 1 | status.rc_override << 2 | status.offboard << 3;
+  s.value[1] = status.control_mode;
+  s.value[2] = status.error_code;
+  s.value[3] = status.num_errors;
+  s.value[4] = status.loop_time_us;
+  s.updated = true;
+}
+
+void TelemetryEncoder::set_error(const Error & error)
+{
+  error_ = error;
+  if (error_.message.size() > MAX_ERROR_MESSAGE) {
+    error_.message.resize(MAX_ERROR_MESSAGE);
+  }
+  error_id_++;
+  error_repeats_ = ERROR_REPEATS;
+}
+
+void TelemetryEncoder::set_attitude(const Attitude & attitude)
+{
+  SectionState & s = sections_[ATTITUDE];
+  s.value[0] = quantize(attitude.w, 1e4);
+  s.value[1] = quantize(attitude.x, 1e4);
+  s.value[2] = quantize(attitude.y, 1e4);
+  s.value[3] = quantize(attitude.z, 1e4);
+  for (size_t i = 0; i < 3; i++) {
+    s.value[4 + i] = quantize(attitude.angular_velocity[i], 1e3);
+  }
+  s.updated = true;
+}
+
+void TelemetryEncoder::set_battery(const Battery & battery)
+{
+  SectionState & s = sections_[BATTERY];
+  s.value[0] = quantize(battery.voltage, 1e3);
+  s.value[1] = quantize(battery.current, 1e3);
+  s.updated = true;
+}
+
+void TelemetryEncoder::set_gnss(const Gnss & gnss)
+{
+  SectionState & s = sections_[GNSS];
+  s.value[0] = gnss.fix;
+  s.value[1] = gnss.time_sec * 1000 + gnss.time_nanos / 1000000;
+  for (size_t i = 0; i < 3; i++) {
+    s.value[2 + i] = quantize(gnss.position[i], 1e2);
+    s.value[5 + i] = quantize(gnss.velocity[i], 1e2);
+  }
+  s.value[8] = quantize(gnss.horizontal_accuracy, 1e2);
+  s.value[9] = quantize(gnss.vertical_accuracy, 1e2);
+  s.value[10] = quantize(gnss.speed_accuracy, 1e2);
+  s.updated = true;
+}
+
+size_t TelemetryEncoder::encode(uint64_t stamp_ms, uint8_t * buffer, size_t budget)
+{
+  if (budget <= FRAME_HEADER_SIZE) {
+    return 0;
+  }
+
+  uint8_t encoded[NUM_SECTIONS][MAX_SECTION_SIZE];
+  size_t size[NUM_SECTIONS];
+  std::array<Section, NUM_SECTIONS> order;
+  size_t pending = 0;
+  for (int section = 0; section < NUM_SECTIONS; section++) {
+    size[section] = encode_section((Section) section, encoded[section]);
+    if (size[section] > 0) {
+      order[pending++] = (Section) section;
+    }
+  }
+
+  // Sections left out of the most frames go first, then the rest in priority order
+  std::stable_sort(order.begin(), order.begin() + pending, [this](Section a, Section b) {
+    return sections_[a].deferred > sections_[b].deferred;
+  });
+  size_t room = budget - FRAME_HEADER_SIZE;
+  uint8_t mask = 0;
+  for (size_t i = 0; i < pending; i++) {
+    if (size[order[i]] <= room) {
+      room -= size[order[i]];
+      mask |= 1 << order[i];
+    }
+  }
+
+  // The decoder reads the sections in Section order
+  uint8_t * out = buffer + FRAME_HEADER_SIZE;
+  for (int section = 0; section < NUM_SECTIONS; section++) {
+    if (mask & (1 << section)) {
+      std::memcpy(out, encoded[section], size[section]);
+      out += size[section];
+      commit_section((Section) section, encoded[section]);
+    } else if (size[section] > 0) {
+      sections_[section].deferred++;
+    }
+  }
+  if (mask == 0) {
+    return 0;
+  }
+
+  buffer[0] = FRAME_VERSION;
+  buffer[1] = mask;
+  buffer[2] = (uint8_t) sequence_;
+  buffer[3] = (uint8_t) (sequence_ >> 8);
+  buffer[4] = (uint8_t) stamp_ms;
+  buffer[5] = (uint8_t) (stamp_ms >> 8);
+  buffer[6] = (uint8_t) (stamp_ms >> 16);
+  sequence_++;
+  return out - buffer;
+}
+
+size_t TelemetryEncoder::encode_section(Section section, uint8_t * out)
+{
+  uint8_t * p = out;
+
+  if (section == ERROR) {
+    if (error_repeats_ == 0) {
+      return 0;
+    }
+    *p++ = error_id_;
+    p = write_varint(p, error_.code);
+    p = write_varint(p, error_.reset_count);
+    p = write_varint(p, error_.pc);
+    *p++ = error_.rearm;
+    *p++ = (uint8_t) error_.message.size();
+    std::memcpy(p, error_.message.data(), error_.message.size());
+    p += error_.message.size();
+  } else {
+    SectionState & s = sections_[section];
+    if (!s.updated) {
+      return 0;
+    }
+    bool key = !s.has_key || s.since_key + 1 >= keyframe_interval_;
+    uint8_t key_id = key ? (uint8_t) ((s.key_id + 1) & 0x7F) : s.key_id;
+    *p++ = (uint8_t) (key << 7) | key_id;
+    for (size_t i = 0; i < FIELD_COUNT[section]; i++) {
+      p = write_varint(p, key ? s.value[i] : s.value[i] - s.key[i]);
+    }
+  }
+  return p - out;
+}
+
+void TelemetryEncoder::commit_section(Section section, const uint8_t * encoded)
+{
+  SectionState & s = sections_[section];
+  s.deferred = 0;
+  if (section == ERROR) {
+    error_repeats_--;
+    return;
+  }
+
+  if (encoded[0] & 0x80) {
+    s.key = s.value;
+    s.key_id = encoded[0] & 0x7F;
+    s.has_key = true;
+    s.since_key = 0;
+  } else {
+    s.since_key++;
+  }
+  s.updated = false;
+}
+
+bool TelemetryDecoder::decode(const uint8_t * data, size_t size, Frame & frame)
+{
+  if (size < FRAME_HEADER_SIZE || data[0] != FRAME_VERSION) {
+    return false;
+  }
+  frame.mask = 0;
+  frame.sequence = (uint16_t) (data[2] | data[3] << 8);
+  frame.stamp_ms = data[4] | data[5] << 8 | data[6] << 16;
+
+  // Drop frames that arrive after a newer one, unless the encoder restarted its sequence
+  if (have_sequence_) {
+    uint16_t gap = frame.sequence - last_sequence_;
+    if (gap == 0 || gap >= 0x8000) {
+      if (++stale_frames_ < STALE_FRAMES_BEFORE_RESYNC) {
+        return true;
+      }
+      // The keyframes and error id belong to the encoder before the restart
+      sections_ = {};
+      have_error_id_ = false;
+    } else {
+      frames_lost_ += gap - 1;
+    }
+  }
+  stale_frames_ = 0;
+  have_sequence_ = true;
+  last_sequence_ = frame.sequence;
+  frames_received_++;
+
+  const uint8_t * in = data + FRAME_HEADER_SIZE;
+  const uint8_t * end = data + size;
+  for (int section = 0; section < NUM_SECTIONS; section++) {
+    if (!(data[1] & (1 << section))) {
+      continue;
+    }
+    if (in == end) {
+      return false;
+    }
+    uint8_t header = *in++;
+
+    if (section == ERROR) {
+      int64_t code, reset_count, pc;
+      if (!read_varint(in, end, code) || !read_varint(in, end, reset_count)
+          || !read_varint(in, end, pc) || end - in < 2 || end - in - 2 < in[1]) {
+        return false;
+      }
+      frame.error.code = (uint32_t) code;
+      frame.error.reset_count = (uint32_t) reset_count;
+      frame.error.pc = (uint32_t) pc;
+      frame.error.rearm = in[0];
+      frame.error.message.assign((const char *) in + 2, in[1]);
+      in += 2 + in[1];
+      // Errors are repeated over several frames
+      if (!have_error_id_ || header != last_error_id_) {
+        have_error_id_ = true;
+        last_error_id_ = header;
+        frame.mask |= 1 << section;
+      }
+      continue;
+    }
+
+    SectionState & s = sections_[section];
+    std::array<int64_t, MAX_FIELDS> values{};
+    for (size_t i = 0; i < FIELD_COUNT[section]; i++) {
+      if (!read_varint(in, end, values[i])) {
+        return false;
+      }
+    }
+    bool key = header & 0x80;
+    uint8_t key_id = header & 0x7F;
+    if (key) {
+      s.key = values;
+      s.key_id = key_id;
+      s.has_key = true;
+      s.value = values;
+    } else if (s.has_key && s.key_id == key_id) {
+      for (size_t i = 0; i < FIELD_COUNT[section]; i++) {
+        // Wrapping, since the values come off the network
+        s.value[i] = (int64_t) ((uint64_t) s.key[i] + (uint64_t) values[i]);
+      }
+    } else {
+      sections_undecodable_++;
+      continue;
+    }
+    frame.mask |= 1 << section;
+  }
+
+  const std::array<int64_t, MAX_FIELDS> & status = sections_[STATUS].value;
+  if (frame.has(STATUS)) {
+    frame.status.armed = status[0] & 1;
+    frame.status.failsafe = status[0] & 2;
+    frame.status.rc_override = status[0] & 4;
+    frame.status.offboard = status[0] & 8;
+    frame.status.control_mode = (uint8_t) status[1];
+    frame.status.error_code = (uint8_t) status[2];
+    frame.status.num_errors = (int16_t) status[3];
+    frame.status.loop_time_us = (int16_t) status[4];
+  }
+  const std::array<int64_t, MAX_FIELDS> & attitude = sections_[ATTITUDE].value;
+  if (frame.has(ATTITUDE)) {
+    // Quantization leaves the quaternion slightly off unit length. Squared as doubles, since the
+    // values come off the network and could overflow an int64_t.
+    double w = (double) attitude[0];
+    double x = (double) attitude[1];
+    double y = (double) attitude[2];
+    double z = (double) attitude[3];
+    double norm = std::sqrt(w * w + x * x + y * y + z * z);
+    if (norm == 0) {
+      norm = 1;
+    }
+    frame.attitude.w = w / norm;
+    frame.attitude.x = x / norm;
+    frame.attitude.y = y / norm;
+    frame.attitude.z = z / norm;
+    for (size_t i = 0; i < 3; i++) {
+      frame.attitude.angular_velocity[i] = attitude[4 + i] * 1e-3;
+    }
+  }
+  const std::array<int64_t, MAX_FIELDS> & battery = sections_[BATTERY].value;
+  if (frame.has(BATTERY)) {
+    frame.battery.voltage = battery[0] * 1e-3;
+    frame.battery.current = battery[1] * 1e-3;
+  }
+  const std::array<int64_t, MAX_FIELDS> & gnss = sections_[GNSS].value;
+  if (frame.has(GNSS)) {
+    frame.gnss.fix = (uint8_t) gnss[0];
+    frame.gnss.time_sec = gnss[1] / 1000;
+    frame.gnss.time_nanos = (uint32_t) (gnss[1] % 1000) * 1000000;
+    for (size_t i = 0; i < 3; i++) {
+      frame.gnss.position[i] = gnss[2 + i] * 1e-2;
+      frame.gnss.velocity[i] = gnss[5 + i] * 1e-2;
+    }
+    frame.gnss.horizontal_accuracy = gnss[8] * 1e-2;
+    frame.gnss.vertical_accuracy = gnss[9] * 1e-2;
+    frame.gnss.speed_accuracy = gnss[10] * 1e-2;
+  }
+  return true;
+}
+
+} // namespace rosflight_gcs
@@ -0,0 +1,184 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <rosflight_gcs/telemetry_relay.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace rosflight_gcs
+{
+TelemetryRelayAir::TelemetryRelayAir()
+    : Node("telemetry_relay_air")
+    , encoder_((unsigned) std::max<int64_t>(this->declare_parameter("keyframe_interval", 10), 1))
+    , max_frame_bytes_(
+        (size_t) std::clamp<int64_t>(this->declare_parameter("max_frame_bytes", 64), 16, 1400))
+{
+  std::string remote_host = this->declare_parameter<std::string>("remote_host", "localhost");
+  std::string remote_port = std::to_string(this->declare_parameter("remote_port", 14600));
+  double rate = this->declare_parameter("rate", 10.0);
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo * result = nullptr;
+  int error = getaddrinfo(remote_host.c_str(), remote_port.c_str(), &hints, &result);
+  if (error != 0) {
+    throw std::runtime_error("Could not resolve " + remote_host + ": " + gai_strerror(error));
+  }
+  socket_ = socket(result->ai_family, SOCK_DGRAM, 0);
+  std::memcpy(&remote_, result->ai_addr, result->ai_addrlen);
+  remote_len_ = result->ai_addrlen;
+  freeaddrinfo(result);
+  if (socket_ < 0) {
+    throw std::runtime_error(std::string("Could not create socket: ") + strerror(errno));
+  }
+
+  status_sub_ = this->create_subscription<rosflight_msgs::msg::Status>(
+    "status", 1, std::bind(&TelemetryRelayAir::statusCallback, this, std::placeholders::_1));
+  // rosflight_io latches errors
+  rclcpp::QoS error_qos(5);
+  error_qos.transient_local();
+  error_sub_ = this->create_subscription<rosflight_msgs::msg::Error>(
+    "rosflight_errors", error_qos,
+    std::bind(&TelemetryRelayAir::errorCallback, this, std::placeholders::_1));
+  attitude_sub_ = this->create_subscription<rosflight_msgs::msg::Attitude>(
+    "attitude", 1, std::bind(&TelemetryRelayAir::attitudeCallback, this, std::placeholders::_1));
+  battery_sub_ = this->create_subscription<rosflight_msgs::msg::BatteryStatus>(
+    "battery", 1, std::bind(&TelemetryRelayAir::batteryCallback, this, std::placeholders::_1));
+  gnss_sub_ = this->create_subscription<rosflight_msgs::msg::GNSS>(
+    "gnss", 1, std::bind(&TelemetryRelayAir::gnssCallback, this, std::placeholders::_1));
+
+  frame_timer_ = this->create_wall_timer(std::chrono::duration<double>(1.0 / rate),
+                                         std::bind(&TelemetryRelayAir::frameTimerCallback, this));
+
+  RCLCPP_INFO(this->get_logger(), "Relaying telemetry to %s:%s, %.1f frames/s of at most %zu bytes",
+              remote_host.c_str(), remote_port.c_str(), rate, max_frame_bytes_);
+}
+
+TelemetryRelayAir::~TelemetryRelayAir()
+{
+  if (socket_ >= 0) {
+    close(socket_);
+  }
+}
+
+void TelemetryRelayAir::statusCallback(const rosflight_msgs::msg::Status & msg)
+{
+  telemetry::Status status;
+  status.armed = msg.armed;
+  status.failsafe = msg.failsafe;
+  status.rc_override = msg.rc_override;
+  status.offboard = msg.offboard;
+  status.control_mode = msg.control_mode;
+  status.error_code = msg.error_code;
+  status.num_errors = msg.num_errors;
+  status.loop_time_us = msg.loop_time_us;
+  encoder_.set_status(status);
+}
+
+void TelemetryRelayAir::errorCallback(const rosflight_msgs::msg::Error & msg)
+{
+  telemetry::Error error;
+  error.message = msg.error_message;
+  error.code = msg.error_code;
+  error.reset_count = msg.reset_count;
+  error.rearm = msg.rearm;
+  error.pc = msg.pc;
+  encoder_.set_error(error);
+}
+
+void TelemetryRelayAir::attitudeCallback(const rosflight_msgs::msg::Attitude & msg)
+{
+  telemetry::Attitude attitude;
+  attitude.w = msg.attitude.w;
+  attitude.x = msg.attitude.x;
+  attitude.y = msg.attitude.y;
+  attitude.z = msg.attitude.z;
+  attitude.angular_velocity = {msg.angular_velocity.x, msg.angular_velocity.y,
+                               msg.angular_velocity.z};
+  encoder_.set_attitude(attitude);
+}
+
+void TelemetryRelayAir::batteryCallback(const rosflight_msgs::msg::BatteryStatus & msg)
+{
+  encoder_.set_battery({msg.voltage, msg.current});
+}
+
+void TelemetryRelayAir::gnssCallback(const rosflight_msgs::msg::GNSS & msg)
+{
+  telemetry::Gnss gnss;
+  gnss.fix = msg.fix;
+  gnss.time_sec = msg.time.sec;
+  gnss.time_nanos = msg.time.nanosec;
+  for (size_t i = 0; i < 3; i++) {
+    gnss.position[i] = msg.position[i];
+    gnss.velocity[i] = msg.velocity[i];
+  }
+  gnss.horizontal_accuracy = msg.horizontal_accuracy;
+  gnss.vertical_accuracy = msg.vertical_accuracy;
+  gnss.speed_accuracy = msg.speed_accuracy;
+  encoder_.set_gnss(gnss);
+}
+
+void TelemetryRelayAir::frameTimerCallback()
+{
+  uint8_t frame[1400];
+  uint64_t now_ms = (uint64_t) (this->get_clock()->now().nanoseconds() / 1000000);
+  size_t size = encoder_.encode(now_ms, frame, max_frame_bytes_);
+  if (size == 0) {
+    return;
+  }
+  if (sendto(socket_, frame, size, 0, (const sockaddr *) &remote_, remote_len_) < 0) {
+    RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                         "Could not send telemetry frame: %s", strerror(errno));
+    return;
+  }
+  bytes_sent_ += size;
+}
+
+} // namespace rosflight_gcs
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<rosflight_gcs::TelemetryRelayAir>());
+  rclcpp::shutdown();
+  return 0;
+}
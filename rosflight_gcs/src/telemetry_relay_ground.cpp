@@ -0,0 +1,208 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <rosflight_gcs/telemetry_relay.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace rosflight_gcs
+{
+TelemetryRelayGround::TelemetryRelayGround()
+    : Node("telemetry_relay_ground")
+{
+  std::string bind_host = this->declare_parameter<std::string>("bind_host", "0.0.0.0");
+  std::string bind_port = std::to_string(this->declare_parameter("bind_port", 14600));
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  hints.ai_flags = AI_PASSIVE;
+  addrinfo * result = nullptr;
+  int error = getaddrinfo(bind_host.c_str(), bind_port.c_str(), &hints, &result);
+  if (error != 0) {
+    throw std::runtime_error("Could not resolve " + bind_host + ": " + gai_strerror(error));
+  }
+  socket_ = socket(result->ai_family, SOCK_DGRAM, 0);
+  bool bound = socket_ >= 0 && bind(socket_, result->ai_addr, result->ai_addrlen) == 0;
+  freeaddrinfo(result);
+  if (!bound) {
+    throw std::runtime_error("Could not bind to " + bind_host + ":" + bind_port + ": "
+                             + strerror(errno));
+  }
+  // Time out reads so the receive thread notices shutdown
+  timeval timeout{0, 100000};
+  setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  status_pub_ = this->create_publisher<rosflight_msgs::msg::Status>("status", 1);
+  rclcpp::QoS error_qos(5);
+  error_qos.transient_local();
+  error_pub_ = this->create_publisher<rosflight_msgs::msg::Error>("rosflight_errors", error_qos);
+  attitude_pub_ = this->create_publisher<rosflight_msgs::msg::Attitude>("attitude", 1);
+  battery_pub_ = this->create_publisher<rosflight_msgs::msg::BatteryStatus>("battery", 1);
+  gnss_pub_ = this->create_publisher<rosflight_msgs::msg::GNSS>("gnss", 1);
+
+  receive_thread_ = std::thread(&TelemetryRelayGround::receive_loop, this);
+
+  RCLCPP_INFO(this->get_logger(), "Listening for telemetry on %s:%s", bind_host.c_str(),
+              bind_port.c_str());
+}
+
+TelemetryRelayGround::~TelemetryRelayGround()
+{
+  running_ = false;
+  if (receive_thread_.joinable()) {
+    receive_thread_.join();
+  }
+  close(socket_);
+}
+
+void TelemetryRelayGround::receive_loop()
+{
+  uint8_t buffer[1500];
+  telemetry::Frame frame;
+  while (running_ && rclcpp::ok()) {
+    ssize_t size = recv(socket_, buffer, sizeof(buffer), 0);
+    if (size <= 0) {
+      continue;
+    }
+    if (!decoder_.decode(buffer, (size_t) size, frame)) {
+      continue;
+    }
+    publish(frame);
+
+    RCLCPP_INFO_THROTTLE(this->get_logger(), *this->get_clock(), 10000,
+                         "Telemetry link: %lu frames received, %lu lost, %lu sections undecodable",
+                         (unsigned long) decoder_.frames_received(),
+                         (unsigned long) decoder_.frames_lost(),
+                         (unsigned long) decoder_.sections_undecodable());
+  }
+}
+
+void TelemetryRelayGround::publish(const telemetry::Frame & frame)
+{
+  rclcpp::Time stamp = frame_time(frame.stamp_ms);
+
+  if (frame.has(telemetry::STATUS)) {
+    rosflight_msgs::msg::Status msg;
+    msg.header.stamp = stamp;
+    msg.armed = frame.status.armed;
+    msg.failsafe = frame.status.failsafe;
+    msg.rc_override = frame.status.rc_override;
+    msg.offboard = frame.status.offboard;
+    msg.control_mode = frame.status.control_mode;
+    msg.error_code = frame.status.error_code;
+    msg.num_errors = frame.status.num_errors;
+    msg.loop_time_us = frame.status.loop_time_us;
+    status_pub_->publish(msg);
+  }
+
+  if (frame.has(telemetry::ERROR)) {
+    rosflight_msgs::msg::Error msg;
+    msg.header.stamp = stamp;
+    msg.error_message = frame.error.message;
+    msg.error_code = frame.error.code;
+    msg.reset_count = frame.error.reset_count;
+    msg.rearm = frame.error.rearm;
+    msg.pc = frame.error.pc;
+    error_pub_->publish(msg);
+  }
+
+  if (frame.has(telemetry::ATTITUDE)) {
+    rosflight_msgs::msg::Attitude msg;
+    msg.header.stamp = stamp;
+    msg.attitude.w = frame.attitude.w;
+    msg.attitude.x = frame.attitude.x;
+    msg.attitude.y = frame.attitude.y;
+    msg.attitude.z = frame.attitude.z;
+    msg.angular_velocity.x = frame.attitude.angular_velocity[0];
+    msg.angular_velocity.y = frame.attitude.angular_velocity[1];
+    msg.angular_velocity.z = frame.attitude.angular_velocity[2];
+    attitude_pub_->publish(msg);
+  }
+
+  if (frame.has(telemetry::BATTERY)) {
+    rosflight_msgs::msg::BatteryStatus msg;
+    msg.header.stamp = stamp;
+    msg.voltage = frame.battery.voltage;
+    msg.current = frame.battery.current;
+    battery_pub_->publish(msg);
+  }
+
+  if (frame.has(telemetry::GNSS)) {
+    rosflight_msgs::msg::GNSS msg;
+    msg.header.stamp = stamp;
+    msg.header.frame_id = "ECEF";
+    msg.fix = frame.gnss.fix;
+    msg.time.sec = frame.gnss.time_sec;
+    msg.time.nanosec = frame.gnss.time_nanos;
+    for (size_t i = 0; i < 3; i++) {
+      msg.position[i] = frame.gnss.position[i];
+      msg.velocity[i] = frame.gnss.velocity[i];
+    }
+    msg.horizontal_accuracy = frame.gnss.horizontal_accuracy;
+    msg.vertical_accuracy = frame.gnss.vertical_accuracy;
+    msg.speed_accuracy = frame.gnss.speed_accuracy;
+    gnss_pub_->publish(msg);
+  }
+}
+
+rclcpp::Time TelemetryRelayGround::frame_time(uint32_t stamp_ms)
+{
+  constexpr int64_t WRAP = 1 << 24;
+  rclcpp::Time now = this->get_clock()->now();
+  int64_t now_ms = now.nanoseconds() / 1000000;
+  // Pick the time with these low bits that is closest to our own clock
+  int64_t ms = (now_ms & ~(WRAP - 1)) | stamp_ms;
+  if (ms - now_ms > WRAP / 2) {
+    ms -= WRAP;
+  } else if (now_ms - ms > WRAP / 2) {
+    ms += WRAP;
+  }
+  return rclcpp::Time(ms * 1000000, now.get_clock_type());
+}
+
+} // namespace rosflight_gcs
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<rosflight_gcs::TelemetryRelayGround>());
+  rclcpp::shutdown();
+  return 0;
+}
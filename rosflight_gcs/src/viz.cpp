@@ -34,100 +34,157 @@
 
 #include <rosflight_gcs/viz.hpp>
 
+#include <algorithm>
+#include <chrono>
+
+#include <sensor_msgs/point_cloud2_iterator.hpp>
+
 namespace rosflight_gcs
 {
+MagPointCloud::MagPointCloud(double voxel_size, size_t capacity)
+    : inv_voxel_size_(1.0 / voxel_size)
+    , capacity_(capacity)
+{
+  points_.reserve(capacity_);
+  keys_.reserve(capacity_);
+  voxels_.reserve(capacity_);
+}
+
+int64_t MagPointCloud::voxel_key(double x, double y, double z) const
+{
+  // 21 bits per axis, which covers +-2^20 voxels
+  auto index = [this](double v) { return (int64_t) std::floor(v * inv_voxel_size_) & 0x1FFFFF; };
+  return (index(x) << 42) | (index(y) << 21) | index(z);
+}
+
+bool MagPointCloud::add(double x, double y, double z)
+{
+  int64_t key = voxel_key(x, y, z);
+  if (!voxels_.insert(key).second) {
+    return false;
+  }
+
+  Point p{(float) x, (float) y, (float) z};
+  if (points_.size() < capacity_) {
+    points_.push_back(p);
+    keys_.push_back(key);
+  } else {
+    voxels_.erase(keys_[next_]);
+    points_[next_] = p;
+    keys_[next_] = key;
+  }
+  next_ = (next_ + 1) % capacity_;
+  return true;
+}
+
 Viz::Viz()
     : Node("viz_node")
+    , mag_cloud_(this->declare_parameter("mag_voxel_size", 0.02),
+                 (size_t) std::max<int64_t>(this->declare_parameter("mag_max_points", 5000), 1))
 {
   // retrieve params
-
-  // initialize variables
-  mag_skip_ = 20;
-  mag_throttle_ = 0;
+  double display_rate = this->declare_parameter("display_rate", 10.0);
+  if (!(display_rate > 0.0)) {
+    RCLCPP_WARN(this->get_logger(), "display_rate must be positive, not %g; using 10 Hz",
+                display_rate);
+    display_rate = 10.0;
+  }
 
   // Magnetometer visualization
   mag_sub_ = this->create_subscription<sensor_msgs::msg::MagneticField>(
     "/magnetometer", 1, std::bind(&Viz::magCallback, this, std::placeholders::_1));
   mag_pub_ = this->create_publisher<geometry_msgs::msg::PoseStamped>("viz/magnetometer", 1);
-  pts_pub_ = this->create_publisher<visualization_msgs::msg::Marker>("viz/cloud", 1);
+  pts_pub_ = this->create_publisher<sensor_msgs::msg::PointCloud2>("viz/cloud", 1);
 
   // Attitude visualization
   att_sub_ = this->create_subscription<rosflight_msgs::msg::Attitude>(
     "/attitude", 1, std::bind(&Viz::attCallback, this, std::placeholders::_1));
   pose_pub_ = this->create_publisher<geometry_msgs::msg::PoseStamped>("viz/attitude", 1);
+
+  display_timer_ = this->create_wall_timer(
+    std::chrono::duration<double>(1.0 / display_rate), std::bind(&Viz::displayTimerCallback, this));
 }
 
 void Viz::magCallback(const sensor_msgs::msg::MagneticField::ConstSharedPtr & msg)
 {
-  if (mag_throttle_ > mag_skip_) {
-    // unpack message
-    double x = msg->magnetic_field.x;
-    double y = msg->magnetic_field.y;
-    double z = msg->magnetic_field.z;
-
-    // get euler angles from vector (assume no roll)
-    double yaw = atan2(y, x);
-    double pitch = atan2(-z, sqrt(x * x + y * y));
-
-    // convert to body quaternion and rotation into the vehicle frame
-    tf2::Quaternion q_v;
-    q_v.setRPY(0, pitch, yaw);
-
-    // pack data into pose message
-    geometry_msgs::msg::PoseStamped pose_msg;
-    pose_msg.header = msg->header;
-    pose_msg.header.frame_id = fixed_frame_;
-    pose_msg.pose.position.x = 0;
-    pose_msg.pose.position.y = 0;
-    pose_msg.pose.position.z = 0;
-    pose_msg.pose.orientation = tf2::toMsg(q_v);
-
-    // Publish the messages
-    mag_pub_->publish(pose_msg);
-
-    // MEASUREMENT CLOUD //
-
-    // store the current measurement
-    geometry_msgs::msg::Point p;
-    p.x = x;
-    p.y = y;
-    p.z = z;
-    pts_list_.push_back(p);
-
-    // begin packing marker message
-    visualization_msgs::msg::Marker pts_msg;
-    pts_msg.header.frame_id = fixed_frame_;
-    pts_msg.header.stamp = msg->header.stamp;
-    pts_msg.type = visualization_msgs::msg::Marker::POINTS;
-    pts_msg.action = visualization_msgs::msg::Marker::ADD;
-
-    // set points style
-    pts_msg.scale.x = 0.1;
-    pts_msg.scale.y = pts_msg.scale.x;
-    pts_msg.scale.z = pts_msg.scale.x;
-    pts_msg.color.a = 1.0;
-    pts_msg.color.r = 0.0;
-    pts_msg.color.g = 1.0;
-    pts_msg.color.b = 0.0;
-
-    for (const auto & item : pts_list_) {
-      pts_msg.points.push_back(item);
-    }
-
-    // publish point cloud
-    pts_pub_->publish(pts_msg);
+  // unpack message
+  double x = msg->magnetic_field.x;
+  double y = msg->magnetic_field.y;
+  double z = msg->magnetic_field.z;
+
+  // get euler angles from vector (assume no roll)
+  double yaw = atan2(y, x);
+  double pitch = atan2(-z, sqrt(x * x + y * y));
+
+  // convert to body quaternion and rotation into the vehicle frame
+  tf2::Quaternion q_v;
+  q_v.setRPY(0, pitch, yaw);
+
+  // pack data into pose message, which is published at the display rate
+  mag_pose_.header = msg->header;
+  mag_pose_.header.frame_id = fixed_frame_;
+  mag_pose_.pose.position.x = 0;
+  mag_pose_.pose.position.y = 0;
+  mag_pose_.pose.position.z = 0;
+  mag_pose_.pose.orientation = tf2::toMsg(q_v);
+  mag_pose_pending_ = true;
+
+  // MEASUREMENT CLOUD //
+
+  // store the current measurement, unless a nearby one is already stored
+  if (mag_cloud_.add(x, y, z)) {
+    cloud_changed_ = true;
   }
-  mag_throttle_++;
 }
 
-void Viz::attCallback(const rosflight_msgs::msg::Attitude::ConstSharedPtr & msg)
+void Viz::displayTimerCallback()
 {
-  geometry_msgs::msg::PoseStamped pose;
-  pose.header = msg->header;
-  pose.header.frame_id = fixed_frame_;
-  pose.pose.orientation = msg->attitude;
+  if (mag_pose_pending_) {
+    mag_pub_->publish(mag_pose_);
+    mag_pose_pending_ = false;
+  }
+  if (att_pose_pending_) {
+    pose_pub_->publish(att_pose_);
+    att_pose_pending_ = false;
+  }
+
+  if (cloud_changed_) {
+    publishCloud(mag_cloud_.points());
+    cloud_changed_ = false;
+  }
+}
 
-  pose_pub_->publish(pose);
+void Viz::publishCloud(const std::vector<MagPointCloud::Point> & points)
+{
+  sensor_msgs::msg::PointCloud2 cloud;
+  cloud.header.frame_id = fixed_frame_;
+  cloud.header.stamp = mag_pose_.header.stamp;
+
+  sensor_msgs::PointCloud2Modifier modifier(cloud);
+  modifier.setPointCloud2FieldsByString(1, "xyz");
+  modifier.resize(points.size());
+
+  sensor_msgs::PointCloud2Iterator<float> iter_x(cloud, "x");
+  sensor_msgs::PointCloud2Iterator<float> iter_y(cloud, "y");
+  sensor_msgs::PointCloud2Iterator<float> iter_z(cloud, "z");
+  for (const auto & p : points) {
+    *iter_x = p.x;
+    *iter_y = p.y;
+    *iter_z = p.z;
+    ++iter_x;
+    ++iter_y;
+    ++iter_z;
+  }
+
+  pts_pub_->publish(cloud);
+}
+
+void Viz::attCallback(const rosflight_msgs::msg::Attitude::ConstSharedPtr & msg)
+{
+  att_pose_.header = msg->header;
+  att_pose_.header.frame_id = fixed_frame_;
+  att_pose_.pose.orientation = msg->attitude;
+  att_pose_pending_ = true;
 }
 
 } // namespace rosflight_gcs
@@ -0,0 +1,147 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file telemetry_codec_test.cpp
+ *
+ * Checks that a tight byte budget delays the low priority sections of the telemetry relay without
+ * starving them, and that the frames still decode to the values that were sent.
+ */
+
+#include <rosflight_gcs/telemetry_codec.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace rosflight_gcs;
+using namespace rosflight_gcs::telemetry;
+
+namespace
+{
+const char * const SECTION_NAMES[NUM_SECTIONS] = {"status", "error", "attitude", "battery", "gnss"};
+
+// Every section is updated before every frame, as with the relay running slower than the topics
+bool check(size_t budget, unsigned max_gap)
+{
+  TelemetryEncoder encoder(10);
+  TelemetryDecoder decoder;
+  unsigned last_sent[NUM_SECTIONS] = {};
+  unsigned worst_gap[NUM_SECTIONS] = {};
+  unsigned sent[NUM_SECTIONS] = {};
+  double gnss_error = 0;
+  bool decoded = true;
+
+  const unsigned frames = 200;
+  for (unsigned i = 1; i <= frames; i++) {
+    double t = i * 0.1;
+    Status status;
+    status.armed = true;
+    status.loop_time_us = (int16_t) (900 + i % 50);
+    encoder.set_status(status);
+
+    Attitude attitude;
+    attitude.w = std::cos(0.05 * t);
+    attitude.z = std::sin(0.05 * t);
+    attitude.angular_velocity = {0.01 * std::sin(t), 0.02, 0.1};
+    encoder.set_attitude(attitude);
+
+    Battery battery;
+    battery.voltage = 16.8 - 0.001 * i;
+    battery.current = 12.0 + 0.5 * std::sin(t);
+    encoder.set_battery(battery);
+
+    // Flying east at 20 m/s, 1500 m above Provo
+    Gnss gnss;
+    gnss.fix = 3;
+    gnss.time_sec = 1700000000 + i / 10;
+    gnss.time_nanos = (i % 10) * 100000000;
+    gnss.position = {-1800000.0 - 12.0 * t, -4500000.0 + 16.0 * t, 4070000.0};
+    gnss.velocity = {-12.0, 16.0, 0.0};
+    gnss.horizontal_accuracy = 1.5;
+    gnss.vertical_accuracy = 3.0;
+    gnss.speed_accuracy = 0.2;
+    encoder.set_gnss(gnss);
+
+    uint8_t buffer[256];
+    size_t size = encoder.encode(i * 100, buffer, budget);
+    if (size > budget) {
+      printf("FAIL: %zu byte frame over a budget of %zu\n", size, budget);
+      return false;
+    }
+
+    Frame frame;
+    if (size == 0 || !decoder.decode(buffer, size, frame)) {
+      decoded = false;
+      continue;
+    }
+    for (int section = 0; section < NUM_SECTIONS; section++) {
+      if (frame.has((Section) section)) {
+        worst_gap[section] = std::max(worst_gap[section], i - last_sent[section]);
+        last_sent[section] = i;
+        sent[section]++;
+      }
+    }
+    if (frame.has(GNSS)) {
+      for (size_t j = 0; j < 3; j++) {
+        gnss_error = std::max(gnss_error, std::abs(frame.gnss.position[j] - gnss.position[j]));
+      }
+    }
+  }
+
+  bool pass = decoded && gnss_error <= 0.005 + 1e-9;
+  printf("%zu byte budget:", budget);
+  for (int section = 0; section < NUM_SECTIONS; section++) {
+    if (section == ERROR) {
+      continue;
+    }
+    // A section still waiting at the end counts as a gap too
+    unsigned gap = std::max(worst_gap[section], frames + 1 - last_sent[section]);
+    pass = pass && gap <= max_gap;
+    printf(" %s %u/%u (longest gap %u)", SECTION_NAMES[section], sent[section], frames, gap);
+  }
+  printf(", GNSS error %.1f mm: %s\n", gnss_error * 1e3, pass ? "PASS" : "FAIL");
+  return pass;
+}
+
+} // namespace
+
+int main()
+{
+  // With every section updated each frame, no section waits longer than one frame per section
+  bool pass = true;
+  for (size_t budget : {40, 48, 64, 256}) {
+    pass = check(budget, NUM_SECTIONS) && pass;
+  }
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file alloc_tracker.hpp
+ */
+
+#ifndef ROSFLIGHT_IO_ALLOC_TRACKER_H
+#define ROSFLIGHT_IO_ALLOC_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace rosflight_io
+{
+/**
+ * \brief Counts the allocations made through the global operator new and the malloc family, per
+ * thread, over windows. Allocations made on a hot path (see mavrosflight::HotPath) are counted
+ * separately and have their call stack recorded, so the code responsible can be found.
+ *
+ * Linking alloc_tracker.cpp replaces the global operator new and delete and interposes malloc,
+ * calloc, realloc, the aligned allocators and free for the whole program, including the C
+ * libraries underneath rclcpp (rcutils, rcl, rmw and the DDS). It is only linked into the check
+ * harnesses. Outside a window the replacements only forward to glibc's allocator. Link the
+ * harness with -rdynamic for symbol names in the call stacks.
+ */
+class AllocTracker
+{
+public:
+  static constexpr size_t MAX_THREADS = 64;
+  static constexpr size_t MAX_CALL_SITES = 64;
+  static constexpr int MAX_FRAMES = 24;
+
+  struct ThreadCount
+  {
+    int tid;
+    char name[16];
+    uint64_t allocations;
+    uint64_t bytes;
+    uint64_t hot_allocations; //!< of allocations, made on a hot path
+  };
+
+  struct CallSite
+  {
+    const char * hot_path; //!< innermost hot path the allocation was made on
+    int tid;               //!< thread of the first allocation from this site
+    void * frames[MAX_FRAMES];
+    int depth;
+    uint64_t count;
+    uint64_t bytes;
+  };
+
+  struct Window
+  {
+    double seconds = 0.0;
+    std::vector<ThreadCount> threads; //!< threads that allocated in the window
+    std::vector<CallSite> call_sites; //!< of the hot path allocations
+    uint64_t hot_allocations = 0;
+    uint64_t dropped_call_sites = 0; //!< hot path allocations whose site did not fit
+  };
+
+  /**
+   * \brief Clears the counts and starts counting
+   */
+  static void start_window();
+
+  /**
+   * \brief Stops counting
+   * \return Counts since start_window()
+   */
+  static Window stop_window();
+
+  /**
+   * \brief Prints the counts per thread and the symbolized call stack of each hot path call site
+   */
+  static void print(const Window & window, FILE * out);
+};
+
+} // namespace rosflight_io
+
+#endif // ROSFLIGHT_IO_ALLOC_TRACKER_H
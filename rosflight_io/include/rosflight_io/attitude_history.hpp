@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file attitude_history.hpp
+ */
+
+#ifndef ROSFLIGHT_IO_ATTITUDE_HISTORY_H
+#define ROSFLIGHT_IO_ATTITUDE_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <eigen3/Eigen/Geometry>
+
+namespace rosflight_io
+{
+/**
+ * \brief Fixed-size, time-ordered ring of attitude estimates, used to look up the attitude at the
+ * time of another measurement. Lookups between two samples slerp between them; lookups slightly
+ * outside the history propagate the nearest sample with its angular velocity. Thread safe.
+ */
+class AttitudeHistory
+{
+public:
+  struct Sample
+  {
+    int64_t stamp_ns = 0;
+    Eigen::Quaterniond attitude = Eigen::Quaterniond::Identity();
+    Eigen::Vector3d angular_velocity = Eigen::Vector3d::Zero(); //!< body frame, rad/s
+  };
+
+  enum Result
+  {
+    OK,          //!< interpolated, or extrapolated within the allowed time
+    EMPTY,       //!< no samples yet
+    OUT_OF_RANGE //!< too far outside the history; the nearest sample is returned instead
+  };
+
+  explicit AttitudeHistory(size_t capacity = 256);
+
+  /**
+   * \brief Clears the history and changes its capacity
+   */
+  void reset(size_t capacity);
+
+  /**
+   * \brief Adds a sample. Samples older than the newest one are dropped, unless they are more than
+   * a second older, which means the flight controller's clock was reset and the history is cleared.
+   */
+  void add(const Sample & sample);
+
+  /**
+   * \brief Attitude at the given time
+   * \param stamp_ns Time to look up
+   * \param max_extrapolation_ns How far outside the history the nearest sample may be propagated
+   * \param sample Set to the attitude at stamp_ns, or the nearest sample if OUT_OF_RANGE
+   */
+  Result lookup(int64_t stamp_ns, int64_t max_extrapolation_ns, Sample & sample) const;
+
+  /**
+   * \brief Newest sample
+   * \return False if the history is empty
+   */
+  bool latest(Sample & sample) const;
+
+  size_t size() const;
+
+private:
+  //! i-th oldest sample, with the mutex held
+  const Sample & at(size_t i) const
+  {
+    return ring_[(head_ + ring_.size() - count_ + i) % ring_.size()];
+  }
+
+  static Sample propagate(const Sample & from, int64_t stamp_ns);
+
+  mutable std::mutex mutex_;
+  std::vector<Sample> ring_;
+  size_t head_ = 0; //!< index of the next sample to write
+  size_t count_ = 0;
+};
+
+} // namespace rosflight_io
+
+#endif // ROSFLIGHT_IO_ATTITUDE_HISTORY_H
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file log_queue.hpp
+ */
+
+#ifndef ROSFLIGHT_IO_LOG_QUEUE_H
+#define ROSFLIGHT_IO_LOG_QUEUE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace rosflight_io
+{
+/**
+ * \brief Fixed capacity queue of log lines. The MAVLink handlers run on the io thread, where
+ * logging through rclcpp would allocate, so they format their lines into the queue and the
+ * executor prints them. Lines pushed while the queue is full are counted and dropped. Kept free of
+ * ROS. Thread safe.
+ */
+class LogQueue
+{
+public:
+  enum Severity : uint8_t
+  {
+    SEVERITY_DEBUG,
+    SEVERITY_INFO,
+    SEVERITY_WARN,
+    SEVERITY_ERROR
+  };
+
+  //! Longest line kept, including the terminating null. Longer lines are truncated.
+  static constexpr size_t LINE_SIZE = 128;
+  static constexpr size_t CAPACITY = 64;
+
+  struct Line
+  {
+    Severity severity;
+    char text[LINE_SIZE];
+  };
+
+  /**
+   * \brief Formats a line into the queue, without allocating
+   * \return False if the queue was full and the line was dropped
+   */
+  bool push(Severity severity, const char * format, ...) __attribute__((format(printf, 3, 4)));
+
+  /**
+   * \brief Hands every queued line to the callback, oldest first, and empties the queue. The
+   * callback runs with the lock released, so it may take as long as it needs.
+   * \return Number of lines dropped since the last drain
+   */
+  template<class Callback>
+  uint64_t drain(Callback && callback)
+  {
+    std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+    size_t count;
+    uint64_t dropped;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      count = count_;
+      std::swap_ranges(lines_.begin(), lines_.begin() + count, draining_.begin());
+      count_ = 0;
+      dropped = dropped_;
+      dropped_ = 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+      callback(draining_[i]);
+    }
+    return dropped;
+  }
+
+private:
+  std::mutex mutex_;
+  std::mutex drain_mutex_; //!< held while draining_ is being read
+  std::array<Line, CAPACITY> lines_;
+  std::array<Line, CAPACITY> draining_;
+  size_t count_ = 0;
+  uint64_t dropped_ = 0;
+};
+
+} // namespace rosflight_io
+
+#endif // ROSFLIGHT_IO_LOG_QUEUE_H
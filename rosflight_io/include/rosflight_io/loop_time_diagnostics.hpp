@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file loop_time_diagnostics.hpp
+ *
+ * Diagnostics built from a LoopTimeMonitor, shared by rosflight_io and the SIL plugin. Header only,
+ * so that the live statistics library stays free of ROS.
+ */
+
+#ifndef ROSFLIGHT_IO_LOOP_TIME_DIAGNOSTICS_H
+#define ROSFLIGHT_IO_LOOP_TIME_DIAGNOSTICS_H
+
+#include <string>
+
+#include <diagnostic_msgs/msg/diagnostic_status.hpp>
+#include <diagnostic_msgs/msg/key_value.hpp>
+
+#include <rosflight_io/loop_time_monitor.hpp>
+
+namespace rosflight_io
+{
+/**
+ * \brief Diagnostic key-value pair. Integer values are written as integers.
+ */
+template<class T>
+diagnostic_msgs::msg::KeyValue key_value(const std::string & key, T value)
+{
+  diagnostic_msgs::msg::KeyValue kv;
+  kv.key = key;
+  kv.value = std::to_string(value);
+  return kv;
+}
+
+/**
+ * \brief Diagnostic status of a loop time summary: stale without samples, a warning once the budget
+ * has been overrun, and OK otherwise
+ * \param name Name of the status
+ * \param hardware_id Hardware id of the status
+ * \param stale_message Message of the status while there are no samples
+ */
+inline diagnostic_msgs::msg::DiagnosticStatus
+loop_time_status(const LoopTimeMonitor::Summary & summary, const std::string & name,
+                 const std::string & hardware_id, const std::string & stale_message)
+{
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.name = name;
+  status.hardware_id = hardware_id;
+  if (summary.samples == 0) {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::STALE;
+    status.message = stale_message;
+  } else if (summary.warning) {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+    status.message = "Over budget " + std::to_string(summary.overruns) + " times, worst "
+      + std::to_string(summary.worst_us) + " us";
+  } else {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.message = "p99 " + std::to_string(summary.p99_us) + " us";
+  }
+
+  status.values.push_back(key_value("p50_us", summary.p50_us));
+  status.values.push_back(key_value("p99_us", summary.p99_us));
+  status.values.push_back(key_value("max_us", summary.max_us));
+  status.values.push_back(key_value("mean_us", summary.mean_us));
+  status.values.push_back(key_value("worst_us", summary.worst_us));
+  status.values.push_back(key_value("budget_us", summary.budget_us));
+  status.values.push_back(key_value("overruns", summary.overruns));
+  status.values.push_back(key_value("error_rate", summary.error_rate));
+  status.values.push_back(key_value("samples", summary.samples));
+  return status;
+}
+
+} // namespace rosflight_io
+
+#endif // ROSFLIGHT_IO_LOOP_TIME_DIAGNOSTICS_H
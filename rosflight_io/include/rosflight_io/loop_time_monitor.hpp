@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file loop_time_monitor.hpp
+ */
+
+#ifndef ROSFLIGHT_IO_LOOP_TIME_MONITOR_H
+#define ROSFLIGHT_IO_LOOP_TIME_MONITOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace rosflight_io
+{
+/**
+ * \brief Running statistics of a flight controller's loop time over a fixed window of samples:
+ * a 1 us histogram of loop times for the percentiles, the rate at which errors are counted, and
+ * overruns of a loop time budget. The first overrun latches a warning that stays set until the
+ * monitor is cleared, so an occasional overrun isn't lost between reports. Kept free of ROS so the
+ * SIL plugin can use it too. Thread safe.
+ */
+class LoopTimeMonitor
+{
+public:
+  //! Longer loop times are counted as this
+  static constexpr uint32_t MAX_LOOP_TIME_US = 65535;
+
+  struct Summary
+  {
+    size_t samples = 0; //!< in the window
+    uint32_t p50_us = 0;
+    uint32_t p99_us = 0;
+    uint32_t max_us = 0; //!< longest loop in the window
+    double mean_us = 0.0;
+    double error_rate = 0.0; //!< errors per second over the window
+    uint64_t overruns = 0;   //!< samples over the budget since the last reset
+    uint32_t worst_us = 0;   //!< longest loop since the last reset
+    uint32_t budget_us = 0;
+    bool warning = false; //!< latched by the first overrun
+  };
+
+  explicit LoopTimeMonitor(size_t window = 1000, uint32_t budget_us = 0);
+
+  /**
+   * \brief Clears all statistics and the warning, and changes the window and budget
+   * \param window Number of samples the percentiles and error rate are computed over
+   * \param budget_us Loop time budget, or 0 to never warn
+   */
+  void reset(size_t window, uint32_t budget_us);
+
+  /**
+   * \brief Adds a sample
+   * \param stamp_ns Time of the sample, only used for the error rate
+   * \param loop_time_us Loop time
+   * \param num_errors Error count reported with the sample, or negative if there is none. Only
+   * increases are counted, so a count that restarts with the flight controller is handled.
+   * \return True if the loop time exceeded the budget
+   */
+  bool add(int64_t stamp_ns, uint32_t loop_time_us, int32_t num_errors = -1);
+
+  Summary summary() const;
+
+  /**
+   * \brief Clears all statistics and the warning, keeping the window and budget
+   */
+  void clear();
+
+private:
+  struct Sample
+  {
+    int64_t stamp_ns;
+    uint32_t loop_time_us;
+    uint64_t total_errors; //!< errors counted up to and including this sample
+  };
+
+  //! clear(), with the mutex held
+  void clear_locked();
+  //! Value at the given fraction of the window, with the mutex held
+  uint32_t percentile(double fraction) const;
+
+  mutable std::mutex mutex_;
+  std::vector<Sample> ring_;
+  size_t head_ = 0; //!< index of the next sample to write
+  size_t count_ = 0;
+  std::vector<uint32_t> histogram_; //!< samples in the window per microsecond of loop time
+  uint64_t sum_us_ = 0;             //!< of the loop times in the window
+
+  uint32_t budget_us_ = 0;
+  uint64_t overruns_ = 0;
+  uint32_t worst_us_ = 0;
+  bool warning_ = false;
+
+  int32_t last_num_errors_ = -1;
+  uint64_t total_errors_ = 0;
+};
+
+} // namespace rosflight_io
+
+#endif // ROSFLIGHT_IO_LOOP_TIME_MONITOR_H
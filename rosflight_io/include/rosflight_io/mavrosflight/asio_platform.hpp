@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file asio_platform.hpp
+ *
+ * A platform for mavrosflight with no middleware, for embedding the library in a plain C++
+ * process: the system clock, timers on a boost::asio io_service and a logger writing to a stream.
+ */
+
+#ifndef MAVROSFLIGHT_ASIO_PLATFORM_H
+#define MAVROSFLIGHT_ASIO_PLATFORM_H
+
+#include <rosflight_io/mavrosflight/platform.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+namespace mavrosflight
+{
+/**
+ * \brief std::chrono::system_clock, the same time base as a ROS node's default clock
+ */
+class SystemClock : public ClockInterface
+{
+public:
+  std::chrono::nanoseconds now() override;
+};
+
+/**
+ * \brief Creates timers on a boost::asio io_service. A timer that is destroyed or cancelled from
+ * another thread waits for a callback in progress to return. Destroy the timers before the factory.
+ */
+class AsioTimerFactory : public TimerFactoryInterface
+{
+public:
+  /**
+   * \brief Runs the timers on an io_service and thread of the factory's own
+   */
+  AsioTimerFactory();
+
+  /**
+   * \brief Runs the timers on the caller's io_service, e.g. one polled from a control loop
+   */
+  explicit AsioTimerFactory(boost::asio::io_service & io_service);
+
+  ~AsioTimerFactory();
+
+  std::unique_ptr<TimerInterface> create_wall_timer(std::chrono::nanoseconds period,
+                                                    std::function<void()> callback) override;
+
+private:
+  boost::asio::io_service own_io_service_;
+  boost::asio::io_service & io_service_;
+  std::unique_ptr<boost::asio::io_service::work> work_; //!< keeps the own io_service running
+  boost::thread thread_;                                 //!< runs the own io_service
+};
+
+/**
+ * \brief Writes log messages at or above a severity to a stream
+ */
+class StreamLogger : public LoggerInterface
+{
+public:
+  explicit StreamLogger(std::ostream & stream = std::cerr,
+                        Severity min_severity = Severity::INFO);
+
+  void write(Severity severity, const char * message) override;
+
+private:
+  std::ostream & stream_;
+  Severity min_severity_;
+  std::mutex mutex_;
+};
+
+/**
+ * \brief The system clock, timers on their own thread and a logger writing to stderr
+ */
+Platform
+make_asio_platform(LoggerInterface::Severity min_severity = LoggerInterface::Severity::INFO);
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_ASIO_PLATFORM_H
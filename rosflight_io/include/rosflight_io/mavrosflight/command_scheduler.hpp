@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file command_scheduler.hpp
+ */
+
+#ifndef MAVROSFLIGHT_COMMAND_SCHEDULER_H
+#define MAVROSFLIGHT_COMMAND_SCHEDULER_H
+
+#include <rosflight_io/mavrosflight/mavlink_comm.hpp>
+#include <rosflight_io/mavrosflight/platform.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace mavrosflight
+{
+/**
+ * \brief Sends the latest offboard and aux commands at a fixed rate, from a timer on the link's io
+ * thread, so the firmware sees evenly spaced setpoints however irregularly they are produced.
+ *
+ * A command that is not renewed within the timeout stops being sent, so the firmware's own offboard
+ * timeout takes over when the source goes quiet. Each transmission is packed anew, so the firmware
+ * sees consecutive sequence numbers.
+ */
+class CommandScheduler
+{
+public:
+  static constexpr int AUX_CHANNELS = 14;
+
+  //! Arguments of an OFFBOARD_CONTROL message
+  struct OffboardCommand
+  {
+    uint8_t mode;
+    uint8_t ignore;
+    float x;
+    float y;
+    float z;
+    float F;
+  };
+
+  //! Arguments of a ROSFLIGHT_AUX_CMD message
+  struct AuxCommand
+  {
+    uint8_t types[AUX_CHANNELS];
+    float values[AUX_CHANNELS];
+  };
+
+  /**
+   * \param comm Link to send on, which must outlive the scheduler
+   * \param platform Logger for commands going stale
+   * \param period Time between transmissions
+   * \param timeout Time after which a command that has not been renewed stops being sent
+   */
+  CommandScheduler(MavlinkComm & comm, const Platform & platform, std::chrono::nanoseconds period,
+                   std::chrono::nanoseconds timeout);
+
+  /**
+   * \brief Replaces the offboard command sent from the next period on
+   */
+  void latch(const OffboardCommand & command);
+
+  /**
+   * \brief Replaces the aux command sent from the next period on
+   */
+  void latch(const AuxCommand & command);
+
+  /**
+   * \brief Stops sending both commands until new ones are latched
+   */
+  void clear();
+
+private:
+  using SteadyClock = std::chrono::steady_clock;
+
+  template<class T>
+  struct Latched
+  {
+    T command;
+    SteadyClock::time_point time;
+    bool sending = false;
+  };
+
+  void transmit();
+
+  /**
+   * \brief Copies a latched command that is still fresh, and stops sending a stale one
+   * \return True if the command should be sent
+   */
+  template<class T>
+  bool take(Latched<T> & latched, SteadyClock::time_point now, const char * name, T & command);
+
+  MavlinkComm & comm_;
+  const Platform platform_;
+  const std::chrono::nanoseconds timeout_;
+
+  std::mutex mutex_; //!< guards the latched commands against the io thread
+  Latched<OffboardCommand> offboard_;
+  Latched<AuxCommand> aux_;
+
+  //! Declared last, so it stops before the rest of the scheduler is destroyed
+  std::unique_ptr<TimerInterface> timer_;
+};
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_COMMAND_SCHEDULER_H
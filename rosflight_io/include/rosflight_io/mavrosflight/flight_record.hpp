@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file flight_record.hpp
+ *
+ * File format of the rosflight_io flight recorder, and a reader for it. A recording is a directory
+ * of segment files. Each segment starts with a header and a table describing the record types,
+ * followed by chunks. A chunk holds up to FLIGHT_RECORD_CHUNK_ROWS rows of one record type, stored
+ * column by column, so each field of a message type is a contiguous array.
+ *
+ * This header does not depend on ROS or MAVLink.
+ */
+
+#ifndef MAVROSFLIGHT_FLIGHT_RECORD_H
+#define MAVROSFLIGHT_FLIGHT_RECORD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace mavrosflight
+{
+static constexpr char FLIGHT_RECORD_MAGIC[8] = {'R', 'F', 'R', 'E', 'C', 'O', 'R', 'D'};
+//! Must be incremented whenever the file layout changes
+static constexpr uint32_t FLIGHT_RECORD_VERSION = 1;
+static constexpr uint32_t FLIGHT_RECORD_CHUNK_MAGIC = 0x4b4e4843; // "CHNK"
+static constexpr uint32_t FLIGHT_RECORD_CHUNK_ROWS = 512;
+static constexpr size_t FLIGHT_RECORD_NAME_LEN = 32;
+static constexpr const char * FLIGHT_RECORD_EXTENSION = ".rfrec";
+
+enum class RecordColumnType : uint8_t
+{
+  UINT8,
+  UINT16,
+  UINT32,
+  UINT64,
+  INT16,
+  INT32,
+  INT64,
+  FLOAT32
+};
+
+size_t record_column_size(RecordColumnType type);
+
+struct RecordColumn
+{
+  std::string name;
+  RecordColumnType type;
+};
+
+/**
+ * \brief Description of one record type. Every record type starts with a recv_time_ns column
+ * holding the host time (CLOCK_REALTIME) at which the message was received.
+ */
+struct RecordSchema
+{
+  uint32_t msgid;
+  std::string name;
+  std::vector<RecordColumn> columns;
+
+  /**
+   * \brief Index of a column by name, or -1 if there is none
+   */
+  int column_index(const std::string & column_name) const;
+  size_t row_size() const;
+};
+
+/**
+ * \brief Fixed part of a segment header. It is followed by schema_count schema entries.
+ */
+struct FlightRecordHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t segment_index;
+  uint64_t used_bytes; //!< bytes of valid data, including this header; grows as chunks are added
+  int64_t start_time_ns;
+  uint32_t schema_count;
+  uint32_t data_offset; //!< offset of the first chunk
+  uint32_t chunk_rows;
+  uint32_t reserved[5];
+};
+
+struct FlightRecordSchemaEntry
+{
+  char name[FLIGHT_RECORD_NAME_LEN];
+  uint32_t msgid;
+  uint32_t column_count;
+};
+
+struct FlightRecordColumnEntry
+{
+  char name[FLIGHT_RECORD_NAME_LEN - 1];
+  uint8_t type;
+};
+
+/**
+ * \brief Header of a chunk. The payload that follows holds the columns of the chunk back to back,
+ * each with rows values, and is padded to a multiple of 8 bytes.
+ */
+struct FlightRecordChunkHeader
+{
+  uint32_t magic;
+  uint16_t schema;
+  uint16_t reserved;
+  uint32_t rows;
+  uint32_t payload_bytes;
+};
+
+static_assert(sizeof(FlightRecordHeader) == 64, "unexpected flight record header size");
+static_assert(sizeof(FlightRecordColumnEntry) == FLIGHT_RECORD_NAME_LEN,
+              "unexpected flight record column entry size");
+static_assert(sizeof(FlightRecordChunkHeader) == 16, "unexpected flight record chunk header size");
+
+/**
+ * \brief Reads the chunks of one segment file, which is mapped read-only
+ */
+class FlightRecordReader
+{
+public:
+  struct Chunk
+  {
+    const RecordSchema * schema = nullptr;
+    uint32_t rows = 0;
+    std::vector<const uint8_t *> columns;
+
+    /**
+     * \brief Value of a column at a row. T must match the column type.
+     */
+    template<typename T>
+    T get(size_t column, size_t row) const
+    {
+      T value;
+      memcpy(&value, columns[column] + row * sizeof(T), sizeof(T));
+      return value;
+    }
+
+    /**
+     * \brief Value of a column at a row converted to double, whatever the column type
+     */
+    double as_double(size_t column, size_t row) const;
+  };
+
+  FlightRecordReader() = default;
+  ~FlightRecordReader();
+  FlightRecordReader(const FlightRecordReader &) = delete;
+  FlightRecordReader & operator=(const FlightRecordReader &) = delete;
+
+  /**
+   * \brief Opens a segment file
+   * \param path Path to the segment
+   * \param error Set to a description of the problem if opening fails
+   */
+  bool open(const std::string & path, std::string & error);
+  void close();
+
+  const FlightRecordHeader & header() const { return *header_; }
+  const std::vector<RecordSchema> & schemas() const { return schemas_; }
+
+  /**
+   * \brief Reads the next chunk
+   * \return False at the end of the valid data
+   */
+  bool next(Chunk & chunk);
+
+  /**
+   * \brief Segment files of a recording directory, in recording order
+   */
+  static std::vector<std::string> segments(const std::string & directory);
+
+private:
+  int fd_ = -1;
+  const uint8_t * data_ = nullptr;
+  size_t mapped_size_ = 0;
+  size_t size_ = 0; //!< size of the valid data
+  const FlightRecordHeader * header_ = nullptr;
+  std::vector<RecordSchema> schemas_;
+  size_t offset_ = 0;
+};
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_FLIGHT_RECORD_H
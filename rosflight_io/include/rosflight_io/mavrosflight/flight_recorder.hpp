@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file flight_recorder.hpp
+ *
+ * Records decoded MAVLink messages into the columnar format described in flight_record.hpp. The
+ * listener callback only decodes the message and stores its fields into a preallocated chunk; full
+ * chunks are handed to a writer thread that copies them into memory-mapped, preallocated segment
+ * files. Nothing on the receive path allocates, locks per message, or makes a system call.
+ */
+
+#ifndef MAVROSFLIGHT_FLIGHT_RECORDER_H
+#define MAVROSFLIGHT_FLIGHT_RECORDER_H
+
+#include <rosflight_io/mavrosflight/flight_record.hpp>
+#include <rosflight_io/mavrosflight/mavlink_bridge.hpp>
+#include <rosflight_io/mavrosflight/mavlink_listener_interface.hpp>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mavrosflight
+{
+class FlightRecorder : public MavlinkListenerInterface
+{
+public:
+  //! Number of preallocated chunks per record type. Rows are dropped if the writer falls this far
+  //! behind.
+  static constexpr size_t CHUNKS_PER_TYPE = 8;
+
+  FlightRecorder();
+  ~FlightRecorder();
+
+  /**
+   * \brief Starts a recording
+   * \param directory Directory for the segment files; created if it does not exist
+   * \param segment_size Size each segment file is preallocated to, in bytes
+   * \param error Set to a description of the problem if the recording can't be started
+   */
+  bool open(const std::string & directory, size_t segment_size, std::string & error);
+
+  /**
+   * \brief Writes out partially filled chunks and closes the recording. Must not be called while
+   * handle_mavlink_message may be running, i.e. unregister the recorder or close the link first.
+   */
+  void close();
+
+  bool is_open() const { return open_; }
+  const std::string & directory() const { return directory_; }
+
+  /**
+   * \brief Records the message if it is of a recorded type. Called from the link's receive thread.
+   */
+  void handle_mavlink_message(const mavlink_message_t & msg) override;
+
+  uint64_t rows_recorded() const { return rows_recorded_.load(std::memory_order_relaxed); }
+  uint64_t rows_dropped() const { return rows_dropped_.load(std::memory_order_relaxed); }
+  uint64_t bytes_written() const { return bytes_written_.load(std::memory_order_relaxed); }
+
+  /**
+   * \brief Record types written by the recorder
+   */
+  static const std::vector<RecordSchema> & schemas();
+
+private:
+  struct Chunk
+  {
+    uint16_t schema;
+    uint32_t rows;
+    std::vector<uint8_t> data; //!< FLIGHT_RECORD_CHUNK_ROWS values per column, column by column
+  };
+
+  Chunk * acquire_chunk(size_t schema);
+  void submit_chunk(Chunk * chunk);
+
+  // writer thread
+  void writer_loop();
+  bool write_chunk(const Chunk & chunk);
+  bool open_segment(std::string & error);
+  void close_segment();
+
+  std::string directory_;
+  size_t segment_size_ = 0;
+  bool open_ = false;
+
+  std::array<int16_t, 256> schema_by_msgid_;
+  //! Offset of each column in a chunk buffer, per record type
+  std::vector<std::vector<size_t>> column_offsets_;
+
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+  std::vector<Chunk *> active_; //!< chunk being filled, per record type; receive thread only
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::vector<Chunk *>> free_; //!< per record type
+  std::deque<Chunk *> full_;
+  bool stop_ = false;
+  std::thread writer_thread_;
+
+  // Current segment, writer thread only once the recording is open
+  int fd_ = -1;
+  uint8_t * segment_ = nullptr;
+  size_t segment_used_ = 0;
+  uint32_t segment_index_ = 0;
+  int64_t start_time_ns_ = 0;
+
+  std::atomic<uint64_t> rows_recorded_{0};
+  std::atomic<uint64_t> rows_dropped_{0};
+  std::atomic<uint64_t> bytes_written_{0};
+};
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_FLIGHT_RECORDER_H
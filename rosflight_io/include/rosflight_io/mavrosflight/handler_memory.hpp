@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file handler_memory.hpp
+ *
+ * Fixed storage for the asio operations that are started on the hot paths. asio allocates every
+ * asynchronous operation, and only recycles one block per thread, and only for operations started
+ * on its own threads. An operation that has its own HandlerMemory never allocates, as long as only
+ * one is in flight at a time and it fits.
+ */
+
+#ifndef MAVROSFLIGHT_HANDLER_MEMORY_H
+#define MAVROSFLIGHT_HANDLER_MEMORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mavrosflight
+{
+/**
+ * \brief Storage for one asio operation at a time. Falls back to the heap if the storage is in use
+ * or too small, so it is always correct, just not always allocation free. The operation may be
+ * started and completed on different threads.
+ */
+class HandlerMemory
+{
+public:
+  HandlerMemory() = default;
+  HandlerMemory(const HandlerMemory &) = delete;
+  HandlerMemory & operator=(const HandlerMemory &) = delete;
+
+  void * allocate(std::size_t size)
+  {
+    if (size <= sizeof(storage_) && !in_use_.exchange(true, std::memory_order_acquire)) {
+      return &storage_;
+    }
+    return ::operator new(size);
+  }
+
+  void deallocate(void * pointer)
+  {
+    if (pointer == &storage_) {
+      in_use_.store(false, std::memory_order_release);
+    } else {
+      ::operator delete(pointer);
+    }
+  }
+
+private:
+  std::aligned_storage<512, alignof(std::max_align_t)>::type storage_;
+  std::atomic<bool> in_use_{false};
+};
+
+/**
+ * \brief Allocator over a HandlerMemory, which asio uses for the operations of a handler that is
+ * associated with it.
+ */
+template<typename T>
+class HandlerAllocator
+{
+public:
+  using value_type = T;
+
+  explicit HandlerAllocator(HandlerMemory & memory)
+      : memory_(memory)
+  {}
+
+  template<typename U>
+  HandlerAllocator(const HandlerAllocator<U> & other) noexcept
+      : memory_(other.memory_)
+  {}
+
+  bool operator==(const HandlerAllocator & other) const noexcept
+  {
+    return &memory_ == &other.memory_;
+  }
+  bool operator!=(const HandlerAllocator & other) const noexcept
+  {
+    return &memory_ != &other.memory_;
+  }
+
+  T * allocate(std::size_t n) const { return static_cast<T *>(memory_.allocate(sizeof(T) * n)); }
+  void deallocate(T * pointer, std::size_t /* n */) const { memory_.deallocate(pointer); }
+
+private:
+  template<typename>
+  friend class HandlerAllocator;
+
+  HandlerMemory & memory_;
+};
+
+/**
+ * \brief Handler whose operations are allocated from a HandlerMemory
+ */
+template<typename Handler>
+class CustomAllocHandler
+{
+public:
+  using allocator_type = HandlerAllocator<Handler>;
+
+  CustomAllocHandler(HandlerMemory & memory, Handler handler)
+      : memory_(memory)
+      , handler_(std::move(handler))
+  {}
+
+  allocator_type get_allocator() const noexcept { return allocator_type(memory_); }
+
+  template<typename... Args>
+  void operator()(Args &&... args)
+  {
+    handler_(std::forward<Args>(args)...);
+  }
+
+private:
+  HandlerMemory & memory_;
+  Handler handler_;
+};
+
+template<typename Handler>
+inline CustomAllocHandler<Handler> make_custom_alloc_handler(HandlerMemory & memory,
+                                                             Handler handler)
+{
+  return CustomAllocHandler<Handler>(memory, std::move(handler));
+}
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_HANDLER_MEMORY_H
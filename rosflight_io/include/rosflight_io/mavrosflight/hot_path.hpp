@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file hot_path.hpp
+ *
+ * Marks code that must not allocate once warmed up. The marker only sets a thread-local pointer;
+ * the allocation tracker linked into the check harnesses (see alloc_tracker.hpp) reads it to tell
+ * hot path allocations apart from the rest of the process.
+ */
+
+#ifndef MAVROSFLIGHT_HOT_PATH_H
+#define MAVROSFLIGHT_HOT_PATH_H
+
+namespace mavrosflight
+{
+/**
+ * \brief Marks the current thread as being on a hot path for the lifetime of the object. Nested
+ * markers take over until they go out of scope.
+ */
+class HotPath
+{
+public:
+  explicit HotPath(const char * name)
+      : previous_(current_)
+  {
+    current_ = name;
+  }
+  ~HotPath() { current_ = previous_; }
+
+  HotPath(const HotPath &) = delete;
+  HotPath & operator=(const HotPath &) = delete;
+
+  /**
+   * \brief Name of the innermost hot path the calling thread is on, or nullptr if none
+   */
+  static const char * current() { return current_; }
+
+private:
+  const char * previous_;
+  static inline thread_local const char * current_ = nullptr;
+};
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_HOT_PATH_H
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file live_stats.hpp
+ *
+ * Versioned shared-memory segment with live statistics from rosflight_io and the SIL plugin. Each
+ * process creates one segment per node under /dev/shm, named after the node, and updates it with
+ * relaxed atomics from its hot paths. Readers such as rosflight_top map it read-only, so the
+ * statistics stay available when DDS is overloaded.
+ *
+ * This header does not depend on ROS or MAVLink so that it can be used by any package.
+ */
+
+#ifndef MAVROSFLIGHT_LIVE_STATS_H
+#define MAVROSFLIGHT_LIVE_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mavrosflight
+{
+static constexpr uint32_t LIVE_STATS_MAGIC = 0x54534652; // "RFST"
+//! Must be incremented whenever the layout of LiveStatsSegment changes
+static constexpr uint32_t LIVE_STATS_VERSION = 1;
+static constexpr const char * LIVE_STATS_PREFIX = "rosflight_stats.";
+
+static constexpr size_t LIVE_STATS_NAME_LEN = 128;
+static constexpr size_t LIVE_STATS_NUM_MSG_IDS = 256;
+static constexpr size_t LIVE_STATS_HISTOGRAM_BUCKETS = 24;
+static constexpr size_t LIVE_STATS_SIL_STAGES = 6;
+//! Names of the SIL stages, in the order used by rosflight_sim::SILProfiler. The last is the step.
+static constexpr const char * LIVE_STATS_SIL_STAGE_NAMES[LIVE_STATS_SIL_STAGES] = {
+  "firmware", "sensors", "comm", "dynamics", "truth", "step"};
+
+enum LiveStatsKind : uint32_t
+{
+  LIVE_STATS_KIND_IO = 1,
+  LIVE_STATS_KIND_SIL = 2
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "live stats require lock-free 64-bit atomics to be shared between processes");
+
+/**
+ * \brief Histogram with power-of-two microsecond buckets. Bucket 0 counts durations below 1 us and
+ * bucket i counts durations in [2^(i-1), 2^i) us. The last bucket also counts anything longer.
+ */
+struct LiveStatsHistogram
+{
+  std::atomic<uint64_t> buckets[LIVE_STATS_HISTOGRAM_BUCKETS];
+
+  void record(int64_t duration_ns);
+  /**
+   * \brief Upper bound of the bucket containing the given percentile
+   * \param counts Bucket counts, usually the difference of two snapshots
+   * \param percentile Percentile in [0, 1]
+   * \return Duration in microseconds, or 0 if the histogram is empty
+   */
+  static double percentile_us(const uint64_t (&counts)[LIVE_STATS_HISTOGRAM_BUCKETS],
+                              double percentile);
+};
+
+/**
+ * \brief Layout of the shared-memory segment. Only ever append fields and bump LIVE_STATS_VERSION.
+ * Counters are monotonic; readers compute rates from the difference between two snapshots.
+ */
+struct LiveStatsSegment
+{
+  // Header, written once before ready is set
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;
+  uint32_t kind;
+  int32_t pid;
+  char name[LIVE_STATS_NAME_LEN];
+  std::atomic<uint32_t> ready;
+  std::atomic<int64_t> last_update_ns; //!< CLOCK_MONOTONIC time of the last update
+
+  // Link
+  std::atomic<uint64_t> rx_bytes;
+  std::atomic<uint64_t> rx_frames;
+  std::atomic<uint64_t> rx_dropped; //!< frames dropped by the parser (bad CRC or framing)
+  std::atomic<uint64_t> rx_lost;    //!< frames lost on the link, from sequence number gaps
+  std::atomic<uint64_t> tx_bytes;
+  std::atomic<uint64_t> tx_frames;
+  std::atomic<uint64_t> tx_errors;
+  std::atomic<uint32_t> write_queue_depth;
+  std::atomic<uint32_t> write_queue_max;
+  std::atomic<uint64_t> rx_msg_count[LIVE_STATS_NUM_MSG_IDS];
+  LiveStatsHistogram dispatch_time; //!< time to dispatch a decoded frame to all listeners
+
+  // Time synchronization
+  std::atomic<uint32_t> time_sync_initialized;
+  std::atomic<int64_t> time_offset_ns;
+  std::atomic<int64_t> time_sync_rtt_ns;
+
+  // Parameters
+  std::atomic<int32_t> params_total;
+  std::atomic<int32_t> params_received;
+  std::atomic<uint32_t> params_unsaved;
+  std::atomic<uint32_t> param_set_queue_depth;
+
+  // SIL
+  std::atomic<uint64_t> sil_steps;
+  std::atomic<int64_t> sil_real_time_factor_ppm;
+  std::atomic<int64_t> sil_stage_p50_ns[LIVE_STATS_SIL_STAGES];
+  std::atomic<int64_t> sil_stage_p99_ns[LIVE_STATS_SIL_STAGES];
+  std::atomic<int64_t> sil_stage_max_ns[LIVE_STATS_SIL_STAGES];
+  LiveStatsHistogram sil_step_time;
+};
+
+/**
+ * \brief Owner of a live statistics segment. Creates the segment on open() and removes it when
+ * destroyed.
+ */
+class LiveStats
+{
+public:
+  LiveStats() = default;
+  ~LiveStats();
+  LiveStats(const LiveStats &) = delete;
+  LiveStats & operator=(const LiveStats &) = delete;
+
+  /**
+   * \brief Creates (or recreates) the segment for a node
+   * \param node_name Fully qualified name of the node that owns the segment
+   * \param kind Which sections of the segment the owner fills in
+   * \return True if the segment was created
+   */
+  bool open(const std::string & node_name, LiveStatsKind kind);
+
+  /**
+   * \brief Segment to update, or nullptr if open() was not called or failed
+   */
+  LiveStatsSegment * segment() const { return segment_; }
+
+  /**
+   * \brief Shared memory object name for a node, e.g. "/rosflight_stats.fixedwing.rosflight_io"
+   */
+  static std::string segment_name(const std::string & node_name);
+
+  /**
+   * \brief CLOCK_MONOTONIC time in nanoseconds, for last_update_ns
+   */
+  static int64_t now_ns();
+
+private:
+  LiveStatsSegment * segment_ = nullptr;
+  std::string shm_name_;
+};
+
+/**
+ * \brief Read-only view of a segment owned by another process
+ */
+class LiveStatsReader
+{
+public:
+  LiveStatsReader() = default;
+  ~LiveStatsReader();
+  LiveStatsReader(const LiveStatsReader &) = delete;
+  LiveStatsReader & operator=(const LiveStatsReader &) = delete;
+
+  /**
+   * \brief Maps a segment read-only and checks its magic number, version and size
+   * \param shm_name Shared memory object name, as returned by list()
+   * \param error Set to a description of the problem if the segment can't be used
+   * \return True if the segment is mapped and compatible
+   */
+  bool attach(const std::string & shm_name, std::string * error);
+
+  const LiveStatsSegment * segment() const { return segment_; }
+
+  /**
+   * \brief True if the process that owns the segment is still running
+   */
+  bool owner_alive() const;
+
+  /**
+   * \brief Names of all live statistics segments on this machine
+   */
+  static std::vector<std::string> list();
+
+private:
+  const LiveStatsSegment * segment_ = nullptr;
+  size_t mapped_size_ = 0;
+};
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_LIVE_STATS_H
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file loopback_pipe.hpp
+ *
+ * In-memory byte pipe between a flight controller and a ground station in the same process. The
+ * firmware side uses the fcu_* methods from its serial driver; the ground station side is used by
+ * MavlinkLoopback. This header does not depend on MAVLink, so it can be included next to the
+ * firmware's own MAVLink headers.
+ *
+ * Each direction is a fixed-size ring allocated up front, so writes and reads never allocate. Like
+ * a UART, bytes that do not fit are dropped and counted.
+ */
+
+#ifndef MAVROSFLIGHT_LOOPBACK_PIPE_H
+#define MAVROSFLIGHT_LOOPBACK_PIPE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace mavrosflight
+{
+class LoopbackPipe
+{
+public:
+  static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+  /**
+   * \brief Creates an empty pipe
+   * \param capacity Number of bytes each direction can hold before dropping writes
+   */
+  explicit LoopbackPipe(size_t capacity = DEFAULT_CAPACITY)
+      : to_gcs_(capacity)
+      , to_fcu_(capacity)
+  {}
+
+  /**
+   * \brief Queues bytes written by the flight controller for the ground station
+   */
+  void fcu_write(const uint8_t * src, size_t len)
+  {
+    std::function<void()> callback;
+    size_t written;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      written = to_gcs_.push(src, len);
+      callback = gcs_data_callback_;
+    }
+    bytes_to_gcs_.fetch_add(written, std::memory_order_relaxed);
+    bytes_dropped_.fetch_add(len - written, std::memory_order_relaxed);
+    if (callback) {
+      callback();
+    }
+  }
+
+  /**
+   * \brief Number of bytes from the ground station waiting to be read by the flight controller
+   */
+  size_t fcu_bytes_available()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return to_fcu_.size();
+  }
+
+  /**
+   * \brief Reads up to len bytes sent by the ground station
+   * \return Number of bytes read
+   */
+  size_t fcu_read(uint8_t * dest, size_t len)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return to_fcu_.pop(dest, len);
+  }
+
+  /**
+   * \brief Queues bytes written by the ground station for the flight controller
+   */
+  void gcs_write(const uint8_t * src, size_t len)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t written = to_fcu_.push(src, len);
+    bytes_to_fcu_.fetch_add(written, std::memory_order_relaxed);
+    bytes_dropped_.fetch_add(len - written, std::memory_order_relaxed);
+  }
+
+  /**
+   * \brief Reads up to len bytes sent by the flight controller
+   * \return Number of bytes read
+   */
+  size_t gcs_read(uint8_t * dest, size_t len)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return to_gcs_.pop(dest, len);
+  }
+
+  /**
+   * \brief Sets a function called, from the flight controller's thread, whenever it writes data
+   */
+  void set_gcs_data_callback(std::function<void()> callback)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    gcs_data_callback_ = std::move(callback);
+  }
+
+  uint64_t bytes_to_gcs() const { return bytes_to_gcs_.load(std::memory_order_relaxed); }
+  uint64_t bytes_to_fcu() const { return bytes_to_fcu_.load(std::memory_order_relaxed); }
+  //! Bytes dropped in either direction because the reader fell behind
+  uint64_t bytes_dropped() const { return bytes_dropped_.load(std::memory_order_relaxed); }
+
+private:
+  /**
+   * \brief Fixed-capacity byte queue
+   */
+  class ByteRing
+  {
+  public:
+    explicit ByteRing(size_t capacity)
+        : data_(std::max<size_t>(capacity, 1))
+    {}
+
+    size_t size() const { return size_; }
+
+    /**
+     * \return Number of bytes queued, less than len if the ring is full
+     */
+    size_t push(const uint8_t * src, size_t len)
+    {
+      size_t n = std::min(len, data_.size() - size_);
+      size_t tail = (head_ + size_) % data_.size();
+      size_t first = std::min(n, data_.size() - tail);
+      std::copy(src, src + first, data_.begin() + (long) tail);
+      std::copy(src + first, src + n, data_.begin());
+      size_ += n;
+      return n;
+    }
+
+    size_t pop(uint8_t * dest, size_t len)
+    {
+      size_t n = std::min(len, size_);
+      size_t first = std::min(n, data_.size() - head_);
+      std::copy(data_.begin() + (long) head_, data_.begin() + (long) (head_ + first), dest);
+      std::copy(data_.begin(), data_.begin() + (long) (n - first), dest + first);
+      head_ = (head_ + n) % data_.size();
+      size_ -= n;
+      return n;
+    }
+
+  private:
+    std::vector<uint8_t> data_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+  };
+
+  std::mutex mutex_;
+  ByteRing to_gcs_;
+  ByteRing to_fcu_;
+  std::function<void()> gcs_data_callback_;
+  std::atomic<uint64_t> bytes_to_gcs_{0};
+  std::atomic<uint64_t> bytes_to_fcu_{0};
+  std::atomic<uint64_t> bytes_dropped_{0};
+};
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_LOOPBACK_PIPE_H
@@ -37,16 +37,22 @@
 #ifndef MAVROSFLIGHT_MAVLINK_COMM_H
 #define MAVROSFLIGHT_MAVLINK_COMM_H
 
+#include <rosflight_io/mavrosflight/asio_platform.hpp>
+#include <rosflight_io/mavrosflight/handler_memory.hpp>
+#include <rosflight_io/mavrosflight/live_stats.hpp>
 #include <rosflight_io/mavrosflight/mavlink_bridge.hpp>
 #include <rosflight_io/mavrosflight/mavlink_listener_interface.hpp>
+#include <rosflight_io/mavrosflight/message_dispatch.hpp>
 
 #include <boost/asio.hpp>
 #include <boost/function.hpp>
 #include <boost/thread.hpp>
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <iostream>
-#include <list>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -79,36 +85,137 @@ public:
    */
   void close();
 
+  /**
+   * \brief Whether the link closed itself after a read or write error since it was opened. The
+   * owner still has to close() it.
+   */
+  bool failed() const { return failed_; }
+
   /**
    * \brief Register a listener for mavlink messages
+   *
+   * Listeners and subscribers are called on the io thread with the listener lock held, so neither
+   * this nor the other methods that add or remove them may be called from a listener or subscriber.
+   * Doing so throws std::logic_error instead of deadlocking.
+   *
    * \param listener Pointer to an object that implements the MavlinkListenerInterface interface
    */
   void register_mavlink_listener(MavlinkListenerInterface * listener);
 
   /**
-   * \brief Unregister a listener for mavlink messages
+   * \brief Unregister a listener for mavlink messages. Must not be called from a subscriber or
+   * listener.
    * \param listener Pointer to an object that implements the MavlinkListenerInterface interface
    */
   void unregister_mavlink_listener(MavlinkListenerInterface * listener);
 
   /**
-   * \brief Send a mavlink message
+   * \brief Subscribe a member function to a message, e.g.
+   * comm.subscribe<&ROSflightIO::handle_small_imu_msg>(this). The message is given by the type of
+   * the handler's argument, and the handler is called directly.
+   *
+   * Subscribers of a message are called in the order they subscribed, after the listeners. Must
+   * not be called from a subscriber or listener.
+   *
+   * \param subscriber Object to call the handler on
+   * \throws std::logic_error if called from a subscriber or listener of this link
+   */
+  template<auto Handler, class C>
+  void subscribe(C * subscriber)
+  {
+    using Message = typename MessageHandlerTraits<decltype(Handler)>::Message;
+    boost::unique_lock<boost::mutex> lock = lock_listeners_for_change();
+    dispatcher<Message>().subscribe(
+      static_cast<typename MessageHandlerTraits<decltype(Handler)>::Class *>(subscriber),
+      &MessageDispatcher<Message>::template call_member<Handler>);
+  }
+
+  /**
+   * \brief Subscribe a callback to a message, e.g.
+   * comm.subscribe<mavlink_small_imu_t>(this, callback). Must not be called from a subscriber or
+   * listener.
+   * \param subscriber Owner of the subscription, used to unsubscribe
+   * \param callback Called with each message
+   * \throws std::logic_error if called from a subscriber or listener of this link
+   */
+  template<class T>
+  void subscribe(const void * subscriber, std::function<void(const T &)> callback)
+  {
+    boost::unique_lock<boost::mutex> lock = lock_listeners_for_change();
+    dispatcher<T>().subscribe(subscriber, std::move(callback));
+  }
+
+  /**
+   * \brief Remove every message subscription of a subscriber. Must not be called from a subscriber
+   * or listener.
+   */
+  void unsubscribe(const void * subscriber);
+
+  /**
+   * \brief Send a mavlink message. The message is queued and written from the io thread. If
+   * WRITE_QUEUE_SIZE messages are already waiting, it is dropped and counted as a tx error.
    * \param msg The message to send
    */
   void send_message(const mavlink_message_t & msg);
 
+  static constexpr size_t WRITE_QUEUE_SIZE = 256;
+
+  /**
+   * \brief Create a timer whose callback runs on the link's io thread, between reads and writes,
+   * so a message sent from it goes out without waiting on another thread. Destroy the timer before
+   * the link.
+   */
+  std::unique_ptr<TimerInterface> create_link_timer(std::chrono::nanoseconds period,
+                                                    std::function<void()> callback)
+  {
+    return link_timers_.create_wall_timer(period, std::move(callback));
+  }
+
+  /**
+   * \brief Run the io thread with the SCHED_FIFO real-time policy. Must be called after open()
+   * \param priority Real-time priority, from 1 (lowest) to 99
+   * \return False if the priority could not be set, e.g. without CAP_SYS_NICE
+   */
+  bool set_io_thread_priority(int priority);
+
+  /**
+   * \brief Set the shared-memory statistics segment updated by this link
+   * \param stats Segment to update, or nullptr to stop updating statistics. Must be set before open()
+   */
+  void set_live_stats(LiveStatsSegment * stats) { stats_ = stats; }
+
+  /**
+   * \brief Shared-memory statistics segment for this link, or nullptr if there is none
+   */
+  LiveStatsSegment * live_stats() const { return stats_; }
+
 protected:
   virtual bool is_open() = 0;
   virtual void do_open() = 0;
   virtual void do_close() = 0;
+  /**
+   * \brief Start reading. Only one read is in flight at a time; implementations allocate the
+   * operation from read_memory_, with make_custom_alloc_handler, so steady-state reads do not
+   * allocate.
+   */
   virtual void
   do_async_read(const boost::asio::mutable_buffers_1 & buffer,
                 boost::function<void(const boost::system::error_code &, size_t)> handler) = 0;
+  /**
+   * \brief Start writing. Only called on the io thread, with one write in flight at a time;
+   * implementations allocate the operation from write_memory_.
+   */
   virtual void
   do_async_write(const boost::asio::const_buffers_1 & buffer,
                  boost::function<void(const boost::system::error_code &, size_t)> handler) = 0;
 
+  // Declared before io_service_, which may still hold operations using them when it is destroyed
+  HandlerMemory read_memory_;       //!< storage for the read operation
+  HandlerMemory write_memory_;      //!< storage for the write operation
+  HandlerMemory write_kick_memory_; //!< storage for handing a new write to the io thread
+
   boost::asio::io_service io_service_; //!< boost io service provider
+  AsioTimerFactory link_timers_;       //!< timers on io_service_
 
 private:
   //===========================================================================
@@ -151,6 +258,12 @@ private:
   // methods
   //===========================================================================
 
+  /**
+   * \brief Stops the link after a read or write error. Called on the io thread, so unlike close()
+   * it doesn't wait for the io thread.
+   */
+  void fail(const boost::system::error_code & error);
+
   /**
    * \brief Initiate an asynchronous read operation
    */
@@ -164,10 +277,10 @@ private:
   void async_read_end(const boost::system::error_code & error, size_t bytes_transferred);
 
   /**
-   * \brief Initialize an asynchronous write operation
-   * \param check_write_state If true, only start another write operation if a write sequence is not already running
+   * \brief Write the buffer at the head of the queue. Only runs on the io thread, while
+   * write_in_progress_ is set.
    */
-  void async_write(bool check_write_state);
+  void async_write();
 
   /**
    * \brief Handler for end of asynchronous write operation
@@ -176,11 +289,43 @@ private:
    */
   void async_write_end(const boost::system::error_code & error, size_t bytes_transferred);
 
+  /**
+   * \brief Update the live statistics for a received frame
+   * \param msg The decoded frame
+   * \param dispatch_time_ns Time taken to pass the frame to all listeners
+   */
+  void update_rx_stats(const mavlink_message_t & msg, int64_t dispatch_time_ns);
+
+  /**
+   * \brief Locks listeners_mutex_ to add or remove listeners or subscribers
+   * \throws std::logic_error if this thread is dispatching a message of this link, which holds the
+   * lock already
+   */
+  boost::unique_lock<boost::mutex> lock_listeners_for_change();
+
+  /**
+   * \brief Dispatcher of a message, created on first use. listeners_mutex_ must be held.
+   */
+  template<class T>
+  MessageDispatcher<T> & dispatcher()
+  {
+    std::unique_ptr<MessageDispatcherBase> & dispatcher = dispatchers_[MessageTraits<T>::ID];
+    if (dispatcher == nullptr) {
+      dispatcher = std::make_unique<MessageDispatcher<T>>();
+    }
+    return static_cast<MessageDispatcher<T> &>(*dispatcher);
+  }
+
   //===========================================================================
   // member variables
   //===========================================================================
 
   std::vector<MavlinkListenerInterface *> listeners_; //!< listeners for mavlink messages
+  //! typed subscribers for mavlink messages, by message ID
+  std::array<std::unique_ptr<MessageDispatcherBase>, MAVLINK_NUM_MSG_IDS> dispatchers_;
+  boost::mutex listeners_mutex_; //!< guards the listeners and subscribers against the io thread
+  //! Link whose messages the calling thread is dispatching, if any
+  static inline thread_local const MavlinkComm * dispatching_ = nullptr;
 
   boost::thread io_thread_;      //!< thread on which the io service runs
   boost::recursive_mutex mutex_; //!< mutex for threadsafe operation
@@ -190,8 +335,14 @@ private:
   mavlink_message_t msg_in_;
   mavlink_status_t status_in_;
 
-  std::list<WriteBuffer *> write_queue_; //!< queue of buffers to be written to the serial port
-  bool write_in_progress_;               //!< flag for whether async_write is already running
+  std::array<WriteBuffer, WRITE_QUEUE_SIZE> write_queue_; //!< ring of buffers to be written
+  size_t write_queue_head_ = 0;  //!< buffer being written
+  size_t write_queue_count_ = 0; //!< number of buffers queued, including the one being written
+  bool write_in_progress_;       //!< whether the io thread is writing, or about to
+  std::atomic<bool> failed_;     //!< see failed()
+
+  LiveStatsSegment * stats_ = nullptr; //!< live statistics, if enabled
+  int16_t last_seq_[256];              //!< last sequence number received from each system id
 };
 
 } // namespace mavrosflight
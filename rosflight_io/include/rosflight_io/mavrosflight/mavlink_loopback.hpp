@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file mavlink_loopback.hpp
+ *
+ * MAVLink over an in-memory LoopbackPipe, for running rosflight_io against a firmware instance in
+ * the same process without a serial port or socket.
+ */
+
+#ifndef MAVROSFLIGHT_MAVLINK_LOOPBACK_H
+#define MAVROSFLIGHT_MAVLINK_LOOPBACK_H
+
+#include <rosflight_io/mavrosflight/loopback_pipe.hpp>
+#include <rosflight_io/mavrosflight/mavlink_comm.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/function.hpp>
+
+#include <atomic>
+#include <memory>
+
+namespace mavrosflight
+{
+class MavlinkLoopback : public MavlinkComm
+{
+public:
+  /**
+   * \brief Instantiates the class on the ground station side of a pipe
+   * \param pipe Pipe shared with the flight controller, which must outlive this object
+   */
+  explicit MavlinkLoopback(LoopbackPipe & pipe);
+
+  /**
+   * \brief Stops communication before the object is destroyed
+   */
+  ~MavlinkLoopback() override;
+
+private:
+  //===========================================================================
+  // methods
+  //===========================================================================
+
+  bool is_open() override;
+  void do_open() override;
+  void do_close() override;
+
+  void
+  do_async_read(const boost::asio::mutable_buffers_1 & buffer,
+                boost::function<void(const boost::system::error_code &, size_t)> handler) override;
+
+  void
+  do_async_write(const boost::asio::const_buffers_1 & buffer,
+                 boost::function<void(const boost::system::error_code &, size_t)> handler) override;
+
+  /**
+   * \brief Schedules try_complete_read() on the io thread, unless it is already scheduled. Called
+   * from both the flight controller's thread and the io thread. Since at most one is pending, it
+   * always fits in read_memory_ and never allocates.
+   */
+  void wake_read();
+
+  /**
+   * \brief Completes the pending read if the flight controller has written anything. Only runs on
+   * the io_service thread.
+   */
+  void try_complete_read();
+
+  //===========================================================================
+  // member variables
+  //===========================================================================
+
+  LoopbackPipe & pipe_;
+  bool open_;
+
+  //! Keeps io_service::run() from returning while no read is ready
+  std::unique_ptr<boost::asio::io_service::work> work_;
+
+  boost::asio::mutable_buffers_1 read_buffer_;
+  boost::function<void(const boost::system::error_code &, size_t)> read_handler_;
+  std::atomic<bool> read_wake_pending_{false}; //!< whether try_complete_read() is scheduled
+};
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_MAVLINK_LOOPBACK_H
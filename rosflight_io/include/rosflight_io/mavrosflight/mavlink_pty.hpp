@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file mavlink_pty.hpp
+ *
+ * MAVLink over the master side of a pseudo-terminal, for programs that stand in for a flight
+ * controller. rosflight_io connects to the slave side as if it were a serial port.
+ */
+
+#ifndef MAVROSFLIGHT_MAVLINK_PTY_H
+#define MAVROSFLIGHT_MAVLINK_PTY_H
+
+#include <rosflight_io/mavrosflight/mavlink_comm.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/function.hpp>
+
+#include <string>
+
+namespace mavrosflight
+{
+class MavlinkPty : public MavlinkComm
+{
+public:
+  /**
+   * \brief Instantiates the class. The pseudo-terminal is created by open().
+   */
+  MavlinkPty();
+
+  /**
+   * \brief Stops communication and closes the pseudo-terminal before the object is destroyed
+   */
+  ~MavlinkPty() override;
+
+  /**
+   * \brief Path of the slave side of the pseudo-terminal (e.g. "/dev/pts/3"), once open
+   */
+  const std::string & slave_name() const { return slave_name_; }
+
+private:
+  //===========================================================================
+  // methods
+  //===========================================================================
+
+  bool is_open() override;
+  void do_open() override;
+  void do_close() override;
+
+  void
+  do_async_read(const boost::asio::mutable_buffers_1 & buffer,
+                boost::function<void(const boost::system::error_code &, size_t)> handler) override;
+
+  void
+  do_async_write(const boost::asio::const_buffers_1 & buffer,
+                 boost::function<void(const boost::system::error_code &, size_t)> handler) override;
+
+  //===========================================================================
+  // member variables
+  //===========================================================================
+
+  boost::asio::posix::stream_descriptor master_; //!< master side of the pseudo-terminal
+
+  //! The slave side is kept open so the master doesn't report EIO while no one is connected
+  int slave_fd_;
+  std::string slave_name_;
+};
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_MAVLINK_PTY_H
@@ -40,13 +40,12 @@
 #include <rosflight_io/mavrosflight/mavlink_bridge.hpp>
 #include <rosflight_io/mavrosflight/mavlink_comm.hpp>
 #include <rosflight_io/mavrosflight/param_manager.hpp>
+#include <rosflight_io/mavrosflight/platform.hpp>
 #include <rosflight_io/mavrosflight/time_manager.hpp>
 
 #include <rosflight_io/mavrosflight/mavlink_listener_interface.hpp>
 #include <rosflight_io/mavrosflight/param_listener_interface.hpp>
 
-#include <rclcpp/rclcpp.hpp>
-
 #include <boost/function.hpp>
 
 #include <cstdint>
@@ -60,9 +59,11 @@ public:
   /**
    * \brief Instantiates the class and begins communication on the specified serial port
    * \param mavlink_comm Reference to a MavlinkComm object (serial or UDP)
+   * \param platform Clock, timers and logger to run on, e.g. make_ros_platform(node) or
+   * make_asio_platform()
    * \param baud_rate Serial communication baud rate
    */
-  MavROSflight(MavlinkComm & mavlink_comm, rclcpp::Node * node);
+  MavROSflight(MavlinkComm & mavlink_comm, const Platform & platform);
 
   /**
    * \brief Stops communication and closes the serial port before the object is destroyed
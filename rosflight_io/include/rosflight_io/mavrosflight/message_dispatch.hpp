@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file message_dispatch.hpp
+ *
+ * Typed dispatch of MAVLink messages. Subscribers register for a message struct, e.g.
+ * mavlink_small_imu_t, and receive a const reference to it. Each frame is decoded once, into a
+ * struct owned by the dispatcher for its message ID, however many subscribers there are. Handlers
+ * given as member function template arguments are called directly, without type erasure.
+ */
+
+#ifndef MAVROSFLIGHT_MESSAGE_DISPATCH_H
+#define MAVROSFLIGHT_MESSAGE_DISPATCH_H
+
+#include <rosflight_io/mavrosflight/mavlink_bridge.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace mavrosflight
+{
+//! Number of MAVLink 1 message IDs
+constexpr size_t MAVLINK_NUM_MSG_IDS = 256;
+
+/**
+ * \brief Maps a MAVLink message struct to its message ID and decode function
+ */
+template<class T>
+struct MessageTraits;
+
+#define MAVROSFLIGHT_MESSAGE_TRAITS(name, NAME)                                                   \
+  template<>                                                                                      \
+  struct MessageTraits<mavlink_##name##_t>                                                        \
+  {                                                                                               \
+    static constexpr uint32_t ID = MAVLINK_MSG_ID_##NAME;                                         \
+    static void decode(const mavlink_message_t & msg, mavlink_##name##_t & out)                   \
+    {                                                                                             \
+      mavlink_msg_##name##_decode(&msg, &out);                                                    \
+    }                                                                                             \
+  };
+
+MAVROSFLIGHT_MESSAGE_TRAITS(attitude_quaternion, ATTITUDE_QUATERNION)
+MAVROSFLIGHT_MESSAGE_TRAITS(diff_pressure, DIFF_PRESSURE)
+MAVROSFLIGHT_MESSAGE_TRAITS(heartbeat, HEARTBEAT)
+MAVROSFLIGHT_MESSAGE_TRAITS(named_command_struct, NAMED_COMMAND_STRUCT)
+MAVROSFLIGHT_MESSAGE_TRAITS(named_value_float, NAMED_VALUE_FLOAT)
+MAVROSFLIGHT_MESSAGE_TRAITS(named_value_int, NAMED_VALUE_INT)
+MAVROSFLIGHT_MESSAGE_TRAITS(param_value, PARAM_VALUE)
+MAVROSFLIGHT_MESSAGE_TRAITS(rc_channels, RC_CHANNELS)
+MAVROSFLIGHT_MESSAGE_TRAITS(rosflight_battery_status, ROSFLIGHT_BATTERY_STATUS)
+MAVROSFLIGHT_MESSAGE_TRAITS(rosflight_cmd_ack, ROSFLIGHT_CMD_ACK)
+MAVROSFLIGHT_MESSAGE_TRAITS(rosflight_gnss, ROSFLIGHT_GNSS)
+MAVROSFLIGHT_MESSAGE_TRAITS(rosflight_gnss_full, ROSFLIGHT_GNSS_FULL)
+MAVROSFLIGHT_MESSAGE_TRAITS(rosflight_hard_error, ROSFLIGHT_HARD_ERROR)
+MAVROSFLIGHT_MESSAGE_TRAITS(rosflight_output_raw, ROSFLIGHT_OUTPUT_RAW)
+MAVROSFLIGHT_MESSAGE_TRAITS(rosflight_status, ROSFLIGHT_STATUS)
+MAVROSFLIGHT_MESSAGE_TRAITS(rosflight_version, ROSFLIGHT_VERSION)
+MAVROSFLIGHT_MESSAGE_TRAITS(small_baro, SMALL_BARO)
+MAVROSFLIGHT_MESSAGE_TRAITS(small_imu, SMALL_IMU)
+MAVROSFLIGHT_MESSAGE_TRAITS(small_mag, SMALL_MAG)
+MAVROSFLIGHT_MESSAGE_TRAITS(small_range, SMALL_RANGE)
+MAVROSFLIGHT_MESSAGE_TRAITS(statustext, STATUSTEXT)
+MAVROSFLIGHT_MESSAGE_TRAITS(timesync, TIMESYNC)
+
+/**
+ * \brief Splits a message handler member function pointer into its class and message struct
+ */
+template<class HandlerT>
+struct MessageHandlerTraits;
+
+template<class C, class T>
+struct MessageHandlerTraits<void (C::*)(const T &)>
+{
+  using Class = C;
+  using Message = T;
+};
+
+/**
+ * \brief Dispatches the frames of one message ID
+ */
+class MessageDispatcherBase
+{
+public:
+  virtual ~MessageDispatcherBase() = default;
+
+  /**
+   * \brief Decodes the frame and passes it to every subscriber
+   */
+  virtual void dispatch(const mavlink_message_t & msg) = 0;
+
+  /**
+   * \brief Removes every subscription of a subscriber
+   */
+  virtual void unsubscribe(const void * subscriber) = 0;
+};
+
+template<class T>
+class MessageDispatcher : public MessageDispatcherBase
+{
+public:
+  using Callback = std::function<void(const T &)>;
+
+  /**
+   * \brief Calls a member function handler, bound at compile time, on the subscriber
+   */
+  template<auto Handler>
+  static void call_member(void * subscriber, const T & msg)
+  {
+    using Class = typename MessageHandlerTraits<decltype(Handler)>::Class;
+    (static_cast<Class *>(subscriber)->*Handler)(msg);
+  }
+
+  void subscribe(void * subscriber, void (*thunk)(void *, const T &))
+  {
+    subscribers_.push_back({subscriber, thunk, nullptr});
+  }
+
+  void subscribe(const void * subscriber, Callback callback)
+  {
+    subscribers_.push_back({const_cast<void *>(subscriber), nullptr, std::move(callback)});
+  }
+
+  void unsubscribe(const void * subscriber) override
+  {
+    subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(),
+                                      [subscriber](const Subscriber & s) {
+                                        return s.subscriber == subscriber;
+                                      }),
+                       subscribers_.end());
+  }
+
+  void dispatch(const mavlink_message_t & msg) override
+  {
+    if (subscribers_.empty()) {
+      return;
+    }
+
+    MessageTraits<T>::decode(msg, decoded_);
+    for (const Subscriber & s : subscribers_) {
+      if (s.thunk != nullptr) {
+        s.thunk(s.subscriber, decoded_);
+      } else {
+        s.callback(decoded_);
+      }
+    }
+  }
+
+private:
+  struct Subscriber
+  {
+    void * subscriber;
+    void (*thunk)(void *, const T &); //!< Member function handler, or nullptr to use callback
+    Callback callback;
+  };
+
+  std::vector<Subscriber> subscribers_;
+  //! The latest frame, decoded. MAVLink orders fields by size, so aligning the struct to the
+  //! largest field aligns every field.
+  alignas(8) T decoded_{};
+};
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_MESSAGE_DISPATCH_H
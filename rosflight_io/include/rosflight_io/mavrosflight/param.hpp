@@ -56,9 +56,12 @@ public:
   MAV_PARAM_TYPE getType() const;
   double getValue() const;
 
-  void requestSet(double value, mavlink_message_t * msg);
+  bool requestSet(double value, mavlink_message_t * msg);
   bool handleUpdate(const mavlink_param_value_t & msg);
 
+  bool isSetInProgress() const;
+  void packPendingSet(mavlink_message_t * msg) const;
+
 private:
   void init(std::string name, int index, MAV_PARAM_TYPE type, float raw_value);
 
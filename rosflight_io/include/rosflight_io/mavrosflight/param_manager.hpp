@@ -39,31 +39,43 @@
 
 #include <rosflight_io/mavrosflight/mavlink_bridge.hpp>
 #include <rosflight_io/mavrosflight/mavlink_comm.hpp>
-#include <rosflight_io/mavrosflight/mavlink_listener_interface.hpp>
 #include <rosflight_io/mavrosflight/param.hpp>
 #include <rosflight_io/mavrosflight/param_listener_interface.hpp>
-
-#include <rclcpp/rclcpp.hpp>
+#include <rosflight_io/mavrosflight/platform.hpp>
 
 #include <deque>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace mavrosflight
 {
-class ParamManager : public MavlinkListenerInterface
+/**
+ * \brief Mirror of the firmware parameters. Thread safe: the parameter messages arrive on the io
+ * thread, while the public methods and the param set timer are called from other threads.
+ * Listeners are called without the manager locked, so they may call back into it.
+ */
+class ParamManager
 {
 public:
-  ParamManager(MavlinkComm * comm, rclcpp::Node * node);
+  ParamManager(MavlinkComm * comm, const Platform & platform);
   ~ParamManager();
 
-  void handle_mavlink_message(const mavlink_message_t & msg) override;
-
   bool unsaved_changes() const;
 
   bool get_param_value(const std::string & name, double * value);
+  /**
+   * \brief Copies a parameter, including its index and type
+   * \return False if the parameter has not been received
+   */
+  bool get_param(const std::string & name, Param * param) const;
+  /**
+   * \brief Whether the parameter has been received
+   */
+  bool is_param_id(const std::string & name) const;
   bool set_param_value(const std::string & name, double value);
   bool write_params();
 
@@ -79,20 +91,46 @@ public:
 
   void request_params();
 
+  /**
+   * \brief Whether any param set has not been confirmed by the firmware yet.
+   */
+  bool param_sets_pending() const;
+  /**
+   * \brief Queues the param sets again that have been sent but not confirmed, e.g. after a lost
+   * PARAM_SET or PARAM_VALUE. Does nothing while the queue is still being sent.
+   */
+  void resend_pending_param_sets();
+
 private:
   void request_param_list();
   void request_param(int index);
 
-  void handle_param_value_msg(const mavlink_message_t & msg);
-  void handle_command_ack_msg(const mavlink_message_t & msg);
+  // The following need mutex_ held
+  bool set_param_value_locked(const std::string & name, double value);
+  void queue_param_set(const mavlink_message_t & msg);
+  int num_params_locked() const;
+  bool is_param_id_locked(const std::string & name) const;
+
+  /**
+   * \brief Starts sending queued param sets if not already. Must be called without mutex_ held,
+   * since resetting the timer waits for its callback, which takes mutex_.
+   */
+  void start_param_set_timer();
+
+  void handle_param_value_msg(const mavlink_param_value_t & param);
+  void handle_command_ack_msg(const mavlink_rosflight_cmd_ack_t & ack);
 
-  bool is_param_id(const std::string & name);
+  void update_live_stats();
 
   std::vector<ParamListenerInterface *> listeners_;
+  //! Guards listeners_, held while they are called
+  std::mutex listeners_mutex_;
+  //! Guards everything else, against the io and param set timer threads
+  mutable std::mutex mutex_;
 
-  rclcpp::Node * const node_;
+  const Platform platform_;
   MavlinkComm * const comm_;
-  std::map<std::string, Param> params_;
+  std::map<std::string, Param, std::less<>> params_; //!< looked up by string_view too
 
   bool unsaved_changes_;
   bool write_request_in_progress_;
@@ -104,7 +142,7 @@ private:
   bool got_all_params_;
 
   std::deque<mavlink_message_t> param_set_queue_;
-  rclcpp::TimerBase::SharedPtr param_set_timer_;
+  std::unique_ptr<TimerInterface> param_set_timer_;
   bool param_set_in_progress_;
   void param_set_timer_callback();
 };
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file platform.hpp
+ *
+ * The clock, timers and logger mavrosflight runs on, so the library does not depend on ROS. See
+ * ros_platform.hpp for the adapter to a ROS node and asio_platform.hpp for one with no middleware.
+ */
+
+#ifndef MAVROSFLIGHT_PLATFORM_H
+#define MAVROSFLIGHT_PLATFORM_H
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+namespace mavrosflight
+{
+/**
+ * \brief Source of the system time that FCU time is synchronized to
+ */
+class ClockInterface
+{
+public:
+  virtual ~ClockInterface() = default;
+
+  /**
+   * \brief The current time, since the epoch of the clock
+   */
+  virtual std::chrono::nanoseconds now() = 0;
+};
+
+/**
+ * \brief A periodic timer. The timer stops when it is destroyed.
+ */
+class TimerInterface
+{
+public:
+  virtual ~TimerInterface() = default;
+
+  /**
+   * \brief Stops the timer. May be called from the timer's own callback.
+   */
+  virtual void cancel() = 0;
+
+  /**
+   * \brief Restarts the timer, so the next callback is a full period away
+   */
+  virtual void reset() = 0;
+};
+
+/**
+ * \brief Creates timers. The platform's timers run on a thread other than the link's io thread;
+ * see MavlinkComm::create_link_timer() for timers on the io thread.
+ */
+class TimerFactoryInterface
+{
+public:
+  virtual ~TimerFactoryInterface() = default;
+
+  /**
+   * \brief Creates a timer that calls the callback every period, starting one period from now
+   */
+  virtual std::unique_ptr<TimerInterface> create_wall_timer(std::chrono::nanoseconds period,
+                                                            std::function<void()> callback) = 0;
+};
+
+/**
+ * \brief Destination of mavrosflight's log messages
+ */
+class LoggerInterface
+{
+public:
+  enum class Severity
+  {
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR
+  };
+
+  virtual ~LoggerInterface() = default;
+
+  /**
+   * \brief Writes one log message
+   */
+  virtual void write(Severity severity, const char * message) = 0;
+
+  /**
+   * \brief Formats a log message printf-style and writes it
+   */
+  void log(Severity severity, const char * format, ...) __attribute__((format(printf, 3, 4)));
+};
+
+/**
+ * \brief Everything mavrosflight needs from the process it runs in
+ */
+struct Platform
+{
+  std::shared_ptr<ClockInterface> clock;
+  std::shared_ptr<TimerFactoryInterface> timers;
+  std::shared_ptr<LoggerInterface> logger;
+};
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_PLATFORM_H
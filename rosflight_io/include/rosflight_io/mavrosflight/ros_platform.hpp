@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file ros_platform.hpp
+ *
+ * Runs mavrosflight on a ROS node's clock, timers and logger. Header only, so the mavrosflight
+ * library itself does not link rclcpp.
+ */
+
+#ifndef MAVROSFLIGHT_ROS_PLATFORM_H
+#define MAVROSFLIGHT_ROS_PLATFORM_H
+
+#include <rosflight_io/mavrosflight/platform.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include <rclcpp/rclcpp.hpp>
+
+namespace mavrosflight
+{
+class RosClock : public ClockInterface
+{
+public:
+  explicit RosClock(rclcpp::Clock::SharedPtr clock)
+      : clock_(std::move(clock))
+  {}
+
+  std::chrono::nanoseconds now() override
+  {
+    return std::chrono::nanoseconds(clock_->now().nanoseconds());
+  }
+
+private:
+  rclcpp::Clock::SharedPtr clock_;
+};
+
+class RosTimer : public TimerInterface
+{
+public:
+  explicit RosTimer(rclcpp::TimerBase::SharedPtr timer)
+      : timer_(std::move(timer))
+  {}
+  ~RosTimer() override { timer_->cancel(); }
+
+  void cancel() override { timer_->cancel(); }
+  void reset() override { timer_->reset(); }
+
+private:
+  rclcpp::TimerBase::SharedPtr timer_;
+};
+
+/**
+ * \brief Creates wall timers on a node, which run on the node's executor
+ */
+class RosTimerFactory : public TimerFactoryInterface
+{
+public:
+  RosTimerFactory(rclcpp::node_interfaces::NodeBaseInterface::SharedPtr base,
+                  rclcpp::node_interfaces::NodeTimersInterface::SharedPtr timers)
+      : base_(std::move(base))
+      , timers_(std::move(timers))
+  {}
+
+  std::unique_ptr<TimerInterface> create_wall_timer(std::chrono::nanoseconds period,
+                                                    std::function<void()> callback) override
+  {
+    return std::make_unique<RosTimer>(
+      rclcpp::create_wall_timer(period, std::move(callback), nullptr, base_.get(), timers_.get()));
+  }
+
+private:
+  rclcpp::node_interfaces::NodeBaseInterface::SharedPtr base_;
+  rclcpp::node_interfaces::NodeTimersInterface::SharedPtr timers_;
+};
+
+class RosLogger : public LoggerInterface
+{
+public:
+  explicit RosLogger(rclcpp::Logger logger)
+      : logger_(std::move(logger))
+  {}
+
+  void write(Severity severity, const char * message) override
+  {
+    switch (severity) {
+      case Severity::DEBUG:
+        RCLCPP_DEBUG(logger_, "%s", message);
+        break;
+      case Severity::INFO:
+        RCLCPP_INFO(logger_, "%s", message);
+        break;
+      case Severity::WARN:
+        RCLCPP_WARN(logger_, "%s", message);
+        break;
+      case Severity::ERROR:
+        RCLCPP_ERROR(logger_, "%s", message);
+        break;
+    }
+  }
+
+private:
+  rclcpp::Logger logger_;
+};
+
+/**
+ * \brief The platform of a node, either an rclcpp::Node or an rclcpp_lifecycle::LifecycleNode
+ */
+template<class NodeT>
+Platform make_ros_platform(NodeT * node)
+{
+  return Platform{
+    std::make_shared<RosClock>(node->get_clock()),
+    std::make_shared<RosTimerFactory>(node->get_node_base_interface(),
+                                      node->get_node_timers_interface()),
+    std::make_shared<RosLogger>(node->get_logger())};
+}
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_ROS_PLATFORM_H
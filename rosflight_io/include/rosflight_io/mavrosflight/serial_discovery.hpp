@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file serial_discovery.hpp
+ *
+ * Finds the flight controller among the serial ports of a companion computer. Every candidate port
+ * is probed on its own thread, trying each baud rate in turn: the probe asks for the firmware
+ * version and waits for a HEARTBEAT or ROSFLIGHT_VERSION that passes the MAVLink checksum. The
+ * first port to answer wins and the other probes are stopped.
+ */
+
+#ifndef MAVROSFLIGHT_SERIAL_DISCOVERY_H
+#define MAVROSFLIGHT_SERIAL_DISCOVERY_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mavrosflight
+{
+class SerialDiscovery
+{
+public:
+  /**
+   * \brief Outcome of a discovery
+   */
+  struct Result
+  {
+    bool found = false;
+    //! Port the firmware answered on, as probed
+    std::string port;
+    //! Device the port resolves to (e.g. "/dev/ttyACM1")
+    std::string device;
+    int baud_rate = 0;
+    //! MAVLink system ID of the message that identified the firmware
+    uint8_t system_id = 0;
+    //! Firmware version, if it arrived before the probe finished
+    std::string version;
+    //! Time from the start of discovery to the answer, or to giving up
+    std::chrono::nanoseconds elapsed{0};
+    //! Every port that was probed
+    std::vector<std::string> probed;
+  };
+
+  /**
+   * \brief Lists the serial ports in a directory, sorted by name
+   * \param directory Directory of device nodes or links to them, e.g. "/dev/serial/by-id"
+   * \return The ports, or an empty list if the directory does not exist
+   */
+  static std::vector<std::string> list_ports(const std::string & directory = "/dev/serial/by-id");
+
+  /**
+   * \brief Probes the ports concurrently and returns the first one a ROSflight firmware answers on
+   * \param ports Ports to probe
+   * \param baud_rates Baud rates to try on each port, in order
+   * \param window How long to wait for an answer at each baud rate
+   */
+  static Result discover(const std::vector<std::string> & ports,
+                         const std::vector<int> & baud_rates, std::chrono::milliseconds window);
+};
+
+} // namespace mavrosflight
+
+#endif // MAVROSFLIGHT_SERIAL_DISCOVERY_H
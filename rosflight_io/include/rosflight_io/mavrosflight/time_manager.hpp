@@ -37,36 +37,49 @@
 #ifndef MAVROSFLIGHT_TIME_MANAGER_H
 #define MAVROSFLIGHT_TIME_MANAGER_H
 
-#include <rclcpp/rclcpp.hpp>
 #include <rosflight_io/mavrosflight/mavlink_bridge.hpp>
 #include <rosflight_io/mavrosflight/mavlink_comm.hpp>
-#include <rosflight_io/mavrosflight/mavlink_listener_interface.hpp>
+#include <rosflight_io/mavrosflight/platform.hpp>
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 
 namespace mavrosflight
 {
-class TimeManager : MavlinkListenerInterface
+class TimeManager
 {
 public:
-  TimeManager(MavlinkComm * comm, rclcpp::Node * node);
+  TimeManager(MavlinkComm * comm, const Platform & platform);
 
-  void handle_mavlink_message(const mavlink_message_t & msg) override;
+  ~TimeManager();
+
+  void handle_timesync_msg(const mavlink_timesync_t & tsync);
 
   std::chrono::nanoseconds fcu_time_to_system_time(std::chrono::nanoseconds fcu_time);
 
+  /**
+   * \brief Sends a burst of time sync requests, instead of waiting for the timer to send them
+   * \param count Number of requests to send
+   */
+  void request_sync(int count);
+
+  //! True once a time sync response has been received
+  bool initialized() const { return initialized_; }
+
 private:
   MavlinkComm * const comm_;
-  rclcpp::Node * const node_;
+  const Platform platform_;
 
-  rclcpp::TimerBase::SharedPtr time_sync_timer_;
+  std::unique_ptr<TimerInterface> time_sync_timer_;
   void timer_callback();
 
   double offset_alpha_;
   std::chrono::nanoseconds offset_ns_;
 
-  bool initialized_;
+  std::atomic<bool> initialized_;
+
+  std::chrono::nanoseconds last_negative_time_log_; //!< throttles the negative time error
 };
 
 } // namespace mavrosflight
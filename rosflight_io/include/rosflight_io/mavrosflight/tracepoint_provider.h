@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file tracepoint_provider.h
+ *
+ * LTTng-UST tracepoint provider for rosflight_io. Only used when rosflight_io is built with
+ * ROSFLIGHT_IO_TRACEPOINTS=ON; code should use the ROSFLIGHT_IO_TRACEPOINT macro from
+ * tracepoints.hpp rather than including this header directly.
+ *
+ * Handles (comm, listener, node) are the addresses of the corresponding objects, so events from
+ * one link can be correlated in an analysis. Message IDs are MAVLink message IDs.
+ */
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER rosflight_io
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "rosflight_io/mavrosflight/tracepoint_provider.h"
+
+#if !defined(MAVROSFLIGHT_TRACEPOINT_PROVIDER_H) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define MAVROSFLIGHT_TRACEPOINT_PROVIDER_H
+
+#include <lttng/tracepoint.h>
+#include <stdint.h>
+
+/* An asynchronous read from the link completed */
+TRACEPOINT_EVENT(
+  rosflight_io, read_end,
+  TP_ARGS(const void *, comm_arg, uint64_t, bytes_arg),
+  TP_FIELDS(ctf_integer_hex(const void *, comm, comm_arg) ctf_integer(uint64_t, bytes, bytes_arg)))
+
+/* The parser produced a complete MAVLink frame */
+TRACEPOINT_EVENT(
+  rosflight_io, frame_decoded,
+  TP_ARGS(const void *, comm_arg, uint32_t, msgid_arg, uint8_t, seq_arg),
+  TP_FIELDS(ctf_integer_hex(const void *, comm, comm_arg) ctf_integer(uint32_t, msgid, msgid_arg)
+              ctf_integer(uint8_t, seq, seq_arg)))
+
+/* A decoded frame is about to be passed to a listener */
+TRACEPOINT_EVENT(
+  rosflight_io, listener_dispatch,
+  TP_ARGS(const void *, comm_arg, const void *, listener_arg, uint32_t, msgid_arg),
+  TP_FIELDS(ctf_integer_hex(const void *, comm, comm_arg)
+              ctf_integer_hex(const void *, listener, listener_arg)
+                ctf_integer(uint32_t, msgid, msgid_arg)))
+
+/* Entry to one of the ROSflightIO handle_*_msg handlers */
+TRACEPOINT_EVENT(
+  rosflight_io, handler_entry,
+  TP_ARGS(const void *, node_arg, uint32_t, msgid_arg),
+  TP_FIELDS(ctf_integer_hex(const void *, node, node_arg) ctf_integer(uint32_t, msgid, msgid_arg)))
+
+/* A handler is about to publish the ROS message built from a MAVLink message */
+TRACEPOINT_EVENT(
+  rosflight_io, handler_publish,
+  TP_ARGS(const void *, node_arg, uint32_t, msgid_arg, const char *, topic_arg),
+  TP_FIELDS(ctf_integer_hex(const void *, node, node_arg) ctf_integer(uint32_t, msgid, msgid_arg)
+              ctf_string(topic, topic_arg)))
+
+/* Entry to ROSflightIO::commandCallback */
+TRACEPOINT_EVENT(
+  rosflight_io, command_callback,
+  TP_ARGS(const void *, node_arg, uint8_t, mode_arg),
+  TP_FIELDS(ctf_integer_hex(const void *, node, node_arg) ctf_integer(uint8_t, mode, mode_arg)))
+
+/* A message was serialized and queued for writing */
+TRACEPOINT_EVENT(
+  rosflight_io, write_submit,
+  TP_ARGS(const void *, comm_arg, uint32_t, msgid_arg, uint64_t, len_arg),
+  TP_FIELDS(ctf_integer_hex(const void *, comm, comm_arg) ctf_integer(uint32_t, msgid, msgid_arg)
+              ctf_integer(uint64_t, len, len_arg)))
+
+/* An asynchronous write to the link completed */
+TRACEPOINT_EVENT(
+  rosflight_io, write_complete,
+  TP_ARGS(const void *, comm_arg, uint64_t, bytes_arg, uint64_t, queued_arg),
+  TP_FIELDS(ctf_integer_hex(const void *, comm, comm_arg) ctf_integer(uint64_t, bytes, bytes_arg)
+              ctf_integer(uint64_t, queued, queued_arg)))
+
+#endif /* MAVROSFLIGHT_TRACEPOINT_PROVIDER_H */
+
+#include <lttng/tracepoint-event.h>
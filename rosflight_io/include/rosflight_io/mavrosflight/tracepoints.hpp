@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file tracepoints.hpp
+ *
+ * Optional LTTng tracepoints for ros2_tracing analyses. The events are defined in
+ * tracepoint_provider.h. Unless rosflight_io is built with ROSFLIGHT_IO_TRACEPOINTS=ON, the macro
+ * expands to nothing and its arguments are not evaluated.
+ */
+
+#ifndef MAVROSFLIGHT_TRACEPOINTS_H
+#define MAVROSFLIGHT_TRACEPOINTS_H
+
+#ifdef ROSFLIGHT_IO_TRACEPOINTS_ENABLED
+#include <rosflight_io/mavrosflight/tracepoint_provider.h>
+#define ROSFLIGHT_IO_TRACEPOINT(event, ...) tracepoint(rosflight_io, event, __VA_ARGS__)
+#else
+#define ROSFLIGHT_IO_TRACEPOINT(event, ...) ((void) 0)
+#endif
+
+#endif // MAVROSFLIGHT_TRACEPOINTS_H
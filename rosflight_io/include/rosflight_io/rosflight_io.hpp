@@ -41,11 +41,18 @@
 #ifndef ROSFLIGHT_IO_MAVROSFLIGHT_ROS_H
 #define ROSFLIGHT_IO_MAVROSFLIGHT_ROS_H
 
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <rclcpp/rclcpp.hpp>
+#include <rclcpp_lifecycle/lifecycle_node.hpp>
+#include <rclcpp_lifecycle/lifecycle_publisher.hpp>
 
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
 #include <geometry_msgs/msg/quaternion.hpp>
 #include <geometry_msgs/msg/twist_stamped.hpp>
 #include <geometry_msgs/msg/vector3_stamped.hpp>
@@ -65,25 +72,43 @@
 #include <std_srvs/srv/trigger.hpp>
 
 #include <rosflight_msgs/msg/airspeed.hpp>
+#include <rosflight_msgs/msg/airspeed_bounded.hpp>
 #include <rosflight_msgs/msg/attitude.hpp>
+#include <rosflight_msgs/msg/attitude_bounded.hpp>
 #include <rosflight_msgs/msg/aux_command.hpp>
 #include <rosflight_msgs/msg/barometer.hpp>
+#include <rosflight_msgs/msg/barometer_bounded.hpp>
 #include <rosflight_msgs/msg/battery_status.hpp>
 #include <rosflight_msgs/msg/command.hpp>
+#include <rosflight_msgs/msg/connection_status.hpp>
 #include <rosflight_msgs/msg/error.hpp>
 #include <rosflight_msgs/msg/gnss.hpp>
+#include <rosflight_msgs/msg/gnss_bounded.hpp>
 #include <rosflight_msgs/msg/gnss_full.hpp>
 #include <rosflight_msgs/msg/output_raw.hpp>
+#include <rosflight_msgs/msg/output_raw_bounded.hpp>
+#include <rosflight_msgs/msg/param_events.hpp>
 #include <rosflight_msgs/msg/rc_raw.hpp>
+#include <rosflight_msgs/msg/rc_raw_bounded.hpp>
+#include <rosflight_msgs/msg/sensor_bundle.hpp>
 #include <rosflight_msgs/msg/status.hpp>
+#include <rosflight_msgs/msg/status_bounded.hpp>
 
+#include <rosflight_msgs/srv/attitude_at_time.hpp>
 #include <rosflight_msgs/srv/param_file.hpp>
 #include <rosflight_msgs/srv/param_get.hpp>
 #include <rosflight_msgs/srv/param_set.hpp>
+#include <rosflight_msgs/srv/provision.hpp>
 
+#include <rosflight_io/attitude_history.hpp>
+#include <rosflight_io/log_queue.hpp>
+#include <rosflight_io/loop_time_monitor.hpp>
+#include <rosflight_io/mavrosflight/command_scheduler.hpp>
+#include <rosflight_io/mavrosflight/flight_recorder.hpp>
+#include <rosflight_io/mavrosflight/live_stats.hpp>
 #include <rosflight_io/mavrosflight/mavlink_comm.hpp>
-#include <rosflight_io/mavrosflight/mavlink_listener_interface.hpp>
 #include <rosflight_io/mavrosflight/mavrosflight.hpp>
+#include <rosflight_io/mavrosflight/message_dispatch.hpp>
 #include <rosflight_io/mavrosflight/param_listener_interface.hpp>
 
 namespace rosflight_io
@@ -97,24 +122,44 @@ namespace rosflight_io
  * ROSflightIO serving as the "ROS" layer on top of MAVROSflight. MAVROSflight uses MAVLink to
  * serialize and deserialize messages between itself and the firmware, which serves as the message
  * "format".
+ *
+ * ROSflightIO is a managed (lifecycle) node. Configuring it opens the link, runs the connection
+ * handshake and creates the publishers. Activating it starts publishing and creates the
+ * subscriptions and services. A configured but inactive node is a hot standby: its publishers
+ * are already discovered and its parameter cache and time sync are kept up to date, so it can take
+ * over from another instance as soon as it is activated.
  */
-class ROSflightIO : public rclcpp::Node,
-                    public mavrosflight::MavlinkListenerInterface,
+class ROSflightIO : public rclcpp_lifecycle::LifecycleNode,
                     public mavrosflight::ParamListenerInterface
 {
 public:
+  using CallbackReturn = rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
+
   /**
    * @brief Default constructor for ROSflightIO.
    *
-   * Initializes many ROS services, subscriptions, publishers, parameters, timers, and topics,
-   * as well as everything required for MAVROSflight.
+   * Only declares the parameters. The link is opened when the node is configured.
    *
-   * Needs to be initialized as shared pointer and then passed to rclcpp::spin() like so:
+   * Needs to be initialized as shared pointer, brought up and then spun like so:
    * @code
-   * rclcpp::spin(std::make_shared<rosflight_io::ROSflightIO>());
+   * auto node = std::make_shared<rosflight_io::ROSflightIO>();
+   * node->configure();
+   * node->activate();
+   * rclcpp::spin(node->get_node_base_interface());
    * @endcode
    */
   ROSflightIO();
+  /**
+   * @brief Constructs ROSflightIO on an existing MAVLink connection instead of creating one from
+   * the udp/port parameters.
+   *
+   * Used to connect to a firmware instance in the same process, e.g. through a
+   * mavrosflight::MavlinkLoopback. The connection is opened when the node is configured and closed
+   * when it is cleaned up, but never deleted, so it must outlive the node.
+   *
+   * @param mavlink_comm Connection to the firmware, which must not be open yet
+   */
+  explicit ROSflightIO(mavrosflight::MavlinkComm * mavlink_comm);
   /**
    * @brief Default de-constructor for ROSflightIO.
    *
@@ -123,15 +168,59 @@ public:
   ~ROSflightIO() override;
 
   /**
-   * @brief Handles all MAVLink messages.
+   * @brief Opens the link, creates the publishers and starts the connection handshake.
    *
-   * This function handles any/all MAVLink messages received from the firmware.
-   * It calls the specific private handle function needed for each message type, doing
-   * nothing with the message itself.
+   * @return FAILURE if the link could not be opened, leaving the node unconfigured so configuring
+   * can be retried.
+   */
+  CallbackReturn on_configure(const rclcpp_lifecycle::State & state) override;
+  /**
+   * @brief Starts publishing and creates the subscriptions and services.
+   *
+   * Also publishes the current state of the latched topics, which are not published while the node
+   * is inactive.
+   */
+  CallbackReturn on_activate(const rclcpp_lifecycle::State & state) override;
+  /**
+   * @brief Stops publishing and removes the subscriptions and services, keeping the link open.
+   *
+   * Fails any provisioning in progress.
+   *
+   * @return ERROR if the handshake timer is deactivating the node because the link failed.
+   */
+  CallbackReturn on_deactivate(const rclcpp_lifecycle::State & state) override;
+  /**
+   * @brief Closes the link and removes the publishers and timers.
    *
-   * @param msg Mavlink message to be handled.
+   * @return ERROR if the handshake timer is cleaning up the node because the link failed.
    */
-  void handle_mavlink_message(const mavlink_message_t & msg) override;
+  CallbackReturn on_cleanup(const rclcpp_lifecycle::State & state) override;
+  /**
+   * @brief Tears down whatever the failed transition left set up, leaving the node unconfigured so
+   * configuring can be retried.
+   *
+   * Also reached when the link fails after configuring: the handshake timer then deactivates or
+   * cleans up the node, and that transition returns ERROR.
+   */
+  CallbackReturn on_error(const rclcpp_lifecycle::State & state) override;
+  /**
+   * @brief Tears down whatever the current state has set up.
+   */
+  CallbackReturn on_shutdown(const rclcpp_lifecycle::State & state) override;
+
+  /**
+   * @brief Looks up the firmware's attitude estimate at a given time.
+   *
+   * Interpolates between the attitude messages received from the firmware, so components running
+   * in the same process can get the attitude at the time of their own measurements without
+   * subscribing to and buffering the attitude topic. Thread safe.
+   *
+   * @param stamp Time to look up.
+   * @param attitude Set to the attitude at the requested time, stamped with that time.
+   * @return True if the time is covered by the attitude history (see the attitude_history_size and
+   * attitude_max_extrapolation parameters).
+   */
+  bool attitude_at(const rclcpp::Time & stamp, rosflight_msgs::msg::Attitude & attitude) const;
 
   /**
    * @brief Callback for when new parameters are received from firmware.
@@ -139,7 +228,7 @@ public:
    * This function is a callback for whenever MAVROSflight receives new parameters. The parameters
    * can be set by either the firmware or ROS.
    *
-   * Currently just prints a ROS message.
+   * Queues a "param_events" event for the parameter.
    *
    * @param name Name of parameter.
    * @param value Value of parameter.
@@ -151,7 +240,7 @@ public:
    * This function is a callback for whenever MAVROSflight receives a parameter that already
    * exists in MAVROSflight. The parameters can be set by either the firmware or ROS.
    *
-   * Currently just prints a ROS message.
+   * Prints a ROS message and queues a "param_events" event for the change.
    *
    * @param name Name of parameter.
    * @param value Value of parameter.
@@ -172,141 +261,195 @@ public:
    */
   static constexpr long HEARTBEAT_PERIOD = 1;
   /**
-   * @brief Number of seconds between version requests.
+   * @brief Number of milliseconds between connection handshake checks.
    *
-   * Defines the number of seconds between firmware version requests. Requests terminate once
-   * response is received.
+   * While connecting, the firmware version is requested again at this rate until it is received,
+   * and missing parameters are requested again whenever the parameter download stops making
+   * progress.
    */
-  static constexpr long VERSION_PERIOD = 10;
+  static constexpr long HANDSHAKE_PERIOD_MS = 100;
   /**
-   * @brief Number of seconds between parameter requests.
-   *
-   * This value defines the number of seconds between requests for all parameters from the firmware.
-   * Requests terminate once all parameters have been received.
+   * @brief Number of milliseconds between printing the log lines queued by the MAVLink handlers.
+   */
+  static constexpr long LOG_PERIOD_MS = 100;
+  /**
+   * @brief Number of seconds without a heartbeat before the firmware is considered disconnected.
    */
-  static constexpr long PARAMETER_PERIOD = 3;
+  static constexpr long HEARTBEAT_TIMEOUT = 3;
+  /**
+   * @brief Number of time sync requests sent at once when the first heartbeat arrives.
+   */
+  static constexpr int TIME_SYNC_BURST = 5;
+  /**
+   * @brief Number of milliseconds between checks on the provisioning step in progress.
+   */
+  static constexpr long PROVISION_PERIOD_MS = 20;
+  /**
+   * @brief Number of seconds to wait for the firmware to confirm param sets before sending the
+   * unconfirmed ones again while provisioning.
+   */
+  static constexpr long PARAM_SET_RETRY = 1;
+
+  /**
+   * @brief State of the connection to the firmware.
+   */
+  enum ConnectionState
+  {
+    WAITING_FOR_HEARTBEAT, ///< No heartbeat yet, or the heartbeat timed out.
+    CONNECTING,            ///< Heartbeat received, waiting for version, time sync and parameters.
+    READY                  ///< Everything received; "ready" has been published.
+  };
+
+  /**
+   * @brief Step of the "provision" service in progress.
+   */
+  enum ProvisionStep
+  {
+    PROVISION_IDLE,      ///< Not provisioning.
+    PROVISION_CONNECT,   ///< Waiting for the connection to be ready.
+    PROVISION_PARAMS,    ///< Waiting for the firmware to confirm every param set.
+    PROVISION_CALIBRATE, ///< Waiting for the firmware to acknowledge a calibration.
+    PROVISION_WRITE      ///< Waiting for the firmware to acknowledge the param write.
+  };
 
 private:
   // MAVLink message handlers
+  /**
+   * @brief Subscribes the message handlers to the link.
+   *
+   * Only the heartbeat and version handlers run while the node is inactive.
+   */
+  void subscribe_handlers(mavrosflight::MavlinkComm & comm);
+  /**
+   * @brief Calls a message handler, but only while the node is active.
+   */
+  template<auto Handler>
+  void
+  when_active(const typename mavrosflight::MessageHandlerTraits<decltype(Handler)>::Message & msg);
+  /**
+   * @brief Checks whether the handshake has completed, after a message it waits on.
+   */
+  template<class T>
+  void follow_handshake(const T & msg);
   /**
    * @brief Handles heartbeat MAVLink messages.
-   * @param msg Heartbeat message.
+   * @param heartbeat Heartbeat message.
    */
-  void handle_heartbeat_msg(const mavlink_message_t & msg);
+  void handle_heartbeat_msg(const mavlink_heartbeat_t & heartbeat);
   /**
    * @brief Handles status MAVLink messages.
    *
    * Handles all MAVLink status messages. This includes arming, failsafe, rc override,
    * ROSflight errors, and control mode.
    *
-   * @param msg Status message.
+   * @param status_msg Status message.
    */
-  void handle_status_msg(const mavlink_message_t & msg);
+  void handle_status_msg(const mavlink_rosflight_status_t & status_msg);
   /**
    * @brief Handles command acknowledgment MAVLink messages.
    *
    * @note Command values are defined by MAVLink. (At the time of writing:
    * rosflight_io/include/rosflight_io/mavlink/v1.0/message_definitions/rosflight.xml)
    *
-   * @param msg Command acknowledgment message.
+   * @param ack Command acknowledgment message.
    */
-  void handle_command_ack_msg(const mavlink_message_t & msg);
+  void handle_command_ack_msg(const mavlink_rosflight_cmd_ack_t & ack);
   /**
    * @brief Handles status text MAVLink messages.
    *
    * Text is printed out as ROS messages according to their severity.
    *
-   * @param msg Status text message.
+   * @param status Status text message.
    */
-  void handle_statustext_msg(const mavlink_message_t & msg);
+  void handle_statustext_msg(const mavlink_statustext_t & status);
   /**
    * @brief Handles attitude quaternion MAVLink messages.
    *
    * Calculates Euler angles from the quaternion and publishes both as a ROS topic.
    *
-   * @param msg Attitude quaternion message.
+   * @param attitude Attitude quaternion message.
    */
-  void handle_attitude_quaternion_msg(const mavlink_message_t & msg);
+  void handle_attitude_quaternion_msg(const mavlink_attitude_quaternion_t & attitude);
   /**
    * @brief Handles IMU MAVLink messages.
    *
    * Receives MAVLink IMU message and republishes it as a ROS topic.
    *
-   * @param msg IMU message.
+   * @param imu IMU message.
    */
-  void handle_small_imu_msg(const mavlink_message_t & msg);
+  void handle_small_imu_msg(const mavlink_small_imu_t & imu);
   /**
    * @brief Handles ROSflight raw servo command output MAVLink messages.
-   * @param msg ROSflight output raw message.
+   * @param servo ROSflight output raw message.
    */
-  void handle_rosflight_output_raw_msg(const mavlink_message_t & msg);
+  void handle_rosflight_output_raw_msg(const mavlink_rosflight_output_raw_t & servo);
   /**
    * @brief Handles RC raw MAVLink messages.
    *
    * Receives RC receiver PWM values from MAVLink and publishes it on "rc_raw" topic.
    *
-   * @param msg RC channels raw message.
+   * @param rc RC channels message.
    */
-  void handle_rc_channels_raw_msg(const mavlink_message_t & msg);
+  void handle_rc_channels_msg(const mavlink_rc_channels_t & rc);
   /**
    * @brief Handles differential pressure MAVLink messages.
    *
    * Receives airspeed differential pressure from MAVLink and publishes it on "airspeed" topic.
    *
-   * @param msg Differential pressure message.
+   * @param diff Differential pressure message.
    */
-  void handle_diff_pressure_msg(const mavlink_message_t & msg);
+  void handle_diff_pressure_msg(const mavlink_diff_pressure_t & diff);
   /**
    * @brief Handles barometer MAVLink messages.
    *
    * Receives barometric pressure from MAVLink and publishes it on "baro" topic.
    *
-   * @param msg Barometer message.
+   * @param baro Barometer message.
    */
-  void handle_small_baro_msg(const mavlink_message_t & msg);
+  void handle_small_baro_msg(const mavlink_small_baro_t & baro);
   /**
    * @brief Handles magnetometer MAVLink messages.
    *
    * Receives magnetometer data from MAVLink and publishes it on "magnetometer" topic.
    *
-   * @param msg Magnetometer message.
+   * @param mag Magnetometer message.
    */
-  void handle_small_mag_msg(const mavlink_message_t & msg);
+  void handle_small_mag_msg(const mavlink_small_mag_t & mag);
   /**
    * @brief Handles ROSflight GNSS MAVLink messages.
    *
    * Receives GNSS data from MAVLink, and uses that to publish "gnss" topic and all three
    * "navsat_compact" topics.
    *
-   * @param msg ROSflight GNSS message.
+   * @param gnss ROSflight GNSS message.
    */
-  void handle_rosflight_gnss_msg(const mavlink_message_t & msg);
+  void handle_rosflight_gnss_msg(const mavlink_rosflight_gnss_t & gnss);
   /**
    * @brief Handles ROSflight GNSS full MAVLink messages.
    *
    * Receives "full" GNSS data from MAVLink and publishes it on "gnss_full" topic.
    *
-   * @param msg ROSflight GNSS full message.
+   * @param full ROSflight GNSS full message.
    */
-  void handle_rosflight_gnss_full_msg(const mavlink_message_t & msg);
+  void handle_rosflight_gnss_full_msg(const mavlink_rosflight_gnss_full_t & full);
   /**
    * @brief Handles named value integer MAVLink messages.
    *
    * Receives named int messages from MAVLink and publishes it on "named_value/int/{value name}"
    * topic. Won't create topic if firmware never sends these messages.
    *
-   * @param msg Named value integer message.
+   * @param val Named value integer message.
    */
-  void handle_named_value_int_msg(const mavlink_message_t & msg);
+  void handle_named_value_int_msg(const mavlink_named_value_int_t & val);
   /**
    * @brief Handles named value float MAVLink messages.
    *
    * Receives named float messages from MAVLink and publishes it on "named_value/float/{value name}"
    * topic. Won't create topic if firmware never sends these messages.
    *
-   * @param msg Named value float message.
+   * @param val Named value float message.
    */
-  void handle_named_value_float_msg(const mavlink_message_t & msg);
+  void handle_named_value_float_msg(const mavlink_named_value_float_t & val);
   /**
    * @brief Handles named command struct MAVLink messages.
    *
@@ -314,44 +457,44 @@ private:
    * "named_value/command_struct/{value name}" topic. Won't create topic if
    * firmware never sends these messages.
    *
-   * @param msg Named command struct message.
+   * @param command Named command struct message.
    */
-  void handle_named_command_struct_msg(const mavlink_message_t & msg);
+  void handle_named_command_struct_msg(const mavlink_named_command_struct_t & command);
   /**
    * @brief Handles rangefinder MAVLink messages.
    *
    * Receives rangefinder data from MAVLink and publishes it on "sonar" or "lidar" topic, depending
    * on the sensor type.
    *
-   * @param msg Range message.
+   * @param range Range message.
    */
-  void handle_small_range_msg(const mavlink_message_t & msg);
+  void handle_small_range_msg(const mavlink_small_range_t & range);
   /**
    * @brief Handles version MAVLink messages.
    *
    * Receives firmware version from MAVLink and publishes it on "version" topic. Also cancels future
    * requests for firmware version.
    *
-   * @param msg Version message.
+   * @param version Version message.
    */
-  void handle_version_msg(const mavlink_message_t & msg);
+  void handle_version_msg(const mavlink_rosflight_version_t & version);
   /**
    * @brief Handles hard error MAVLink messages.
    *
    * When hard faults occur, Receives the fault data from MAVLink and publishes it as both a ROS
    * error message and on the "rosflight_errors" topic.
    *
-   * @param msg Hard error message.
+   * @param error Hard error message.
    */
-  void handle_hard_error_msg(const mavlink_message_t & msg);
+  void handle_hard_error_msg(const mavlink_rosflight_hard_error_t & error);
   /**
    * @brief Handles battery status MAVLink messages.
    *
    * Receives battery voltage and current from MAVLink and publishes it on "battery" topic.
    *
-   * @param msg Battery status message.
+   * @param battery_status Battery status message.
    */
-  void handle_battery_status_msg(const mavlink_message_t & msg);
+  void handle_battery_status_msg(const mavlink_rosflight_battery_status_t & battery_status);
 
   /**
    * @brief Parses firmware and git version strings into consistent format.
@@ -365,7 +508,8 @@ private:
    * @brief "command" topic subscription callback.
    *
    * This function is called anytime rosflight_io receives a message on the "command" topic.
-   * It saturates the commands and sends them over MAVLink to the firmware.
+   * It saturates the commands and sends them over MAVLink to the firmware, or latches them for the
+   * command scheduler if command_rate is set.
    *
    * @param msg Populated ROSflight Command message.
    */
@@ -374,7 +518,8 @@ private:
    * @brief "aux_command" topic subscription callback.
    *
    * This function is called anytime rosflight_io receives a message on the "aux_command" topic,
-   * where it sends the aux command over MAVLink to the firmware.
+   * where it sends the aux command over MAVLink to the firmware, or latches it for the command
+   * scheduler if command_rate is set.
    *
    * @param msg Populated ROSflight AuxCommand message
    */
@@ -480,7 +625,8 @@ private:
    * @brief "calibrate_baro" service callback.
    *
    * This function is called anytime the "calibrate_baro" ROS service is called. It signals the
-   * firmware through MAVROSflight to calibrate the baro altitude calculation.
+   * firmware through MAVROSflight to calibrate the baro altitude calculation. Fails if no
+   * barometer has reported since configuring.
    *
    * @param req ROS Trigger service request.
    * @param res ROS Trigger service response.
@@ -492,7 +638,8 @@ private:
    * @brief "calibrate_airspeed" service callback.
    *
    * This function is called anytime the "calibrate_airspeed" ROS service is called. It signals the
-   * firmware through MAVROSflight to calibrate the airspeed sensor.
+   * firmware through MAVROSflight to calibrate the airspeed sensor. Fails if no airspeed sensor
+   * has reported since configuring.
    *
    * @param req ROS Trigger service request.
    * @param res ROS Trigger service response.
@@ -524,22 +671,50 @@ private:
    */
   bool rebootToBootloaderSrvCallback(const std_srvs::srv::Trigger::Request::SharedPtr & req,
                                      const std_srvs::srv::Trigger::Response::SharedPtr & res);
-
-  // timer callbacks
   /**
-   * @brief Callback for parameter request timer.
+   * @brief "attitude_at_time" service callback.
    *
-   * This function is called repeatedly until MAVROSflight has received all parameters from the
-   * firmware. It outputs ROS info/error messages with the current status of this request.
+   * Looks up the attitude at the requested time with attitude_at, or the latest attitude if the
+   * requested time is zero.
+   *
+   * @param req ROSflight AttitudeAtTime service request.
+   * @param res ROSflight AttitudeAtTime service response.
+   * @return True
    */
-  void paramTimerCallback();
+  bool
+  attitudeAtTimeSrvCallback(const rosflight_msgs::srv::AttitudeAtTime::Request::SharedPtr & req,
+                            const rosflight_msgs::srv::AttitudeAtTime::Response::SharedPtr & res);
   /**
-   * @brief Callback for firmware version request timer.
+   * @brief "provision" service callback.
    *
-   * This function is called repeatedly until ROSflightIO receives the firmware version. It sends
-   * a request for the version, but does not process the response.
+   * Checks the request and starts provisioning. The response is deferred: the provisioning timer
+   * sends it once the firmware has confirmed every step, or a step has failed or timed out.
+   *
+   * @param header ROS service request header, used to send the response.
+   * @param req ROSflight Provision service request.
    */
-  void versionTimerCallback();
+  void provisionSrvCallback(const std::shared_ptr<rmw_request_id_t> & header,
+                            const rosflight_msgs::srv::Provision::Request::SharedPtr & req);
+  /**
+   * @brief "reset_loop_time_monitor" service callback.
+   *
+   * Clears the loop time statistics and the latched overrun warning.
+   *
+   * @param req Trigger service request.
+   * @param res Trigger service response.
+   * @return True
+   */
+  bool resetLoopTimeMonitorSrvCallback(const std_srvs::srv::Trigger::Request::SharedPtr & req,
+                                       const std_srvs::srv::Trigger::Response::SharedPtr & res);
+
+  // timer callbacks
+  /**
+   * @brief Callback for the connection handshake timer.
+   *
+   * This function is called every HANDSHAKE_PERIOD_MS. While connecting, it requests whatever the
+   * handshake is still missing. It also detects a lost heartbeat and drops back to waiting for one.
+   */
+  void handshakeTimerCallback();
   /**
    * @brief Callback for the heat beat request timer.
    *
@@ -547,8 +722,110 @@ private:
    * for the firmware to send a heartbeat message.
    */
   void heartbeatTimerCallback();
+  /**
+   * @brief Callback for the log timer.
+   *
+   * This function is called every LOG_PERIOD_MS. It prints the lines the MAVLink handlers queued,
+   * since logging through rclcpp would allocate on the io thread.
+   */
+  void logTimerCallback();
+  /**
+   * @brief Callback for the provisioning timer.
+   *
+   * This function is called every PROVISION_PERIOD_MS while provisioning. It moves to the next step
+   * as soon as the current one is confirmed, and fails the step once it exceeds the timeout.
+   */
+  void provisionTimerCallback();
+  /**
+   * @brief Callback for the loop time report timer.
+   *
+   * Publishes the firmware loop time percentiles, error rate and overruns on "diagnostics".
+   */
+  void loopTimeTimerCallback();
+  /**
+   * @brief Callback for the "param_events" timer.
+   *
+   * Publishes the parameter changes queued since the last call, and a snapshot when a subscriber
+   * has joined since.
+   */
+  void paramEventsTimerCallback();
+  /**
+   * @brief "param_snapshot" service callback.
+   *
+   * Publishes every parameter received so far on "param_events".
+   *
+   * @param req Trigger service request.
+   * @param res Trigger service response.
+   * @return True
+   */
+  bool paramSnapshotSrvCallback(const std_srvs::srv::Trigger::Request::SharedPtr & req,
+                                const std_srvs::srv::Trigger::Response::SharedPtr & res);
+  /**
+   * @brief Queues a "param_events" event for a parameter received from the firmware.
+   *
+   * @param name Name of the parameter.
+   * @param value New value of the parameter.
+   */
+  void queue_param_event(const std::string & name, double value);
+  /**
+   * @brief Publishes every parameter received so far on "param_events".
+   */
+  void publish_param_snapshot();
 
   // helpers
+  /**
+   * @brief Creates every fixed publisher, so they are discovered before the node is activated.
+   */
+  void create_publishers();
+  /**
+   * @brief Closes the link and releases everything on_configure set up.
+   */
+  void close_link();
+  /**
+   * @brief Finds the serial port the firmware is on, by probing every port in the
+   * discovery_directory at each baud rate.
+   *
+   * @param port Set to the port the firmware answered on
+   * @param baud_rate Configured baud rate, tried first. Set to the baud rate that was found.
+   * @return Whether the firmware was found.
+   */
+  bool discover_port(std::string & port, int & baud_rate);
+  /**
+   * @brief Starts the connection handshake.
+   *
+   * Requests the firmware version, a burst of time syncs and the parameters all at once, instead of
+   * waiting for the handshake timer.
+   */
+  void start_handshake();
+  /**
+   * @brief Moves to READY and publishes "ready" once the whole handshake has completed.
+   */
+  void check_connection_ready();
+  /**
+   * @brief Publishes the latched "ready" topic.
+   * @param ready Whether the handshake has completed.
+   */
+  void publish_connection_status(bool ready);
+  /**
+   * @brief Starts a provisioning step and sends whatever the firmware needs for it.
+   * @param step Step to start.
+   */
+  void start_provision_step(ProvisionStep step);
+  /**
+   * @brief Starts the step after the current one, skipping steps the request does not need, or
+   * finishes provisioning after the last one.
+   */
+  void next_provision_step();
+  /**
+   * @brief Sends the deferred "provision" response and stops provisioning.
+   * @param success Whether every step was confirmed.
+   * @param message Reason for a failure.
+   */
+  void finish_provision(bool success, const std::string & message);
+  /**
+   * @brief Describes the provisioning step in progress, for messages.
+   */
+  std::string provision_step_name() const;
   /**
    * @brief Sends a version request to MAVROSflight.
    */
@@ -569,13 +846,28 @@ private:
    * @param name String of name to print out in ROS error/info stream.
    */
   void check_error_code(uint8_t current, uint8_t previous, ROSFLIGHT_ERROR_CODE code,
-                        const std::string & name);
+                        const char * name);
   /**
    * @brief Converts FCU time in MAVLink message to current ROS time.
    * @param fcu_time Chrono nanoseconds object of current FCU time.
    * @return ROS time object of current ROS time.
    */
   rclcpp::Time fcu_time_to_ros_time(std::chrono::nanoseconds fcu_time);
+  /**
+   * @brief Publishes the sensor bundle for one IMU sample.
+   *
+   * Combines the IMU message with the latest measurement of every other sensor and the age of each
+   * measurement relative to the IMU sample. The members are all stamped with their receipt time,
+   * since only the IMU, attitude and GNSS messages carry an FCU timestamp.
+   *
+   * @param imu_msg IMU message, with the orientation already filled in.
+   * @param temperature IMU temperature.
+   * @param attitude Attitude at (or nearest to) the IMU time, or nullptr if there is none yet.
+   * @param received ROS time at which the IMU message was received.
+   */
+  void publish_sensor_bundle(const sensor_msgs::msg::Imu & imu_msg, float temperature,
+                             const rosflight_io::AttitudeHistory::Sample * attitude,
+                             const rclcpp::Time & received);
 
   template<class T>
   /**
@@ -600,54 +892,97 @@ private:
   rclcpp::Subscription<rosflight_msgs::msg::Attitude>::SharedPtr extatt_sub_;
 
   /// "unsaved_params" ROS topic publisher.
-  rclcpp::Publisher<std_msgs::msg::Bool>::SharedPtr unsaved_params_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<std_msgs::msg::Bool>::SharedPtr unsaved_params_pub_;
+  /// "param_events" ROS topic publisher.
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::ParamEvents>::SharedPtr
+    param_events_pub_;
   /// "imu/data" ROS topic publisher.
-  rclcpp::Publisher<sensor_msgs::msg::Imu>::SharedPtr imu_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<sensor_msgs::msg::Imu>::SharedPtr imu_pub_;
   /// "imu/temperature" ROS topic publisher.
-  rclcpp::Publisher<sensor_msgs::msg::Temperature>::SharedPtr imu_temp_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<sensor_msgs::msg::Temperature>::SharedPtr imu_temp_pub_;
   /// "output_raw" ROS topic publisher.
-  rclcpp::Publisher<rosflight_msgs::msg::OutputRaw>::SharedPtr output_raw_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::OutputRaw>::SharedPtr output_raw_pub_;
   /// "rc_raw" ROS topic publisher.
-  rclcpp::Publisher<rosflight_msgs::msg::RCRaw>::SharedPtr rc_raw_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::RCRaw>::SharedPtr rc_raw_pub_;
   /// "airspeed" ROS topic publisher.
-  rclcpp::Publisher<rosflight_msgs::msg::Airspeed>::SharedPtr diff_pressure_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::Airspeed>::SharedPtr diff_pressure_pub_;
   /// "baro" ROS topic publisher.
-  rclcpp::Publisher<rosflight_msgs::msg::Barometer>::SharedPtr baro_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::Barometer>::SharedPtr baro_pub_;
   /// "sonar" ROS topic publisher.
-  rclcpp::Publisher<sensor_msgs::msg::Range>::SharedPtr sonar_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<sensor_msgs::msg::Range>::SharedPtr sonar_pub_;
   /// "gnss" ROS topic publisher.
-  rclcpp::Publisher<rosflight_msgs::msg::GNSS>::SharedPtr gnss_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::GNSS>::SharedPtr gnss_pub_;
   /// "gnss_full" ROS topic publisher.
-  rclcpp::Publisher<rosflight_msgs::msg::GNSSFull>::SharedPtr gnss_full_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::GNSSFull>::SharedPtr gnss_full_pub_;
   /// "navsat_compat/fix" ROS topic publisher.
-  rclcpp::Publisher<sensor_msgs::msg::NavSatFix>::SharedPtr nav_sat_fix_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<sensor_msgs::msg::NavSatFix>::SharedPtr nav_sat_fix_pub_;
   /// "navsat_compat/vel" ROS topic publisher.
-  rclcpp::Publisher<geometry_msgs::msg::TwistStamped>::SharedPtr twist_stamped_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<geometry_msgs::msg::TwistStamped>::SharedPtr
+    twist_stamped_pub_;
   /// "navsat_compat/time_reference" ROS topic publisher.
-  rclcpp::Publisher<sensor_msgs::msg::TimeReference>::SharedPtr time_reference_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<sensor_msgs::msg::TimeReference>::SharedPtr
+    time_reference_pub_;
   /// "magnetometer" ROS topic publisher.
-  rclcpp::Publisher<sensor_msgs::msg::MagneticField>::SharedPtr mag_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<sensor_msgs::msg::MagneticField>::SharedPtr mag_pub_;
   /// "attitude" ROS topic publisher.
-  rclcpp::Publisher<rosflight_msgs::msg::Attitude>::SharedPtr attitude_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::Attitude>::SharedPtr attitude_pub_;
   /// "attitude/euler" ROS topic publisher.
-  rclcpp::Publisher<geometry_msgs::msg::Vector3Stamped>::SharedPtr euler_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<geometry_msgs::msg::Vector3Stamped>::SharedPtr euler_pub_;
   /// "status" ROS topic publisher.
-  rclcpp::Publisher<rosflight_msgs::msg::Status>::SharedPtr status_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::Status>::SharedPtr status_pub_;
   /// "version" ROS topic publisher.
-  rclcpp::Publisher<std_msgs::msg::String>::SharedPtr version_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<std_msgs::msg::String>::SharedPtr version_pub_;
   /// "lidar" ROS topic publisher.
-  rclcpp::Publisher<sensor_msgs::msg::Range>::SharedPtr lidar_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<sensor_msgs::msg::Range>::SharedPtr lidar_pub_;
   /// "rosflight_errors" ROS topic publisher.
-  rclcpp::Publisher<rosflight_msgs::msg::Error>::SharedPtr error_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::Error>::SharedPtr error_pub_;
+  /// "ready" ROS topic publisher.
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::ConnectionStatus>::SharedPtr
+    connection_status_pub_;
   /// "battery" ROS topic publisher.
-  rclcpp::Publisher<rosflight_msgs::msg::BatteryStatus>::SharedPtr battery_status_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::BatteryStatus>::SharedPtr
+    battery_status_pub_;
+  /// "sensor_bundle" ROS topic publisher.
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::SensorBundle>::SharedPtr
+    sensor_bundle_pub_;
+  /// "status/bounded" ROS topic publisher.
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::StatusBounded>::SharedPtr
+    status_bounded_pub_;
+  /// "attitude/bounded" ROS topic publisher.
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::AttitudeBounded>::SharedPtr
+    attitude_bounded_pub_;
+  /// "output_raw/bounded" ROS topic publisher.
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::OutputRawBounded>::SharedPtr
+    output_raw_bounded_pub_;
+  /// "rc_raw/bounded" ROS topic publisher.
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::RCRawBounded>::SharedPtr
+    rc_raw_bounded_pub_;
+  /// "airspeed/bounded" ROS topic publisher.
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::AirspeedBounded>::SharedPtr
+    airspeed_bounded_pub_;
+  /// "baro/bounded" ROS topic publisher.
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::BarometerBounded>::SharedPtr
+    baro_bounded_pub_;
+  /// "gnss/bounded" ROS topic publisher.
+  rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::GNSSBounded>::SharedPtr
+    gnss_bounded_pub_;
+  /// "diagnostics" ROS topic publisher.
+  rclcpp_lifecycle::LifecyclePublisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr
+    diagnostics_pub_;
+  /// "loop_time_overrun" ROS topic publisher.
+  rclcpp_lifecycle::LifecyclePublisher<std_msgs::msg::Bool>::SharedPtr loop_time_overrun_pub_;
   /// "named_value/int/" ROS topic publisher.
-  std::map<std::string, rclcpp::Publisher<std_msgs::msg::Int32>::SharedPtr> named_value_int_pubs_;
+  std::map<std::string, rclcpp_lifecycle::LifecyclePublisher<std_msgs::msg::Int32>::SharedPtr,
+           std::less<>>
+    named_value_int_pubs_;
   /// "named_value/float/" ROS topic publisher.
-  std::map<std::string, rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr>
+  std::map<std::string, rclcpp_lifecycle::LifecyclePublisher<std_msgs::msg::Float32>::SharedPtr,
+           std::less<>>
     named_value_float_pubs_;
   /// "named_value/command_struct/" ROS topic publisher.
-  std::map<std::string, rclcpp::Publisher<rosflight_msgs::msg::Command>::SharedPtr>
+  std::map<std::string,
+           rclcpp_lifecycle::LifecyclePublisher<rosflight_msgs::msg::Command>::SharedPtr,
+           std::less<>>
     named_command_struct_pubs_;
 
   /// "param_get" ROS service.
@@ -672,16 +1007,103 @@ private:
   rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr reboot_srv_;
   /// "reboot_to_bootloader" ROS service.
   rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr reboot_bootloader_srv_;
+  /// ROS service for looking up the attitude at a given time.
+  rclcpp::Service<rosflight_msgs::srv::AttitudeAtTime>::SharedPtr attitude_at_time_srv_;
+  /// "provision" ROS service.
+  rclcpp::Service<rosflight_msgs::srv::Provision>::SharedPtr provision_srv_;
+  /// "reset_loop_time_monitor" ROS service.
+  rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr reset_loop_time_monitor_srv_;
+  /// "param_snapshot" ROS service.
+  rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr param_snapshot_srv_;
 
-  /// ROS timer for param requests.
-  rclcpp::TimerBase::SharedPtr param_timer_;
-  /// ROS timer for firmware version requests.
-  rclcpp::TimerBase::SharedPtr version_timer_;
+  /// ROS timer for the connection handshake.
+  rclcpp::TimerBase::SharedPtr handshake_timer_;
   /// ROS timer for heartbeat requests.
   rclcpp::TimerBase::SharedPtr heartbeat_timer_;
+  /// ROS timer printing the queued log lines.
+  rclcpp::TimerBase::SharedPtr log_timer_;
+  /// ROS timer for provisioning, only running while provisioning.
+  rclcpp::TimerBase::SharedPtr provision_timer_;
+  /// ROS timer for loop time reports.
+  rclcpp::TimerBase::SharedPtr loop_time_timer_;
+  /// ROS timer that publishes the queued parameter changes.
+  rclcpp::TimerBase::SharedPtr param_events_timer_;
+  /// Resends the latest commands at command_rate while active, if set. Null otherwise.
+  std::unique_ptr<mavrosflight::CommandScheduler> command_scheduler_;
 
-  /// Quaternion ROS message, for passing quaternion data between functions.
-  geometry_msgs::msg::Quaternion attitude_quat_;
+  /// Recent attitude estimates, used to stamp IMU messages with the attitude at the IMU time.
+  rosflight_io::AttitudeHistory attitude_history_;
+  /// How far outside the attitude history a lookup may extrapolate, in nanoseconds.
+  int64_t attitude_max_extrapolation_ns_;
+  /// Whether to publish a sensor bundle with every IMU sample.
+  bool publish_sensor_bundle_;
+  /// Latest measurement of each sensor, kept for the sensor bundle. Only touched by the handlers.
+  rosflight_msgs::msg::SensorBundle sensor_bundle_;
+  /// Whether to also publish the fixed-size variants of the high-rate messages.
+  bool publish_bounded_msgs_;
+  /// Bounded messages published when the middleware cannot loan them. Only touched by the handlers.
+  rosflight_msgs::msg::StatusBounded status_bounded_msg_;
+  rosflight_msgs::msg::AttitudeBounded attitude_bounded_msg_;
+  rosflight_msgs::msg::OutputRawBounded output_raw_bounded_msg_;
+  rosflight_msgs::msg::RCRawBounded rc_raw_bounded_msg_;
+  rosflight_msgs::msg::AirspeedBounded airspeed_bounded_msg_;
+  rosflight_msgs::msg::BarometerBounded baro_bounded_msg_;
+  rosflight_msgs::msg::GNSSBounded gnss_bounded_msg_;
+  /// Whether the node is active. Inactive, the MAVLink handlers only follow the handshake.
+  std::atomic<bool> active_;
+  /// Log lines from the MAVLink handlers, printed by the log timer.
+  rosflight_io::LogQueue log_queue_;
+  /// Loop time and error statistics of the firmware, fed by the status handler.
+  rosflight_io::LoopTimeMonitor loop_time_monitor_;
+  /// Whether the latched loop time overrun warning has been published.
+  std::atomic<bool> loop_time_overrun_;
+  /// Current connection state. Moved forward by the MAVLink handlers, back by the handshake timer.
+  std::atomic<ConnectionState> connection_state_;
+  /// Whether the firmware version has been received since the handshake started.
+  std::atomic<bool> version_received_;
+  /// Whether a barometer has reported since configuring, for the calibrate_baro service.
+  std::atomic<bool> baro_received_;
+  /// Whether an airspeed sensor has reported since configuring, for the calibrate_airspeed service.
+  std::atomic<bool> airspeed_received_;
+  /// Whether the handshake timer found the link failed and is taking the node through on_error.
+  bool link_failed_;
+  /// Steady clock time of the most recent heartbeat, in nanoseconds.
+  std::atomic<int64_t> last_heartbeat_ns_;
+  /// Steady clock time at which the handshake started.
+  std::chrono::steady_clock::time_point handshake_start_;
+  /// Steady clock time at which the node started.
+  std::chrono::steady_clock::time_point node_start_;
+  /// Number of parameters received at the previous handshake check, used to detect stalls.
+  int params_received_at_last_check_;
+  /// Guards the parameter mirror and queued events, fed by the MAVLink handlers.
+  std::mutex param_events_mutex_;
+  /// Latest value, index and type of every parameter received, for snapshots.
+  std::map<std::string, rosflight_msgs::msg::ParamEvent> param_mirror_;
+  /// Parameter changes not published yet.
+  std::vector<rosflight_msgs::msg::ParamEvent> param_events_;
+  /// Subscriber count of "param_events" at the last timer callback, to detect new subscribers.
+  size_t param_events_subscribers_;
+  /// Provisioning step in progress. Only touched on the executor thread.
+  ProvisionStep provision_step_;
+  /// Provision request in progress.
+  rosflight_msgs::srv::Provision::Request provision_request_;
+  /// Header of the provision request in progress, used to send the deferred response.
+  std::shared_ptr<rmw_request_id_t> provision_header_;
+  /// Index into the requested calibrations of the calibration in progress.
+  size_t provision_calibration_;
+  /// Steady clock times at which provisioning started, the current step started, and unconfirmed
+  /// param sets were last sent again.
+  std::chrono::steady_clock::time_point provision_start_;
+  std::chrono::steady_clock::time_point provision_step_start_;
+  std::chrono::steady_clock::time_point provision_last_resend_;
+  /// ROSFLIGHT_CMD whose acknowledgement provisioning is waiting for, or -1.
+  std::atomic<int> provision_awaited_command_;
+  /// Acknowledgement of the awaited command: -1 while waiting, 1 for success, 0 for failure.
+  std::atomic<int> provision_ack_result_;
+  /// Bit i set once accelerometer bias i has been set to a calibration result while provisioning.
+  std::atomic<int> provision_biases_captured_;
+  /// Error code of the latest firmware status.
+  std::atomic<uint8_t> status_error_code_;
   /// Previous firmware status, used to detect changes in status.
   mavlink_rosflight_status_t prev_status_;
 
@@ -690,8 +1112,14 @@ private:
 
   /// Pointer to Mavlink communication object, used by MavROSflight.
   mavrosflight::MavlinkComm * mavlink_comm_;
+  /// Whether mavlink_comm_ was created by this node and must be deleted by it.
+  bool owns_mavlink_comm_;
   /// Pointer to MavROSflight instance, which is used for all serial communication.
   mavrosflight::MavROSflight * mavrosflight_;
+  /// Shared-memory statistics segment read by rosflight_top. Must outlive mavlink_comm_.
+  mavrosflight::LiveStats live_stats_;
+  /// Records decoded telemetry to disk when the record parameter is set.
+  mavrosflight::FlightRecorder recorder_;
 };
 
 } // namespace rosflight_io
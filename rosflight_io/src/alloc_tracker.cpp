@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file alloc_tracker.cpp
+ */
+
+#include <rosflight_io/alloc_tracker.hpp>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <rosflight_io/mavrosflight/hot_path.hpp>
+
+// glibc's allocator, which the malloc family below forwards to. These are used rather than
+// dlsym(RTLD_NEXT, ...), since dlsym itself allocates.
+extern "C" {
+void * __libc_malloc(size_t size);
+void * __libc_calloc(size_t count, size_t size);
+void * __libc_realloc(void * ptr, size_t size);
+void * __libc_memalign(size_t alignment, size_t size);
+void * __libc_valloc(size_t size);
+void * __libc_pvalloc(size_t size);
+void __libc_free(void * ptr);
+}
+
+namespace rosflight_io
+{
+namespace
+{
+struct ThreadSlot
+{
+  std::atomic<int> tid{0};
+  char name[16] = {0};
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> hot_allocations{0};
+};
+
+std::atomic<bool> counting{false};
+std::chrono::steady_clock::time_point window_start;
+
+// Slots are handed out on a thread's first counted allocation and kept across windows. Threads
+// beyond the last slot share the overflow slot.
+ThreadSlot thread_slots[AllocTracker::MAX_THREADS];
+ThreadSlot overflow_slot;
+std::atomic<size_t> threads_claimed{0};
+thread_local ThreadSlot * this_thread_slot = nullptr;
+thread_local bool in_tracker = false;
+
+std::atomic<uint64_t> hot_allocations{0};
+std::atomic_flag call_sites_lock = ATOMIC_FLAG_INIT;
+AllocTracker::CallSite call_sites[AllocTracker::MAX_CALL_SITES];
+size_t num_call_sites = 0;
+uint64_t dropped_call_sites = 0;
+
+ThreadSlot & thread_slot()
+{
+  if (this_thread_slot == nullptr) {
+    size_t index = threads_claimed.fetch_add(1, std::memory_order_relaxed);
+    if (index < AllocTracker::MAX_THREADS) {
+      ThreadSlot & slot = thread_slots[index];
+      pthread_getname_np(pthread_self(), slot.name, sizeof(slot.name));
+      slot.tid.store((int) syscall(SYS_gettid), std::memory_order_release);
+      this_thread_slot = &slot;
+    } else {
+      this_thread_slot = &overflow_slot;
+    }
+  }
+  return *this_thread_slot;
+}
+
+void record_call_site(const char * hot_path, int tid, void * const * frames, int depth,
+                      size_t size)
+{
+  while (call_sites_lock.test_and_set(std::memory_order_acquire)) {}
+
+  for (size_t i = 0; i < num_call_sites; i++) {
+    AllocTracker::CallSite & site = call_sites[i];
+    if (site.hot_path == hot_path && site.depth == depth
+        && std::memcmp(site.frames, frames, depth * sizeof(void *)) == 0) {
+      site.count++;
+      site.bytes += size;
+      call_sites_lock.clear(std::memory_order_release);
+      return;
+    }
+  }
+
+  if (num_call_sites < AllocTracker::MAX_CALL_SITES) {
+    AllocTracker::CallSite & site = call_sites[num_call_sites++];
+    site.hot_path = hot_path;
+    site.tid = tid;
+    std::memcpy(site.frames, frames, depth * sizeof(void *));
+    site.depth = depth;
+    site.count = 1;
+    site.bytes = size;
+  } else {
+    dropped_call_sites++;
+  }
+  call_sites_lock.clear(std::memory_order_release);
+}
+
+// Not inlined, so the frames to skip in the call stack are known: this and the operator new or
+// malloc family function that called it
+__attribute__((noinline)) void record_allocation(size_t size)
+{
+  if (in_tracker) {
+    return; // made by the tracker itself, e.g. by backtrace() loading the unwinder
+  }
+  in_tracker = true;
+
+  ThreadSlot & slot = thread_slot();
+  slot.allocations.fetch_add(1, std::memory_order_relaxed);
+  slot.bytes.fetch_add(size, std::memory_order_relaxed);
+
+  const char * hot_path = mavrosflight::HotPath::current();
+  if (hot_path != nullptr) {
+    slot.hot_allocations.fetch_add(1, std::memory_order_relaxed);
+    hot_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    void * frames[AllocTracker::MAX_FRAMES + 2];
+    int depth = backtrace(frames, AllocTracker::MAX_FRAMES + 2);
+    if (depth > 2) {
+      record_call_site(hot_path, slot.tid.load(std::memory_order_relaxed), frames + 2, depth - 2,
+                       size);
+    }
+  }
+
+  in_tracker = false;
+}
+
+__attribute__((always_inline)) inline void * track(void * ptr, size_t size)
+{
+  if (ptr != nullptr && counting.load(std::memory_order_relaxed)) {
+    record_allocation(size);
+  }
+  return ptr;
+}
+
+__attribute__((always_inline)) inline void * allocate(size_t size)
+{
+  void * ptr = track(__libc_malloc(size == 0 ? 1 : size), size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+__attribute__((always_inline)) inline void * allocate_aligned(size_t size, std::align_val_t align)
+{
+  size_t alignment = std::max((size_t) align, sizeof(void *));
+  void * ptr = track(__libc_memalign(alignment, size == 0 ? 1 : size), size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+bool is_valid_alignment(size_t alignment)
+{
+  return alignment >= sizeof(void *) && (alignment & (alignment - 1)) == 0;
+}
+
+void reset_slot(ThreadSlot & slot)
+{
+  slot.allocations.store(0, std::memory_order_relaxed);
+  slot.bytes.store(0, std::memory_order_relaxed);
+  slot.hot_allocations.store(0, std::memory_order_relaxed);
+}
+
+void copy_slot(const ThreadSlot & slot, int tid, const char * name,
+               std::vector<AllocTracker::ThreadCount> & threads)
+{
+  AllocTracker::ThreadCount count;
+  count.tid = tid;
+  std::strncpy(count.name, name, sizeof(count.name) - 1);
+  count.name[sizeof(count.name) - 1] = '\0';
+  count.allocations = slot.allocations.load(std::memory_order_relaxed);
+  count.bytes = slot.bytes.load(std::memory_order_relaxed);
+  count.hot_allocations = slot.hot_allocations.load(std::memory_order_relaxed);
+  if (count.allocations > 0) {
+    threads.push_back(count);
+  }
+}
+
+} // namespace
+
+void AllocTracker::start_window()
+{
+  // The first backtrace() loads the unwinder, which allocates
+  void * frames[MAX_FRAMES];
+  backtrace(frames, MAX_FRAMES);
+
+  for (ThreadSlot & slot : thread_slots) { reset_slot(slot); }
+  reset_slot(overflow_slot);
+  hot_allocations.store(0, std::memory_order_relaxed);
+  while (call_sites_lock.test_and_set(std::memory_order_acquire)) {}
+  num_call_sites = 0;
+  dropped_call_sites = 0;
+  call_sites_lock.clear(std::memory_order_release);
+
+  window_start = std::chrono::steady_clock::now();
+  counting.store(true, std::memory_order_release);
+}
+
+AllocTracker::Window AllocTracker::stop_window()
+{
+  counting.store(false, std::memory_order_release);
+
+  Window window;
+  window.seconds =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - window_start).count();
+  window.hot_allocations = hot_allocations.load(std::memory_order_relaxed);
+
+  size_t claimed = std::min(threads_claimed.load(std::memory_order_acquire), MAX_THREADS);
+  for (size_t i = 0; i < claimed; i++) {
+    const ThreadSlot & slot = thread_slots[i];
+    copy_slot(slot, slot.tid.load(std::memory_order_acquire), slot.name, window.threads);
+  }
+  copy_slot(overflow_slot, 0, "(other)", window.threads);
+
+  while (call_sites_lock.test_and_set(std::memory_order_acquire)) {}
+  window.call_sites.assign(call_sites, call_sites + num_call_sites);
+  window.dropped_call_sites = dropped_call_sites;
+  call_sites_lock.clear(std::memory_order_release);
+
+  std::sort(window.call_sites.begin(), window.call_sites.end(),
+            [](const CallSite & a, const CallSite & b) { return a.count > b.count; });
+  return window;
+}
+
+void AllocTracker::print(const Window & window, FILE * out)
+{
+  fprintf(out, "%-8s %-16s %12s %14s %12s\n", "tid", "thread", "allocations", "bytes",
+          "hot path");
+  for (const ThreadCount & thread : window.threads) {
+    fprintf(out, "%-8d %-16s %12lu %14lu %12lu\n", thread.tid, thread.name,
+            (unsigned long) thread.allocations, (unsigned long) thread.bytes,
+            (unsigned long) thread.hot_allocations);
+  }
+
+  for (const CallSite & site : window.call_sites) {
+    fprintf(out, "\n%lu allocations (%lu bytes) on hot path \"%s\", first on thread %d:\n",
+            (unsigned long) site.count, (unsigned long) site.bytes, site.hot_path, site.tid);
+    for (int i = 0; i < site.depth; i++) {
+      Dl_info info;
+      if (dladdr(site.frames[i], &info) == 0) {
+        fprintf(out, "  #%-2d %p\n", i, site.frames[i]);
+        continue;
+      }
+
+      const char * module = info.dli_fname != nullptr ? info.dli_fname : "?";
+      const char * slash = std::strrchr(module, '/');
+      module = slash != nullptr ? slash + 1 : module;
+      auto module_offset = (unsigned long) ((char *) site.frames[i] - (char *) info.dli_fbase);
+
+      if (info.dli_sname == nullptr) {
+        fprintf(out, "  #%-2d %s+0x%lx\n", i, module, module_offset);
+        continue;
+      }
+      int status = 0;
+      char * demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+      fprintf(out, "  #%-2d %s+0x%lx (%s+0x%lx)\n", i,
+              status == 0 && demangled != nullptr ? demangled : info.dli_sname,
+              (unsigned long) ((char *) site.frames[i] - (char *) info.dli_saddr), module,
+              module_offset);
+      std::free(demangled);
+    }
+  }
+  if (window.dropped_call_sites > 0) {
+    fprintf(out, "\n%lu hot path allocations from further call sites not shown\n",
+            (unsigned long) window.dropped_call_sites);
+  }
+}
+
+} // namespace rosflight_io
+
+// Replacements for the global allocation functions, see the class comment
+
+void * operator new(std::size_t size) { return rosflight_io::allocate(size); }
+void * operator new[](std::size_t size) { return rosflight_io::allocate(size); }
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+  try {
+    return rosflight_io::allocate(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+  try {
+    return rosflight_io::allocate(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void * operator new(std::size_t size, std::align_val_t align)
+{
+  return rosflight_io::allocate_aligned(size, align);
+}
+
+void * operator new[](std::size_t size, std::align_val_t align)
+{
+  return rosflight_io::allocate_aligned(size, align);
+}
+
+void operator delete(void * ptr) noexcept { __libc_free(ptr); }
+void operator delete[](void * ptr) noexcept { __libc_free(ptr); }
+void operator delete(void * ptr, std::size_t) noexcept { __libc_free(ptr); }
+void operator delete[](void * ptr, std::size_t) noexcept { __libc_free(ptr); }
+void operator delete(void * ptr, const std::nothrow_t &) noexcept { __libc_free(ptr); }
+void operator delete[](void * ptr, const std::nothrow_t &) noexcept { __libc_free(ptr); }
+void operator delete(void * ptr, std::align_val_t) noexcept { __libc_free(ptr); }
+void operator delete[](void * ptr, std::align_val_t) noexcept { __libc_free(ptr); }
+void operator delete(void * ptr, std::size_t, std::align_val_t) noexcept { __libc_free(ptr); }
+void operator delete[](void * ptr, std::size_t, std::align_val_t) noexcept { __libc_free(ptr); }
+
+// Interposed malloc family. The shared libraries resolve these to the executable's definitions, so
+// allocations made in C code, e.g. by rcutils, rcl and the DDS, are counted too.
+
+extern "C" {
+void * malloc(size_t size) { return rosflight_io::track(__libc_malloc(size), size); }
+
+void * calloc(size_t count, size_t size)
+{
+  return rosflight_io::track(__libc_calloc(count, size), count * size);
+}
+
+void * realloc(void * ptr, size_t size)
+{
+  return rosflight_io::track(__libc_realloc(ptr, size), size);
+}
+
+void * reallocarray(void * ptr, size_t count, size_t size)
+{
+  size_t total;
+  if (__builtin_mul_overflow(count, size, &total)) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  return rosflight_io::track(__libc_realloc(ptr, total), total);
+}
+
+void * memalign(size_t alignment, size_t size)
+{
+  return rosflight_io::track(__libc_memalign(alignment, size), size);
+}
+
+void * aligned_alloc(size_t alignment, size_t size)
+{
+  return rosflight_io::track(__libc_memalign(alignment, size), size);
+}
+
+int posix_memalign(void ** ptr, size_t alignment, size_t size)
+{
+  if (!rosflight_io::is_valid_alignment(alignment)) {
+    return EINVAL;
+  }
+  void * result = rosflight_io::track(__libc_memalign(alignment, size), size);
+  if (result == nullptr) {
+    return ENOMEM;
+  }
+  *ptr = result;
+  return 0;
+}
+
+void * valloc(size_t size) { return rosflight_io::track(__libc_valloc(size), size); }
+void * pvalloc(size_t size) { return rosflight_io::track(__libc_pvalloc(size), size); }
+
+void free(void * ptr) { __libc_free(ptr); }
+}
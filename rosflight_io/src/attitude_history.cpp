@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file attitude_history.cpp
+ */
+
+#include <rosflight_io/attitude_history.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace rosflight_io
+{
+namespace
+{
+constexpr int64_t CLOCK_RESET_THRESHOLD_NS = 1000000000;
+}
+
+AttitudeHistory::AttitudeHistory(size_t capacity) { reset(capacity); }
+
+void AttitudeHistory::reset(size_t capacity)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  ring_.assign(std::max<size_t>(capacity, 2), Sample());
+  head_ = 0;
+  count_ = 0;
+}
+
+void AttitudeHistory::add(const Sample & sample)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (count_ > 0) {
+    int64_t newest = at(count_ - 1).stamp_ns;
+    if (sample.stamp_ns <= newest) {
+      if (newest - sample.stamp_ns < CLOCK_RESET_THRESHOLD_NS) {
+        return;
+      }
+      count_ = 0;
+    }
+  }
+
+  ring_[head_] = sample;
+  ring_[head_].attitude.normalize();
+  head_ = (head_ + 1) % ring_.size();
+  count_ = std::min(count_ + 1, ring_.size());
+}
+
+AttitudeHistory::Result AttitudeHistory::lookup(int64_t stamp_ns, int64_t max_extrapolation_ns,
+                                                Sample & sample) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (count_ == 0) {
+    return EMPTY;
+  }
+
+  const Sample & oldest = at(0);
+  const Sample & newest = at(count_ - 1);
+  if (stamp_ns <= oldest.stamp_ns || stamp_ns >= newest.stamp_ns) {
+    const Sample & nearest = stamp_ns <= oldest.stamp_ns ? oldest : newest;
+    if (std::abs(stamp_ns - nearest.stamp_ns) > max_extrapolation_ns) {
+      sample = nearest;
+      return OUT_OF_RANGE;
+    }
+    sample = propagate(nearest, stamp_ns);
+    return OK;
+  }
+
+  // First sample at or after the requested time; there is always one before it
+  size_t lo = 0;
+  size_t hi = count_ - 1;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (at(mid).stamp_ns < stamp_ns) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  const Sample & before = at(hi - 1);
+  const Sample & after = at(hi);
+
+  double alpha =
+    (double) (stamp_ns - before.stamp_ns) / (double) (after.stamp_ns - before.stamp_ns);
+  sample.stamp_ns = stamp_ns;
+  sample.attitude = before.attitude.slerp(alpha, after.attitude);
+  sample.angular_velocity =
+    (1.0 - alpha) * before.angular_velocity + alpha * after.angular_velocity;
+  return OK;
+}
+
+bool AttitudeHistory::latest(Sample & sample) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (count_ == 0) {
+    return false;
+  }
+  sample = at(count_ - 1);
+  return true;
+}
+
+size_t AttitudeHistory::size() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return count_;
+}
+
+AttitudeHistory::Sample AttitudeHistory::propagate(const Sample & from, int64_t stamp_ns)
+{
+  // Constant body rate over dt: q(t + dt) = q(t) * exp(omega * dt / 2)
+  double dt = (double) (stamp_ns - from.stamp_ns) * 1e-9;
+  Eigen::Vector3d rotation = from.angular_velocity * dt;
+  double angle = rotation.norm();
+
+  Sample sample = from;
+  sample.stamp_ns = stamp_ns;
+  if (angle > 1e-12) {
+    Eigen::Quaterniond delta(Eigen::AngleAxisd(angle, rotation / angle));
+    sample.attitude = from.attitude * delta;
+    sample.attitude.normalize();
+  }
+  return sample;
+}
+
+} // namespace rosflight_io
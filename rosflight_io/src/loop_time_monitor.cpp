@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file loop_time_monitor.cpp
+ */
+
+#include <rosflight_io/loop_time_monitor.hpp>
+
+#include <algorithm>
+
+namespace rosflight_io
+{
+LoopTimeMonitor::LoopTimeMonitor(size_t window, uint32_t budget_us) { reset(window, budget_us); }
+
+void LoopTimeMonitor::reset(size_t window, uint32_t budget_us)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  ring_.resize(std::max<size_t>(window, 1));
+  budget_us_ = budget_us;
+  clear_locked();
+}
+
+void LoopTimeMonitor::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  clear_locked();
+}
+
+void LoopTimeMonitor::clear_locked()
+{
+  head_ = 0;
+  count_ = 0;
+  histogram_.assign(MAX_LOOP_TIME_US + 1, 0);
+  sum_us_ = 0;
+
+  overruns_ = 0;
+  worst_us_ = 0;
+  warning_ = false;
+
+  last_num_errors_ = -1;
+  total_errors_ = 0;
+}
+
+bool LoopTimeMonitor::add(int64_t stamp_ns, uint32_t loop_time_us, int32_t num_errors)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  loop_time_us = std::min(loop_time_us, MAX_LOOP_TIME_US);
+
+  if (num_errors >= 0) {
+    if (last_num_errors_ >= 0 && num_errors > last_num_errors_) {
+      total_errors_ += (uint64_t) (num_errors - last_num_errors_);
+    }
+    last_num_errors_ = num_errors;
+  }
+
+  // The oldest sample leaves the histogram once the window is full
+  if (count_ == ring_.size()) {
+    const Sample & oldest = ring_[head_];
+    histogram_[oldest.loop_time_us]--;
+    sum_us_ -= oldest.loop_time_us;
+  } else {
+    count_++;
+  }
+  ring_[head_] = {stamp_ns, loop_time_us, total_errors_};
+  head_ = (head_ + 1) % ring_.size();
+  histogram_[loop_time_us]++;
+  sum_us_ += loop_time_us;
+
+  worst_us_ = std::max(worst_us_, loop_time_us);
+  bool overrun = budget_us_ > 0 && loop_time_us > budget_us_;
+  if (overrun) {
+    overruns_++;
+    warning_ = true;
+  }
+  return overrun;
+}
+
+LoopTimeMonitor::Summary LoopTimeMonitor::summary() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  Summary summary;
+  summary.samples = count_;
+  summary.overruns = overruns_;
+  summary.worst_us = worst_us_;
+  summary.budget_us = budget_us_;
+  summary.warning = warning_;
+  if (count_ == 0) {
+    return summary;
+  }
+
+  summary.p50_us = percentile(0.50);
+  summary.p99_us = percentile(0.99);
+  summary.max_us = percentile(1.0);
+  summary.mean_us = (double) sum_us_ / (double) count_;
+
+  const Sample & oldest = ring_[(head_ + ring_.size() - count_) % ring_.size()];
+  const Sample & newest = ring_[(head_ + ring_.size() - 1) % ring_.size()];
+  if (newest.stamp_ns > oldest.stamp_ns) {
+    summary.error_rate = (double) (newest.total_errors - oldest.total_errors)
+      / ((double) (newest.stamp_ns - oldest.stamp_ns) * 1e-9);
+  }
+  return summary;
+}
+
+uint32_t LoopTimeMonitor::percentile(double fraction) const
+{
+  // Same rank as the nth_element percentiles of the SIL profiler
+  auto rank = (size_t) (fraction * (double) (count_ - 1));
+  size_t seen = 0;
+  for (uint32_t us = 0; us <= MAX_LOOP_TIME_US; us++) {
+    seen += histogram_[us];
+    if (seen > rank) {
+      return us;
+    }
+  }
+  return MAX_LOOP_TIME_US;
+}
+
+} // namespace rosflight_io
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file asio_platform.cpp
+ */
+
+#include <rosflight_io/mavrosflight/asio_platform.hpp>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+
+namespace mavrosflight
+{
+namespace
+{
+class AsioTimer : public TimerInterface
+{
+public:
+  AsioTimer(boost::asio::io_service & io_service, std::chrono::nanoseconds period,
+            std::function<void()> callback)
+      : state_(std::make_shared<State>(io_service, period, std::move(callback)))
+  {
+    reset();
+  }
+
+  ~AsioTimer() override { cancel(); }
+
+  void cancel() override
+  {
+    std::lock_guard<std::recursive_mutex> lock(state_->mutex);
+    state_->generation++;
+    state_->timer.cancel();
+  }
+
+  void reset() override
+  {
+    std::lock_guard<std::recursive_mutex> lock(state_->mutex);
+    state_->generation++;
+    state_->timer.expires_at(std::chrono::steady_clock::now() + state_->period);
+    wait(state_, state_->generation);
+  }
+
+private:
+  //! Shared with the pending wait, which may complete after the timer is destroyed
+  struct State
+  {
+    State(boost::asio::io_service & io_service, std::chrono::nanoseconds period,
+          std::function<void()> callback)
+        : timer(io_service)
+        , period(period)
+        , callback(std::move(callback))
+    {}
+
+    boost::asio::steady_timer timer;
+    std::chrono::nanoseconds period;
+    std::function<void()> callback;
+    //! Held while the callback runs, which may cancel or reset its own timer
+    std::recursive_mutex mutex;
+    //! Bumped by cancel and reset, so a wait from before them does nothing
+    uint64_t generation = 0;
+  };
+
+  static void wait(const std::shared_ptr<State> & state, uint64_t generation)
+  {
+    state->timer.async_wait([state, generation](const boost::system::error_code & error) {
+      if (error) {
+        return;
+      }
+
+      std::lock_guard<std::recursive_mutex> lock(state->mutex);
+      if (state->generation != generation) {
+        return;
+      }
+      state->callback();
+      if (state->generation == generation) {
+        state->timer.expires_at(state->timer.expiry() + state->period);
+        wait(state, generation);
+      }
+    });
+  }
+
+  std::shared_ptr<State> state_;
+};
+
+const char * severity_name(LoggerInterface::Severity severity)
+{
+  switch (severity) {
+    case LoggerInterface::Severity::DEBUG:
+      return "DEBUG";
+    case LoggerInterface::Severity::INFO:
+      return "INFO";
+    case LoggerInterface::Severity::WARN:
+      return "WARN";
+    case LoggerInterface::Severity::ERROR:
+      return "ERROR";
+  }
+  return "";
+}
+
+} // namespace
+
+std::chrono::nanoseconds SystemClock::now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch());
+}
+
+AsioTimerFactory::AsioTimerFactory()
+    : io_service_(own_io_service_)
+    , work_(new boost::asio::io_service::work(own_io_service_))
+{
+  thread_ = boost::thread(boost::bind(&boost::asio::io_service::run, &own_io_service_));
+}
+
+AsioTimerFactory::AsioTimerFactory(boost::asio::io_service & io_service)
+    : io_service_(io_service)
+{}
+
+AsioTimerFactory::~AsioTimerFactory()
+{
+  if (thread_.joinable()) {
+    work_.reset();
+    own_io_service_.stop();
+    thread_.join();
+  }
+}
+
+std::unique_ptr<TimerInterface>
+AsioTimerFactory::create_wall_timer(std::chrono::nanoseconds period, std::function<void()> callback)
+{
+  return std::make_unique<AsioTimer>(io_service_, period, std::move(callback));
+}
+
+StreamLogger::StreamLogger(std::ostream & stream, Severity min_severity)
+    : stream_(stream)
+    , min_severity_(min_severity)
+{}
+
+void StreamLogger::write(Severity severity, const char * message)
+{
+  if (severity < min_severity_) {
+    return;
+  }
+
+  std::chrono::nanoseconds now = SystemClock().now();
+  char stamp[32];
+  snprintf(stamp, sizeof(stamp), "%ld.%09ld", (long) (now.count() / 1000000000),
+           (long) (now.count() % 1000000000));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  stream_ << "[" << severity_name(severity) << "] [" << stamp << "] [mavrosflight]: " << message
+          << std::endl;
+}
+
+Platform make_asio_platform(LoggerInterface::Severity min_severity)
+{
+  return Platform{std::make_shared<SystemClock>(), std::make_shared<AsioTimerFactory>(),
+                  std::make_shared<StreamLogger>(std::cerr, min_severity)};
+}
+
+} // namespace mavrosflight
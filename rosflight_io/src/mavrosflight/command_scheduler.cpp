@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file command_scheduler.cpp
+ */
+
+#include <rosflight_io/mavrosflight/command_scheduler.hpp>
+#include <rosflight_io/mavrosflight/hot_path.hpp>
+
+namespace mavrosflight
+{
+CommandScheduler::CommandScheduler(MavlinkComm & comm, const Platform & platform,
+                                   std::chrono::nanoseconds period,
+                                   std::chrono::nanoseconds timeout)
+    : comm_(comm)
+    , platform_(platform)
+    , timeout_(timeout)
+{
+  timer_ = comm_.create_link_timer(period, [this]() { transmit(); });
+}
+
+void CommandScheduler::latch(const OffboardCommand & command)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  offboard_.command = command;
+  offboard_.time = SteadyClock::now();
+  offboard_.sending = true;
+}
+
+void CommandScheduler::latch(const AuxCommand & command)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  aux_.command = command;
+  aux_.time = SteadyClock::now();
+  aux_.sending = true;
+}
+
+void CommandScheduler::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  offboard_.sending = false;
+  aux_.sending = false;
+}
+
+void CommandScheduler::transmit()
+{
+  HotPath hot_path("command_scheduler.transmit");
+  SteadyClock::time_point now = SteadyClock::now();
+
+  OffboardCommand offboard;
+  AuxCommand aux;
+  bool send_offboard, send_aux;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    send_offboard = take(offboard_, now, "Offboard", offboard);
+    send_aux = take(aux_, now, "Aux", aux);
+  }
+
+  mavlink_message_t msg;
+  if (send_offboard) {
+    mavlink_msg_offboard_control_pack(1, 50, &msg, offboard.mode, offboard.ignore, offboard.x,
+                                      offboard.y, offboard.z, offboard.F);
+    comm_.send_message(msg);
+  }
+  if (send_aux) {
+    mavlink_msg_rosflight_aux_cmd_pack(1, 50, &msg, aux.types, aux.values);
+    comm_.send_message(msg);
+  }
+}
+
+template<class T>
+bool CommandScheduler::take(Latched<T> & latched, SteadyClock::time_point now, const char * name,
+                            T & command)
+{
+  if (!latched.sending) {
+    return false;
+  }
+
+  if (now - latched.time > timeout_) {
+    latched.sending = false;
+    platform_.logger->log(LoggerInterface::Severity::WARN,
+                          "%s command not renewed for %.0f ms, stopped sending it", name,
+                          std::chrono::duration<double, std::milli>(timeout_).count());
+    return false;
+  }
+
+  command = latched.command;
+  return true;
+}
+
+} // namespace mavrosflight
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file flight_record.cpp
+ */
+
+#include <rosflight_io/mavrosflight/flight_record.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace mavrosflight
+{
+size_t record_column_size(RecordColumnType type)
+{
+  switch (type) {
+    case RecordColumnType::UINT8:
+      return 1;
+    case RecordColumnType::UINT16:
+    case RecordColumnType::INT16:
+      return 2;
+    case RecordColumnType::UINT32:
+    case RecordColumnType::INT32:
+    case RecordColumnType::FLOAT32:
+      return 4;
+    case RecordColumnType::UINT64:
+    case RecordColumnType::INT64:
+      return 8;
+  }
+  return 0;
+}
+
+int RecordSchema::column_index(const std::string & column_name) const
+{
+  for (size_t i = 0; i < columns.size(); i++) {
+    if (columns[i].name == column_name) {
+      return (int) i;
+    }
+  }
+  return -1;
+}
+
+size_t RecordSchema::row_size() const
+{
+  size_t size = 0;
+  for (const auto & column : columns) { size += record_column_size(column.type); }
+  return size;
+}
+
+double FlightRecordReader::Chunk::as_double(size_t column, size_t row) const
+{
+  switch (schema->columns[column].type) {
+    case RecordColumnType::UINT8:
+      return get<uint8_t>(column, row);
+    case RecordColumnType::UINT16:
+      return get<uint16_t>(column, row);
+    case RecordColumnType::UINT32:
+      return get<uint32_t>(column, row);
+    case RecordColumnType::UINT64:
+      return (double) get<uint64_t>(column, row);
+    case RecordColumnType::INT16:
+      return get<int16_t>(column, row);
+    case RecordColumnType::INT32:
+      return get<int32_t>(column, row);
+    case RecordColumnType::INT64:
+      return (double) get<int64_t>(column, row);
+    case RecordColumnType::FLOAT32:
+      return get<float>(column, row);
+  }
+  return 0.0;
+}
+
+FlightRecordReader::~FlightRecordReader() { close(); }
+
+bool FlightRecordReader::open(const std::string & path, std::string & error)
+{
+  close();
+
+  fd_ = ::open(path.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    error = path + ": " + strerror(errno);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd_, &st) != 0 || (size_t) st.st_size < sizeof(FlightRecordHeader)) {
+    error = path + ": not a flight record";
+    close();
+    return false;
+  }
+  mapped_size_ = (size_t) st.st_size;
+  size_ = mapped_size_;
+
+  void * data = mmap(nullptr, mapped_size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) {
+    error = path + ": " + strerror(errno);
+    close();
+    return false;
+  }
+  data_ = static_cast<const uint8_t *>(data);
+  header_ = reinterpret_cast<const FlightRecordHeader *>(data_);
+
+  if (memcmp(header_->magic, FLIGHT_RECORD_MAGIC, sizeof(FLIGHT_RECORD_MAGIC)) != 0) {
+    error = path + ": not a flight record";
+    close();
+    return false;
+  }
+  if (header_->version != FLIGHT_RECORD_VERSION) {
+    error = path + ": unsupported flight record version " + std::to_string(header_->version);
+    close();
+    return false;
+  }
+
+  // Schema table
+  size_t offset = sizeof(FlightRecordHeader);
+  for (uint32_t i = 0; i < header_->schema_count; i++) {
+    if (offset + sizeof(FlightRecordSchemaEntry) > size_) {
+      error = path + ": truncated schema table";
+      close();
+      return false;
+    }
+    const auto * entry = reinterpret_cast<const FlightRecordSchemaEntry *>(data_ + offset);
+    offset += sizeof(FlightRecordSchemaEntry);
+
+    RecordSchema schema;
+    schema.msgid = entry->msgid;
+    schema.name.assign(entry->name, strnlen(entry->name, sizeof(entry->name)));
+    for (uint32_t c = 0; c < entry->column_count; c++) {
+      if (offset + sizeof(FlightRecordColumnEntry) > size_) {
+        error = path + ": truncated schema table";
+        close();
+        return false;
+      }
+      const auto * column = reinterpret_cast<const FlightRecordColumnEntry *>(data_ + offset);
+      offset += sizeof(FlightRecordColumnEntry);
+      std::string name(column->name, strnlen(column->name, sizeof(column->name)));
+      schema.columns.push_back({name, static_cast<RecordColumnType>(column->type)});
+    }
+    schemas_.push_back(std::move(schema));
+  }
+
+  // A segment that was not closed cleanly still has its preallocated size; only trust used_bytes
+  size_ = std::min<size_t>(size_, header_->used_bytes);
+  offset_ = header_->data_offset;
+  return true;
+}
+
+void FlightRecordReader::close()
+{
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t *>(data_), mapped_size_);
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+  fd_ = -1;
+  data_ = nullptr;
+  header_ = nullptr;
+  mapped_size_ = 0;
+  size_ = 0;
+  offset_ = 0;
+  schemas_.clear();
+}
+
+bool FlightRecordReader::next(Chunk & chunk)
+{
+  if (data_ == nullptr || offset_ + sizeof(FlightRecordChunkHeader) > size_) {
+    return false;
+  }
+
+  const auto * header = reinterpret_cast<const FlightRecordChunkHeader *>(data_ + offset_);
+  if (header->magic != FLIGHT_RECORD_CHUNK_MAGIC || header->schema >= schemas_.size()
+      || offset_ + sizeof(FlightRecordChunkHeader) + header->payload_bytes > size_) {
+    return false;
+  }
+
+  chunk.schema = &schemas_[header->schema];
+  chunk.rows = header->rows;
+  chunk.columns.clear();
+  const uint8_t * column = data_ + offset_ + sizeof(FlightRecordChunkHeader);
+  for (const auto & c : chunk.schema->columns) {
+    chunk.columns.push_back(column);
+    column += record_column_size(c.type) * header->rows;
+  }
+
+  offset_ += sizeof(FlightRecordChunkHeader) + header->payload_bytes;
+  return true;
+}
+
+std::vector<std::string> FlightRecordReader::segments(const std::string & directory)
+{
+  std::vector<std::string> paths;
+  DIR * dir = opendir(directory.c_str());
+  if (dir == nullptr) {
+    return paths;
+  }
+
+  std::string extension = FLIGHT_RECORD_EXTENSION;
+  while (struct dirent * entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name.size() > extension.size()
+        && name.compare(name.size() - extension.size(), extension.size(), extension) == 0) {
+      paths.push_back(directory + "/" + name);
+    }
+  }
+  closedir(dir);
+
+  // Segment names are zero padded, so lexical order is recording order
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
+} // namespace mavrosflight
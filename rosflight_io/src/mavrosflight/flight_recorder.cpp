@@ -0,0 +1,556 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file flight_recorder.cpp
+ */
+
+#include <rosflight_io/mavrosflight/flight_recorder.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+namespace mavrosflight
+{
+namespace
+{
+using T = RecordColumnType;
+
+/**
+ * \brief Stores the fields of one row into a chunk, one column after the other
+ */
+class RowWriter
+{
+public:
+  RowWriter(uint8_t * data, const std::vector<size_t> & offsets,
+            const std::vector<RecordColumn> & columns, uint32_t row)
+      : data_(data)
+      , offsets_(offsets)
+      , columns_(columns)
+      , row_(row)
+  {}
+
+  template<typename V>
+  RowWriter & operator<<(V value)
+  {
+    assert(column_ < columns_.size() && record_column_size(columns_[column_].type) == sizeof(V));
+    memcpy(data_ + offsets_[column_] + row_ * sizeof(V), &value, sizeof(V));
+    column_++;
+    return *this;
+  }
+
+private:
+  uint8_t * data_;
+  const std::vector<size_t> & offsets_;
+  const std::vector<RecordColumn> & columns_;
+  uint32_t row_;
+  size_t column_ = 0;
+};
+
+struct RecordType
+{
+  RecordSchema schema;
+  void (*append)(RowWriter & row, const mavlink_message_t & msg);
+};
+
+RecordSchema schema(uint32_t msgid, const char * name, std::vector<RecordColumn> columns)
+{
+  columns.insert(columns.begin(), {"recv_time_ns", T::INT64});
+  return {msgid, name, std::move(columns)};
+}
+
+std::vector<RecordColumn> numbered(const char * prefix, size_t count, RecordColumnType type)
+{
+  std::vector<RecordColumn> columns;
+  for (size_t i = 0; i < count; i++) { columns.push_back({prefix + std::to_string(i), type}); }
+  return columns;
+}
+
+// clang-format off
+const std::vector<RecordType> & record_types()
+{
+  static const std::vector<RecordType> types = {
+    {schema(MAVLINK_MSG_ID_SMALL_IMU, "small_imu",
+            {{"time_boot_us", T::UINT64}, {"xacc", T::FLOAT32}, {"yacc", T::FLOAT32},
+             {"zacc", T::FLOAT32}, {"xgyro", T::FLOAT32}, {"ygyro", T::FLOAT32},
+             {"zgyro", T::FLOAT32}, {"temperature", T::FLOAT32}}),
+     [](RowWriter & row, const mavlink_message_t & msg) {
+       mavlink_small_imu_t imu;
+       mavlink_msg_small_imu_decode(&msg, &imu);
+       row << (uint64_t) imu.time_boot_us << (float) imu.xacc << (float) imu.yacc
+           << (float) imu.zacc << (float) imu.xgyro << (float) imu.ygyro << (float) imu.zgyro
+           << (float) imu.temperature;
+     }},
+    {schema(MAVLINK_MSG_ID_ATTITUDE_QUATERNION, "attitude_quaternion",
+            {{"time_boot_ms", T::UINT32}, {"q1", T::FLOAT32}, {"q2", T::FLOAT32},
+             {"q3", T::FLOAT32}, {"q4", T::FLOAT32}, {"rollspeed", T::FLOAT32},
+             {"pitchspeed", T::FLOAT32}, {"yawspeed", T::FLOAT32}}),
+     [](RowWriter & row, const mavlink_message_t & msg) {
+       mavlink_attitude_quaternion_t att;
+       mavlink_msg_attitude_quaternion_decode(&msg, &att);
+       row << (uint32_t) att.time_boot_ms << (float) att.q1 << (float) att.q2 << (float) att.q3
+           << (float) att.q4 << (float) att.rollspeed << (float) att.pitchspeed
+           << (float) att.yawspeed;
+     }},
+    {schema(MAVLINK_MSG_ID_SMALL_MAG, "small_mag",
+            {{"xmag", T::FLOAT32}, {"ymag", T::FLOAT32}, {"zmag", T::FLOAT32}}),
+     [](RowWriter & row, const mavlink_message_t & msg) {
+       mavlink_small_mag_t mag;
+       mavlink_msg_small_mag_decode(&msg, &mag);
+       row << (float) mag.xmag << (float) mag.ymag << (float) mag.zmag;
+     }},
+    {schema(MAVLINK_MSG_ID_SMALL_BARO, "small_baro",
+            {{"altitude", T::FLOAT32}, {"pressure", T::FLOAT32}, {"temperature", T::FLOAT32}}),
+     [](RowWriter & row, const mavlink_message_t & msg) {
+       mavlink_small_baro_t baro;
+       mavlink_msg_small_baro_decode(&msg, &baro);
+       row << (float) baro.altitude << (float) baro.pressure << (float) baro.temperature;
+     }},
+    {schema(MAVLINK_MSG_ID_DIFF_PRESSURE, "diff_pressure",
+            {{"velocity", T::FLOAT32}, {"diff_pressure", T::FLOAT32},
+             {"temperature", T::FLOAT32}}),
+     [](RowWriter & row, const mavlink_message_t & msg) {
+       mavlink_diff_pressure_t diff;
+       mavlink_msg_diff_pressure_decode(&msg, &diff);
+       row << (float) diff.velocity << (float) diff.diff_pressure << (float) diff.temperature;
+     }},
+    {schema(MAVLINK_MSG_ID_SMALL_RANGE, "small_range",
+            {{"type", T::UINT8}, {"range", T::FLOAT32}, {"max_range", T::FLOAT32},
+             {"min_range", T::FLOAT32}}),
+     [](RowWriter & row, const mavlink_message_t & msg) {
+       mavlink_small_range_t range;
+       mavlink_msg_small_range_decode(&msg, &range);
+       row << (uint8_t) range.type << (float) range.range << (float) range.max_range
+           << (float) range.min_range;
+     }},
+    {[]() {
+       std::vector<RecordColumn> columns = numbered("value", 14, T::FLOAT32);
+       columns.insert(columns.begin(), {"stamp", T::UINT64});
+       return schema(MAVLINK_MSG_ID_ROSFLIGHT_OUTPUT_RAW, "rosflight_output_raw", columns);
+     }(),
+     [](RowWriter & row, const mavlink_message_t & msg) {
+       mavlink_rosflight_output_raw_t servo;
+       mavlink_msg_rosflight_output_raw_decode(&msg, &servo);
+       row << (uint64_t) servo.stamp;
+       for (float value : servo.values) { row << value; }
+     }},
+    {[]() {
+       std::vector<RecordColumn> columns = numbered("chan", 8, T::UINT16);
+       columns.insert(columns.begin(), {"time_boot_ms", T::UINT32});
+       return schema(MAVLINK_MSG_ID_RC_CHANNELS_RAW, "rc_channels_raw", columns);
+     }(),
+     [](RowWriter & row, const mavlink_message_t & msg) {
+       mavlink_rc_channels_raw_t rc;
+       mavlink_msg_rc_channels_raw_decode(&msg, &rc);
+       row << (uint32_t) rc.time_boot_ms << (uint16_t) rc.chan1_raw << (uint16_t) rc.chan2_raw
+           << (uint16_t) rc.chan3_raw << (uint16_t) rc.chan4_raw << (uint16_t) rc.chan5_raw
+           << (uint16_t) rc.chan6_raw << (uint16_t) rc.chan7_raw << (uint16_t) rc.chan8_raw;
+     }},
+    {schema(MAVLINK_MSG_ID_ROSFLIGHT_STATUS, "rosflight_status",
+            {{"armed", T::UINT8}, {"failsafe", T::UINT8}, {"rc_override", T::UINT8},
+             {"offboard", T::UINT8}, {"control_mode", T::UINT8}, {"error_code", T::UINT8},
+             {"num_errors", T::INT16}, {"loop_time_us", T::INT16}}),
+     [](RowWriter & row, const mavlink_message_t & msg) {
+       mavlink_rosflight_status_t status;
+       mavlink_msg_rosflight_status_decode(&msg, &status);
+       row << (uint8_t) status.armed << (uint8_t) status.failsafe << (uint8_t) status.rc_override
+           << (uint8_t) status.offboard << (uint8_t) status.control_mode
+           << (uint8_t) status.error_code << (int16_t) status.num_errors
+           << (int16_t) status.loop_time_us;
+     }},
+    {schema(MAVLINK_MSG_ID_ROSFLIGHT_BATTERY_STATUS, "rosflight_battery_status",
+            {{"battery_voltage", T::FLOAT32}, {"battery_current", T::FLOAT32}}),
+     [](RowWriter & row, const mavlink_message_t & msg) {
+       mavlink_rosflight_battery_status_t battery;
+       mavlink_msg_rosflight_battery_status_decode(&msg, &battery);
+       row << (float) battery.battery_voltage << (float) battery.battery_current;
+     }},
+    {schema(MAVLINK_MSG_ID_ROSFLIGHT_GNSS, "rosflight_gnss",
+            {{"rosflight_timestamp", T::UINT64}, {"time", T::INT64}, {"nanos", T::UINT32},
+             {"fix_type", T::UINT8}, {"lat", T::INT32}, {"lon", T::INT32}, {"height", T::INT32},
+             {"vel_n", T::FLOAT32}, {"vel_e", T::FLOAT32}, {"vel_d", T::FLOAT32},
+             {"h_acc", T::FLOAT32}, {"v_acc", T::FLOAT32}, {"ecef_x", T::INT32},
+             {"ecef_y", T::INT32}, {"ecef_z", T::INT32}, {"p_acc", T::FLOAT32},
+             {"ecef_v_x", T::INT32}, {"ecef_v_y", T::INT32}, {"ecef_v_z", T::INT32},
+             {"s_acc", T::FLOAT32}}),
+     [](RowWriter & row, const mavlink_message_t & msg) {
+       mavlink_rosflight_gnss_t gnss;
+       mavlink_msg_rosflight_gnss_decode(&msg, &gnss);
+       row << (uint64_t) gnss.rosflight_timestamp << (int64_t) gnss.time << (uint32_t) gnss.nanos
+           << (uint8_t) gnss.fix_type << (int32_t) gnss.lat << (int32_t) gnss.lon
+           << (int32_t) gnss.height << (float) gnss.vel_n << (float) gnss.vel_e
+           << (float) gnss.vel_d << (float) gnss.h_acc << (float) gnss.v_acc
+           << (int32_t) gnss.ecef_x << (int32_t) gnss.ecef_y << (int32_t) gnss.ecef_z
+           << (float) gnss.p_acc << (int32_t) gnss.ecef_v_x << (int32_t) gnss.ecef_v_y
+           << (int32_t) gnss.ecef_v_z << (float) gnss.s_acc;
+     }},
+  };
+  return types;
+}
+// clang-format on
+
+int64_t realtime_ns()
+{
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+size_t align(size_t value, size_t alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+bool make_directories(const std::string & path)
+{
+  for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+    std::string prefix = path.substr(0, pos);
+    if (!prefix.empty() && mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+      return false;
+    }
+    if (pos == std::string::npos) {
+      return true;
+    }
+  }
+}
+
+} // namespace
+
+const std::vector<RecordSchema> & FlightRecorder::schemas()
+{
+  static const std::vector<RecordSchema> schemas = []() {
+    std::vector<RecordSchema> result;
+    for (const auto & type : record_types()) { result.push_back(type.schema); }
+    return result;
+  }();
+  return schemas;
+}
+
+FlightRecorder::FlightRecorder() { schema_by_msgid_.fill(-1); }
+
+FlightRecorder::~FlightRecorder() { close(); }
+
+bool FlightRecorder::open(const std::string & directory, size_t segment_size, std::string & error)
+{
+  close();
+
+  const auto & types = record_types();
+  directory_ = directory;
+  segment_size_ = segment_size;
+  segment_index_ = 0;
+  start_time_ns_ = realtime_ns();
+  stop_ = false;
+
+  if (!make_directories(directory_)) {
+    error = directory_ + ": " + strerror(errno);
+    return false;
+  }
+
+  // Preallocate every chunk the recording will use
+  schema_by_msgid_.fill(-1);
+  column_offsets_.assign(types.size(), {});
+  free_.assign(types.size(), {});
+  active_.assign(types.size(), nullptr);
+  chunks_.clear();
+  size_t largest_chunk = 0;
+  for (size_t i = 0; i < types.size(); i++) {
+    const RecordSchema & schema = types[i].schema;
+    if (schema.msgid < schema_by_msgid_.size()) {
+      schema_by_msgid_[schema.msgid] = (int16_t) i;
+    }
+
+    size_t offset = 0;
+    for (const auto & column : schema.columns) {
+      column_offsets_[i].push_back(offset);
+      offset += record_column_size(column.type) * FLIGHT_RECORD_CHUNK_ROWS;
+    }
+    largest_chunk = std::max(largest_chunk, offset);
+
+    for (size_t c = 0; c < CHUNKS_PER_TYPE; c++) {
+      auto chunk = std::make_unique<Chunk>();
+      chunk->schema = (uint16_t) i;
+      chunk->rows = 0;
+      chunk->data.resize(offset);
+      free_[i].push_back(chunk.get());
+      chunks_.push_back(std::move(chunk));
+    }
+  }
+
+  if (segment_size_ < 4 * largest_chunk) {
+    error = "segment size must be at least " + std::to_string(4 * largest_chunk) + " bytes";
+    return false;
+  }
+
+  if (!open_segment(error)) {
+    return false;
+  }
+
+  writer_thread_ = std::thread(&FlightRecorder::writer_loop, this);
+  open_ = true;
+  return true;
+}
+
+void FlightRecorder::close()
+{
+  if (!open_) {
+    return;
+  }
+
+  for (Chunk *& chunk : active_) {
+    if (chunk != nullptr && chunk->rows > 0) {
+      submit_chunk(chunk);
+      chunk = nullptr;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  if (writer_thread_.joinable()) {
+    writer_thread_.join();
+  }
+
+  close_segment();
+  open_ = false;
+}
+
+void FlightRecorder::handle_mavlink_message(const mavlink_message_t & msg)
+{
+  if (!open_ || (size_t) msg.msgid >= schema_by_msgid_.size()) {
+    return;
+  }
+  int16_t schema = schema_by_msgid_[msg.msgid];
+  if (schema < 0) {
+    return;
+  }
+
+  Chunk *& chunk = active_[schema];
+  if (chunk == nullptr) {
+    chunk = acquire_chunk(schema);
+    if (chunk == nullptr) {
+      rows_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  const RecordType & type = record_types()[schema];
+  RowWriter row(chunk->data.data(), column_offsets_[schema], type.schema.columns, chunk->rows);
+  row << realtime_ns();
+  type.append(row, msg);
+  rows_recorded_.fetch_add(1, std::memory_order_relaxed);
+
+  if (++chunk->rows == FLIGHT_RECORD_CHUNK_ROWS) {
+    submit_chunk(chunk);
+    chunk = nullptr;
+  }
+}
+
+FlightRecorder::Chunk * FlightRecorder::acquire_chunk(size_t schema)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (free_[schema].empty()) {
+    return nullptr;
+  }
+  Chunk * chunk = free_[schema].back();
+  free_[schema].pop_back();
+  chunk->rows = 0;
+  return chunk;
+}
+
+void FlightRecorder::submit_chunk(Chunk * chunk)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    full_.push_back(chunk);
+  }
+  cv_.notify_one();
+}
+
+void FlightRecorder::writer_loop()
+{
+  while (true) {
+    Chunk * chunk;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stop_ || !full_.empty(); });
+      if (full_.empty()) {
+        return;
+      }
+      chunk = full_.front();
+      full_.pop_front();
+    }
+
+    if (!write_chunk(*chunk)) {
+      rows_dropped_.fetch_add(chunk->rows, std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_[chunk->schema].push_back(chunk);
+  }
+}
+
+bool FlightRecorder::write_chunk(const Chunk & chunk)
+{
+  const RecordSchema & schema = record_types()[chunk.schema].schema;
+  size_t payload = align(schema.row_size() * chunk.rows, 8);
+  size_t needed = sizeof(FlightRecordChunkHeader) + payload;
+
+  if (segment_ == nullptr || segment_used_ + needed > segment_size_) {
+    close_segment();
+    segment_index_++;
+    std::string error;
+    if (!open_segment(error)) {
+      fprintf(stderr, "flight recorder: %s\n", error.c_str());
+      return false;
+    }
+  }
+
+  uint8_t * dest = segment_ + segment_used_;
+  FlightRecordChunkHeader header = {};
+  header.magic = FLIGHT_RECORD_CHUNK_MAGIC;
+  header.schema = chunk.schema;
+  header.rows = chunk.rows;
+  header.payload_bytes = (uint32_t) payload;
+  memcpy(dest, &header, sizeof(header));
+  dest += sizeof(header);
+
+  // Columns are stored with the chunk's row count, so a partially filled chunk is compacted
+  const auto & offsets = column_offsets_[chunk.schema];
+  for (size_t c = 0; c < schema.columns.size(); c++) {
+    size_t bytes = record_column_size(schema.columns[c].type) * chunk.rows;
+    memcpy(dest, chunk.data.data() + offsets[c], bytes);
+    dest += bytes;
+  }
+
+  // Publish the chunk to readers of a live segment only once it is complete
+  segment_used_ += needed;
+  __atomic_store_n(&reinterpret_cast<FlightRecordHeader *>(segment_)->used_bytes,
+                   (uint64_t) segment_used_, __ATOMIC_RELEASE);
+  bytes_written_.fetch_add(needed, std::memory_order_relaxed);
+  return true;
+}
+
+bool FlightRecorder::open_segment(std::string & error)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "/segment_%05u", segment_index_);
+  std::string path = directory_ + name + FLIGHT_RECORD_EXTENSION;
+
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    error = path + ": " + strerror(errno);
+    return false;
+  }
+
+  // Reserve the whole segment up front so writing never has to extend the file
+  int result = posix_fallocate(fd_, 0, (off_t) segment_size_);
+  if (result != 0) {
+    error = path + ": " + strerror(result);
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+
+  void * data = mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) {
+    error = path + ": " + strerror(errno);
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  segment_ = static_cast<uint8_t *>(data);
+  madvise(segment_, segment_size_, MADV_SEQUENTIAL);
+
+  // Header and schema table
+  const auto & types = record_types();
+  size_t offset = sizeof(FlightRecordHeader);
+  for (const auto & type : types) {
+    FlightRecordSchemaEntry entry = {};
+    strncpy(entry.name, type.schema.name.c_str(), sizeof(entry.name) - 1);
+    entry.msgid = type.schema.msgid;
+    entry.column_count = (uint32_t) type.schema.columns.size();
+    memcpy(segment_ + offset, &entry, sizeof(entry));
+    offset += sizeof(entry);
+
+    for (const auto & column : type.schema.columns) {
+      FlightRecordColumnEntry column_entry = {};
+      strncpy(column_entry.name, column.name.c_str(), sizeof(column_entry.name) - 1);
+      column_entry.type = (uint8_t) column.type;
+      memcpy(segment_ + offset, &column_entry, sizeof(column_entry));
+      offset += sizeof(column_entry);
+    }
+  }
+
+  FlightRecordHeader header = {};
+  memcpy(header.magic, FLIGHT_RECORD_MAGIC, sizeof(header.magic));
+  header.version = FLIGHT_RECORD_VERSION;
+  header.segment_index = segment_index_;
+  header.start_time_ns = start_time_ns_;
+  header.schema_count = (uint32_t) types.size();
+  header.data_offset = (uint32_t) align(offset, 64);
+  header.chunk_rows = FLIGHT_RECORD_CHUNK_ROWS;
+  header.used_bytes = header.data_offset;
+  memcpy(segment_, &header, sizeof(header));
+
+  segment_used_ = header.data_offset;
+  bytes_written_.fetch_add(segment_used_, std::memory_order_relaxed);
+  return true;
+}
+
+void FlightRecorder::close_segment()
+{
+  if (segment_ != nullptr) {
+    munmap(segment_, segment_size_);
+    segment_ = nullptr;
+  }
+  if (fd_ >= 0) {
+    // Give back the unused part of the preallocation
+    if (ftruncate(fd_, (off_t) segment_used_) != 0) {
+      fprintf(stderr, "flight recorder: could not truncate segment: %s\n", strerror(errno));
+    }
+    ::close(fd_);
+    fd_ = -1;
+  }
+  segment_used_ = 0;
+}
+
+} // namespace mavrosflight
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file live_stats.cpp
+ */
+
+#include <rosflight_io/mavrosflight/live_stats.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <new>
+
+namespace mavrosflight
+{
+void LiveStatsHistogram::record(int64_t duration_ns)
+{
+  uint64_t us = duration_ns > 0 ? (uint64_t) duration_ns / 1000 : 0;
+  size_t bucket = us == 0 ? 0 : (size_t) (64 - __builtin_clzll(us));
+  if (bucket >= LIVE_STATS_HISTOGRAM_BUCKETS) {
+    bucket = LIVE_STATS_HISTOGRAM_BUCKETS - 1;
+  }
+  buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+double LiveStatsHistogram::percentile_us(const uint64_t (&counts)[LIVE_STATS_HISTOGRAM_BUCKETS],
+                                         double percentile)
+{
+  uint64_t total = 0;
+  for (uint64_t count : counts) {
+    total += count;
+  }
+  if (total == 0) {
+    return 0.0;
+  }
+
+  auto target = (uint64_t) std::ceil(percentile * (double) total);
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < LIVE_STATS_HISTOGRAM_BUCKETS; i++) {
+    cumulative += counts[i];
+    if (cumulative >= target && cumulative > 0) {
+      return std::ldexp(1.0, (int) i);
+    }
+  }
+  return std::ldexp(1.0, (int) LIVE_STATS_HISTOGRAM_BUCKETS - 1);
+}
+
+LiveStats::~LiveStats()
+{
+  if (segment_ != nullptr) {
+    munmap(segment_, sizeof(LiveStatsSegment));
+    shm_unlink(shm_name_.c_str());
+  }
+}
+
+bool LiveStats::open(const std::string & node_name, LiveStatsKind kind)
+{
+  shm_name_ = segment_name(node_name);
+
+  // Remove any segment left behind by a previous run instead of truncating it, so readers that
+  // still have the old one mapped aren't affected
+  shm_unlink(shm_name_.c_str());
+  int fd = shm_open(shm_name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  if (ftruncate(fd, sizeof(LiveStatsSegment)) != 0) {
+    ::close(fd);
+    shm_unlink(shm_name_.c_str());
+    return false;
+  }
+
+  void * addr = mmap(nullptr, sizeof(LiveStatsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    shm_unlink(shm_name_.c_str());
+    return false;
+  }
+
+  std::memset(addr, 0, sizeof(LiveStatsSegment));
+  segment_ = new (addr) LiveStatsSegment;
+  segment_->magic = LIVE_STATS_MAGIC;
+  segment_->version = LIVE_STATS_VERSION;
+  segment_->size = sizeof(LiveStatsSegment);
+  segment_->kind = kind;
+  segment_->pid = getpid();
+  strncpy(segment_->name, node_name.c_str(), LIVE_STATS_NAME_LEN - 1);
+  segment_->last_update_ns.store(now_ns(), std::memory_order_relaxed);
+  segment_->ready.store(1, std::memory_order_release);
+  return true;
+}
+
+std::string LiveStats::segment_name(const std::string & node_name)
+{
+  std::string name = "/" + std::string(LIVE_STATS_PREFIX);
+  for (size_t i = 0; i < node_name.size(); i++) {
+    if (node_name[i] == '/') {
+      if (i != 0) {
+        name += '.';
+      }
+    } else {
+      name += node_name[i];
+    }
+  }
+  return name;
+}
+
+int64_t LiveStats::now_ns()
+{
+  timespec ts{};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+LiveStatsReader::~LiveStatsReader()
+{
+  if (segment_ != nullptr) {
+    munmap(const_cast<LiveStatsSegment *>(segment_), mapped_size_);
+  }
+}
+
+bool LiveStatsReader::attach(const std::string & shm_name, std::string * error)
+{
+  int fd = shm_open(shm_name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    *error = std::strerror(errno);
+    return false;
+  }
+
+  struct stat st = {};
+  if (fstat(fd, &st) != 0 || (size_t) st.st_size < offsetof(LiveStatsSegment, kind)) {
+    ::close(fd);
+    *error = "segment is too small";
+    return false;
+  }
+
+  void * addr = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    *error = std::strerror(errno);
+    return false;
+  }
+
+  const auto * segment = static_cast<const LiveStatsSegment *>(addr);
+  if (segment->magic != LIVE_STATS_MAGIC) {
+    *error = "not a rosflight statistics segment";
+  } else if (segment->version != LIVE_STATS_VERSION) {
+    *error = "segment version " + std::to_string(segment->version) + ", expected "
+      + std::to_string(LIVE_STATS_VERSION);
+  } else if (segment->size != sizeof(LiveStatsSegment)
+             || (size_t) st.st_size < sizeof(LiveStatsSegment)) {
+    *error = "segment size does not match its version";
+  } else if (segment->ready.load(std::memory_order_acquire) == 0) {
+    *error = "segment is not initialized yet";
+  } else {
+    segment_ = segment;
+    mapped_size_ = (size_t) st.st_size;
+    return true;
+  }
+
+  munmap(addr, (size_t) st.st_size);
+  return false;
+}
+
+bool LiveStatsReader::owner_alive() const
+{
+  return segment_ != nullptr && (kill(segment_->pid, 0) == 0 || errno == EPERM);
+}
+
+std::vector<std::string> LiveStatsReader::list()
+{
+  std::vector<std::string> names;
+  DIR * dir = opendir("/dev/shm");
+  if (dir == nullptr) {
+    return names;
+  }
+
+  size_t prefix_len = std::strlen(LIVE_STATS_PREFIX);
+  while (dirent * entry = readdir(dir)) {
+    if (std::strncmp(entry->d_name, LIVE_STATS_PREFIX, prefix_len) == 0) {
+      names.push_back("/" + std::string(entry->d_name));
+    }
+  }
+  closedir(dir);
+  return names;
+}
+
+} // namespace mavrosflight
@@ -34,7 +34,15 @@
  * \author Daniel Koch <daniel.koch@byu.edu>
  */
 
+#include <rosflight_io/mavrosflight/hot_path.hpp>
 #include <rosflight_io/mavrosflight/mavlink_comm.hpp>
+#include <rosflight_io/mavrosflight/tracepoints.hpp>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <stdexcept>
 
 namespace mavrosflight
 {
@@ -42,17 +50,22 @@ using boost::asio::serial_port_base;
 
 MavlinkComm::MavlinkComm()
     : io_service_()
+    , link_timers_(io_service_)
     , read_buf_raw_()
     , msg_in_()
     , status_in_()
     , write_in_progress_(false)
-{}
+    , failed_(false)
+{
+  std::fill(std::begin(last_seq_), std::end(last_seq_), -1);
+}
 
 MavlinkComm::~MavlinkComm() = default;
 
 void MavlinkComm::open()
 {
   // open the port
+  failed_ = false;
   do_open();
 
   // start reading from the port
@@ -72,12 +85,43 @@ void MavlinkComm::close()
   }
 }
 
+void MavlinkComm::fail(const boost::system::error_code & error)
+{
+  std::cerr << error.message() << std::endl;
+
+  mutex_lock lock(mutex_);
+  failed_ = true;
+  io_service_.stop();
+  do_close();
+}
+
+bool MavlinkComm::set_io_thread_priority(int priority)
+{
+  if (!io_thread_.joinable()) {
+    return false;
+  }
+
+  sched_param param{};
+  param.sched_priority = priority;
+  return pthread_setschedparam(io_thread_.native_handle(), SCHED_FIFO, &param) == 0;
+}
+
+boost::unique_lock<boost::mutex> MavlinkComm::lock_listeners_for_change()
+{
+  if (dispatching_ == this) {
+    throw std::logic_error("MAVLink listeners and subscribers cannot be changed from a listener or "
+                           "subscriber of the same link");
+  }
+  return boost::unique_lock<boost::mutex>(listeners_mutex_);
+}
+
 void MavlinkComm::register_mavlink_listener(MavlinkListenerInterface * const listener)
 {
   if (listener == nullptr) {
     return;
   }
 
+  boost::unique_lock<boost::mutex> lock = lock_listeners_for_change();
   bool already_registered = false;
   for (auto & item : listeners_) {
     if (listener == item) {
@@ -97,6 +141,7 @@ void MavlinkComm::unregister_mavlink_listener(MavlinkListenerInterface * const l
     return;
   }
 
+  boost::unique_lock<boost::mutex> lock = lock_listeners_for_change();
   for (int i = 0; i < (int) listeners_.size(); i++) {
     if (listener == listeners_[i]) {
       listeners_.erase(listeners_.begin() + i);
@@ -105,6 +150,16 @@ void MavlinkComm::unregister_mavlink_listener(MavlinkListenerInterface * const l
   }
 }
 
+void MavlinkComm::unsubscribe(const void * const subscriber)
+{
+  boost::unique_lock<boost::mutex> lock = lock_listeners_for_change();
+  for (auto & dispatcher : dispatchers_) {
+    if (dispatcher != nullptr) {
+      dispatcher->unsubscribe(subscriber);
+    }
+  }
+}
+
 void MavlinkComm::async_read()
 {
   if (!is_open()) {
@@ -123,49 +178,121 @@ void MavlinkComm::async_read_end(const boost::system::error_code & error, size_t
   }
 
   if (error) {
-    close();
+    fail(error);
     return;
   }
 
+  HotPath hot_path("mavlink_comm.read");
+  ROSFLIGHT_IO_TRACEPOINT(read_end, this, bytes_transferred);
+
+  boost::unique_lock<boost::mutex> lock(listeners_mutex_);
+  dispatching_ = this;
   for (int i = 0; i < (int) bytes_transferred; i++) {
     if (mavlink_parse_char(MAVLINK_COMM_0, read_buf_raw_[i], &msg_in_, &status_in_)) {
+      ROSFLIGHT_IO_TRACEPOINT(frame_decoded, this, msg_in_.msgid, msg_in_.seq);
+      int64_t dispatch_start_ns = stats_ != nullptr ? LiveStats::now_ns() : 0;
+
       for (auto & listener : listeners_) {
+        ROSFLIGHT_IO_TRACEPOINT(listener_dispatch, this, listener, msg_in_.msgid);
         listener->handle_mavlink_message(msg_in_);
       }
+
+      // Decoded once, however many subscribers the message has
+      if (msg_in_.msgid < MAVLINK_NUM_MSG_IDS && dispatchers_[msg_in_.msgid] != nullptr) {
+        ROSFLIGHT_IO_TRACEPOINT(listener_dispatch, this, dispatchers_[msg_in_.msgid].get(),
+                                msg_in_.msgid);
+        dispatchers_[msg_in_.msgid]->dispatch(msg_in_);
+      }
+
+      if (stats_ != nullptr) {
+        update_rx_stats(msg_in_, LiveStats::now_ns() - dispatch_start_ns);
+      }
     }
   }
 
+  dispatching_ = nullptr;
+  lock.unlock();
+
+  if (stats_ != nullptr) {
+    stats_->rx_bytes.fetch_add(bytes_transferred, std::memory_order_relaxed);
+    stats_->rx_dropped.store(status_in_.packet_rx_drop_count, std::memory_order_relaxed);
+    stats_->last_update_ns.store(LiveStats::now_ns(), std::memory_order_relaxed);
+  }
+
   async_read();
 }
 
-void MavlinkComm::send_message(const mavlink_message_t & msg)
+void MavlinkComm::update_rx_stats(const mavlink_message_t & msg, int64_t dispatch_time_ns)
 {
-  auto * buffer = new WriteBuffer();
-  buffer->len = mavlink_msg_to_send_buffer(buffer->data, &msg);
-  assert(buffer->len <= MAVLINK_MAX_PACKET_LEN); //! \todo Do something less catastrophic here
+  stats_->rx_frames.fetch_add(1, std::memory_order_relaxed);
+  stats_->rx_msg_count[msg.msgid % LIVE_STATS_NUM_MSG_IDS].fetch_add(1, std::memory_order_relaxed);
+  stats_->dispatch_time.record(dispatch_time_ns);
+
+  // Sequence numbers are per sender and wrap at 256, so any gap is frames lost on the link
+  int16_t & last_seq = last_seq_[msg.sysid];
+  if (last_seq >= 0) {
+    auto lost = (uint8_t) (msg.seq - last_seq - 1);
+    stats_->rx_lost.fetch_add(lost, std::memory_order_relaxed);
+  }
+  last_seq = msg.seq;
+}
 
+void MavlinkComm::send_message(const mavlink_message_t & msg)
+{
+  HotPath hot_path("mavlink_comm.send");
+  [[maybe_unused]] size_t len;
+  bool start_write;
   {
     mutex_lock lock(mutex_);
-    write_queue_.push_back(buffer);
+    if (write_queue_count_ == WRITE_QUEUE_SIZE) {
+      // The link has fallen far behind; drop the frame rather than queue without bound
+      if (stats_ != nullptr) {
+        stats_->tx_errors.fetch_add(1, std::memory_order_relaxed);
+      }
+      return;
+    }
+
+    WriteBuffer & buffer =
+      write_queue_[(write_queue_head_ + write_queue_count_) % WRITE_QUEUE_SIZE];
+    buffer.len = mavlink_msg_to_send_buffer(buffer.data, &msg);
+    buffer.pos = 0;
+    assert(buffer.len <= MAVLINK_MAX_PACKET_LEN); //! \todo Do something less catastrophic here
+    len = buffer.len;
+    write_queue_count_++;
+
+    if (stats_ != nullptr) {
+      auto depth = (uint32_t) write_queue_count_;
+      stats_->tx_frames.fetch_add(1, std::memory_order_relaxed);
+      stats_->write_queue_depth.store(depth, std::memory_order_relaxed);
+      if (depth > stats_->write_queue_max.load(std::memory_order_relaxed)) {
+        stats_->write_queue_max.store(depth, std::memory_order_relaxed);
+      }
+    }
+
+    start_write = !write_in_progress_;
+    write_in_progress_ = true;
   }
+  ROSFLIGHT_IO_TRACEPOINT(write_submit, this, msg.msgid, len);
 
-  async_write(true);
+  // Writes are only started on the io thread, where their operations come from write_memory_.
+  // write_in_progress_ stays set until the queue drains, so at most one of these is pending.
+  if (start_write) {
+    io_service_.post(
+      make_custom_alloc_handler(write_kick_memory_, boost::bind(&MavlinkComm::async_write, this)));
+  }
 }
 
-void MavlinkComm::async_write(bool check_write_state)
+void MavlinkComm::async_write()
 {
-  if (check_write_state && write_in_progress_) {
-    return;
-  }
-
+  HotPath hot_path("mavlink_comm.write");
   mutex_lock lock(mutex_);
-  if (write_queue_.empty()) {
+  if (write_queue_count_ == 0) {
+    write_in_progress_ = false;
     return;
   }
 
-  write_in_progress_ = true;
-  WriteBuffer * buffer = write_queue_.front();
-  do_async_write(boost::asio::buffer(buffer->dpos(), buffer->nbytes()),
+  WriteBuffer & buffer = write_queue_[write_queue_head_];
+  do_async_write(boost::asio::buffer(buffer.dpos(), buffer.nbytes()),
                  boost::bind(&MavlinkComm::async_write_end, this, boost::asio::placeholders::error,
                              boost::asio::placeholders::bytes_transferred));
 }
@@ -174,28 +301,36 @@ void MavlinkComm::async_write_end(const boost::system::error_code & error,
                                   std::size_t bytes_transferred)
 {
   if (error) {
-    std::cerr << error.message() << std::endl;
-    close();
+    if (stats_ != nullptr) {
+      stats_->tx_errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    fail(error);
     return;
   }
 
+  HotPath hot_path("mavlink_comm.write");
   mutex_lock lock(mutex_);
-  if (write_queue_.empty()) {
+  if (write_queue_count_ == 0) {
     write_in_progress_ = false;
     return;
   }
 
-  WriteBuffer * buffer = write_queue_.front();
-  buffer->pos += bytes_transferred;
-  if (buffer->nbytes() == 0) {
-    write_queue_.pop_front();
-    delete buffer;
+  WriteBuffer & buffer = write_queue_[write_queue_head_];
+  buffer.pos += bytes_transferred;
+  if (buffer.nbytes() == 0) {
+    write_queue_head_ = (write_queue_head_ + 1) % WRITE_QUEUE_SIZE;
+    write_queue_count_--;
+  }
+  ROSFLIGHT_IO_TRACEPOINT(write_complete, this, bytes_transferred, write_queue_count_);
+  if (stats_ != nullptr) {
+    stats_->tx_bytes.fetch_add(bytes_transferred, std::memory_order_relaxed);
+    stats_->write_queue_depth.store((uint32_t) write_queue_count_, std::memory_order_relaxed);
   }
 
-  if (write_queue_.empty()) {
+  if (write_queue_count_ == 0) {
     write_in_progress_ = false;
   } else {
-    async_write(false);
+    async_write();
   }
 }
 
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file mavlink_loopback.cpp
+ */
+
+#include <rosflight_io/mavrosflight/mavlink_loopback.hpp>
+
+namespace mavrosflight
+{
+MavlinkLoopback::MavlinkLoopback(LoopbackPipe & pipe)
+    : MavlinkComm()
+    , pipe_(pipe)
+    , open_(false)
+    , read_buffer_(nullptr, 0)
+{}
+
+MavlinkLoopback::~MavlinkLoopback() { MavlinkLoopback::do_close(); }
+
+bool MavlinkLoopback::is_open() { return open_; }
+
+void MavlinkLoopback::do_open()
+{
+  work_ = std::make_unique<boost::asio::io_service::work>(io_service_);
+  pipe_.set_gcs_data_callback([this]() { wake_read(); });
+  open_ = true;
+}
+
+void MavlinkLoopback::do_close()
+{
+  pipe_.set_gcs_data_callback(nullptr);
+  work_.reset();
+  open_ = false;
+}
+
+void MavlinkLoopback::do_async_read(
+  const boost::asio::mutable_buffers_1 & buffer,
+  boost::function<void(const boost::system::error_code &, size_t)> handler)
+{
+  read_buffer_ = buffer;
+  read_handler_ = handler;
+  wake_read();
+}
+
+void MavlinkLoopback::do_async_write(
+  const boost::asio::const_buffers_1 & buffer,
+  boost::function<void(const boost::system::error_code &, size_t)> handler)
+{
+  size_t len = boost::asio::buffer_size(buffer);
+  pipe_.gcs_write(boost::asio::buffer_cast<const uint8_t *>(buffer), len);
+  auto complete = boost::bind(handler, boost::system::error_code(), len);
+  io_service_.post(make_custom_alloc_handler(write_memory_, complete));
+}
+
+void MavlinkLoopback::wake_read()
+{
+  if (!read_wake_pending_.exchange(true)) {
+    io_service_.post(make_custom_alloc_handler(
+      read_memory_, boost::bind(&MavlinkLoopback::try_complete_read, this)));
+  }
+}
+
+void MavlinkLoopback::try_complete_read()
+{
+  // Cleared before reading, so data written from now on schedules another read
+  read_wake_pending_.store(false);
+  if (!read_handler_) {
+    return;
+  }
+
+  size_t len = pipe_.gcs_read(boost::asio::buffer_cast<uint8_t *>(read_buffer_),
+                              boost::asio::buffer_size(read_buffer_));
+  if (len > 0) {
+    // Clear the handler first, since calling it starts the next read
+    auto handler = read_handler_;
+    read_handler_.clear();
+    handler(boost::system::error_code(), len);
+  }
+}
+
+} // namespace mavrosflight
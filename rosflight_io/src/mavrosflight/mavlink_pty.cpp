@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file mavlink_pty.cpp
+ */
+
+#include <rosflight_io/mavrosflight/mavlink_pty.hpp>
+#include <rosflight_io/mavrosflight/serial_exception.hpp>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace mavrosflight
+{
+MavlinkPty::MavlinkPty()
+    : MavlinkComm()
+    , master_(io_service_)
+    , slave_fd_(-1)
+{}
+
+MavlinkPty::~MavlinkPty() { MavlinkPty::do_close(); }
+
+bool MavlinkPty::is_open() { return master_.is_open(); }
+
+void MavlinkPty::do_open()
+{
+  int master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master_fd < 0 || grantpt(master_fd) != 0 || unlockpt(master_fd) != 0) {
+    std::string error = std::strerror(errno);
+    if (master_fd >= 0) {
+      ::close(master_fd);
+    }
+    throw SerialException("unable to create pseudo-terminal: " + error);
+  }
+  slave_name_ = ptsname(master_fd);
+
+  // Put the slave in raw mode so the line discipline doesn't echo or translate the binary stream
+  slave_fd_ = ::open(slave_name_.c_str(), O_RDWR | O_NOCTTY);
+  if (slave_fd_ >= 0) {
+    termios tio{};
+    tcgetattr(slave_fd_, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave_fd_, TCSANOW, &tio);
+  }
+
+  master_.assign(master_fd);
+}
+
+void MavlinkPty::do_close()
+{
+  if (master_.is_open()) {
+    master_.close();
+  }
+  if (slave_fd_ >= 0) {
+    ::close(slave_fd_);
+    slave_fd_ = -1;
+  }
+}
+
+void MavlinkPty::do_async_read(
+  const boost::asio::mutable_buffers_1 & buffer,
+  boost::function<void(const boost::system::error_code &, size_t)> handler)
+{
+  master_.async_read_some(buffer, make_custom_alloc_handler(read_memory_, handler));
+}
+
+void MavlinkPty::do_async_write(
+  const boost::asio::const_buffers_1 & buffer,
+  boost::function<void(const boost::system::error_code &, size_t)> handler)
+{
+  master_.async_write_some(buffer, make_custom_alloc_handler(write_memory_, handler));
+}
+
+} // namespace mavrosflight
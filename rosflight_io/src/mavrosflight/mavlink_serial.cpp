@@ -72,14 +72,14 @@ void MavlinkSerial::do_async_read(
   const boost::asio::mutable_buffers_1 & buffer,
   boost::function<void(const boost::system::error_code &, size_t)> handler)
 {
-  serial_port_.async_read_some(buffer, handler);
+  serial_port_.async_read_some(buffer, make_custom_alloc_handler(read_memory_, handler));
 }
 
 void MavlinkSerial::do_async_write(
   const boost::asio::const_buffers_1 & buffer,
   boost::function<void(const boost::system::error_code &, size_t)> handler)
 {
-  serial_port_.async_write_some(buffer, handler);
+  serial_port_.async_write_some(buffer, make_custom_alloc_handler(write_memory_, handler));
 }
 
 } // namespace mavrosflight
@@ -85,14 +85,16 @@ void MavlinkUDP::do_async_read(
   const boost::asio::mutable_buffers_1 & buffer,
   boost::function<void(const boost::system::error_code &, size_t)> handler)
 {
-  socket_.async_receive_from(buffer, remote_endpoint_, handler);
+  socket_.async_receive_from(buffer, remote_endpoint_,
+                             make_custom_alloc_handler(read_memory_, handler));
 }
 
 void MavlinkUDP::do_async_write(
   const boost::asio::const_buffers_1 & buffer,
   boost::function<void(const boost::system::error_code &, size_t)> handler)
 {
-  socket_.async_send_to(buffer, remote_endpoint_, handler);
+  socket_.async_send_to(buffer, remote_endpoint_,
+                        make_custom_alloc_handler(write_memory_, handler));
 }
 
 } // namespace mavrosflight
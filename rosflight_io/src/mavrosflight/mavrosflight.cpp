@@ -40,10 +40,10 @@ namespace mavrosflight
 {
 using boost::asio::serial_port_base;
 
-MavROSflight::MavROSflight(MavlinkComm & mavlink_comm, rclcpp::Node * const node)
+MavROSflight::MavROSflight(MavlinkComm & mavlink_comm, const Platform & platform)
     : comm(mavlink_comm)
-    , param(&comm, node)
-    , time(&comm, node)
+    , param(&comm, platform)
+    , time(&comm, platform)
 {
   comm.open();
 }
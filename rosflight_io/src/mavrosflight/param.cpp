@@ -74,17 +74,18 @@ MAV_PARAM_TYPE Param::getType() const { return type_; }
 
 double Param::getValue() const { return value_; }
 
-void Param::requestSet(double value, mavlink_message_t * msg)
+bool Param::requestSet(double value, mavlink_message_t * msg)
 {
   if (value != value_) {
     new_value_ = getCastValue(value);
     expected_raw_value_ = getRawValue(new_value_);
 
-    mavlink_msg_param_set_pack(1, 50, msg, 1, MAV_COMP_ID_ALL, name_.c_str(), expected_raw_value_,
-                               type_);
+    packPendingSet(msg);
 
     set_in_progress_ = true;
+    return true;
   }
+  return false;
 }
 
 bool Param::handleUpdate(const mavlink_param_value_t & msg)
@@ -109,6 +110,14 @@ bool Param::handleUpdate(const mavlink_param_value_t & msg)
   return false;
 }
 
+bool Param::isSetInProgress() const { return set_in_progress_; }
+
+void Param::packPendingSet(mavlink_message_t * msg) const
+{
+  mavlink_msg_param_set_pack(1, 50, msg, 1, MAV_COMP_ID_ALL, name_.c_str(), expected_raw_value_,
+                             type_);
+}
+
 void Param::init(std::string name, int index, MAV_PARAM_TYPE type, float raw_value)
 {
   name_ = std::move(name);
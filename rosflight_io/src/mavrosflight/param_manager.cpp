@@ -34,6 +34,7 @@
  * \author Daniel Koch <daniel.koch@byu.edu>
  */
 
+#include <cstring>
 #include <fstream>
 #include <functional>
 
@@ -42,8 +43,8 @@
 
 namespace mavrosflight
 {
-ParamManager::ParamManager(MavlinkComm * const comm, rclcpp::Node * const node)
-    : node_(node)
+ParamManager::ParamManager(MavlinkComm * const comm, const Platform & platform)
+    : platform_(platform)
     , comm_(comm)
     , unsaved_changes_(false)
     , write_request_in_progress_(false)
@@ -54,37 +55,32 @@ ParamManager::ParamManager(MavlinkComm * const comm, rclcpp::Node * const node)
     , got_all_params_(false)
     , param_set_in_progress_(false)
 {
-  comm_->register_mavlink_listener(this);
+  comm_->subscribe<&ParamManager::handle_param_value_msg>(this);
+  comm_->subscribe<&ParamManager::handle_command_ack_msg>(this);
 
   param_set_timer_ =
-    node_->create_wall_timer(std::chrono::milliseconds(10),
-                             std::bind(&ParamManager::param_set_timer_callback, this), nullptr);
+    platform_.timers->create_wall_timer(std::chrono::milliseconds(10),
+                                        std::bind(&ParamManager::param_set_timer_callback, this));
 }
 
 ParamManager::~ParamManager()
 {
+  comm_->unsubscribe(this);
   if (first_param_received_) {
     delete[] received_;
   }
 }
 
-void ParamManager::handle_mavlink_message(const mavlink_message_t & msg)
+bool ParamManager::unsaved_changes() const
 {
-  switch (msg.msgid) {
-    case MAVLINK_MSG_ID_PARAM_VALUE:
-      handle_param_value_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_ROSFLIGHT_CMD_ACK:
-      handle_command_ack_msg(msg);
-      break;
-  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  return unsaved_changes_;
 }
 
-bool ParamManager::unsaved_changes() const { return unsaved_changes_; }
-
 bool ParamManager::get_param_value(const std::string & name, double * value)
 {
-  if (is_param_id(name)) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (is_param_id_locked(name)) {
     *value = params_[name].getValue();
     return true;
   } else {
@@ -93,16 +89,34 @@ bool ParamManager::get_param_value(const std::string & name, double * value)
   }
 }
 
+bool ParamManager::get_param(const std::string & name, Param * param) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = params_.find(name);
+  if (it == params_.end()) {
+    return false;
+  }
+  *param = it->second;
+  return true;
+}
+
 bool ParamManager::set_param_value(const std::string & name, double value)
 {
-  if (is_param_id(name)) {
-    mavlink_message_t msg;
-    params_[name].requestSet(value, &msg);
+  bool found;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    found = set_param_value_locked(name, value);
+  }
+  start_param_set_timer();
+  return found;
+}
 
-    param_set_queue_.push_back(msg);
-    if (!param_set_in_progress_) {
-      param_set_timer_->reset();
-      param_set_in_progress_ = true;
+bool ParamManager::set_param_value_locked(const std::string & name, double value)
+{
+  if (is_param_id_locked(name)) {
+    mavlink_message_t msg;
+    if (params_[name].requestSet(value, &msg)) {
+      queue_param_set(msg);
     }
 
     return true;
@@ -113,6 +127,7 @@ bool ParamManager::set_param_value(const std::string & name, double value)
 
 bool ParamManager::write_params()
 {
+  std::lock_guard<std::mutex> lock(mutex_);
   if (!write_request_in_progress_) {
     mavlink_message_t msg;
     uint8_t sysid = 1;
@@ -133,6 +148,7 @@ void ParamManager::register_param_listener(ParamListenerInterface * listener)
     return;
   }
 
+  std::lock_guard<std::mutex> lock(listeners_mutex_);
   bool already_registered = false;
   for (auto & item : listeners_) {
     if (listener == item) {
@@ -152,6 +168,7 @@ void ParamManager::unregister_param_listener(ParamListenerInterface * listener)
     return;
   }
 
+  std::lock_guard<std::mutex> lock(listeners_mutex_);
   for (int i = 0; i < (int) listeners_.size(); i++) {
     if (listener == listeners_[i]) {
       listeners_.erase(listeners_.begin() + i);
@@ -165,7 +182,8 @@ bool ParamManager::save_to_file(const std::string & filename)
   // build YAML document
   YAML::Emitter yaml;
   yaml << YAML::BeginSeq;
-  std::map<std::string, Param>::iterator it;
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::map<std::string, Param, std::less<>>::iterator it;
   for (it = params_.begin(); it != params_.end(); it++) {
     yaml << YAML::Flow;
     yaml << YAML::BeginMap;
@@ -175,6 +193,7 @@ bool ParamManager::save_to_file(const std::string & filename)
     yaml << YAML::EndMap;
   }
   yaml << YAML::EndSeq;
+  lock.unlock();
 
   // write to file
   try {
@@ -193,27 +212,38 @@ bool ParamManager::load_from_file(const std::string & filename)
 {
   try {
     YAML::Node root = YAML::LoadFile(filename);
-    assert(root.IsSequence());
-
-    for (auto && item : root) {
-      if (item.IsMap() && item["name"] && item["type"] && item["value"]) {
-        if (is_param_id(item["name"].as<std::string>())) {
-          Param param = params_.find(item["name"].as<std::string>())->second;
-          if ((MAV_PARAM_TYPE) item["type"].as<int>() == param.getType()) {
-            set_param_value(item["name"].as<std::string>(), item["value"].as<double>());
+    if (!root.IsSequence()) {
+      platform_.logger->log(LoggerInterface::Severity::ERROR,
+                            "Could not load %s: expected a list of parameters", filename.c_str());
+      return false;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto && item : root) {
+        if (item.IsMap() && item["name"] && item["type"] && item["value"]) {
+          if (is_param_id_locked(item["name"].as<std::string>())) {
+            Param param = params_.find(item["name"].as<std::string>())->second;
+            if ((MAV_PARAM_TYPE) item["type"].as<int>() == param.getType()) {
+              set_param_value_locked(item["name"].as<std::string>(), item["value"].as<double>());
+            }
           }
         }
       }
     }
+    start_param_set_timer();
 
     return true;
-  } catch (...) {
+  } catch (const std::exception & e) {
+    platform_.logger->log(LoggerInterface::Severity::ERROR, "Could not load %s: %s",
+                          filename.c_str(), e.what());
     return false;
   }
 }
 
 void ParamManager::request_params()
 {
+  std::lock_guard<std::mutex> lock(mutex_);
   if (!first_param_received_) {
     request_param_list();
   } else {
@@ -225,6 +255,56 @@ void ParamManager::request_params()
   }
 }
 
+bool ParamManager::param_sets_pending() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!param_set_queue_.empty()) {
+    return true;
+  }
+  for (const auto & param : params_) {
+    if (param.second.isSetInProgress()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ParamManager::resend_pending_param_sets()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!param_set_queue_.empty()) {
+      return;
+    }
+    for (const auto & param : params_) {
+      if (param.second.isSetInProgress()) {
+        mavlink_message_t msg;
+        param.second.packPendingSet(&msg);
+        queue_param_set(msg);
+      }
+    }
+  }
+  start_param_set_timer();
+}
+
+void ParamManager::queue_param_set(const mavlink_message_t & msg)
+{
+  param_set_queue_.push_back(msg);
+  update_live_stats();
+}
+
+void ParamManager::start_param_set_timer()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (param_set_in_progress_ || param_set_queue_.empty()) {
+      return;
+    }
+    param_set_in_progress_ = true;
+  }
+  param_set_timer_->reset();
+}
+
 void ParamManager::request_param_list()
 {
   mavlink_message_t param_list_msg;
@@ -241,11 +321,19 @@ void ParamManager::request_param(int index)
   comm_->send_message(param_request_msg);
 }
 
-void ParamManager::handle_param_value_msg(const mavlink_message_t & msg)
+void ParamManager::handle_param_value_msg(const mavlink_param_value_t & param)
 {
-  mavlink_param_value_t param;
-  mavlink_msg_param_value_decode(&msg, &param);
+  // Collected under the lock, the listeners are called after releasing it
+  bool new_param = false;
+  bool updated = false;
+  double value = 0.0;
+  bool unsaved_changes = false;
+
+  // looked up without a copy; the name is only null terminated when shorter than the field
+  std::string_view name(param.param_id,
+                        strnlen(param.param_id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN));
 
+  std::unique_lock<std::mutex> lock(mutex_);
   if (!first_param_received_) {
     first_param_received_ = true;
     num_params_ = param.param_count;
@@ -255,16 +343,10 @@ void ParamManager::handle_param_value_msg(const mavlink_message_t & msg)
     }
   }
 
-  // ensure null termination of name
-  char c_name[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN + 1];
-  memcpy(c_name, param.param_id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN);
-  c_name[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN] = '\0';
-
-  std::string name(c_name);
-
-  if (!is_param_id(name)) // if we haven't received this param before, add it
+  auto it = params_.find(name);
+  if (it == params_.end()) // if we haven't received this param before, add it
   {
-    params_[name] = Param(param);
+    it = params_.emplace(name, Param(param)).first;
     received_[param.param_index] = true;
 
     // increase the param count
@@ -273,52 +355,85 @@ void ParamManager::handle_param_value_msg(const mavlink_message_t & msg)
       got_all_params_ = true;
     }
 
-    for (auto & listener : listeners_) {
-      listener->on_new_param_received(name, params_[name].getValue());
-    }
+    new_param = true;
+    value = it->second.getValue();
   } else // otherwise check if we have new unsaved changes as a result of a param set request
   {
-    if (params_[name].handleUpdate(param)) {
+    if (it->second.handleUpdate(param)) {
       unsaved_changes_ = true;
-      for (auto & listener : listeners_) {
-        listener->on_param_value_updated(name, params_[name].getValue());
-        listener->on_params_saved_change(unsaved_changes_);
-      }
+      updated = true;
+      value = it->second.getValue();
+      unsaved_changes = unsaved_changes_;
+    }
+  }
+  update_live_stats();
+  lock.unlock();
+
+  // Only new and changed parameters are passed on, so a repeated value doesn't allocate
+  if (!new_param && !updated) {
+    return;
+  }
+  std::string name_copy(name);
+  std::lock_guard<std::mutex> listeners_lock(listeners_mutex_);
+  for (auto & listener : listeners_) {
+    if (new_param) {
+      listener->on_new_param_received(name_copy, value);
+    } else {
+      listener->on_param_value_updated(name_copy, value);
+      listener->on_params_saved_change(unsaved_changes);
     }
   }
 }
 
-void ParamManager::handle_command_ack_msg(const mavlink_message_t & msg)
+void ParamManager::handle_command_ack_msg(const mavlink_rosflight_cmd_ack_t & ack)
 {
-  if (write_request_in_progress_) {
-    mavlink_rosflight_cmd_ack_t ack;
-    mavlink_msg_rosflight_cmd_ack_decode(&msg, &ack);
+  bool saved = false;
 
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (write_request_in_progress_) {
     if (ack.command == ROSFLIGHT_CMD_WRITE_PARAMS) {
       write_request_in_progress_ = false;
       if (ack.success == ROSFLIGHT_CMD_SUCCESS) {
-        RCLCPP_INFO(node_->get_logger(), "Param write succeeded");
+        platform_.logger->log(LoggerInterface::Severity::INFO, "Param write succeeded");
         unsaved_changes_ = false;
-
-        for (auto & listener : listeners_) {
-          listener->on_params_saved_change(unsaved_changes_);
-        }
+        saved = true;
       } else {
-        RCLCPP_INFO(node_->get_logger(),
-                    "Param write failed - maybe disarm the aircraft and try again?");
+        platform_.logger->log(LoggerInterface::Severity::INFO,
+                              "Param write failed - maybe disarm the aircraft and try again?");
         write_request_in_progress_ = false;
         unsaved_changes_ = true;
       }
     }
   }
+  update_live_stats();
+  lock.unlock();
+
+  if (saved) {
+    std::lock_guard<std::mutex> listeners_lock(listeners_mutex_);
+    for (auto & listener : listeners_) {
+      listener->on_params_saved_change(false);
+    }
+  }
+}
+
+bool ParamManager::is_param_id(const std::string & name) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return is_param_id_locked(name);
 }
 
-bool ParamManager::is_param_id(const std::string & name)
+bool ParamManager::is_param_id_locked(const std::string & name) const
 {
   return (params_.find(name) != params_.end());
 }
 
 int ParamManager::get_num_params() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_params_locked();
+}
+
+int ParamManager::num_params_locked() const
 {
   if (first_param_received_) {
     return num_params_;
@@ -327,12 +442,22 @@ int ParamManager::get_num_params() const
   }
 }
 
-int ParamManager::get_params_received() const { return received_count_; }
+int ParamManager::get_params_received() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return received_count_;
+}
 
-bool ParamManager::got_all_params() const { return got_all_params_; }
+bool ParamManager::got_all_params() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return got_all_params_;
+}
 
 void ParamManager::param_set_timer_callback()
 {
+  // Cancelling from the callback itself does not wait, so it is safe with the lock held
+  std::lock_guard<std::mutex> lock(mutex_);
   if (param_set_queue_.empty()) {
     param_set_timer_->cancel();
     param_set_in_progress_ = false;
@@ -340,6 +465,21 @@ void ParamManager::param_set_timer_callback()
     comm_->send_message(param_set_queue_.front());
     param_set_queue_.pop_front();
   }
+  update_live_stats();
+}
+
+void ParamManager::update_live_stats()
+{
+  LiveStatsSegment * stats = comm_->live_stats();
+  if (stats == nullptr) {
+    return;
+  }
+
+  stats->params_total.store(num_params_locked(), std::memory_order_relaxed);
+  stats->params_received.store(received_count_, std::memory_order_relaxed);
+  stats->params_unsaved.store(unsaved_changes_ ? 1 : 0, std::memory_order_relaxed);
+  stats->param_set_queue_depth.store((uint32_t) param_set_queue_.size(),
+                                     std::memory_order_relaxed);
 }
 
 } // namespace mavrosflight
@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file serial_discovery.cpp
+ */
+
+#include <rosflight_io/mavrosflight/mavlink_bridge.hpp>
+#include <rosflight_io/mavrosflight/serial_discovery.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace mavrosflight
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+//! How often the version request is sent again while waiting at one baud rate
+constexpr std::chrono::milliseconds REQUEST_PERIOD(100);
+//! How long to keep listening for the version after a HEARTBEAT identified the firmware
+constexpr std::chrono::milliseconds VERSION_GRACE(100);
+
+//! State shared by the probes. The first probe to claim it wins.
+struct Discovery
+{
+  Clock::time_point start;
+  std::atomic<bool> done{false};
+  std::mutex mutex;
+  SerialDiscovery::Result result;
+};
+
+speed_t to_speed(int baud_rate)
+{
+  switch (baud_rate) {
+    case 9600:
+      return B9600;
+    case 19200:
+      return B19200;
+    case 38400:
+      return B38400;
+    case 57600:
+      return B57600;
+    case 115200:
+      return B115200;
+    case 230400:
+      return B230400;
+    case 460800:
+      return B460800;
+    case 500000:
+      return B500000;
+    case 921600:
+      return B921600;
+    case 1000000:
+      return B1000000;
+    case 1500000:
+      return B1500000;
+    case 2000000:
+      return B2000000;
+    case 3000000:
+      return B3000000;
+    default:
+      return B0;
+  }
+}
+
+/**
+ * \brief Opens a port in raw, non-blocking mode at the given baud rate
+ * \return The file descriptor, or -1 if the port could not be opened or the baud rate is not
+ * supported
+ */
+int open_port(const std::string & port, int baud_rate)
+{
+  speed_t speed = to_speed(baud_rate);
+  if (speed == B0) {
+    return -1;
+  }
+
+  int fd = ::open(port.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0) {
+    return -1;
+  }
+
+  termios tio{};
+  if (tcgetattr(fd, &tio) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  cfmakeraw(&tio);
+  cfsetispeed(&tio, speed);
+  cfsetospeed(&tio, speed);
+  tio.c_cflag |= CLOCAL | CREAD;
+  if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  tcflush(fd, TCIOFLUSH);
+  return fd;
+}
+
+/**
+ * \brief Claims the discovery for a port
+ * \return Whether this port was the first to answer
+ */
+bool claim(Discovery & discovery, const std::string & port, int baud_rate, uint8_t system_id)
+{
+  std::lock_guard<std::mutex> lock(discovery.mutex);
+  if (discovery.done) {
+    return false;
+  }
+  discovery.done = true;
+
+  SerialDiscovery::Result & result = discovery.result;
+  result.found = true;
+  result.port = port;
+  result.baud_rate = baud_rate;
+  result.system_id = system_id;
+  result.elapsed = Clock::now() - discovery.start;
+
+  char device[PATH_MAX];
+  result.device = realpath(port.c_str(), device) != nullptr ? device : port;
+  return true;
+}
+
+/**
+ * \brief Probes one port at each baud rate in turn, until it answers, another port has answered,
+ * or every baud rate has been tried
+ * \param channel MAVLink parser channel, which must not be used by any other thread
+ */
+void probe(const std::string & port, const std::vector<int> & baud_rates,
+           std::chrono::milliseconds window, uint8_t channel, Discovery & discovery)
+{
+  // Only ask for the version. A HEARTBEAT of our own could come back from a port that echoes.
+  uint8_t request[MAVLINK_MAX_PACKET_LEN];
+  mavlink_message_t msg;
+  mavlink_msg_rosflight_cmd_pack(1, 50, &msg, ROSFLIGHT_CMD_SEND_VERSION);
+  size_t request_len = mavlink_msg_to_send_buffer(request, &msg);
+
+  for (int baud_rate : baud_rates) {
+    if (discovery.done) {
+      return;
+    }
+    int fd = open_port(port, baud_rate);
+    if (fd < 0) {
+      continue;
+    }
+    // Drop any partial frame left by the previous baud rate
+    mavlink_get_channel_status(channel)->parse_state = MAVLINK_PARSE_STATE_UNINIT;
+
+    bool answered = false;
+    Clock::time_point now = Clock::now();
+    Clock::time_point deadline = now + window;
+    Clock::time_point next_request = now;
+    while (now < deadline && (answered || !discovery.done)) {
+      if (now >= next_request) {
+        if (::write(fd, request, request_len) < 0 && errno != EAGAIN) {
+          break;
+        }
+        next_request = now + REQUEST_PERIOD;
+      }
+
+      pollfd pfd{fd, POLLIN, 0};
+      auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::min(deadline, next_request) - now);
+      if (poll(&pfd, 1, std::max((int) wait.count(), 1)) > 0) {
+        uint8_t buf[256];
+        ssize_t len = ::read(fd, buf, sizeof(buf));
+        mavlink_status_t status;
+        for (ssize_t i = 0; i < len; i++) {
+          if (!mavlink_parse_char(channel, buf[i], &msg, &status)) {
+            continue;
+          }
+          if (msg.msgid == MAVLINK_MSG_ID_ROSFLIGHT_VERSION) {
+            if (!answered && !claim(discovery, port, baud_rate, msg.sysid)) {
+              break;
+            }
+            mavlink_rosflight_version_t version;
+            mavlink_msg_rosflight_version_decode(&msg, &version);
+            std::lock_guard<std::mutex> lock(discovery.mutex);
+            discovery.result.version =
+              std::string(version.version, strnlen(version.version, sizeof(version.version)));
+            answered = true;
+            deadline = now;
+            break;
+          } else if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT && !answered) {
+            if (!claim(discovery, port, baud_rate, msg.sysid)) {
+              break;
+            }
+            answered = true;
+            deadline = std::min(deadline, now + VERSION_GRACE);
+          }
+        }
+      }
+      now = Clock::now();
+    }
+
+    ::close(fd);
+    if (answered) {
+      return;
+    }
+  }
+}
+
+} // namespace
+
+std::vector<std::string> SerialDiscovery::list_ports(const std::string & directory)
+{
+  std::vector<std::string> ports;
+  DIR * dir = opendir(directory.c_str());
+  if (dir == nullptr) {
+    return ports;
+  }
+
+  while (struct dirent * entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      ports.push_back(directory + "/" + entry->d_name);
+    }
+  }
+  closedir(dir);
+
+  std::sort(ports.begin(), ports.end());
+  return ports;
+}
+
+SerialDiscovery::Result SerialDiscovery::discover(const std::vector<std::string> & ports,
+                                                  const std::vector<int> & baud_rates,
+                                                  std::chrono::milliseconds window)
+{
+  Discovery discovery;
+  discovery.start = Clock::now();
+
+  // Each probe needs a parser channel of its own. Channel 0 is left to MavlinkComm, and any ports
+  // beyond the number of channels wait for a free probe.
+  size_t num_probes = std::min(ports.size(), (size_t) MAVLINK_COMM_NUM_BUFFERS - 1);
+  std::atomic<size_t> next_port(0);
+  std::vector<std::thread> probes;
+  for (size_t i = 0; i < num_probes; i++) {
+    probes.emplace_back([&, i]() {
+      for (size_t port = next_port++; port < ports.size(); port = next_port++) {
+        probe(ports[port], baud_rates, window, (uint8_t) (i + 1), discovery);
+      }
+    });
+  }
+  for (auto & thread : probes) {
+    thread.join();
+  }
+
+  Result result = discovery.result;
+  if (!result.found) {
+    result.elapsed = Clock::now() - discovery.start;
+  }
+  result.probed = ports;
+  return result;
+}
+
+} // namespace mavrosflight
@@ -33,53 +33,60 @@
  * \file time_manager.cpp
  * \author Daniel Koch <daniel.koch@byu.edu>
  */
+#include <cmath>
 #include <functional>
 
 #include <rosflight_io/mavrosflight/time_manager.hpp>
 
 namespace mavrosflight
 {
-TimeManager::TimeManager(MavlinkComm * const comm, rclcpp::Node * const node)
+TimeManager::TimeManager(MavlinkComm * const comm, const Platform & platform)
     : comm_(comm)
-    , node_(node)
+    , platform_(platform)
     , offset_alpha_(0.95)
     , offset_ns_(0)
     , initialized_(false)
+    , last_negative_time_log_(0)
 {
-  comm_->register_mavlink_listener(this);
-  time_sync_timer_ = node_->create_wall_timer(
-    std::chrono::milliseconds(100), std::bind(&TimeManager::timer_callback, this), nullptr);
+  comm_->subscribe<&TimeManager::handle_timesync_msg>(this);
+  time_sync_timer_ = platform_.timers->create_wall_timer(
+    std::chrono::milliseconds(100), std::bind(&TimeManager::timer_callback, this));
 }
 
-void TimeManager::handle_mavlink_message(const mavlink_message_t & msg)
+TimeManager::~TimeManager() { comm_->unsubscribe(this); }
+
+void TimeManager::handle_timesync_msg(const mavlink_timesync_t & tsync)
 {
-  std::chrono::nanoseconds now(node_->get_clock()->now().nanoseconds());
+  std::chrono::nanoseconds now = platform_.clock->now();
 
-  if (msg.msgid == MAVLINK_MSG_ID_TIMESYNC) {
-    mavlink_timesync_t tsync;
-    mavlink_msg_timesync_decode(&msg, &tsync);
+  std::chrono::nanoseconds tc1_chrono(tsync.tc1);
 
-    std::chrono::nanoseconds tc1_chrono(tsync.tc1);
+  if (tsync.tc1 > 0) // check that this is a response, not a request
+  {
+    std::chrono::nanoseconds ts1_chrono(tsync.ts1);
+    std::chrono::nanoseconds offset_ns((ts1_chrono + now - 2 * tc1_chrono) / 2);
 
-    if (tsync.tc1 > 0) // check that this is a response, not a request
+    // if difference > 10ms, use it directly
+    if (!initialized_ || (offset_ns_ - offset_ns) > std::chrono::milliseconds(10)
+        || (offset_ns_ - offset_ns) < std::chrono::milliseconds(-10)) {
+      platform_.logger->log(
+        LoggerInterface::Severity::INFO, "Detected time offset of %0.3f s.",
+        std::abs(std::chrono::duration<double>(offset_ns_ - offset_ns).count()));
+      platform_.logger->log(LoggerInterface::Severity::DEBUG,
+                            "FCU time: %0.3f, System time: %0.3f", tsync.tc1 * 1e-9,
+                            tsync.ts1 * 1e-9);
+      offset_ns_ = offset_ns;
+      initialized_ = true;
+    } else // otherwise low-pass filter the offset
     {
-      std::chrono::nanoseconds ts1_chrono(tsync.ts1);
-      std::chrono::nanoseconds offset_ns((ts1_chrono + now - 2 * tc1_chrono) / 2);
+      offset_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        offset_alpha_ * offset_ns + (1.0 - offset_alpha_) * offset_ns_);
+    }
 
-      // if difference > 10ms, use it directly
-      if (!initialized_ || (offset_ns_ - offset_ns) > std::chrono::milliseconds(10)
-          || (offset_ns_ - offset_ns) < std::chrono::milliseconds(-10)) {
-        RCLCPP_INFO(node_->get_logger(), "Detected time offset of %0.3f s.",
-                    abs(std::chrono::duration<double>(offset_ns_ - offset_ns).count()));
-        RCLCPP_DEBUG(node_->get_logger(), "FCU time: %0.3f, System time: %0.3f", tsync.tc1 * 1e-9,
-                     tsync.ts1 * 1e-9);
-        offset_ns_ = offset_ns;
-        initialized_ = true;
-      } else // otherwise low-pass filter the offset
-      {
-        offset_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
-          offset_alpha_ * offset_ns + (1.0 - offset_alpha_) * offset_ns_);
-      }
+    if (LiveStatsSegment * stats = comm_->live_stats()) {
+      stats->time_sync_initialized.store(1, std::memory_order_relaxed);
+      stats->time_offset_ns.store(offset_ns_.count(), std::memory_order_relaxed);
+      stats->time_sync_rtt_ns.store((now - ts1_chrono).count(), std::memory_order_relaxed);
     }
   }
 }
@@ -87,24 +94,35 @@ void TimeManager::handle_mavlink_message(const mavlink_message_t & msg)
 std::chrono::nanoseconds TimeManager::fcu_time_to_system_time(std::chrono::nanoseconds fcu_time)
 {
   if (!initialized_) {
-    return std::chrono::nanoseconds(node_->get_clock()->now().nanoseconds());
+    return platform_.clock->now();
   }
 
   std::chrono::nanoseconds ns = fcu_time + offset_ns_;
   if (ns < std::chrono::nanoseconds::zero()) {
-    RCLCPP_ERROR_THROTTLE(
-      node_->get_logger(), *node_->get_clock(), 1,
-      "negative time calculated from FCU: fcu_time=%ld, offset_ns=%ld.  Using system time",
-      fcu_time.count(), offset_ns_.count());
-    return std::chrono::nanoseconds(node_->get_clock()->now().nanoseconds());
+    std::chrono::nanoseconds now = platform_.clock->now();
+    if (now - last_negative_time_log_ >= std::chrono::seconds(1)) {
+      platform_.logger->log(
+        LoggerInterface::Severity::ERROR,
+        "negative time calculated from FCU: fcu_time=%ld, offset_ns=%ld.  Using system time",
+        fcu_time.count(), offset_ns_.count());
+      last_negative_time_log_ = now;
+    }
+    return now;
   }
   return ns;
 }
 
+void TimeManager::request_sync(int count)
+{
+  for (int i = 0; i < count; i++) {
+    timer_callback();
+  }
+}
+
 void TimeManager::timer_callback()
 {
   mavlink_message_t msg;
-  mavlink_msg_timesync_pack(1, 50, &msg, 0, node_->get_clock()->now().nanoseconds());
+  mavlink_msg_timesync_pack(1, 50, &msg, 0, platform_.clock->now().count());
   comm_->send_message(msg);
 }
 
@@ -0,0 +1,727 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file mock_fcu.cpp
+ *
+ * Stand-in for a flight controller, for finding out how much traffic rosflight_io can handle. It
+ * speaks the ROSflight MAVLink dialect over UDP or a pseudo-terminal, streams sensor and state
+ * messages at configurable rates, and answers time sync, parameter and command requests.
+ *
+ * With --ramp it also acts as the test harness: it raises the IMU rate step by step, reads what
+ * rosflight_io actually received from its live statistics segment, and reports the rate at which
+ * rosflight_io starts losing frames along with its CPU cost per 1000 frames.
+ */
+
+#include <rosflight_io/mavrosflight/live_stats.hpp>
+#include <rosflight_io/mavrosflight/mavlink_comm.hpp>
+#include <rosflight_io/mavrosflight/mavlink_listener_interface.hpp>
+#include <rosflight_io/mavrosflight/mavlink_pty.hpp>
+#include <rosflight_io/mavrosflight/mavlink_udp.hpp>
+#include <rosflight_io/mavrosflight/serial_exception.hpp>
+
+#include <getopt.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr uint8_t SYSTEM_ID = 1;
+constexpr uint8_t COMPONENT_ID = 1;
+
+std::atomic<bool> stop_requested{false};
+
+struct Options
+{
+  bool pty = false;
+  std::string bind_host = "localhost";
+  uint16_t bind_port = 14525;
+  std::string remote_host = "localhost";
+  uint16_t remote_port = 14520;
+
+  double imu_rate = 500.0;
+  double attitude_rate = 100.0;
+  double status_rate = 10.0;
+  double gnss_rate = 10.0;
+  double named_value_rate = 10.0;
+  double param_rate = 200.0;
+  int num_params = 100;
+  double duration = 0.0;
+
+  bool ramp = false;
+  std::string target = "/rosflight_io";
+  double ramp_start = 500.0;
+  double ramp_factor = 1.25;
+  double ramp_max = 100000.0;
+  double ramp_step = 5.0;
+  double ramp_settle = 1.0;
+  double tolerance = 0.001;
+};
+
+/**
+ * \brief Simulated flight controller. Streams are emitted from the thread that calls run_for(),
+ * requests are answered from the MAVLink I/O thread.
+ */
+class MockFCU : public mavrosflight::MavlinkListenerInterface
+{
+public:
+  MockFCU(mavrosflight::MavlinkComm & comm, const Options & options);
+
+  void handle_mavlink_message(const mavlink_message_t & msg) override;
+
+  /**
+   * \brief Emits the configured streams until the time has passed or a stop is requested
+   */
+  void run_for(double seconds);
+
+  void set_imu_rate(double rate);
+  double imu_rate() const { return streams_[IMU].rate; }
+  uint64_t frames_sent() const { return frames_sent_.load(std::memory_order_relaxed); }
+
+private:
+  enum StreamId
+  {
+    HEARTBEAT,
+    IMU,
+    ATTITUDE,
+    STATUS,
+    GNSS,
+    NAMED_VALUE,
+    PARAM_LIST,
+    NUM_STREAMS
+  };
+
+  struct Stream
+  {
+    double rate = 0.0;
+    Clock::time_point start;
+    uint64_t sent = 0;
+  };
+
+  struct MockParam
+  {
+    char id[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN];
+    float raw_value;
+    uint8_t type;
+  };
+
+  void emit(StreamId stream);
+  void send(const mavlink_message_t & msg);
+  void send_param(int index);
+  int find_param(const char * id) const;
+  uint64_t boot_us() const;
+
+  mavrosflight::MavlinkComm & comm_;
+  Clock::time_point boot_time_;
+  Stream streams_[NUM_STREAMS];
+
+  std::mutex mutex_; //!< protects the parameters and the outgoing MAVLink sequence number
+  std::vector<MockParam> params_;
+  int next_param_ = 0;
+
+  std::atomic<uint64_t> frames_sent_{0};
+};
+
+MockFCU::MockFCU(mavrosflight::MavlinkComm & comm, const Options & options)
+    : comm_(comm)
+    , boot_time_(Clock::now())
+{
+  streams_[HEARTBEAT].rate = 1.0;
+  streams_[IMU].rate = options.imu_rate;
+  streams_[ATTITUDE].rate = options.attitude_rate;
+  streams_[STATUS].rate = options.status_rate;
+  streams_[GNSS].rate = options.gnss_rate;
+  streams_[NAMED_VALUE].rate = options.named_value_rate;
+  streams_[PARAM_LIST].rate = options.param_rate;
+  for (Stream & stream : streams_) {
+    stream.start = boot_time_;
+  }
+
+  // ROSflight only uses int32 and float parameters
+  params_.resize((size_t) options.num_params);
+  for (size_t i = 0; i < params_.size(); i++) {
+    char id[32] = {};
+    snprintf(id, sizeof(id), "MOCK_%03zu", i);
+    memcpy(params_[i].id, id, sizeof(params_[i].id));
+    params_[i].raw_value = 0.0f;
+    params_[i].type = i % 2 == 0 ? MAV_PARAM_TYPE_INT32 : MAV_PARAM_TYPE_REAL32;
+  }
+  next_param_ = (int) params_.size(); // the firmware waits for a request before sending params
+}
+
+uint64_t MockFCU::boot_us() const
+{
+  return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(Clock::now()
+                                                                          - boot_time_)
+    .count();
+}
+
+void MockFCU::set_imu_rate(double rate)
+{
+  streams_[IMU].rate = rate;
+  streams_[IMU].start = Clock::now();
+  streams_[IMU].sent = 0;
+}
+
+void MockFCU::send(const mavlink_message_t & msg)
+{
+  comm_.send_message(msg);
+  frames_sent_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MockFCU::run_for(double seconds)
+{
+  Clock::time_point end = Clock::now()
+    + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+  while (!stop_requested && Clock::now() < end) {
+    Clock::time_point now = Clock::now();
+    for (int i = 0; i < NUM_STREAMS; i++) {
+      Stream & stream = streams_[i];
+      if (stream.rate <= 0.0) {
+        continue;
+      }
+      // Emit however many messages are due, so the average rate holds even when the sleep
+      // below is longer than the period
+      auto due =
+        (uint64_t) (std::chrono::duration<double>(now - stream.start).count() * stream.rate);
+      while (stream.sent < due) {
+        emit((StreamId) i);
+        stream.sent++;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+}
+
+void MockFCU::emit(StreamId stream)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  mavlink_message_t msg;
+  double t = (double) boot_us() * 1e-6;
+
+  switch (stream) {
+    case HEARTBEAT: {
+      mavlink_heartbeat_t heartbeat = {};
+      heartbeat.type = MAV_TYPE_GENERIC;
+      heartbeat.autopilot = MAV_AUTOPILOT_GENERIC;
+      heartbeat.system_status = MAV_STATE_ACTIVE;
+      mavlink_msg_heartbeat_encode(SYSTEM_ID, COMPONENT_ID, &msg, &heartbeat);
+      break;
+    }
+    case IMU: {
+      mavlink_small_imu_t imu = {};
+      imu.time_boot_us = boot_us();
+      imu.xacc = 0.05f * (float) std::sin(t);
+      imu.yacc = 0.05f * (float) std::cos(t);
+      imu.zacc = -9.81f;
+      imu.xgyro = 0.01f * (float) std::sin(2.0 * t);
+      imu.ygyro = 0.01f * (float) std::cos(2.0 * t);
+      imu.zgyro = 0.1f;
+      imu.temperature = 25.0f;
+      mavlink_msg_small_imu_encode(SYSTEM_ID, COMPONENT_ID, &msg, &imu);
+      break;
+    }
+    case ATTITUDE: {
+      // Slow constant yaw rate
+      mavlink_attitude_quaternion_t attitude = {};
+      attitude.time_boot_ms = (uint32_t) (boot_us() / 1000);
+      attitude.q1 = (float) std::cos(0.05 * t);
+      attitude.q4 = (float) std::sin(0.05 * t);
+      attitude.yawspeed = 0.1f;
+      mavlink_msg_attitude_quaternion_encode(SYSTEM_ID, COMPONENT_ID, &msg, &attitude);
+      break;
+    }
+    case STATUS: {
+      mavlink_rosflight_status_t status = {};
+      status.control_mode = MODE_PASS_THROUGH;
+      status.error_code = ROSFLIGHT_ERROR_NONE;
+      status.loop_time_us = 1000;
+      mavlink_msg_rosflight_status_encode(SYSTEM_ID, COMPONENT_ID, &msg, &status);
+      break;
+    }
+    case GNSS: {
+      // Stationary at a fixed location
+      mavlink_rosflight_gnss_t gnss = {};
+      gnss.rosflight_timestamp = boot_us();
+      gnss.fix_type = GNSS_FIX_FIX;
+      gnss.time = (uint64_t) std::time(nullptr);
+      gnss.lat = 402338000;
+      gnss.lon = -1116585000;
+      gnss.height = 1387000;
+      gnss.ecef_x = -184232300;
+      gnss.ecef_y = -463542800;
+      gnss.ecef_z = 409730900;
+      gnss.h_acc = 1.5f;
+      gnss.v_acc = 3.0f;
+      gnss.s_acc = 0.2f;
+      mavlink_msg_rosflight_gnss_encode(SYSTEM_ID, COMPONENT_ID, &msg, &gnss);
+      break;
+    }
+    case NAMED_VALUE: {
+      mavlink_named_value_float_t value = {};
+      value.time_boot_ms = (uint32_t) (boot_us() / 1000);
+      strncpy(value.name, "mock", MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN);
+      value.value = (float) std::sin(t);
+      mavlink_msg_named_value_float_encode(SYSTEM_ID, COMPONENT_ID, &msg, &value);
+      break;
+    }
+    case PARAM_LIST:
+      if (next_param_ < (int) params_.size()) {
+        send_param(next_param_++);
+      }
+      return;
+    default:
+      return;
+  }
+  send(msg);
+}
+
+void MockFCU::send_param(int index)
+{
+  const MockParam & param = params_[(size_t) index];
+  mavlink_param_value_t value = {};
+  memcpy(value.param_id, param.id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN);
+  value.param_value = param.raw_value;
+  value.param_type = param.type;
+  value.param_count = (uint16_t) params_.size();
+  value.param_index = (uint16_t) index;
+
+  mavlink_message_t msg;
+  mavlink_msg_param_value_encode(SYSTEM_ID, COMPONENT_ID, &msg, &value);
+  send(msg);
+}
+
+int MockFCU::find_param(const char * id) const
+{
+  for (size_t i = 0; i < params_.size(); i++) {
+    if (strncmp(params_[i].id, id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN) == 0) {
+      return (int) i;
+    }
+  }
+  return -1;
+}
+
+void MockFCU::handle_mavlink_message(const mavlink_message_t & msg)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  mavlink_message_t reply;
+
+  switch (msg.msgid) {
+    case MAVLINK_MSG_ID_TIMESYNC: {
+      mavlink_timesync_t request;
+      mavlink_msg_timesync_decode(&msg, &request);
+      if (request.tc1 == 0) {
+        auto now_ns = (int64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        Clock::now() - boot_time_)
+                        .count();
+        mavlink_msg_timesync_pack(SYSTEM_ID, COMPONENT_ID, &reply, now_ns, request.ts1);
+        send(reply);
+      }
+      break;
+    }
+    case MAVLINK_MSG_ID_PARAM_REQUEST_LIST:
+      next_param_ = 0;
+      break;
+    case MAVLINK_MSG_ID_PARAM_REQUEST_READ: {
+      mavlink_param_request_read_t request;
+      mavlink_msg_param_request_read_decode(&msg, &request);
+      int index = request.param_index >= 0 ? request.param_index : find_param(request.param_id);
+      if (index >= 0 && index < (int) params_.size()) {
+        send_param(index);
+      }
+      break;
+    }
+    case MAVLINK_MSG_ID_PARAM_SET: {
+      // Like the firmware, answer with the stored value, which is unchanged if the type is wrong
+      mavlink_param_set_t set;
+      mavlink_msg_param_set_decode(&msg, &set);
+      int index = find_param(set.param_id);
+      if (index >= 0) {
+        if (set.param_type == params_[(size_t) index].type) {
+          params_[(size_t) index].raw_value = set.param_value;
+        }
+        send_param(index);
+      }
+      break;
+    }
+    case MAVLINK_MSG_ID_ROSFLIGHT_CMD: {
+      mavlink_rosflight_cmd_t command;
+      mavlink_msg_rosflight_cmd_decode(&msg, &command);
+      if (command.command == ROSFLIGHT_CMD_SEND_VERSION) {
+        mavlink_msg_rosflight_version_pack(SYSTEM_ID, COMPONENT_ID, &reply, "mock_fcu");
+      } else {
+        mavlink_msg_rosflight_cmd_ack_pack(SYSTEM_ID, COMPONENT_ID, &reply, command.command,
+                                           ROSFLIGHT_CMD_SUCCESS);
+      }
+      send(reply);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/**
+ * \brief CPU time used by a process so far, in seconds, or a negative value if it can't be read
+ */
+double process_cpu_seconds(int pid)
+{
+  std::ifstream stat_file("/proc/" + std::to_string(pid) + "/stat");
+  std::string contents((std::istreambuf_iterator<char>(stat_file)),
+                       std::istreambuf_iterator<char>());
+  size_t name_end = contents.rfind(')');
+  if (name_end == std::string::npos) {
+    return -1.0;
+  }
+
+  // Fields after the command name start at field 3 (state); utime and stime are fields 14 and 15
+  std::istringstream fields(contents.substr(name_end + 2));
+  std::string field;
+  unsigned long long utime = 0, stime = 0;
+  for (int i = 3; i <= 15 && fields >> field; i++) {
+    if (i == 14) {
+      utime = std::stoull(field);
+    } else if (i == 15) {
+      stime = std::stoull(field);
+    }
+  }
+  return (double) (utime + stime) / (double) sysconf(_SC_CLK_TCK);
+}
+
+struct RampSample
+{
+  uint64_t sent;
+  uint64_t received;
+  uint64_t lost;
+  uint64_t dropped;
+  double cpu;
+  Clock::time_point time;
+};
+
+RampSample take_sample(const MockFCU & fcu, const mavrosflight::LiveStatsSegment & stats)
+{
+  RampSample sample{};
+  sample.sent = fcu.frames_sent();
+  sample.received = stats.rx_frames.load(std::memory_order_relaxed);
+  sample.lost = stats.rx_lost.load(std::memory_order_relaxed);
+  sample.dropped = stats.rx_dropped.load(std::memory_order_relaxed);
+  sample.cpu = process_cpu_seconds(stats.pid);
+  sample.time = Clock::now();
+  return sample;
+}
+
+int run_ramp(MockFCU & fcu, const Options & options)
+{
+  // rosflight_io may still be starting up, so keep the link busy while waiting for its segment
+  std::string shm_name = mavrosflight::LiveStats::segment_name(options.target);
+  mavrosflight::LiveStatsReader reader;
+  std::string error;
+  printf("Waiting for live statistics of %s (%s)\n", options.target.c_str(), shm_name.c_str());
+  while (!reader.attach(shm_name, &error)) {
+    if (stop_requested) {
+      return 1;
+    }
+    fcu.run_for(0.5);
+  }
+  const mavrosflight::LiveStatsSegment & stats = *reader.segment();
+
+  printf("%10s %10s %10s %8s %8s %10s %14s\n", "imu (Hz)", "sent/s", "recv/s", "lost", "dropped",
+         "cpu (%)", "cpu ms/1k frm");
+
+  double last_clean_rate = 0.0;
+  double saturation_rate = 0.0;
+  for (double rate = options.ramp_start; rate <= options.ramp_max && !stop_requested;
+       rate *= options.ramp_factor) {
+    fcu.set_imu_rate(rate);
+    fcu.run_for(options.ramp_settle);
+    RampSample before = take_sample(fcu, stats);
+    fcu.run_for(options.ramp_step);
+    RampSample after = take_sample(fcu, stats);
+
+    double dt = std::chrono::duration<double>(after.time - before.time).count();
+    uint64_t sent = after.sent - before.sent;
+    uint64_t received = after.received - before.received;
+    uint64_t lost = after.lost - before.lost;
+    uint64_t dropped = after.dropped - before.dropped;
+    double cpu = after.cpu - before.cpu;
+    double cpu_per_1k = received > 0 ? cpu * 1e3 / ((double) received * 1e-3) : 0.0;
+
+    printf("%10.0f %10.0f %10.0f %8llu %8llu %10.1f %14.3f\n", rate, (double) sent / dt,
+           (double) received / dt, (unsigned long long) lost, (unsigned long long) dropped,
+           100.0 * cpu / dt, cpu_per_1k);
+    fflush(stdout);
+
+    // Frames still in flight at the end of the window make received slightly lower than sent
+    bool saturated = lost > 0 || dropped > 0
+      || (double) received < (double) sent * (1.0 - options.tolerance);
+    if (saturated) {
+      saturation_rate = rate;
+      break;
+    }
+    last_clean_rate = rate;
+  }
+
+  if (saturation_rate > 0.0) {
+    printf("rosflight_io started losing frames at an IMU rate of %.0f Hz (last clean rate %.0f Hz)"
+           "\n",
+           saturation_rate, last_clean_rate);
+  } else {
+    printf("No frame loss up to an IMU rate of %.0f Hz\n", last_clean_rate);
+  }
+  return 0;
+}
+
+void print_usage(const char * program)
+{
+  printf(
+    "Usage: %s [options]\n"
+    "Transport:\n"
+    "  --pty                 use a pseudo-terminal instead of UDP and print its path\n"
+    "  --bind-host HOST      UDP address to bind to (default localhost)\n"
+    "  --bind-port PORT      UDP port to bind to (default 14525)\n"
+    "  --remote-host HOST    UDP address of rosflight_io (default localhost)\n"
+    "  --remote-port PORT    UDP port of rosflight_io (default 14520)\n"
+    "Streams (Hz, 0 disables):\n"
+    "  --imu-rate R          SMALL_IMU (default 500)\n"
+    "  --attitude-rate R     ATTITUDE_QUATERNION (default 100)\n"
+    "  --status-rate R       ROSFLIGHT_STATUS (default 10)\n"
+    "  --gnss-rate R         ROSFLIGHT_GNSS (default 10)\n"
+    "  --named-value-rate R  NAMED_VALUE_FLOAT (default 10)\n"
+    "  --param-rate R        PARAM_VALUE messages per second while sending the list (default 200)\n"
+    "  --params N            number of parameters (default 100)\n"
+    "  --duration S          stop after S seconds (default: run until interrupted)\n"
+    "Ramp test:\n"
+    "  --ramp                raise the IMU rate until rosflight_io loses frames\n"
+    "  --target NODE         fully qualified name of rosflight_io (default /rosflight_io)\n"
+    "  --ramp-start R        first IMU rate (default 500)\n"
+    "  --ramp-factor F       rate multiplier between steps (default 1.25)\n"
+    "  --ramp-max R          highest IMU rate to try (default 100000)\n"
+    "  --ramp-step S         measurement time per step (default 5)\n"
+    "  --ramp-settle S       time to let the rate settle before measuring (default 1)\n"
+    "  --tolerance T         fraction of frames allowed to be in flight (default 0.001)\n",
+    program);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  enum
+  {
+    OPT_PTY = 256,
+    OPT_BIND_HOST,
+    OPT_BIND_PORT,
+    OPT_REMOTE_HOST,
+    OPT_REMOTE_PORT,
+    OPT_IMU_RATE,
+    OPT_ATTITUDE_RATE,
+    OPT_STATUS_RATE,
+    OPT_GNSS_RATE,
+    OPT_NAMED_VALUE_RATE,
+    OPT_PARAM_RATE,
+    OPT_PARAMS,
+    OPT_DURATION,
+    OPT_RAMP,
+    OPT_TARGET,
+    OPT_RAMP_START,
+    OPT_RAMP_FACTOR,
+    OPT_RAMP_MAX,
+    OPT_RAMP_STEP,
+    OPT_RAMP_SETTLE,
+    OPT_TOLERANCE
+  };
+  const option long_options[] = {{"pty", no_argument, nullptr, OPT_PTY},
+                                 {"bind-host", required_argument, nullptr, OPT_BIND_HOST},
+                                 {"bind-port", required_argument, nullptr, OPT_BIND_PORT},
+                                 {"remote-host", required_argument, nullptr, OPT_REMOTE_HOST},
+                                 {"remote-port", required_argument, nullptr, OPT_REMOTE_PORT},
+                                 {"imu-rate", required_argument, nullptr, OPT_IMU_RATE},
+                                 {"attitude-rate", required_argument, nullptr, OPT_ATTITUDE_RATE},
+                                 {"status-rate", required_argument, nullptr, OPT_STATUS_RATE},
+                                 {"gnss-rate", required_argument, nullptr, OPT_GNSS_RATE},
+                                 {"named-value-rate", required_argument, nullptr,
+                                  OPT_NAMED_VALUE_RATE},
+                                 {"param-rate", required_argument, nullptr, OPT_PARAM_RATE},
+                                 {"params", required_argument, nullptr, OPT_PARAMS},
+                                 {"duration", required_argument, nullptr, OPT_DURATION},
+                                 {"ramp", no_argument, nullptr, OPT_RAMP},
+                                 {"target", required_argument, nullptr, OPT_TARGET},
+                                 {"ramp-start", required_argument, nullptr, OPT_RAMP_START},
+                                 {"ramp-factor", required_argument, nullptr, OPT_RAMP_FACTOR},
+                                 {"ramp-max", required_argument, nullptr, OPT_RAMP_MAX},
+                                 {"ramp-step", required_argument, nullptr, OPT_RAMP_STEP},
+                                 {"ramp-settle", required_argument, nullptr, OPT_RAMP_SETTLE},
+                                 {"tolerance", required_argument, nullptr, OPT_TOLERANCE},
+                                 {"help", no_argument, nullptr, 'h'},
+                                 {nullptr, 0, nullptr, 0}};
+
+  Options options;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "h", long_options, nullptr)) != -1) {
+    switch (opt) {
+      case OPT_PTY:
+        options.pty = true;
+        break;
+      case OPT_BIND_HOST:
+        options.bind_host = optarg;
+        break;
+      case OPT_BIND_PORT:
+        options.bind_port = (uint16_t) std::atoi(optarg);
+        break;
+      case OPT_REMOTE_HOST:
+        options.remote_host = optarg;
+        break;
+      case OPT_REMOTE_PORT:
+        options.remote_port = (uint16_t) std::atoi(optarg);
+        break;
+      case OPT_IMU_RATE:
+        options.imu_rate = std::atof(optarg);
+        break;
+      case OPT_ATTITUDE_RATE:
+        options.attitude_rate = std::atof(optarg);
+        break;
+      case OPT_STATUS_RATE:
+        options.status_rate = std::atof(optarg);
+        break;
+      case OPT_GNSS_RATE:
+        options.gnss_rate = std::atof(optarg);
+        break;
+      case OPT_NAMED_VALUE_RATE:
+        options.named_value_rate = std::atof(optarg);
+        break;
+      case OPT_PARAM_RATE:
+        options.param_rate = std::atof(optarg);
+        break;
+      case OPT_PARAMS:
+        options.num_params = std::max(std::atoi(optarg), 0);
+        break;
+      case OPT_DURATION:
+        options.duration = std::atof(optarg);
+        break;
+      case OPT_RAMP:
+        options.ramp = true;
+        break;
+      case OPT_TARGET:
+        options.target = optarg;
+        break;
+      case OPT_RAMP_START:
+        options.ramp_start = std::atof(optarg);
+        break;
+      case OPT_RAMP_FACTOR:
+        options.ramp_factor = std::atof(optarg);
+        break;
+      case OPT_RAMP_MAX:
+        options.ramp_max = std::atof(optarg);
+        break;
+      case OPT_RAMP_STEP:
+        options.ramp_step = std::atof(optarg);
+        break;
+      case OPT_RAMP_SETTLE:
+        options.ramp_settle = std::atof(optarg);
+        break;
+      case OPT_TOLERANCE:
+        options.tolerance = std::atof(optarg);
+        break;
+      default:
+        print_usage(argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (options.ramp && options.ramp_factor <= 1.0) {
+    fprintf(stderr, "--ramp-factor must be greater than 1\n");
+    return 1;
+  }
+
+  std::signal(SIGINT, [](int) { stop_requested = true; });
+  std::signal(SIGTERM, [](int) { stop_requested = true; });
+
+  std::unique_ptr<mavrosflight::MavlinkComm> comm;
+  mavrosflight::MavlinkPty * pty = nullptr;
+  if (options.pty) {
+    pty = new mavrosflight::MavlinkPty();
+    comm.reset(pty);
+  } else {
+    comm.reset(new mavrosflight::MavlinkUDP(options.bind_host, options.bind_port,
+                                            options.remote_host, options.remote_port));
+  }
+
+  MockFCU fcu(*comm, options);
+  comm->register_mavlink_listener(&fcu);
+  try {
+    comm->open();
+  } catch (const mavrosflight::SerialException & e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  if (pty != nullptr) {
+    printf("Connect rosflight_io with: ros2 run rosflight_io rosflight_io --ros-args -p port:=%s\n",
+           pty->slave_name().c_str());
+  } else {
+    printf("Sending to %s:%d from %s:%d\n", options.remote_host.c_str(), options.remote_port,
+           options.bind_host.c_str(), options.bind_port);
+  }
+  fflush(stdout);
+
+  int result = 0;
+  if (options.ramp) {
+    result = run_ramp(fcu, options);
+  } else if (options.duration > 0.0) {
+    fcu.run_for(options.duration);
+  } else {
+    while (!stop_requested) {
+      fcu.run_for(1.0);
+    }
+  }
+
+  comm->close();
+  return result;
+}
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file record_convert.cpp
+ *
+ * Converts a recording made by the rosflight_io flight recorder to CSV files, one per record type,
+ * and/or to a rosbag2 bag with the topics and message types rosflight_io publishes. Bag messages
+ * are stamped with the time rosflight_io received them.
+ */
+
+#include <rosflight_io/mavrosflight/flight_record.hpp>
+
+#include <getopt.h>
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+#include <rosbag2_cpp/writer.hpp>
+#include <rosflight_msgs/msg/airspeed.hpp>
+#include <rosflight_msgs/msg/attitude.hpp>
+#include <rosflight_msgs/msg/barometer.hpp>
+#include <rosflight_msgs/msg/battery_status.hpp>
+#include <rosflight_msgs/msg/output_raw.hpp>
+#include <rosflight_msgs/msg/rc_raw.hpp>
+#include <rosflight_msgs/msg/status.hpp>
+#include <sensor_msgs/msg/imu.hpp>
+#include <sensor_msgs/msg/magnetic_field.hpp>
+#include <sensor_msgs/msg/temperature.hpp>
+
+using mavrosflight::FlightRecordReader;
+using mavrosflight::RecordColumnType;
+using mavrosflight::RecordSchema;
+
+namespace
+{
+struct Options
+{
+  std::string csv_directory;
+  std::string bag_uri;
+  std::string topic_namespace;
+  std::string frame_id = "world";
+};
+
+/**
+ * \brief Writes each record type to its own CSV file
+ */
+class CsvWriter
+{
+public:
+  explicit CsvWriter(std::string directory)
+      : directory_(std::move(directory))
+  {}
+
+  ~CsvWriter()
+  {
+    for (auto & file : files_) { fclose(file.second); }
+  }
+
+  bool write(const FlightRecordReader::Chunk & chunk)
+  {
+    FILE * file = file_for(*chunk.schema);
+    if (file == nullptr) {
+      return false;
+    }
+
+    const auto & columns = chunk.schema->columns;
+    for (uint32_t row = 0; row < chunk.rows; row++) {
+      for (size_t c = 0; c < columns.size(); c++) {
+        if (c > 0) {
+          fputc(',', file);
+        }
+        switch (columns[c].type) {
+          case RecordColumnType::UINT64:
+            fprintf(file, "%" PRIu64, chunk.get<uint64_t>(c, row));
+            break;
+          case RecordColumnType::INT64:
+            fprintf(file, "%" PRId64, chunk.get<int64_t>(c, row));
+            break;
+          case RecordColumnType::FLOAT32:
+            fprintf(file, "%.9g", (double) chunk.get<float>(c, row));
+            break;
+          default:
+            fprintf(file, "%.0f", chunk.as_double(c, row));
+            break;
+        }
+      }
+      fputc('\n', file);
+    }
+    return true;
+  }
+
+private:
+  FILE * file_for(const RecordSchema & schema)
+  {
+    auto it = files_.find(schema.name);
+    if (it != files_.end()) {
+      return it->second;
+    }
+
+    std::string path = directory_ + "/" + schema.name + ".csv";
+    FILE * file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+      perror(path.c_str());
+      return nullptr;
+    }
+    for (size_t c = 0; c < schema.columns.size(); c++) {
+      fprintf(file, "%s%s", c > 0 ? "," : "", schema.columns[c].name.c_str());
+    }
+    fputc('\n', file);
+    files_[schema.name] = file;
+    return file;
+  }
+
+  std::string directory_;
+  std::map<std::string, FILE *> files_;
+};
+
+/**
+ * \brief Writes the record types rosflight_io publishes to a bag, as the messages it publishes
+ */
+class BagWriter
+{
+public:
+  BagWriter(const std::string & uri, const Options & options)
+      : options_(options)
+  {
+    writer_.open(uri);
+  }
+
+  void write(const FlightRecordReader::Chunk & chunk)
+  {
+    const std::string & name = chunk.schema->name;
+    auto column = [&chunk](const char * column_name) {
+      return (size_t) chunk.schema->column_index(column_name);
+    };
+    auto f = [&chunk](size_t c, uint32_t row) { return chunk.as_double(c, row); };
+
+    for (uint32_t row = 0; row < chunk.rows; row++) {
+      rclcpp::Time stamp(chunk.get<int64_t>(0, row), RCL_SYSTEM_TIME);
+      std_msgs::msg::Header header;
+      header.stamp = stamp;
+      header.frame_id = options_.frame_id;
+
+      if (name == "small_imu") {
+        sensor_msgs::msg::Imu imu;
+        imu.header = header;
+        imu.linear_acceleration.x = f(column("xacc"), row);
+        imu.linear_acceleration.y = f(column("yacc"), row);
+        imu.linear_acceleration.z = f(column("zacc"), row);
+        imu.angular_velocity.x = f(column("xgyro"), row);
+        imu.angular_velocity.y = f(column("ygyro"), row);
+        imu.angular_velocity.z = f(column("zgyro"), row);
+        writer_.write(imu, topic("imu/data"), stamp);
+
+        sensor_msgs::msg::Temperature temperature;
+        temperature.header = header;
+        temperature.temperature = f(column("temperature"), row);
+        writer_.write(temperature, topic("imu/temperature"), stamp);
+      } else if (name == "attitude_quaternion") {
+        rosflight_msgs::msg::Attitude attitude;
+        attitude.header = header;
+        attitude.attitude.w = f(column("q1"), row);
+        attitude.attitude.x = f(column("q2"), row);
+        attitude.attitude.y = f(column("q3"), row);
+        attitude.attitude.z = f(column("q4"), row);
+        attitude.angular_velocity.x = f(column("rollspeed"), row);
+        attitude.angular_velocity.y = f(column("pitchspeed"), row);
+        attitude.angular_velocity.z = f(column("yawspeed"), row);
+        writer_.write(attitude, topic("attitude"), stamp);
+      } else if (name == "small_mag") {
+        sensor_msgs::msg::MagneticField mag;
+        mag.header = header;
+        mag.magnetic_field.x = f(column("xmag"), row);
+        mag.magnetic_field.y = f(column("ymag"), row);
+        mag.magnetic_field.z = f(column("zmag"), row);
+        writer_.write(mag, topic("magnetometer"), stamp);
+      } else if (name == "small_baro") {
+        rosflight_msgs::msg::Barometer baro;
+        baro.header = header;
+        baro.altitude = (float) f(column("altitude"), row);
+        baro.pressure = (float) f(column("pressure"), row);
+        baro.temperature = (float) f(column("temperature"), row);
+        writer_.write(baro, topic("baro"), stamp);
+      } else if (name == "diff_pressure") {
+        rosflight_msgs::msg::Airspeed airspeed;
+        airspeed.header = header;
+        airspeed.velocity = (float) f(column("velocity"), row);
+        airspeed.differential_pressure = (float) f(column("diff_pressure"), row);
+        airspeed.temperature = (float) f(column("temperature"), row);
+        writer_.write(airspeed, topic("airspeed"), stamp);
+      } else if (name == "rosflight_output_raw") {
+        rosflight_msgs::msg::OutputRaw output;
+        output.header = header;
+        for (size_t i = 0; i < output.values.size(); i++) {
+          output.values[i] = (float) f(column(("value" + std::to_string(i)).c_str()), row);
+        }
+        writer_.write(output, topic("output_raw"), stamp);
+      } else if (name == "rc_channels_raw") {
+        rosflight_msgs::msg::RCRaw rc;
+        rc.header = header;
+        for (size_t i = 0; i < rc.values.size(); i++) {
+          rc.values[i] = (uint16_t) f(column(("chan" + std::to_string(i)).c_str()), row);
+        }
+        writer_.write(rc, topic("rc_raw"), stamp);
+      } else if (name == "rosflight_status") {
+        rosflight_msgs::msg::Status status;
+        status.header = header;
+        status.armed = f(column("armed"), row) != 0;
+        status.failsafe = f(column("failsafe"), row) != 0;
+        status.rc_override = f(column("rc_override"), row) != 0;
+        status.offboard = f(column("offboard"), row) != 0;
+        status.control_mode = (uint8_t) f(column("control_mode"), row);
+        status.error_code = (uint8_t) f(column("error_code"), row);
+        status.num_errors = (int16_t) f(column("num_errors"), row);
+        status.loop_time_us = (int16_t) f(column("loop_time_us"), row);
+        writer_.write(status, topic("status"), stamp);
+      } else if (name == "rosflight_battery_status") {
+        rosflight_msgs::msg::BatteryStatus battery;
+        battery.header = header;
+        battery.voltage = (float) f(column("battery_voltage"), row);
+        battery.current = (float) f(column("battery_current"), row);
+        writer_.write(battery, topic("battery"), stamp);
+      } else {
+        // Only in the CSV output
+        return;
+      }
+    }
+  }
+
+private:
+  std::string topic(const std::string & name) const
+  {
+    return options_.topic_namespace + "/" + name;
+  }
+
+  const Options & options_;
+  rosbag2_cpp::Writer writer_;
+};
+
+void print_usage(const char * program)
+{
+  printf("Usage: %s [options] RECORDING\n"
+         "Converts a rosflight_io recording directory to CSV and/or rosbag2.\n"
+         "  --csv DIR        write one CSV file per record type to DIR\n"
+         "  --bag URI        write a bag with the topics rosflight_io publishes\n"
+         "  --namespace NS   namespace for the bag topics (default: none)\n"
+         "  --frame-id ID    frame_id of the bag messages (default world)\n",
+         program);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  enum
+  {
+    OPT_CSV = 256,
+    OPT_BAG,
+    OPT_NAMESPACE,
+    OPT_FRAME_ID
+  };
+  const option long_options[] = {{"csv", required_argument, nullptr, OPT_CSV},
+                                 {"bag", required_argument, nullptr, OPT_BAG},
+                                 {"namespace", required_argument, nullptr, OPT_NAMESPACE},
+                                 {"frame-id", required_argument, nullptr, OPT_FRAME_ID},
+                                 {"help", no_argument, nullptr, 'h'},
+                                 {nullptr, 0, nullptr, 0}};
+
+  Options options;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "h", long_options, nullptr)) != -1) {
+    switch (opt) {
+      case OPT_CSV:
+        options.csv_directory = optarg;
+        break;
+      case OPT_BAG:
+        options.bag_uri = optarg;
+        break;
+      case OPT_NAMESPACE:
+        options.topic_namespace = optarg;
+        break;
+      case OPT_FRAME_ID:
+        options.frame_id = optarg;
+        break;
+      default:
+        print_usage(argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (optind != argc - 1 || (options.csv_directory.empty() && options.bag_uri.empty())) {
+    print_usage(argv[0]);
+    return 1;
+  }
+  while (!options.topic_namespace.empty() && options.topic_namespace.back() == '/') {
+    options.topic_namespace.pop_back();
+  }
+
+  std::string recording = argv[optind];
+  std::vector<std::string> segments = FlightRecordReader::segments(recording);
+  if (segments.empty()) {
+    fprintf(stderr, "No flight record segments in %s\n", recording.c_str());
+    return 1;
+  }
+
+  std::unique_ptr<CsvWriter> csv;
+  if (!options.csv_directory.empty()) {
+    if (mkdir(options.csv_directory.c_str(), 0755) != 0 && errno != EEXIST) {
+      perror(options.csv_directory.c_str());
+      return 1;
+    }
+    csv = std::make_unique<CsvWriter>(options.csv_directory);
+  }
+  std::unique_ptr<BagWriter> bag;
+  if (!options.bag_uri.empty()) {
+    bag = std::make_unique<BagWriter>(options.bag_uri, options);
+  }
+
+  std::map<std::string, uint64_t> rows;
+  for (const auto & path : segments) {
+    FlightRecordReader reader;
+    std::string error;
+    if (!reader.open(path, error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+
+    FlightRecordReader::Chunk chunk;
+    while (reader.next(chunk)) {
+      if (csv && !csv->write(chunk)) {
+        return 1;
+      }
+      if (bag) {
+        bag->write(chunk);
+      }
+      rows[chunk.schema->name] += chunk.rows;
+    }
+  }
+
+  for (const auto & count : rows) {
+    printf("%-26s %" PRIu64 " rows\n", count.first.c_str(), count.second);
+  }
+  return 0;
+}
@@ -44,9 +44,18 @@
 #define GIT_VERSION_STRING TOSTRING(ROSFLIGHT_VERSION)
 #endif
 
+#include <rosflight_io/loop_time_diagnostics.hpp>
+#include <rosflight_io/mavrosflight/hot_path.hpp>
 #include <rosflight_io/mavrosflight/mavlink_serial.hpp>
 #include <rosflight_io/mavrosflight/mavlink_udp.hpp>
+#include <rosflight_io/mavrosflight/ros_platform.hpp>
+#include <rosflight_io/mavrosflight/serial_discovery.hpp>
 #include <rosflight_io/mavrosflight/serial_exception.hpp>
+#include <rosflight_io/mavrosflight/tracepoints.hpp>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <limits>
 #include <string>
 #include <tf2/LinearMath/Matrix3x3.h>
 #include <tf2/LinearMath/Quaternion.h>
@@ -57,10 +66,324 @@
 
 namespace rosflight_io
 {
+namespace
+{
+void to_bounded(const rosflight_msgs::msg::Status & in, rosflight_msgs::msg::StatusBounded & out)
+{
+  out.stamp = in.header.stamp;
+  out.armed = in.armed;
+  out.failsafe = in.failsafe;
+  out.rc_override = in.rc_override;
+  out.offboard = in.offboard;
+  out.control_mode = in.control_mode;
+  out.error_code = in.error_code;
+  out.num_errors = in.num_errors;
+  out.loop_time_us = in.loop_time_us;
+}
+
+void to_bounded(const rosflight_msgs::msg::Attitude & in,
+                rosflight_msgs::msg::AttitudeBounded & out)
+{
+  out.stamp = in.header.stamp;
+  out.attitude = in.attitude;
+  out.angular_velocity = in.angular_velocity;
+}
+
+void to_bounded(const rosflight_msgs::msg::OutputRaw & in,
+                rosflight_msgs::msg::OutputRawBounded & out)
+{
+  out.stamp = in.header.stamp;
+  out.values = in.values;
+}
+
+void to_bounded(const rosflight_msgs::msg::RCRaw & in, rosflight_msgs::msg::RCRawBounded & out)
+{
+  out.stamp = in.header.stamp;
+  out.values = in.values;
+}
+
+void to_bounded(const rosflight_msgs::msg::Airspeed & in,
+                rosflight_msgs::msg::AirspeedBounded & out)
+{
+  out.stamp = in.header.stamp;
+  out.velocity = in.velocity;
+  out.differential_pressure = in.differential_pressure;
+  out.temperature = in.temperature;
+}
+
+void to_bounded(const rosflight_msgs::msg::Barometer & in,
+                rosflight_msgs::msg::BarometerBounded & out)
+{
+  out.stamp = in.header.stamp;
+  out.altitude = in.altitude;
+  out.pressure = in.pressure;
+  out.temperature = in.temperature;
+}
+
+void to_bounded(const rosflight_msgs::msg::GNSS & in, rosflight_msgs::msg::GNSSBounded & out)
+{
+  out.stamp = in.header.stamp;
+  out.fix = in.fix;
+  out.time = in.time;
+  out.position = in.position;
+  out.horizontal_accuracy = in.horizontal_accuracy;
+  out.vertical_accuracy = in.vertical_accuracy;
+  out.velocity = in.velocity;
+  out.speed_accuracy = in.speed_accuracy;
+}
+
+/**
+ * @brief Maps the calibration names of the "provision" service to ROSFLIGHT_CMDs.
+ * @return The command, or -1 for an unknown name.
+ */
+int calibration_command(const std::string & name)
+{
+  if (name == "imu") {
+    return ROSFLIGHT_CMD_ACCEL_CALIBRATION;
+  } else if (name == "rc_trim") {
+    return ROSFLIGHT_CMD_RC_CALIBRATION;
+  } else if (name == "baro") {
+    return ROSFLIGHT_CMD_BARO_CALIBRATION;
+  } else if (name == "airspeed") {
+    return ROSFLIGHT_CMD_AIRSPEED_CALIBRATION;
+  }
+  return -1;
+}
+
+/**
+ * @brief Publishes the bounded variant of a message. The message is loaned from the middleware
+ * when it supports loans, so co-located subscribers get it without a copy. Otherwise it is filled
+ * in and published from the preallocated message.
+ */
+template<class BoundedT, class MsgT>
+void publish_bounded(rclcpp_lifecycle::LifecyclePublisher<BoundedT> & pub, BoundedT & unloaned,
+                     const MsgT & msg)
+{
+  if (pub.can_loan_messages()) {
+    auto loaned = pub.borrow_loaned_message();
+    to_bounded(msg, loaned.get());
+    pub.publish(std::move(loaned));
+  } else {
+    to_bounded(msg, unloaned);
+    pub.publish(unloaned);
+  }
+}
+} // namespace
+
 ROSflightIO::ROSflightIO()
-    : Node("rosflight_io")
+    : ROSflightIO(nullptr)
+{}
+
+ROSflightIO::ROSflightIO(mavrosflight::MavlinkComm * mavlink_comm)
+    : LifecycleNode("rosflight_io")
+    , publish_sensor_bundle_(false)
+    , publish_bounded_msgs_(false)
+    , active_(false)
+    , loop_time_overrun_(false)
+    , connection_state_(WAITING_FOR_HEARTBEAT)
+    , version_received_(false)
+    , baro_received_(false)
+    , airspeed_received_(false)
+    , link_failed_(false)
+    , last_heartbeat_ns_(0)
+    , node_start_(std::chrono::steady_clock::now())
+    , params_received_at_last_check_(0)
+    , param_events_subscribers_(0)
+    , provision_step_(PROVISION_IDLE)
+    , provision_calibration_(0)
+    , provision_awaited_command_(-1)
+    , provision_ack_result_(-1)
+    , provision_biases_captured_(0)
+    , status_error_code_(0)
     , prev_status_()
+    , mavlink_comm_(mavlink_comm)
+    , owns_mavlink_comm_(mavlink_comm == nullptr)
+    , mavrosflight_(nullptr)
 {
+  this->declare_parameter("udp", rclcpp::PARAMETER_BOOL);
+  this->declare_parameter("bind_host", rclcpp::PARAMETER_STRING);
+  this->declare_parameter("bind_port", rclcpp::PARAMETER_INTEGER);
+  this->declare_parameter("remote_host", rclcpp::PARAMETER_STRING);
+  this->declare_parameter("remote_port", rclcpp::PARAMETER_INTEGER);
+  this->declare_parameter("port", rclcpp::PARAMETER_STRING);
+  this->declare_parameter("baud_rate", rclcpp::PARAMETER_INTEGER);
+  this->declare_parameter("frame_id", rclcpp::PARAMETER_STRING);
+  this->declare_parameter("live_stats", rclcpp::PARAMETER_BOOL);
+  this->declare_parameter("attitude_history_size", rclcpp::PARAMETER_INTEGER);
+  this->declare_parameter("attitude_max_extrapolation", rclcpp::PARAMETER_DOUBLE);
+  this->declare_parameter("record", rclcpp::PARAMETER_BOOL);
+  this->declare_parameter("record_directory", rclcpp::PARAMETER_STRING);
+  this->declare_parameter("record_segment_size", rclcpp::PARAMETER_INTEGER);
+  this->declare_parameter("sensor_bundle", rclcpp::PARAMETER_BOOL);
+  this->declare_parameter("bounded_msgs", rclcpp::PARAMETER_BOOL);
+  this->declare_parameter("loop_time_budget_us", rclcpp::PARAMETER_INTEGER);
+  this->declare_parameter("loop_time_window", rclcpp::PARAMETER_INTEGER);
+  this->declare_parameter("loop_time_report_period", rclcpp::PARAMETER_DOUBLE);
+  this->declare_parameter("discover_port", rclcpp::PARAMETER_BOOL);
+  this->declare_parameter("discovery_directory", rclcpp::PARAMETER_STRING);
+  this->declare_parameter("discovery_baud_rates", rclcpp::PARAMETER_INTEGER_ARRAY);
+  this->declare_parameter("discovery_window", rclcpp::PARAMETER_DOUBLE);
+  this->declare_parameter("autostart", rclcpp::PARAMETER_BOOL);
+  this->declare_parameter("standby", rclcpp::PARAMETER_BOOL);
+  this->declare_parameter("param_events_window", rclcpp::PARAMETER_DOUBLE);
+  this->declare_parameter("command_rate", rclcpp::PARAMETER_DOUBLE);
+  this->declare_parameter("command_timeout", rclcpp::PARAMETER_DOUBLE);
+  this->declare_parameter("io_thread_priority", rclcpp::PARAMETER_INTEGER);
+}
+
+ROSflightIO::~ROSflightIO()
+{
+  if (mavrosflight_ != nullptr) {
+    close_link();
+  }
+}
+
+ROSflightIO::CallbackReturn ROSflightIO::on_configure(const rclcpp_lifecycle::State & state)
+{
+  // Read the settings first, so nothing is published with stale ones after a reconfigure
+  frame_id_ = this->get_parameter_or<std::string>("frame_id", "world");
+  attitude_history_.reset((size_t) this->get_parameter_or<int>("attitude_history_size", 256));
+  attitude_max_extrapolation_ns_ =
+    (int64_t) (this->get_parameter_or<double>("attitude_max_extrapolation", 0.05) * 1e9);
+  publish_sensor_bundle_ = this->get_parameter_or("sensor_bundle", false);
+  publish_bounded_msgs_ = this->get_parameter_or("bounded_msgs", false);
+  loop_time_monitor_.reset(
+    (size_t) std::max(this->get_parameter_or<int>("loop_time_window", 600), 1),
+    (uint32_t) std::max(this->get_parameter_or<int>("loop_time_budget_us", 1000), 0));
+  loop_time_overrun_ = false;
+
+  prev_status_.armed = false;
+  prev_status_.failsafe = false;
+  prev_status_.rc_override = false;
+  prev_status_.offboard = false;
+  prev_status_.control_mode = OFFBOARD_CONTROL_MODE_ENUM_END;
+  prev_status_.error_code = ROSFLIGHT_ERROR_NONE;
+  connection_state_ = WAITING_FOR_HEARTBEAT;
+  version_received_ = false;
+  baro_received_ = false;
+  airspeed_received_ = false;
+
+  create_publishers();
+
+  if (!owns_mavlink_comm_) {
+    // Given to the constructor
+  } else if (this->get_parameter_or("udp", false)) {
+    auto bind_host = this->get_parameter_or<std::string>("bind_host", "localhost");
+    auto bind_port = this->get_parameter_or<uint16_t>("bind_port", 14520);
+    auto remote_host = this->get_parameter_or<std::string>("remote_host", bind_host);
+    auto remote_port = this->get_parameter_or<uint16_t>("remote_port", 14525);
+
+    RCLCPP_INFO(this->get_logger(), "Connecting over UDP to \"%s:%d\", from \"%s:%d\"",
+                remote_host.c_str(), remote_port, bind_host.c_str(), bind_port);
+
+    mavlink_comm_ = new mavrosflight::MavlinkUDP(bind_host, bind_port, remote_host, remote_port);
+  } else {
+    auto port = this->get_parameter_or<std::string>("port", "/dev/ttyACM0");
+    int baud_rate = this->get_parameter_or<int>("baud_rate", 921600);
+
+    if (this->get_parameter_or("discover_port", false) && !discover_port(port, baud_rate)) {
+      close_link();
+      return CallbackReturn::FAILURE;
+    }
+
+    RCLCPP_INFO(this->get_logger(), "Connecting to serial port \"%s\", at %d baud", port.c_str(),
+                baud_rate);
+
+    mavlink_comm_ = new mavrosflight::MavlinkSerial(port, baud_rate);
+  }
+
+  // Publish link statistics to shared memory for rosflight_top
+  if (this->get_parameter_or("live_stats", true)) {
+    if (live_stats_.open(this->get_fully_qualified_name(), mavrosflight::LIVE_STATS_KIND_IO)) {
+      mavlink_comm_->set_live_stats(live_stats_.segment());
+    } else {
+      RCLCPP_WARN(this->get_logger(), "Could not create live statistics segment \"%s\"",
+                  mavrosflight::LiveStats::segment_name(this->get_fully_qualified_name()).c_str());
+    }
+  }
+
+  try {
+    mavrosflight_ =
+      new mavrosflight::MavROSflight(*mavlink_comm_, mavrosflight::make_ros_platform(this));
+  } catch (const mavrosflight::SerialException & e) {
+    // Stay unconfigured, so configuring can be retried once the link is back
+    RCLCPP_ERROR(this->get_logger(), "%s", e.what());
+    close_link();
+    return CallbackReturn::FAILURE;
+  }
+
+  // The io thread reads, writes and runs the command scheduler, so it decides the command timing
+  int io_thread_priority = this->get_parameter_or<int>("io_thread_priority", 0);
+  if (io_thread_priority > 0 && !mavrosflight_->comm.set_io_thread_priority(io_thread_priority)) {
+    RCLCPP_WARN(this->get_logger(),
+                "Could not give the io thread real-time priority %d, check the rtprio limit",
+                io_thread_priority);
+  }
+
+  // Record decoded telemetry to disk, ahead of this node's own handlers
+  if (this->get_parameter_or("record", false)) {
+    auto directory = this->get_parameter_or<std::string>("record_directory", "rosflight_records");
+    int segment_mb = this->get_parameter_or<int>("record_segment_size", 64);
+
+    char stamp[32];
+    time_t now = time(nullptr);
+    strftime(stamp, sizeof(stamp), "/%Y%m%d_%H%M%S", localtime(&now));
+
+    std::string error;
+    if (recorder_.open(directory + stamp, (size_t) segment_mb * 1024 * 1024, error)) {
+      mavrosflight_->comm.register_mavlink_listener(&recorder_);
+      RCLCPP_INFO(this->get_logger(), "Recording to %s", recorder_.directory().c_str());
+    } else {
+      RCLCPP_ERROR(this->get_logger(), "Could not start the flight recorder: %s", error.c_str());
+    }
+  }
+
+  subscribe_handlers(mavrosflight_->comm);
+  mavrosflight_->param.register_param_listener(this);
+
+  // Ask right away in case the firmware is already running; the handshake starts over from the
+  // first heartbeat either way
+  mavrosflight_->param.request_params();
+  request_version();
+  handshake_timer_ =
+    this->create_wall_timer(std::chrono::milliseconds(HANDSHAKE_PERIOD_MS),
+                            std::bind(&ROSflightIO::handshakeTimerCallback, this), nullptr);
+
+  // Start the heartbeat
+  heartbeat_timer_ =
+    this->create_wall_timer(std::chrono::seconds(HEARTBEAT_PERIOD),
+                            std::bind(&ROSflightIO::heartbeatTimerCallback, this), nullptr);
+
+  // The MAVLink handlers queue their log lines, since logging on the io thread would allocate
+  log_timer_ = this->create_wall_timer(std::chrono::milliseconds(LOG_PERIOD_MS),
+                                       std::bind(&ROSflightIO::logTimerCallback, this), nullptr);
+
+  return CallbackReturn::SUCCESS;
+}
+
+ROSflightIO::CallbackReturn ROSflightIO::on_activate(const rclcpp_lifecycle::State & state)
+{
+  // Activates the publishers
+  LifecycleNode::on_activate(state);
+  active_ = true;
+
+  // Before the subscriptions, so the callbacks see it
+  double command_rate = this->get_parameter_or<double>("command_rate", 0.0);
+  if (command_rate > 0.0) {
+    // Shorter than a period, every command would go stale before it is sent
+    double command_timeout =
+      std::max(this->get_parameter_or<double>("command_timeout", 0.1), 1.0 / command_rate);
+    command_scheduler_ = std::make_unique<mavrosflight::CommandScheduler>(
+      mavrosflight_->comm, mavrosflight::make_ros_platform(this),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(1.0 / command_rate)),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(command_timeout)));
+    RCLCPP_INFO(this->get_logger(),
+                "Sending commands at %.1f Hz, stopping after %.3f s without a new one",
+                command_rate, command_timeout);
+  }
+
   command_sub_ = this->create_subscription<rosflight_msgs::msg::Command>(
     "command", 1, std::bind(&ROSflightIO::commandCallback, this, std::placeholders::_1));
   aux_command_sub_ = this->create_subscription<rosflight_msgs::msg::AuxCommand>(
@@ -69,15 +392,6 @@ ROSflightIO::ROSflightIO()
     "external_attitude", 1,
     std::bind(&ROSflightIO::externalAttitudeCallback, this, std::placeholders::_1));
 
-  rclcpp::QoS qos_transient_local_1_(1);
-  qos_transient_local_1_.transient_local();
-  unsaved_params_pub_ =
-    this->create_publisher<std_msgs::msg::Bool>("unsaved_params", qos_transient_local_1_);
-  rclcpp::QoS qos_transient_local_5_(5); // A relatively large queue so all messages get through
-  qos_transient_local_5_.transient_local();
-  error_pub_ =
-    this->create_publisher<rosflight_msgs::msg::Error>("rosflight_errors", qos_transient_local_5_);
-
   param_get_srv_ = this->create_service<rosflight_msgs::srv::ParamGet>(
     "param_get",
     std::bind(&ROSflightIO::paramGetSrvCallback, this, std::placeholders::_1,
@@ -106,6 +420,14 @@ ROSflightIO::ROSflightIO()
     "calibrate_rc_trim",
     std::bind(&ROSflightIO::calibrateRCTrimSrvCallback, this, std::placeholders::_1,
               std::placeholders::_2));
+  calibrate_baro_srv_ = this->create_service<std_srvs::srv::Trigger>(
+    "calibrate_baro",
+    std::bind(&ROSflightIO::calibrateBaroSrvCallback, this, std::placeholders::_1,
+              std::placeholders::_2));
+  calibrate_airspeed_srv_ = this->create_service<std_srvs::srv::Trigger>(
+    "calibrate_airspeed",
+    std::bind(&ROSflightIO::calibrateAirspeedSrvCallback, this, std::placeholders::_1,
+              std::placeholders::_2));
   reboot_srv_ = this->create_service<std_srvs::srv::Trigger>(
     "reboot",
     std::bind(&ROSflightIO::rebootSrvCallback, this, std::placeholders::_1, std::placeholders::_2));
@@ -113,223 +435,526 @@ ROSflightIO::ROSflightIO()
     "reboot_to_bootloader",
     std::bind(&ROSflightIO::rebootToBootloaderSrvCallback, this, std::placeholders::_1,
               std::placeholders::_2));
+  provision_srv_ = this->create_service<rosflight_msgs::srv::Provision>(
+    "provision",
+    std::bind(&ROSflightIO::provisionSrvCallback, this, std::placeholders::_1,
+              std::placeholders::_2));
+  attitude_at_time_srv_ = this->create_service<rosflight_msgs::srv::AttitudeAtTime>(
+    "attitude_at_time",
+    std::bind(&ROSflightIO::attitudeAtTimeSrvCallback, this, std::placeholders::_1,
+              std::placeholders::_2));
+  reset_loop_time_monitor_srv_ = this->create_service<std_srvs::srv::Trigger>(
+    "reset_loop_time_monitor",
+    std::bind(&ROSflightIO::resetLoopTimeMonitorSrvCallback, this, std::placeholders::_1,
+              std::placeholders::_2));
+  param_snapshot_srv_ = this->create_service<std_srvs::srv::Trigger>(
+    "param_snapshot",
+    std::bind(&ROSflightIO::paramSnapshotSrvCallback, this, std::placeholders::_1,
+              std::placeholders::_2));
 
-  this->declare_parameter("udp", rclcpp::PARAMETER_BOOL);
-  this->declare_parameter("bind_host", rclcpp::PARAMETER_STRING);
-  this->declare_parameter("bind_port", rclcpp::PARAMETER_INTEGER);
-  this->declare_parameter("remote_host", rclcpp::PARAMETER_STRING);
-  this->declare_parameter("remote_port", rclcpp::PARAMETER_INTEGER);
-  this->declare_parameter("port", rclcpp::PARAMETER_STRING);
-  this->declare_parameter("baud_rate", rclcpp::PARAMETER_INTEGER);
-  this->declare_parameter("frame_id", rclcpp::PARAMETER_STRING);
+  // The latched topics are not published while inactive, so bring them up to date. The firmware
+  // sends its version again when asked.
+  std_msgs::msg::Bool unsaved_msg;
+  unsaved_msg.data = mavrosflight_->param.unsaved_changes();
+  unsaved_params_pub_->publish(unsaved_msg);
+  std_msgs::msg::Bool overrun_msg;
+  overrun_msg.data = loop_time_overrun_;
+  loop_time_overrun_pub_->publish(overrun_msg);
+  publish_connection_status(connection_state_ == READY);
+  request_version();
 
-  if (this->get_parameter_or("udp", false)) {
-    auto bind_host = this->get_parameter_or<std::string>("bind_host", "localhost");
-    auto bind_port = this->get_parameter_or<uint16_t>("bind_port", 14520);
-    auto remote_host = this->get_parameter_or<std::string>("remote_host", bind_host);
-    auto remote_port = this->get_parameter_or<uint16_t>("remote_port", 14525);
+  // Changes queued while inactive are covered by a snapshot
+  {
+    std::lock_guard<std::mutex> lock(param_events_mutex_);
+    param_events_.clear();
+  }
+  publish_param_snapshot();
+  param_events_subscribers_ = param_events_pub_->get_subscription_count();
+  double param_events_window =
+    std::max(this->get_parameter_or<double>("param_events_window", 0.05), 0.001);
+  param_events_timer_ = this->create_wall_timer(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(param_events_window)),
+    std::bind(&ROSflightIO::paramEventsTimerCallback, this), nullptr);
+
+  double report_period = this->get_parameter_or<double>("loop_time_report_period", 1.0);
+  if (report_period > 0.0) {
+    loop_time_timer_ = this->create_wall_timer(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(report_period)),
+      std::bind(&ROSflightIO::loopTimeTimerCallback, this), nullptr);
+  }
 
-    RCLCPP_INFO(this->get_logger(), "Connecting over UDP to \"%s:%d\", from \"%s:%d\"",
-                remote_host.c_str(), remote_port, bind_host.c_str(), bind_port);
+  RCLCPP_INFO(this->get_logger(), "Activated");
+  return CallbackReturn::SUCCESS;
+}
 
-    mavlink_comm_ = new mavrosflight::MavlinkUDP(bind_host, bind_port, remote_host, remote_port);
-  } else {
-    auto port = this->get_parameter_or<std::string>("port", "/dev/ttyACM0");
-    int baud_rate = this->get_parameter_or<int>("baud_rate", 921600);
+ROSflightIO::CallbackReturn ROSflightIO::on_deactivate(const rclcpp_lifecycle::State & state)
+{
+  active_ = false;
+  if (provision_step_ != PROVISION_IDLE) {
+    finish_provision(false, "rosflight_io was deactivated");
+  }
+  LifecycleNode::on_deactivate(state);
+
+  command_sub_.reset();
+  aux_command_sub_.reset();
+  extatt_sub_.reset();
+  command_scheduler_.reset();
+
+  param_get_srv_.reset();
+  param_set_srv_.reset();
+  param_write_srv_.reset();
+  param_save_to_file_srv_.reset();
+  param_load_from_file_srv_.reset();
+  imu_calibrate_bias_srv_.reset();
+  calibrate_rc_srv_.reset();
+  calibrate_baro_srv_.reset();
+  calibrate_airspeed_srv_.reset();
+  reboot_srv_.reset();
+  reboot_bootloader_srv_.reset();
+  provision_srv_.reset();
+  attitude_at_time_srv_.reset();
+  reset_loop_time_monitor_srv_.reset();
+  param_snapshot_srv_.reset();
+
+  loop_time_timer_.reset();
+  param_events_timer_.reset();
+  provision_timer_.reset();
+
+  if (link_failed_) {
+    return CallbackReturn::ERROR;
+  }
+  RCLCPP_INFO(this->get_logger(), "Deactivated, standing by");
+  return CallbackReturn::SUCCESS;
+}
 
-    RCLCPP_INFO(this->get_logger(), "Connecting to serial port \"%s\", at %d baud", port.c_str(),
-                baud_rate);
+ROSflightIO::CallbackReturn ROSflightIO::on_cleanup(const rclcpp_lifecycle::State & state)
+{
+  close_link();
+  return link_failed_ ? CallbackReturn::ERROR : CallbackReturn::SUCCESS;
+}
 
-    mavlink_comm_ = new mavrosflight::MavlinkSerial(port, baud_rate);
+ROSflightIO::CallbackReturn ROSflightIO::on_error(const rclcpp_lifecycle::State & state)
+{
+  RCLCPP_ERROR(this->get_logger(), "Error while %s, closing the link", state.label().c_str());
+  if (active_) {
+    on_deactivate(state);
   }
-
-  try {
-    mavrosflight_ = new mavrosflight::MavROSflight(*mavlink_comm_, this);
-  } catch (const mavrosflight::SerialException & e) {
-    RCLCPP_FATAL(this->get_logger(), "%s", e.what());
-    rclcpp::shutdown();
+  if (mavrosflight_ != nullptr) {
+    close_link();
   }
+  link_failed_ = false;
+  return CallbackReturn::SUCCESS;
+}
 
-  mavrosflight_->comm.register_mavlink_listener(this);
-  mavrosflight_->param.register_param_listener(this);
+ROSflightIO::CallbackReturn ROSflightIO::on_shutdown(const rclcpp_lifecycle::State & state)
+{
+  if (active_) {
+    on_deactivate(state);
+  }
+  if (mavrosflight_ != nullptr) {
+    close_link();
+  }
+  return CallbackReturn::SUCCESS;
+}
 
-  // request the param list
-  mavrosflight_->param.request_params();
-  param_timer_ =
-    this->create_wall_timer(std::chrono::seconds(PARAMETER_PERIOD),
-                            std::bind(&ROSflightIO::paramTimerCallback, this), nullptr);
+void ROSflightIO::create_publishers()
+{
+  rclcpp::QoS qos_transient_local_1_(1);
+  qos_transient_local_1_.transient_local();
+  rclcpp::QoS qos_transient_local_5_(5); // A relatively large queue so all messages get through
+  qos_transient_local_5_.transient_local();
 
-  // request version information
-  request_version();
-  version_timer_ =
-    this->create_wall_timer(std::chrono::seconds(VERSION_PERIOD),
-                            std::bind(&ROSflightIO::versionTimerCallback, this), nullptr);
+  unsaved_params_pub_ =
+    this->create_publisher<std_msgs::msg::Bool>("unsaved_params", qos_transient_local_1_);
+  param_events_pub_ = this->create_publisher<rosflight_msgs::msg::ParamEvents>(
+    "param_events", qos_transient_local_1_);
+  error_pub_ =
+    this->create_publisher<rosflight_msgs::msg::Error>("rosflight_errors", qos_transient_local_5_);
+  connection_status_pub_ =
+    this->create_publisher<rosflight_msgs::msg::ConnectionStatus>("ready", qos_transient_local_1_);
+  version_pub_ = this->create_publisher<std_msgs::msg::String>("version", qos_transient_local_1_);
+  loop_time_overrun_pub_ =
+    this->create_publisher<std_msgs::msg::Bool>("loop_time_overrun", qos_transient_local_1_);
+  diagnostics_pub_ =
+    this->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("diagnostics", 1);
+
+  status_pub_ = this->create_publisher<rosflight_msgs::msg::Status>("status", 1);
+  attitude_pub_ = this->create_publisher<rosflight_msgs::msg::Attitude>("attitude", 1);
+  euler_pub_ = this->create_publisher<geometry_msgs::msg::Vector3Stamped>("attitude/euler", 1);
+  imu_pub_ = this->create_publisher<sensor_msgs::msg::Imu>("imu/data", 1);
+  imu_temp_pub_ = this->create_publisher<sensor_msgs::msg::Temperature>("imu/temperature", 1);
+  output_raw_pub_ = this->create_publisher<rosflight_msgs::msg::OutputRaw>("output_raw", 1);
+  rc_raw_pub_ = this->create_publisher<rosflight_msgs::msg::RCRaw>("rc_raw", 1);
+  diff_pressure_pub_ = this->create_publisher<rosflight_msgs::msg::Airspeed>("airspeed", 1);
+  baro_pub_ = this->create_publisher<rosflight_msgs::msg::Barometer>("baro", 1);
+  mag_pub_ = this->create_publisher<sensor_msgs::msg::MagneticField>("magnetometer", 1);
+  sonar_pub_ = this->create_publisher<sensor_msgs::msg::Range>("sonar", 1);
+  lidar_pub_ = this->create_publisher<sensor_msgs::msg::Range>("lidar", 1);
+  battery_status_pub_ = this->create_publisher<rosflight_msgs::msg::BatteryStatus>("battery", 1);
+  gnss_pub_ = this->create_publisher<rosflight_msgs::msg::GNSS>("gnss", 1);
+  gnss_full_pub_ = this->create_publisher<rosflight_msgs::msg::GNSSFull>("gnss_full", 1);
+  nav_sat_fix_pub_ = this->create_publisher<sensor_msgs::msg::NavSatFix>("navsat_compat/fix", 1);
+  twist_stamped_pub_ =
+    this->create_publisher<geometry_msgs::msg::TwistStamped>("navsat_compat/vel", 1);
+  time_reference_pub_ =
+    this->create_publisher<sensor_msgs::msg::TimeReference>("navsat_compat/time_reference", 1);
+
+  if (publish_sensor_bundle_) {
+    sensor_bundle_pub_ =
+      this->create_publisher<rosflight_msgs::msg::SensorBundle>("sensor_bundle", 1);
+  }
+  if (publish_bounded_msgs_) {
+    status_bounded_pub_ =
+      this->create_publisher<rosflight_msgs::msg::StatusBounded>("status/bounded", 1);
+    attitude_bounded_pub_ =
+      this->create_publisher<rosflight_msgs::msg::AttitudeBounded>("attitude/bounded", 1);
+    output_raw_bounded_pub_ =
+      this->create_publisher<rosflight_msgs::msg::OutputRawBounded>("output_raw/bounded", 1);
+    rc_raw_bounded_pub_ =
+      this->create_publisher<rosflight_msgs::msg::RCRawBounded>("rc_raw/bounded", 1);
+    airspeed_bounded_pub_ =
+      this->create_publisher<rosflight_msgs::msg::AirspeedBounded>("airspeed/bounded", 1);
+    baro_bounded_pub_ =
+      this->create_publisher<rosflight_msgs::msg::BarometerBounded>("baro/bounded", 1);
+    gnss_bounded_pub_ =
+      this->create_publisher<rosflight_msgs::msg::GNSSBounded>("gnss/bounded", 1);
+  }
+}
 
-  // initialize latched "unsaved parameters" message value
-  std_msgs::msg::Bool unsaved_msg;
-  unsaved_msg.data = false;
-  unsaved_params_pub_->publish(unsaved_msg);
+bool ROSflightIO::discover_port(std::string & port, int & baud_rate)
+{
+  auto directory = this->get_parameter_or<std::string>("discovery_directory", "/dev/serial/by-id");
+  double window = this->get_parameter_or<double>("discovery_window", 0.3);
+
+  // The configured baud rate goes first
+  std::vector<int> baud_rates = {baud_rate};
+  for (int64_t rate : this->get_parameter_or<std::vector<int64_t>>(
+         "discovery_baud_rates", {921600, 460800, 230400, 115200, 57600})) {
+    if (std::find(baud_rates.begin(), baud_rates.end(), (int) rate) == baud_rates.end()) {
+      baud_rates.push_back((int) rate);
+    }
+  }
 
-  // Set up a few other random things
-  frame_id_ = this->get_parameter_or<std::string>("frame_id", "world");
+  std::vector<std::string> ports = mavrosflight::SerialDiscovery::list_ports(directory);
+  if (ports.empty()) {
+    RCLCPP_ERROR(this->get_logger(), "No serial ports to probe in %s", directory.c_str());
+    return false;
+  }
+  RCLCPP_INFO(this->get_logger(), "Probing %zu serial ports in %s at %zu baud rates",
+              ports.size(), directory.c_str(), baud_rates.size());
 
-  prev_status_.armed = false;
-  prev_status_.failsafe = false;
-  prev_status_.rc_override = false;
-  prev_status_.offboard = false;
-  prev_status_.control_mode = OFFBOARD_CONTROL_MODE_ENUM_END;
-  prev_status_.error_code = ROSFLIGHT_ERROR_NONE;
+  mavrosflight::SerialDiscovery::Result result = mavrosflight::SerialDiscovery::discover(
+    ports, baud_rates, std::chrono::milliseconds((int64_t) (window * 1000)));
+  if (!result.found) {
+    RCLCPP_ERROR(this->get_logger(),
+                 "No ROSflight firmware answered on %zu serial ports after %.3f s", ports.size(),
+                 std::chrono::duration<double>(result.elapsed).count());
+    return false;
+  }
 
-  // Start the heartbeat
-  heartbeat_timer_ =
-    this->create_wall_timer(std::chrono::seconds(HEARTBEAT_PERIOD),
-                            std::bind(&ROSflightIO::heartbeatTimerCallback, this), nullptr);
+  RCLCPP_INFO(this->get_logger(),
+              "Found ROSflight firmware %s(system ID %d) on \"%s\" (%s) at %d baud, after %.3f s",
+              result.version.empty() ? "" : (result.version + " ").c_str(), result.system_id,
+              result.port.c_str(), result.device.c_str(), result.baud_rate,
+              std::chrono::duration<double>(result.elapsed).count());
+  port = result.port;
+  baud_rate = result.baud_rate;
+
+  // So the port that was found shows up in the parameters
+  this->set_parameter(rclcpp::Parameter("port", port));
+  this->set_parameter(rclcpp::Parameter("baud_rate", baud_rate));
+  return true;
 }
 
-ROSflightIO::~ROSflightIO()
+void ROSflightIO::close_link()
 {
+  handshake_timer_.reset();
+  heartbeat_timer_.reset();
+  command_scheduler_.reset();
+
+  if (mavrosflight_ != nullptr) {
+    // An external link outlives this node
+    mavrosflight_->comm.unsubscribe(this);
+    mavrosflight_->comm.unregister_mavlink_listener(&recorder_);
+  }
   delete mavrosflight_;
-  delete mavlink_comm_;
+  mavrosflight_ = nullptr;
+  // Nothing queues log lines anymore, so print what is left
+  log_timer_.reset();
+  logTimerCallback();
+  if (recorder_.is_open()) {
+    // The link is closed, so nothing else is feeding the recorder
+    recorder_.close();
+    RCLCPP_INFO(this->get_logger(), "Recorded %lu messages (%lu dropped) to %s",
+                (unsigned long) recorder_.rows_recorded(), (unsigned long) recorder_.rows_dropped(),
+                recorder_.directory().c_str());
+  }
+  if (owns_mavlink_comm_) {
+    delete mavlink_comm_;
+    mavlink_comm_ = nullptr;
+  }
+
+  // The next link may be to another flight controller
+  {
+    std::lock_guard<std::mutex> lock(param_events_mutex_);
+    param_mirror_.clear();
+    param_events_.clear();
+  }
+
+  // Publishers of a node that is configured again must not keep the old settings
+  unsaved_params_pub_.reset();
+  param_events_pub_.reset();
+  error_pub_.reset();
+  connection_status_pub_.reset();
+  version_pub_.reset();
+  loop_time_overrun_pub_.reset();
+  diagnostics_pub_.reset();
+  status_pub_.reset();
+  attitude_pub_.reset();
+  euler_pub_.reset();
+  imu_pub_.reset();
+  imu_temp_pub_.reset();
+  output_raw_pub_.reset();
+  rc_raw_pub_.reset();
+  diff_pressure_pub_.reset();
+  baro_pub_.reset();
+  mag_pub_.reset();
+  sonar_pub_.reset();
+  lidar_pub_.reset();
+  battery_status_pub_.reset();
+  gnss_pub_.reset();
+  gnss_full_pub_.reset();
+  nav_sat_fix_pub_.reset();
+  twist_stamped_pub_.reset();
+  time_reference_pub_.reset();
+  sensor_bundle_pub_.reset();
+  status_bounded_pub_.reset();
+  attitude_bounded_pub_.reset();
+  output_raw_bounded_pub_.reset();
+  rc_raw_bounded_pub_.reset();
+  airspeed_bounded_pub_.reset();
+  baro_bounded_pub_.reset();
+  gnss_bounded_pub_.reset();
+  named_value_int_pubs_.clear();
+  named_value_float_pubs_.clear();
+  named_command_struct_pubs_.clear();
 }
 
-void ROSflightIO::handle_mavlink_message(const mavlink_message_t & msg)
+void ROSflightIO::subscribe_handlers(mavrosflight::MavlinkComm & comm)
 {
-  switch (msg.msgid) {
-    case MAVLINK_MSG_ID_HEARTBEAT:
-      handle_heartbeat_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_ROSFLIGHT_STATUS:
-      handle_status_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_ROSFLIGHT_CMD_ACK:
-      handle_command_ack_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_STATUSTEXT:
-      handle_statustext_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_ATTITUDE_QUATERNION:
-      handle_attitude_quaternion_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_SMALL_IMU:
-      handle_small_imu_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_SMALL_MAG:
-      handle_small_mag_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_ROSFLIGHT_OUTPUT_RAW:
-      handle_rosflight_output_raw_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_RC_CHANNELS:
-      handle_rc_channels_raw_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_DIFF_PRESSURE:
-      handle_diff_pressure_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_NAMED_VALUE_INT:
-      handle_named_value_int_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_NAMED_VALUE_FLOAT:
-      handle_named_value_float_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_NAMED_COMMAND_STRUCT:
-      handle_named_command_struct_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_SMALL_BARO:
-      handle_small_baro_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_SMALL_RANGE:
-      handle_small_range_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_ROSFLIGHT_GNSS:
-      handle_rosflight_gnss_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_ROSFLIGHT_GNSS_FULL:
-      handle_rosflight_gnss_full_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_ROSFLIGHT_VERSION:
-      handle_version_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_PARAM_VALUE:
-    case MAVLINK_MSG_ID_TIMESYNC:
-      // silently ignore (handled elsewhere)
-      break;
-    case MAVLINK_MSG_ID_ROSFLIGHT_HARD_ERROR:
-      handle_hard_error_msg(msg);
-      break;
-    case MAVLINK_MSG_ID_ROSFLIGHT_BATTERY_STATUS:
-      handle_battery_status_msg(msg);
-      break;
-    default:
-      RCLCPP_DEBUG(this->get_logger(), "rosflight_io: Got unhandled mavlink message ID %d",
-                   msg.msgid);
-      break;
+  // A standby only follows the handshake
+  comm.subscribe<&ROSflightIO::handle_heartbeat_msg>(this);
+  comm.subscribe<&ROSflightIO::handle_version_msg>(this);
+
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_status_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_command_ack_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_statustext_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_attitude_quaternion_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_small_imu_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_small_mag_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_rosflight_output_raw_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_rc_channels_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_diff_pressure_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_named_value_int_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_named_value_float_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_named_command_struct_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_small_baro_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_small_range_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_rosflight_gnss_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_rosflight_gnss_full_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_hard_error_msg>>(this);
+  comm.subscribe<&ROSflightIO::when_active<&ROSflightIO::handle_battery_status_msg>>(this);
+
+  // The param and time managers subscribed first, so they are up to date by the time these run
+  comm.subscribe<&ROSflightIO::follow_handshake<mavlink_heartbeat_t>>(this);
+  comm.subscribe<&ROSflightIO::follow_handshake<mavlink_rosflight_version_t>>(this);
+  comm.subscribe<&ROSflightIO::follow_handshake<mavlink_param_value_t>>(this);
+  comm.subscribe<&ROSflightIO::follow_handshake<mavlink_timesync_t>>(this);
+}
+
+template<auto Handler>
+void ROSflightIO::when_active(
+  const typename mavrosflight::MessageHandlerTraits<decltype(Handler)>::Message & msg)
+{
+  if (active_) {
+    mavrosflight::HotPath hot_path("rosflight_io.handler");
+    (this->*Handler)(msg);
+  }
+}
+
+template<class T>
+void ROSflightIO::follow_handshake(const T &)
+{
+  if (connection_state_ == CONNECTING) {
+    check_connection_ready();
   }
 }
 
 void ROSflightIO::on_new_param_received(std::string name, double value)
 {
-  RCLCPP_DEBUG(this->get_logger(), "Got parameter %s with value %g", name.c_str(), value);
+  log_queue_.push(LogQueue::SEVERITY_DEBUG, "Got parameter %s with value %g", name.c_str(), value);
+  queue_param_event(name, value);
 }
 
 void ROSflightIO::on_param_value_updated(std::string name, double value)
 {
-  RCLCPP_INFO(this->get_logger(), "Parameter %s has new value %g", name.c_str(), value);
+  log_queue_.push(LogQueue::SEVERITY_INFO, "Parameter %s has new value %g", name.c_str(), value);
+  queue_param_event(name, value);
+
+  // The firmware zeroes the accelerometer biases when an IMU calibration starts, and sets them to
+  // the result when it finishes
+  if (provision_awaited_command_ == ROSFLIGHT_CMD_ACCEL_CALIBRATION && value != 0.0) {
+    static const char * const bias_names[3] = {"ACC_X_BIAS", "ACC_Y_BIAS", "ACC_Z_BIAS"};
+    for (int axis = 0; axis < 3; axis++) {
+      if (name == bias_names[axis]) {
+        provision_biases_captured_ |= 1 << axis;
+      }
+    }
+  }
+}
+
+void ROSflightIO::queue_param_event(const std::string & name, double value)
+{
+  std::lock_guard<std::mutex> lock(param_events_mutex_);
+  auto it = param_mirror_.find(name);
+  if (it == param_mirror_.end()) {
+    // Called by the param manager on the io thread, so its parameters can be read here
+    mavrosflight::Param param;
+    mavrosflight_->param.get_param(name, &param);
+
+    rosflight_msgs::msg::ParamEvent event;
+    event.name = name;
+    event.index = param.getIndex();
+    event.type = param.getType();
+    event.old_value = std::numeric_limits<double>::quiet_NaN();
+    event.new_value = value;
+    it = param_mirror_.emplace(name, event).first;
+  } else {
+    it->second.old_value = it->second.new_value;
+    it->second.new_value = value;
+  }
+
+  // Several changes to a parameter within a window are published as one
+  for (rosflight_msgs::msg::ParamEvent & event : param_events_) {
+    if (event.name == name) {
+      event.new_value = value;
+      return;
+    }
+  }
+  param_events_.push_back(it->second);
+}
+
+void ROSflightIO::publish_param_snapshot()
+{
+  rosflight_msgs::msg::ParamEvents msg;
+  msg.header.stamp = this->get_clock()->now();
+  msg.snapshot = true;
+  {
+    std::lock_guard<std::mutex> lock(param_events_mutex_);
+    msg.events.reserve(param_mirror_.size());
+    for (const auto & entry : param_mirror_) {
+      msg.events.push_back(entry.second);
+      msg.events.back().old_value = entry.second.new_value;
+    }
+  }
+  param_events_pub_->publish(msg);
+}
+
+void ROSflightIO::paramEventsTimerCallback()
+{
+  rosflight_msgs::msg::ParamEvents msg;
+  {
+    std::lock_guard<std::mutex> lock(param_events_mutex_);
+    msg.events.swap(param_events_);
+  }
+  if (!msg.events.empty()) {
+    msg.header.stamp = this->get_clock()->now();
+    msg.snapshot = false;
+    param_events_pub_->publish(msg);
+  }
+
+  // Durability only replays the last message, so bring new subscribers fully up to date
+  size_t subscribers = param_events_pub_->get_subscription_count();
+  if (subscribers > param_events_subscribers_) {
+    publish_param_snapshot();
+  }
+  param_events_subscribers_ = subscribers;
+}
+
+bool ROSflightIO::paramSnapshotSrvCallback(const std_srvs::srv::Trigger::Request::SharedPtr & req,
+                                           const std_srvs::srv::Trigger::Response::SharedPtr & res)
+{
+  publish_param_snapshot();
+  res->success = true;
+  return true;
 }
 
 void ROSflightIO::on_params_saved_change(bool unsaved_changes)
 {
-  std_msgs::msg::Bool msg;
-  msg.data = unsaved_changes;
-  unsaved_params_pub_->publish(msg);
+  if (active_) {
+    std_msgs::msg::Bool msg;
+    msg.data = unsaved_changes;
+    unsaved_params_pub_->publish(msg);
+  }
 
   if (unsaved_changes) {
-    RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 1,
-                         "There are unsaved changes to onboard parameters");
+    log_queue_.push(LogQueue::SEVERITY_WARN, "There are unsaved changes to onboard parameters");
   } else {
-    RCLCPP_INFO(this->get_logger(), "Onboard parameters have been saved");
+    log_queue_.push(LogQueue::SEVERITY_INFO, "Onboard parameters have been saved");
   }
 }
 
-void ROSflightIO::handle_heartbeat_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_heartbeat_msg(const mavlink_heartbeat_t & heartbeat)
 {
-  RCLCPP_INFO_ONCE(this->get_logger(), "Got HEARTBEAT, connected.");
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_HEARTBEAT);
+
+  last_heartbeat_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count();
+
+  ConnectionState expected = WAITING_FOR_HEARTBEAT;
+  if (connection_state_.compare_exchange_strong(expected, CONNECTING)) {
+    log_queue_.push(LogQueue::SEVERITY_INFO, "Got HEARTBEAT, connecting.");
+    start_handshake();
+  }
 }
 
-void ROSflightIO::handle_status_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_status_msg(const mavlink_rosflight_status_t & status_msg)
 {
-  mavlink_rosflight_status_t status_msg;
-  mavlink_msg_rosflight_status_decode(&msg, &status_msg);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_ROSFLIGHT_STATUS);
 
   // armed state check
   if (prev_status_.armed != status_msg.armed) {
     if (status_msg.armed)
-      RCLCPP_WARN(this->get_logger(), "Autopilot ARMED");
+      log_queue_.push(LogQueue::SEVERITY_WARN, "Autopilot ARMED");
     else
-      RCLCPP_WARN(this->get_logger(), "Autopilot DISARMED");
+      log_queue_.push(LogQueue::SEVERITY_WARN, "Autopilot DISARMED");
   }
 
   // failsafe check
   if (prev_status_.failsafe != status_msg.failsafe) {
     if (status_msg.failsafe)
-      RCLCPP_ERROR(this->get_logger(), "Autopilot FAILSAFE");
+      log_queue_.push(LogQueue::SEVERITY_ERROR, "Autopilot FAILSAFE");
     else
-      RCLCPP_INFO(this->get_logger(), "Autopilot FAILSAFE RECOVERED");
+      log_queue_.push(LogQueue::SEVERITY_INFO, "Autopilot FAILSAFE RECOVERED");
   }
 
   // rc override check
   if (prev_status_.rc_override != status_msg.rc_override) {
     if (status_msg.rc_override)
-      RCLCPP_WARN(this->get_logger(), "RC override active");
+      log_queue_.push(LogQueue::SEVERITY_WARN, "RC override active");
     else
-      RCLCPP_WARN(this->get_logger(), "Returned to computer control");
+      log_queue_.push(LogQueue::SEVERITY_WARN, "Returned to computer control");
   }
 
   // offboard control check
   if (prev_status_.offboard != status_msg.offboard) {
     if (status_msg.offboard)
-      RCLCPP_WARN(this->get_logger(), "Computer control active");
+      log_queue_.push(LogQueue::SEVERITY_WARN, "Computer control active");
     else
-      RCLCPP_WARN(this->get_logger(), "Computer control lost");
+      log_queue_.push(LogQueue::SEVERITY_WARN, "Computer control lost");
   }
 
   // Print if got error code
@@ -349,12 +974,12 @@ void ROSflightIO::handle_status_msg(const mavlink_message_t & msg)
     check_error_code(status_msg.error_code, prev_status_.error_code, ROSFLIGHT_ERROR_BUFFER_OVERRUN,
                      "Buffer Overrun");
 
-    RCLCPP_DEBUG(this->get_logger(), "Autopilot ERROR 0x%02x", status_msg.error_code);
+    log_queue_.push(LogQueue::SEVERITY_DEBUG, "Autopilot ERROR 0x%02x", status_msg.error_code);
   }
 
   // Print if change in control mode
   if (prev_status_.control_mode != status_msg.control_mode) {
-    std::string mode_string;
+    const char * mode_string;
     switch (status_msg.control_mode) {
       case MODE_PASS_THROUGH:
         mode_string = "PASS_THROUGH";
@@ -368,10 +993,25 @@ void ROSflightIO::handle_status_msg(const mavlink_message_t & msg)
       default:
         mode_string = "UNKNOWN";
     }
-    RCLCPP_WARN_STREAM(this->get_logger(), "Autopilot now in " << mode_string << " mode");
+    log_queue_.push(LogQueue::SEVERITY_WARN, "Autopilot now in %s mode", mode_string);
   }
 
   prev_status_ = status_msg;
+  status_error_code_ = status_msg.error_code;
+
+  // The firmware sends the loop time as a signed 16 bit field, so longer loops wrap negative
+  int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now().time_since_epoch())
+                     .count();
+  uint16_t loop_time_us = (uint16_t) status_msg.loop_time_us;
+  if (loop_time_monitor_.add(now_ns, loop_time_us, status_msg.num_errors)
+      && !loop_time_overrun_.exchange(true)) {
+    log_queue_.push(LogQueue::SEVERITY_WARN, "Firmware loop time of %u us is over budget",
+                    loop_time_us);
+    std_msgs::msg::Bool overrun_msg;
+    overrun_msg.data = true;
+    loop_time_overrun_pub_->publish(overrun_msg);
+  }
 
   // Build the status message and send it
   rosflight_msgs::msg::Status out_status;
@@ -384,28 +1024,32 @@ void ROSflightIO::handle_status_msg(const mavlink_message_t & msg)
   out_status.error_code = status_msg.error_code;
   out_status.num_errors = status_msg.num_errors;
   out_status.loop_time_us = status_msg.loop_time_us;
-  if (status_pub_ == nullptr) {
-    status_pub_ = this->create_publisher<rosflight_msgs::msg::Status>("status", 1);
-  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_ROSFLIGHT_STATUS,
+                          status_pub_->get_topic_name());
   status_pub_->publish(out_status);
+  if (publish_bounded_msgs_) {
+    publish_bounded(*status_bounded_pub_, status_bounded_msg_, out_status);
+  }
 }
 
-void ROSflightIO::handle_command_ack_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_command_ack_msg(const mavlink_rosflight_cmd_ack_t & ack)
 {
-  mavlink_rosflight_cmd_ack_t ack;
-  mavlink_msg_rosflight_cmd_ack_decode(&msg, &ack);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_ROSFLIGHT_CMD_ACK);
 
   if (ack.success == ROSFLIGHT_CMD_SUCCESS) {
-    RCLCPP_DEBUG(this->get_logger(), "MAVLink command %d Acknowledged", ack.command);
+    log_queue_.push(LogQueue::SEVERITY_DEBUG, "MAVLink command %d Acknowledged", ack.command);
   } else {
-    RCLCPP_ERROR(this->get_logger(), "MAVLink command %d Failed", ack.command);
+    log_queue_.push(LogQueue::SEVERITY_ERROR, "MAVLink command %d Failed", ack.command);
+  }
+
+  if (ack.command == provision_awaited_command_) {
+    provision_ack_result_ = ack.success == ROSFLIGHT_CMD_SUCCESS ? 1 : 0;
   }
 }
 
-void ROSflightIO::handle_statustext_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_statustext_msg(const mavlink_statustext_t & status)
 {
-  mavlink_statustext_t status;
-  mavlink_msg_statustext_decode(&msg, &status);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_STATUSTEXT);
 
   // ensure null termination
   char c_str[MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN + 1];
@@ -413,31 +1057,30 @@ void ROSflightIO::handle_statustext_msg(const mavlink_message_t & msg)
   c_str[MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN] = '\0';
 
   // Switch statement without break will execute sequentially until the next break, meaning MAV severity
-  //  EMERGENCY, ALERT, CRITICAL, and ERROR will call the RCLCPP_ERROR line
+  //  EMERGENCY, ALERT, CRITICAL, and ERROR will queue an error line
   switch (status.severity) {
     case MAV_SEVERITY_EMERGENCY:
     case MAV_SEVERITY_ALERT:
     case MAV_SEVERITY_CRITICAL:
     case MAV_SEVERITY_ERROR:
-      RCLCPP_ERROR(this->get_logger(), "[Autopilot]: %s", c_str);
+      log_queue_.push(LogQueue::SEVERITY_ERROR, "[Autopilot]: %s", c_str);
       break;
     case MAV_SEVERITY_WARNING:
-      RCLCPP_WARN(this->get_logger(), "[Autopilot]: %s", c_str);
+      log_queue_.push(LogQueue::SEVERITY_WARN, "[Autopilot]: %s", c_str);
       break;
     case MAV_SEVERITY_NOTICE:
     case MAV_SEVERITY_INFO:
-      RCLCPP_INFO(this->get_logger(), "[Autopilot]: %s", c_str);
+      log_queue_.push(LogQueue::SEVERITY_INFO, "[Autopilot]: %s", c_str);
       break;
     case MAV_SEVERITY_DEBUG:
-      RCLCPP_DEBUG(this->get_logger(), "[Autopilot]: %s", c_str);
+      log_queue_.push(LogQueue::SEVERITY_DEBUG, "[Autopilot]: %s", c_str);
       break;
   }
 }
 
-void ROSflightIO::handle_attitude_quaternion_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_attitude_quaternion_msg(const mavlink_attitude_quaternion_t & attitude)
 {
-  mavlink_attitude_quaternion_t attitude;
-  mavlink_msg_attitude_quaternion_decode(&msg, &attitude);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_ATTITUDE_QUATERNION);
 
   rosflight_msgs::msg::Attitude attitude_msg;
 
@@ -457,23 +1100,28 @@ void ROSflightIO::handle_attitude_quaternion_msg(const mavlink_message_t & msg)
   tf2::Quaternion quat(attitude.q2, attitude.q3, attitude.q4, attitude.q1);
   tf2::Matrix3x3(quat).getEulerYPR(euler_msg.vector.z, euler_msg.vector.y, euler_msg.vector.x);
 
-  // save off the quaternion for use with the IMU callback
-  attitude_quat_ = tf2::toMsg(quat);
+  // save the attitude for stamping IMU messages and for attitude_at
+  rosflight_io::AttitudeHistory::Sample sample;
+  sample.stamp_ns = rclcpp::Time(attitude_msg.header.stamp).nanoseconds();
+  sample.attitude = Eigen::Quaterniond(attitude.q1, attitude.q2, attitude.q3, attitude.q4);
+  sample.angular_velocity = Eigen::Vector3d(attitude.rollspeed, attitude.pitchspeed,
+                                            attitude.yawspeed);
+  attitude_history_.add(sample);
 
-  if (attitude_pub_ == nullptr) {
-    attitude_pub_ = this->create_publisher<rosflight_msgs::msg::Attitude>("attitude", 1);
-  }
-  if (euler_pub_ == nullptr) {
-    euler_pub_ = this->create_publisher<geometry_msgs::msg::Vector3Stamped>("attitude/euler", 1);
-  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_ATTITUDE_QUATERNION,
+                          attitude_pub_->get_topic_name());
   attitude_pub_->publish(attitude_msg);
+  if (publish_bounded_msgs_) {
+    publish_bounded(*attitude_bounded_pub_, attitude_bounded_msg_, attitude_msg);
+  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_ATTITUDE_QUATERNION,
+                          euler_pub_->get_topic_name());
   euler_pub_->publish(euler_msg);
 }
 
-void ROSflightIO::handle_small_imu_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_small_imu_msg(const mavlink_small_imu_t & imu)
 {
-  mavlink_small_imu_t imu;
-  mavlink_msg_small_imu_decode(&msg, &imu);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_SMALL_IMU);
 
   sensor_msgs::msg::Imu imu_msg;
   imu_msg.header.stamp = fcu_time_to_ros_time(std::chrono::microseconds(imu.time_boot_us));
@@ -484,28 +1132,41 @@ void ROSflightIO::handle_small_imu_msg(const mavlink_message_t & msg)
   imu_msg.angular_velocity.x = imu.xgyro;
   imu_msg.angular_velocity.y = imu.ygyro;
   imu_msg.angular_velocity.z = imu.zgyro;
-  imu_msg.orientation = attitude_quat_;
+
+  // Attitude at the time of the IMU sample. Outside the history, fall back to the nearest estimate.
+  rosflight_io::AttitudeHistory::Sample attitude;
+  bool have_attitude = attitude_history_.lookup(rclcpp::Time(imu_msg.header.stamp).nanoseconds(),
+                                                attitude_max_extrapolation_ns_, attitude)
+    != rosflight_io::AttitudeHistory::EMPTY;
+  if (have_attitude) {
+    imu_msg.orientation.w = attitude.attitude.w();
+    imu_msg.orientation.x = attitude.attitude.x();
+    imu_msg.orientation.y = attitude.attitude.y();
+    imu_msg.orientation.z = attitude.attitude.z();
+  }
 
   sensor_msgs::msg::Temperature temp_msg;
   temp_msg.header.stamp = imu_msg.header.stamp;
   temp_msg.header.frame_id = frame_id_;
   temp_msg.temperature = imu.temperature;
 
-  if (imu_pub_ == nullptr) {
-    imu_pub_ = this->create_publisher<sensor_msgs::msg::Imu>("imu/data", 1);
-  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_SMALL_IMU,
+                          imu_pub_->get_topic_name());
   imu_pub_->publish(imu_msg);
 
-  if (imu_temp_pub_ == nullptr) {
-    imu_temp_pub_ = this->create_publisher<sensor_msgs::msg::Temperature>("imu/temperature", 1);
-  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_SMALL_IMU,
+                          imu_temp_pub_->get_topic_name());
   imu_temp_pub_->publish(temp_msg);
+
+  if (publish_sensor_bundle_) {
+    publish_sensor_bundle(imu_msg, imu.temperature, have_attitude ? &attitude : nullptr,
+                          this->get_clock()->now());
+  }
 }
 
-void ROSflightIO::handle_rosflight_output_raw_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_rosflight_output_raw_msg(const mavlink_rosflight_output_raw_t & servo)
 {
-  mavlink_rosflight_output_raw_t servo;
-  mavlink_msg_rosflight_output_raw_decode(&msg, &servo);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_ROSFLIGHT_OUTPUT_RAW);
 
   rosflight_msgs::msg::OutputRaw out_msg;
   out_msg.header.stamp = fcu_time_to_ros_time(std::chrono::microseconds(servo.stamp));
@@ -513,16 +1174,17 @@ void ROSflightIO::handle_rosflight_output_raw_msg(const mavlink_message_t & msg)
     out_msg.values[i] = servo.values[i];
   }
 
-  if (output_raw_pub_ == nullptr) {
-    output_raw_pub_ = this->create_publisher<rosflight_msgs::msg::OutputRaw>("output_raw", 1);
-  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_ROSFLIGHT_OUTPUT_RAW,
+                          output_raw_pub_->get_topic_name());
   output_raw_pub_->publish(out_msg);
+  if (publish_bounded_msgs_) {
+    publish_bounded(*output_raw_bounded_pub_, output_raw_bounded_msg_, out_msg);
+  }
 }
 
-void ROSflightIO::handle_rc_channels_raw_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_rc_channels_msg(const mavlink_rc_channels_t & rc)
 {
-  mavlink_rc_channels_raw_t rc;
-  mavlink_msg_rc_channels_raw_decode(&msg, &rc);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_RC_CHANNELS);
 
   rosflight_msgs::msg::RCRaw out_msg;
   out_msg.header.stamp = fcu_time_to_ros_time(std::chrono::milliseconds(rc.time_boot_ms));
@@ -536,16 +1198,17 @@ void ROSflightIO::handle_rc_channels_raw_msg(const mavlink_message_t & msg)
   out_msg.values[6] = rc.chan7_raw;
   out_msg.values[7] = rc.chan8_raw;
 
-  if (rc_raw_pub_ == nullptr) {
-    rc_raw_pub_ = this->create_publisher<rosflight_msgs::msg::RCRaw>("rc_raw", 1);
-  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_RC_CHANNELS,
+                          rc_raw_pub_->get_topic_name());
   rc_raw_pub_->publish(out_msg);
+  if (publish_bounded_msgs_) {
+    publish_bounded(*rc_raw_bounded_pub_, rc_raw_bounded_msg_, out_msg);
+  }
 }
 
-void ROSflightIO::handle_diff_pressure_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_diff_pressure_msg(const mavlink_diff_pressure_t & diff)
 {
-  mavlink_diff_pressure_t diff;
-  mavlink_msg_diff_pressure_decode(&msg, &diff);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_DIFF_PRESSURE);
 
   rosflight_msgs::msg::Airspeed airspeed_msg;
   airspeed_msg.header.stamp = this->get_clock()->now();
@@ -553,77 +1216,80 @@ void ROSflightIO::handle_diff_pressure_msg(const mavlink_message_t & msg)
   airspeed_msg.differential_pressure = diff.diff_pressure;
   airspeed_msg.temperature = diff.temperature;
 
-  if (calibrate_airspeed_srv_ == nullptr) {
-    calibrate_airspeed_srv_ = this->create_service<std_srvs::srv::Trigger>(
-      "calibrate_airspeed",
-      std::bind(&ROSflightIO::calibrateAirspeedSrvCallback, this, std::placeholders::_1,
-                std::placeholders::_2));
+  airspeed_received_ = true;
+
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_DIFF_PRESSURE,
+                          diff_pressure_pub_->get_topic_name());
+  diff_pressure_pub_->publish(airspeed_msg);
+  if (publish_bounded_msgs_) {
+    publish_bounded(*airspeed_bounded_pub_, airspeed_bounded_msg_, airspeed_msg);
   }
 
-  if (diff_pressure_pub_ == nullptr) {
-    diff_pressure_pub_ = this->create_publisher<rosflight_msgs::msg::Airspeed>("airspeed", 1);
+  if (publish_sensor_bundle_) {
+    sensor_bundle_.airspeed = airspeed_msg;
   }
-  diff_pressure_pub_->publish(airspeed_msg);
 }
 
-void ROSflightIO::handle_named_value_int_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_named_value_int_msg(const mavlink_named_value_int_t & val)
 {
-  mavlink_named_value_int_t val;
-  mavlink_msg_named_value_int_decode(&msg, &val);
-
-  // ensure null termination of name
-  char c_name[MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN + 1];
-  memcpy(c_name, val.name, MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN);
-  c_name[MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN] = '\0';
-  std::string name(c_name);
-
-  if (named_value_int_pubs_.find(name) == named_value_int_pubs_.end()) {
-    named_value_int_pubs_[name] =
-      this->create_publisher<std_msgs::msg::Int32>("named_value/int/" + name, 1);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_NAMED_VALUE_INT);
+
+  // looked up without a copy; the name is only null terminated when shorter than the field
+  std::string_view name(val.name, strnlen(val.name, MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN));
+  auto pub = named_value_int_pubs_.find(name);
+  if (pub == named_value_int_pubs_.end()) {
+    pub = named_value_int_pubs_
+            .emplace(name, this->create_publisher<std_msgs::msg::Int32>(
+                             "named_value/int/" + std::string(name), 1))
+            .first;
+    pub->second->on_activate();
   }
 
   std_msgs::msg::Int32 out_msg;
   out_msg.data = val.value;
 
-  named_value_int_pubs_[name]->publish(out_msg);
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_NAMED_VALUE_INT,
+                          pub->second->get_topic_name());
+  pub->second->publish(out_msg);
 }
 
-void ROSflightIO::handle_named_value_float_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_named_value_float_msg(const mavlink_named_value_float_t & val)
 {
-  mavlink_named_value_float_t val;
-  mavlink_msg_named_value_float_decode(&msg, &val);
-
-  // ensure null termination of name
-  char c_name[MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN + 1];
-  memcpy(c_name, val.name, MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN);
-  c_name[MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN] = '\0';
-  std::string name(c_name);
-
-  if (named_value_float_pubs_.find(name) == named_value_float_pubs_.end()) {
-    named_value_float_pubs_[name] =
-      this->create_publisher<std_msgs::msg::Float32>("named_value/float/" + name, 1);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_NAMED_VALUE_FLOAT);
+
+  // looked up without a copy; the name is only null terminated when shorter than the field
+  std::string_view name(val.name, strnlen(val.name, MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN));
+  auto pub = named_value_float_pubs_.find(name);
+  if (pub == named_value_float_pubs_.end()) {
+    pub = named_value_float_pubs_
+            .emplace(name, this->create_publisher<std_msgs::msg::Float32>(
+                             "named_value/float/" + std::string(name), 1))
+            .first;
+    pub->second->on_activate();
   }
 
   std_msgs::msg::Float32 out_msg;
   out_msg.data = val.value;
 
-  named_value_float_pubs_[name]->publish(out_msg);
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_NAMED_VALUE_FLOAT,
+                          pub->second->get_topic_name());
+  pub->second->publish(out_msg);
 }
 
-void ROSflightIO::handle_named_command_struct_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_named_command_struct_msg(const mavlink_named_command_struct_t & command)
 {
-  mavlink_named_command_struct_t command;
-  mavlink_msg_named_command_struct_decode(&msg, &command);
-
-  // ensure null termination of name
-  char c_name[MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN + 1];
-  memcpy(c_name, command.name, MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN);
-  c_name[MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN] = '\0';
-  std::string name(c_name);
-
-  if (named_command_struct_pubs_.find(name) == named_command_struct_pubs_.end()) {
-    named_command_struct_pubs_[name] =
-      this->create_publisher<rosflight_msgs::msg::Command>("named_value/command_struct/" + name, 1);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_NAMED_COMMAND_STRUCT);
+
+  // looked up without a copy; the name is only null terminated when shorter than the field
+  std::string_view name(command.name,
+                        strnlen(command.name, MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN));
+  auto pub = named_command_struct_pubs_.find(name);
+  if (pub == named_command_struct_pubs_.end()) {
+    pub = named_command_struct_pubs_
+            .emplace(name, this->create_publisher<rosflight_msgs::msg::Command>(
+                             "named_value/command_struct/" + std::string(name), 1))
+            .first;
+    pub->second->on_activate();
   }
 
   rosflight_msgs::msg::Command command_msg;
@@ -640,13 +1306,14 @@ void ROSflightIO::handle_named_command_struct_msg(const mavlink_message_t & msg)
   command_msg.y = command.y;
   command_msg.z = command.z;
   command_msg.f = command.F;
-  named_command_struct_pubs_[name]->publish(command_msg);
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_NAMED_COMMAND_STRUCT,
+                          pub->second->get_topic_name());
+  pub->second->publish(command_msg);
 }
 
-void ROSflightIO::handle_small_baro_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_small_baro_msg(const mavlink_small_baro_t & baro)
 {
-  mavlink_small_baro_t baro;
-  mavlink_msg_small_baro_decode(&msg, &baro);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_SMALL_BARO);
 
   rosflight_msgs::msg::Barometer baro_msg;
   baro_msg.header.stamp = this->get_clock()->now();
@@ -654,24 +1321,23 @@ void ROSflightIO::handle_small_baro_msg(const mavlink_message_t & msg)
   baro_msg.pressure = baro.pressure;
   baro_msg.temperature = baro.temperature;
 
-  // If we are getting barometer messages, then we should publish the barometer calibration service
-  if (calibrate_baro_srv_ == nullptr) {
-    calibrate_baro_srv_ = this->create_service<std_srvs::srv::Trigger>(
-      "calibrate_baro",
-      std::bind(&ROSflightIO::calibrateBaroSrvCallback, this, std::placeholders::_1,
-                std::placeholders::_2));
+  baro_received_ = true;
+
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_SMALL_BARO,
+                          baro_pub_->get_topic_name());
+  baro_pub_->publish(baro_msg);
+  if (publish_bounded_msgs_) {
+    publish_bounded(*baro_bounded_pub_, baro_bounded_msg_, baro_msg);
   }
 
-  if (baro_pub_ == nullptr) {
-    baro_pub_ = this->create_publisher<rosflight_msgs::msg::Barometer>("baro", 1);
+  if (publish_sensor_bundle_) {
+    sensor_bundle_.baro = baro_msg;
   }
-  baro_pub_->publish(baro_msg);
 }
 
-void ROSflightIO::handle_small_mag_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_small_mag_msg(const mavlink_small_mag_t & mag)
 {
-  mavlink_small_mag_t mag;
-  mavlink_msg_small_mag_decode(&msg, &mag);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_SMALL_MAG);
 
   //! \todo calibration, correct units, floating point message type
   sensor_msgs::msg::MagneticField mag_msg;
@@ -682,16 +1348,18 @@ void ROSflightIO::handle_small_mag_msg(const mavlink_message_t & msg)
   mag_msg.magnetic_field.y = mag.ymag;
   mag_msg.magnetic_field.z = mag.zmag;
 
-  if (mag_pub_ == nullptr) {
-    mag_pub_ = this->create_publisher<sensor_msgs::msg::MagneticField>("magnetometer", 1);
-  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_SMALL_MAG,
+                          mag_pub_->get_topic_name());
   mag_pub_->publish(mag_msg);
+
+  if (publish_sensor_bundle_) {
+    sensor_bundle_.mag = mag_msg;
+  }
 }
 
-void ROSflightIO::handle_small_range_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_small_range_msg(const mavlink_small_range_t & range)
 {
-  mavlink_small_range_t range;
-  mavlink_msg_small_range_decode(&msg, &range);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_SMALL_RANGE);
 
   sensor_msgs::msg::Range alt_msg;
   alt_msg.header.stamp = this->get_clock()->now();
@@ -704,22 +1372,24 @@ void ROSflightIO::handle_small_range_msg(const mavlink_message_t & msg)
       alt_msg.radiation_type = sensor_msgs::msg::Range::ULTRASOUND;
       alt_msg.field_of_view = 1.0472; // approx 60 deg
 
-      if (sonar_pub_ == nullptr) {
-        sonar_pub_ = this->create_publisher<sensor_msgs::msg::Range>("sonar", 1);
-      }
+      ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_SMALL_RANGE,
+                              sonar_pub_->get_topic_name());
       sonar_pub_->publish(alt_msg);
       break;
     case ROSFLIGHT_RANGE_LIDAR:
       alt_msg.radiation_type = sensor_msgs::msg::Range::INFRARED;
       alt_msg.field_of_view = .0349066; // approx 2 deg
 
-      if (lidar_pub_ == nullptr) {
-        lidar_pub_ = this->create_publisher<sensor_msgs::msg::Range>("lidar", 1);
-      }
+      ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_SMALL_RANGE,
+                              lidar_pub_->get_topic_name());
       lidar_pub_->publish(alt_msg);
       break;
     default:
-      break;
+      return;
+  }
+
+  if (publish_sensor_bundle_) {
+    sensor_bundle_.range = alt_msg;
   }
 }
 
@@ -728,6 +1398,50 @@ rclcpp::Time ROSflightIO::fcu_time_to_ros_time(std::chrono::nanoseconds fcu_time
   return rclcpp::Time(mavrosflight_->time.fcu_time_to_system_time(fcu_time).count());
 }
 
+namespace
+{
+// Age of a measurement relative to the IMU sample, both stamped on receipt
+float sensor_age(const rclcpp::Time & imu_stamp, const builtin_interfaces::msg::Time & stamp)
+{
+  if (stamp.sec == 0 && stamp.nanosec == 0) {
+    return rosflight_msgs::msg::SensorBundle::AGE_NEVER_RECEIVED;
+  }
+  return std::max(0.0f, (float) (imu_stamp - rclcpp::Time(stamp)).seconds());
+}
+} // namespace
+
+void ROSflightIO::publish_sensor_bundle(const sensor_msgs::msg::Imu & imu_msg, float temperature,
+                                        const rosflight_io::AttitudeHistory::Sample * attitude,
+                                        const rclcpp::Time & received)
+{
+  // Mag, baro, airspeed and range carry no FCU timestamp, so every member is stamped on receipt
+  rclcpp::Time stamp = received;
+  sensor_bundle_.header = imu_msg.header;
+  sensor_bundle_.imu = imu_msg;
+  sensor_bundle_.imu.header.stamp = stamp;
+  sensor_bundle_.imu_temperature = temperature;
+
+  if (attitude != nullptr) {
+    // Keeps the offset from the IMU sample that the FCU stamps give
+    sensor_bundle_.attitude.header.stamp =
+      stamp + rclcpp::Duration::from_nanoseconds(
+        attitude->stamp_ns - rclcpp::Time(imu_msg.header.stamp).nanoseconds());
+    sensor_bundle_.attitude.attitude = imu_msg.orientation;
+    sensor_bundle_.attitude.angular_velocity.x = attitude->angular_velocity.x();
+    sensor_bundle_.attitude.angular_velocity.y = attitude->angular_velocity.y();
+    sensor_bundle_.attitude.angular_velocity.z = attitude->angular_velocity.z();
+  }
+
+  sensor_bundle_.attitude_age = sensor_age(stamp, sensor_bundle_.attitude.header.stamp);
+  sensor_bundle_.mag_age = sensor_age(stamp, sensor_bundle_.mag.header.stamp);
+  sensor_bundle_.baro_age = sensor_age(stamp, sensor_bundle_.baro.header.stamp);
+  sensor_bundle_.airspeed_age = sensor_age(stamp, sensor_bundle_.airspeed.header.stamp);
+  sensor_bundle_.range_age = sensor_age(stamp, sensor_bundle_.range.header.stamp);
+  sensor_bundle_.gnss_age = sensor_age(stamp, sensor_bundle_.gnss.header.stamp);
+
+  sensor_bundle_pub_->publish(sensor_bundle_);
+}
+
 std::string ROSflightIO::get_major_minor_version(const std::string & version)
 {
   size_t start_index = 0;
@@ -739,87 +1453,88 @@ std::string ROSflightIO::get_major_minor_version(const std::string & version)
   return version.substr(start_index, dot_index - start_index);
 }
 
-void ROSflightIO::handle_version_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_version_msg(const mavlink_rosflight_version_t & version)
 {
-  version_timer_->cancel();
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_ROSFLIGHT_VERSION);
 
-  mavlink_rosflight_version_t version;
-  mavlink_msg_rosflight_version_decode(&msg, &version);
+  version_received_ = true;
 
   std_msgs::msg::String version_msg;
   version_msg.data = version.version;
 
-  if (version_pub_ == nullptr) {
-    rclcpp::QoS qos_transient_local_1_(1);
-    qos_transient_local_1_.transient_local();
-    version_pub_ = this->create_publisher<std_msgs::msg::String>("version", qos_transient_local_1_);
+  if (active_) {
+    ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_ROSFLIGHT_VERSION,
+                            version_pub_->get_topic_name());
+    version_pub_->publish(version_msg);
   }
-  version_pub_->publish(version_msg);
 #ifdef GIT_VERSION_STRING // Macro so that is compiles even if git is not available
   const std::string git_version_string = GIT_VERSION_STRING;
   const std::string rosflight_major_minor_version = get_major_minor_version(git_version_string);
   const std::string firmware_version(version.version);
   const std::string firmware_major_minor_version = get_major_minor_version(firmware_version);
   if (rosflight_major_minor_version == firmware_major_minor_version) {
-    RCLCPP_INFO(this->get_logger(), "ROSflight/firmware version: %s",
-                firmware_major_minor_version.c_str());
+    log_queue_.push(LogQueue::SEVERITY_INFO, "ROSflight/firmware version: %s",
+                    firmware_major_minor_version.c_str());
   } else {
-    RCLCPP_WARN(
-      this->get_logger(),
+    log_queue_.push(
+      LogQueue::SEVERITY_WARN,
       "ROSflight version does not match firmware version. Errors or missing features may result");
-    RCLCPP_WARN(this->get_logger(), "ROSflight version: %s", rosflight_major_minor_version.c_str());
-    RCLCPP_WARN(this->get_logger(), "Firmware version: %s", firmware_major_minor_version.c_str());
+    log_queue_.push(LogQueue::SEVERITY_WARN, "ROSflight version: %s",
+                    rosflight_major_minor_version.c_str());
+    log_queue_.push(LogQueue::SEVERITY_WARN, "Firmware version: %s",
+                    firmware_major_minor_version.c_str());
   }
 
 #else
-  RCLCPP_WARN(this->get_logger(),
-              "Version checking unavailable. Firmware version may or may not be compatible with "
-              "ROSflight version");
-  RCLCPP_WARN(this->get_logger(), "Firmware version: %s", version.version);
+  log_queue_.push(LogQueue::SEVERITY_WARN,
+                  "Version checking unavailable. Firmware version may or may not be compatible "
+                  "with ROSflight version");
+  log_queue_.push(LogQueue::SEVERITY_WARN, "Firmware version: %s", version.version);
 #endif
 }
 
-void ROSflightIO::handle_hard_error_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_hard_error_msg(const mavlink_rosflight_hard_error_t & error)
 {
-  mavlink_rosflight_hard_error_t error;
-  mavlink_msg_rosflight_hard_error_decode(&msg, &error);
-  RCLCPP_ERROR(this->get_logger(),
-               "Hard fault detected, with error code %u. The flight controller has rebooted.",
-               error.error_code);
-  RCLCPP_ERROR(this->get_logger(), "Hard fault was at: 0x%x", error.pc);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_ROSFLIGHT_HARD_ERROR);
+
+  log_queue_.push(LogQueue::SEVERITY_ERROR,
+                  "Hard fault detected, with error code %u. The flight controller has rebooted.",
+                  error.error_code);
+  log_queue_.push(LogQueue::SEVERITY_ERROR, "Hard fault was at: 0x%x", error.pc);
   if (error.doRearm) {
-    RCLCPP_ERROR(this->get_logger(), "The firmware has rearmed itself.");
+    log_queue_.push(LogQueue::SEVERITY_ERROR, "The firmware has rearmed itself.");
   }
-  RCLCPP_ERROR(this->get_logger(), "The flight controller has rebooted %u time%s.",
-               error.reset_count, error.reset_count > 1 ? "s" : "");
+  log_queue_.push(LogQueue::SEVERITY_ERROR, "The flight controller has rebooted %u time%s.",
+                  error.reset_count, error.reset_count > 1 ? "s" : "");
   rosflight_msgs::msg::Error error_msg;
   error_msg.error_message = "A firmware error has caused the flight controller to reboot.";
   error_msg.error_code = error.error_code;
   error_msg.reset_count = error.reset_count;
   error_msg.rearm = error.doRearm;
   error_msg.pc = error.pc;
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_ROSFLIGHT_HARD_ERROR,
+                          error_pub_->get_topic_name());
   error_pub_->publish(error_msg);
 }
 
-void ROSflightIO::handle_battery_status_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_battery_status_msg(
+  const mavlink_rosflight_battery_status_t & battery_status)
 {
-  mavlink_rosflight_battery_status_t battery_status;
-  mavlink_msg_rosflight_battery_status_decode(&msg, &battery_status);
-  if (battery_status_pub_ == nullptr) {
-    battery_status_pub_ = this->create_publisher<rosflight_msgs::msg::BatteryStatus>("battery", 1);
-  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_ROSFLIGHT_BATTERY_STATUS);
+
   rosflight_msgs::msg::BatteryStatus battery_status_message;
   battery_status_message.voltage = battery_status.battery_voltage;
   battery_status_message.current = battery_status.battery_current;
   battery_status_message.header.stamp = this->get_clock()->now();
 
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_ROSFLIGHT_BATTERY_STATUS,
+                          battery_status_pub_->get_topic_name());
   battery_status_pub_->publish(battery_status_message);
 }
 
-void ROSflightIO::handle_rosflight_gnss_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_rosflight_gnss_msg(const mavlink_rosflight_gnss_t & gnss)
 {
-  mavlink_rosflight_gnss_t gnss;
-  mavlink_msg_rosflight_gnss_decode(&msg, &gnss);
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_ROSFLIGHT_GNSS);
 
   rclcpp::Time stamp = fcu_time_to_ros_time(std::chrono::microseconds(gnss.rosflight_timestamp));
   rosflight_msgs::msg::GNSS gnss_msg;
@@ -836,10 +1551,17 @@ void ROSflightIO::handle_rosflight_gnss_msg(const mavlink_message_t & msg)
   gnss_msg.velocity[1] = .01 * gnss.ecef_v_y;
   gnss_msg.velocity[2] = .01 * gnss.ecef_v_z;
   gnss_msg.speed_accuracy = gnss.s_acc;
-  if (gnss_pub_ == nullptr) {
-    gnss_pub_ = this->create_publisher<rosflight_msgs::msg::GNSS>("gnss", 1);
-  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_ROSFLIGHT_GNSS,
+                          gnss_pub_->get_topic_name());
   gnss_pub_->publish(gnss_msg);
+  if (publish_bounded_msgs_) {
+    publish_bounded(*gnss_bounded_pub_, gnss_bounded_msg_, gnss_msg);
+  }
+
+  if (publish_sensor_bundle_) {
+    sensor_bundle_.gnss = gnss_msg;
+    sensor_bundle_.gnss.header.stamp = this->get_clock()->now();
+  }
 
   sensor_msgs::msg::NavSatFix navsat_fix;
   navsat_fix.header.stamp = stamp;
@@ -868,9 +1590,8 @@ void ROSflightIO::handle_rosflight_gnss_msg(const mavlink_message_t & msg)
   navsat_status.service = 1; // Report that only GPS was used, even though others may have been
   navsat_fix.status = navsat_status;
 
-  if (nav_sat_fix_pub_ == nullptr) {
-    nav_sat_fix_pub_ = this->create_publisher<sensor_msgs::msg::NavSatFix>("navsat_compat/fix", 1);
-  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_ROSFLIGHT_GNSS,
+                          nav_sat_fix_pub_->get_topic_name());
   nav_sat_fix_pub_->publish(navsat_fix);
 
   geometry_msgs::msg::TwistStamped twist_stamped;
@@ -884,10 +1605,8 @@ void ROSflightIO::handle_rosflight_gnss_msg(const mavlink_message_t & msg)
   twist_stamped.twist.linear.y = .001 * gnss.vel_e;
   twist_stamped.twist.linear.z = .001 * gnss.vel_d;
 
-  if (twist_stamped_pub_ == nullptr) {
-    twist_stamped_pub_ =
-      this->create_publisher<geometry_msgs::msg::TwistStamped>("navsat_compat/vel", 1);
-  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_ROSFLIGHT_GNSS,
+                          twist_stamped_pub_->get_topic_name());
   twist_stamped_pub_->publish(twist_stamped);
 
   sensor_msgs::msg::TimeReference time_ref;
@@ -895,22 +1614,19 @@ void ROSflightIO::handle_rosflight_gnss_msg(const mavlink_message_t & msg)
   time_ref.source = "GNSS";
   time_ref.time_ref = rclcpp::Time((int32_t) gnss.time, gnss.nanos);
 
-  if (time_reference_pub_ == nullptr) {
-    time_reference_pub_ =
-      this->create_publisher<sensor_msgs::msg::TimeReference>("navsat_compat/time_reference", 1);
-  }
 
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_ROSFLIGHT_GNSS,
+                          time_reference_pub_->get_topic_name());
   time_reference_pub_->publish(time_ref);
 }
 
-void ROSflightIO::handle_rosflight_gnss_full_msg(const mavlink_message_t & msg)
+void ROSflightIO::handle_rosflight_gnss_full_msg(const mavlink_rosflight_gnss_full_t & full)
 {
+  ROSFLIGHT_IO_TRACEPOINT(handler_entry, this, MAVLINK_MSG_ID_ROSFLIGHT_GNSS_FULL);
+
   /// \todo Publishes a lot of duplicate data, reduce this down to more unified topics and MAVLink
   ///  communication. (Move additional information in gnss_full to gnss and get rid of gnss_full?)
 
-  mavlink_rosflight_gnss_full_t full;
-  mavlink_msg_rosflight_gnss_full_decode(&msg, &full);
-
   rosflight_msgs::msg::GNSSFull msg_out;
   msg_out.header.stamp = this->get_clock()->now();
   msg_out.time_of_week = full.time_of_week;
@@ -940,14 +1656,16 @@ void ROSflightIO::handle_rosflight_gnss_full_msg(const mavlink_message_t & msg)
   msg_out.head_acc = full.head_acc;
   msg_out.p_dop = full.p_dop;
 
-  if (gnss_full_pub_ == nullptr) {
-    gnss_full_pub_ = this->create_publisher<rosflight_msgs::msg::GNSSFull>("gnss_full", 1);
-  }
+  ROSFLIGHT_IO_TRACEPOINT(handler_publish, this, MAVLINK_MSG_ID_ROSFLIGHT_GNSS_FULL,
+                          gnss_full_pub_->get_topic_name());
   gnss_full_pub_->publish(msg_out);
 }
 
 void ROSflightIO::commandCallback(const rosflight_msgs::msg::Command::ConstSharedPtr & msg)
 {
+  mavrosflight::HotPath hot_path("rosflight_io.command");
+  ROSFLIGHT_IO_TRACEPOINT(command_callback, this, msg->mode);
+
   //! \todo these are hard-coded to match right now; may want to replace with something more robust
   auto mode = (OFFBOARD_CONTROL_MODE) msg->mode;
   auto ignore = (OFFBOARD_CONTROL_IGNORE) msg->ignore;
@@ -971,6 +1689,12 @@ void ROSflightIO::commandCallback(const rosflight_msgs::msg::Command::ConstShare
       break;
   }
 
+  if (command_scheduler_ != nullptr) {
+    command_scheduler_->latch(mavrosflight::CommandScheduler::OffboardCommand{
+      (uint8_t) mode, (uint8_t) ignore, x, y, z, F});
+    return;
+  }
+
   mavlink_message_t mavlink_msg;
   mavlink_msg_offboard_control_pack(1, 50, &mavlink_msg, mode, ignore, x, y, z, F);
   mavrosflight_->comm.send_message(mavlink_msg);
@@ -978,14 +1702,19 @@ void ROSflightIO::commandCallback(const rosflight_msgs::msg::Command::ConstShare
 
 void ROSflightIO::auxCommandCallback(const rosflight_msgs::msg::AuxCommand::ConstSharedPtr & msg)
 {
-  uint8_t types[14];
-  float values[14];
-  for (int i = 0; i < 14; i++) {
-    types[i] = msg->type_array[i];
-    values[i] = msg->values[i];
+  mavrosflight::CommandScheduler::AuxCommand command;
+  for (int i = 0; i < mavrosflight::CommandScheduler::AUX_CHANNELS; i++) {
+    command.types[i] = msg->type_array[i];
+    command.values[i] = msg->values[i];
+  }
+
+  if (command_scheduler_ != nullptr) {
+    command_scheduler_->latch(command);
+    return;
   }
+
   mavlink_message_t mavlink_msg;
-  mavlink_msg_rosflight_aux_cmd_pack(1, 50, &mavlink_msg, types, values);
+  mavlink_msg_rosflight_aux_cmd_pack(1, 50, &mavlink_msg, command.types, command.values);
   mavrosflight_->comm.send_message(mavlink_msg);
 }
 
@@ -1069,23 +1798,291 @@ bool ROSflightIO::calibrateRCTrimSrvCallback(
   return true;
 }
 
-void ROSflightIO::paramTimerCallback()
+void ROSflightIO::handshakeTimerCallback()
 {
-  if (mavrosflight_->param.got_all_params()) {
-    param_timer_->cancel();
-    RCLCPP_INFO(this->get_logger(), "Received all parameters");
-  } else {
+  // The io thread can only close the link, so the transition out of the current state starts here
+  if (!link_failed_ && mavrosflight_->comm.failed()) {
+    RCLCPP_ERROR(this->get_logger(), "The MAVLink link failed");
+    link_failed_ = true;
+    if (active_) {
+      this->deactivate();
+    } else {
+      this->cleanup();
+    }
+    return;
+  }
+
+  int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now().time_since_epoch())
+                     .count();
+  ConnectionState state = connection_state_;
+  if (state != WAITING_FOR_HEARTBEAT
+      && std::chrono::nanoseconds(now_ns - last_heartbeat_ns_)
+        > std::chrono::seconds(HEARTBEAT_TIMEOUT)) {
+    if (connection_state_.compare_exchange_strong(state, WAITING_FOR_HEARTBEAT)) {
+      RCLCPP_WARN(this->get_logger(), "No HEARTBEAT for %ld s, waiting for the firmware",
+                  HEARTBEAT_TIMEOUT);
+      publish_connection_status(false);
+    }
+    return;
+  }
+  if (state != CONNECTING) {
+    return;
+  }
+
+  if (!version_received_) {
+    request_version();
+  }
+
+  // Params stream in after a single request, so only ask again once they stop arriving
+  int params_received = mavrosflight_->param.get_params_received();
+  if (!mavrosflight_->param.got_all_params()
+      && params_received == params_received_at_last_check_) {
     mavrosflight_->param.request_params();
-    RCLCPP_ERROR(this->get_logger(),
-                 "Received %d of %d parameters. Requesting missing parameters...",
-                 mavrosflight_->param.get_params_received(), mavrosflight_->param.get_num_params());
+    RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 1000,
+                         "Received %d of %d parameters. Requesting missing parameters...",
+                         params_received, mavrosflight_->param.get_num_params());
   }
+  params_received_at_last_check_ = params_received;
 }
 
-void ROSflightIO::versionTimerCallback() { request_version(); }
-
 void ROSflightIO::heartbeatTimerCallback() { send_heartbeat(); }
 
+void ROSflightIO::logTimerCallback()
+{
+  uint64_t dropped = log_queue_.drain([this](const LogQueue::Line & line) {
+    switch (line.severity) {
+      case LogQueue::SEVERITY_DEBUG:
+        RCLCPP_DEBUG(this->get_logger(), "%s", line.text);
+        break;
+      case LogQueue::SEVERITY_INFO:
+        RCLCPP_INFO(this->get_logger(), "%s", line.text);
+        break;
+      case LogQueue::SEVERITY_WARN:
+        RCLCPP_WARN(this->get_logger(), "%s", line.text);
+        break;
+      case LogQueue::SEVERITY_ERROR:
+        RCLCPP_ERROR(this->get_logger(), "%s", line.text);
+        break;
+    }
+  });
+  if (dropped > 0) {
+    RCLCPP_WARN(this->get_logger(), "Dropped %lu log lines from the MAVLink handlers",
+                (unsigned long) dropped);
+  }
+}
+
+void ROSflightIO::loopTimeTimerCallback()
+{
+  std::string name = std::string(this->get_fully_qualified_name()) + ": firmware loop time";
+  diagnostic_msgs::msg::DiagnosticArray msg;
+  msg.header.stamp = this->get_clock()->now();
+  msg.status.push_back(loop_time_status(loop_time_monitor_.summary(), name, this->get_namespace(),
+                                        "No status from the firmware"));
+  diagnostics_pub_->publish(msg);
+}
+
+void ROSflightIO::start_handshake()
+{
+  handshake_start_ = std::chrono::steady_clock::now();
+  version_received_ = false;
+
+  request_version();
+  mavrosflight_->time.request_sync(TIME_SYNC_BURST);
+  mavrosflight_->param.request_params();
+}
+
+void ROSflightIO::check_connection_ready()
+{
+  if (!version_received_ || !mavrosflight_->time.initialized()
+      || !mavrosflight_->param.got_all_params()) {
+    return;
+  }
+
+  ConnectionState expected = CONNECTING;
+  if (connection_state_.compare_exchange_strong(expected, READY)) {
+    log_queue_.push(LogQueue::SEVERITY_INFO, "Received all parameters");
+    publish_connection_status(true);
+  }
+}
+
+void ROSflightIO::publish_connection_status(bool ready)
+{
+  rosflight_msgs::msg::ConnectionStatus msg;
+  msg.header.stamp = this->get_clock()->now();
+  msg.ready = ready;
+  if (ready) {
+    auto now = std::chrono::steady_clock::now();
+    msg.time_to_ready = rclcpp::Duration(now - handshake_start_);
+    msg.time_since_start = rclcpp::Duration(now - node_start_);
+    log_queue_.push(LogQueue::SEVERITY_INFO, "Ready, %.3f s after the first HEARTBEAT",
+                    std::chrono::duration<double>(now - handshake_start_).count());
+  }
+  if (active_) {
+    connection_status_pub_->publish(msg);
+  }
+}
+
+void ROSflightIO::provisionTimerCallback()
+{
+  auto now = std::chrono::steady_clock::now();
+  bool step_done = false;
+  switch (provision_step_) {
+    case PROVISION_IDLE:
+      provision_timer_->cancel();
+      return;
+    case PROVISION_CONNECT:
+      step_done = connection_state_ == READY;
+      break;
+    case PROVISION_PARAMS:
+      step_done = !mavrosflight_->param.param_sets_pending();
+      if (!step_done && now - provision_last_resend_ > std::chrono::seconds(PARAM_SET_RETRY)) {
+        mavrosflight_->param.resend_pending_param_sets();
+        provision_last_resend_ = now;
+      }
+      break;
+    case PROVISION_CALIBRATE:
+    case PROVISION_WRITE:
+      if (provision_ack_result_ == 0) {
+        finish_provision(false, provision_step_name() + " was rejected by the firmware");
+        return;
+      }
+      step_done = provision_ack_result_ == 1;
+      // The IMU calibration is acknowledged when it starts, so also wait for its result. The
+      // error flag alone isn't enough, since it is already clear on a calibrated flight controller.
+      if (provision_awaited_command_ == ROSFLIGHT_CMD_ACCEL_CALIBRATION) {
+        step_done = step_done && provision_biases_captured_ == 0x7
+          && !(status_error_code_ & ROSFLIGHT_ERROR_UNCALIBRATED_IMU);
+      }
+      break;
+  }
+
+  if (step_done) {
+    next_provision_step();
+  } else if (now - provision_step_start_
+             > std::chrono::duration<double>(provision_request_.timeout)) {
+    finish_provision(false, provision_step_name() + " timed out");
+  }
+}
+
+void ROSflightIO::start_provision_step(ProvisionStep step)
+{
+  provision_step_ = step;
+  provision_step_start_ = std::chrono::steady_clock::now();
+  provision_last_resend_ = provision_step_start_;
+
+  int command = -1;
+  switch (step) {
+    case PROVISION_IDLE:
+    case PROVISION_CONNECT:
+      break;
+    case PROVISION_PARAMS:
+      if (!mavrosflight_->param.load_from_file(provision_request_.params_file)) {
+        finish_provision(false, "Could not load " + provision_request_.params_file);
+      }
+      break;
+    case PROVISION_CALIBRATE:
+      command = calibration_command(provision_request_.calibrations[provision_calibration_]);
+      break;
+    case PROVISION_WRITE:
+      command = ROSFLIGHT_CMD_WRITE_PARAMS;
+      break;
+  }
+  if (command < 0) {
+    provision_awaited_command_ = -1;
+    return;
+  }
+
+  RCLCPP_INFO(this->get_logger(), "Provisioning: %s", provision_step_name().c_str());
+  provision_ack_result_ = -1;
+  provision_biases_captured_ = 0;
+  provision_awaited_command_ = command;
+  if (command == ROSFLIGHT_CMD_WRITE_PARAMS) {
+    if (!mavrosflight_->param.write_params()) {
+      finish_provision(false, "A param write is already in progress");
+    }
+  } else {
+    mavlink_message_t msg;
+    mavlink_msg_rosflight_cmd_pack(1, 50, &msg, command);
+    mavrosflight_->comm.send_message(msg);
+  }
+}
+
+void ROSflightIO::next_provision_step()
+{
+  const rosflight_msgs::srv::Provision::Request & req = provision_request_;
+  switch (provision_step_) {
+    case PROVISION_IDLE:
+      return;
+    case PROVISION_CONNECT:
+      if (!req.params_file.empty()) {
+        start_provision_step(PROVISION_PARAMS);
+        return;
+      }
+      [[fallthrough]];
+    case PROVISION_PARAMS:
+      provision_calibration_ = 0;
+      if (provision_calibration_ < req.calibrations.size()) {
+        start_provision_step(PROVISION_CALIBRATE);
+        return;
+      }
+      [[fallthrough]];
+    case PROVISION_CALIBRATE:
+      if (provision_step_ == PROVISION_CALIBRATE
+          && ++provision_calibration_ < req.calibrations.size()) {
+        start_provision_step(PROVISION_CALIBRATE);
+        return;
+      }
+      if (req.write_params) {
+        start_provision_step(PROVISION_WRITE);
+        return;
+      }
+      [[fallthrough]];
+    case PROVISION_WRITE:
+      finish_provision(true, "");
+  }
+}
+
+void ROSflightIO::finish_provision(bool success, const std::string & message)
+{
+  auto duration = std::chrono::steady_clock::now() - provision_start_;
+  if (success) {
+    RCLCPP_INFO(this->get_logger(), "Provisioning done in %.3f s",
+                std::chrono::duration<double>(duration).count());
+  } else {
+    RCLCPP_ERROR(this->get_logger(), "Provisioning failed: %s", message.c_str());
+  }
+
+  rosflight_msgs::srv::Provision::Response res;
+  res.success = success;
+  res.message = message;
+  res.duration = rclcpp::Duration(duration);
+  provision_srv_->send_response(*provision_header_, res);
+
+  provision_step_ = PROVISION_IDLE;
+  provision_awaited_command_ = -1;
+  provision_header_.reset();
+  if (provision_timer_ != nullptr) {
+    provision_timer_->cancel();
+  }
+}
+
+std::string ROSflightIO::provision_step_name() const
+{
+  switch (provision_step_) {
+    case PROVISION_CONNECT:
+      return "connecting";
+    case PROVISION_PARAMS:
+      return "loading " + provision_request_.params_file;
+    case PROVISION_CALIBRATE:
+      return provision_request_.calibrations[provision_calibration_] + " calibration";
+    case PROVISION_WRITE:
+      return "param write";
+    default:
+      return "idle";
+  }
+}
+
 void ROSflightIO::request_version()
 {
   mavlink_message_t msg;
@@ -1100,13 +2097,13 @@ void ROSflightIO::send_heartbeat()
 }
 
 void ROSflightIO::check_error_code(uint8_t current, uint8_t previous, ROSFLIGHT_ERROR_CODE code,
-                                   const std::string & name)
+                                   const char * name)
 {
   if ((current & code) != (previous & code)) {
     if (current & code) {
-      RCLCPP_ERROR(this->get_logger(), "Autopilot ERROR: %s", name.c_str());
+      log_queue_.push(LogQueue::SEVERITY_ERROR, "Autopilot ERROR: %s", name);
     } else {
-      RCLCPP_INFO(this->get_logger(), "Autopilot RECOVERED ERROR: %s", name.c_str());
+      log_queue_.push(LogQueue::SEVERITY_INFO, "Autopilot RECOVERED ERROR: %s", name);
     }
   }
 }
@@ -1115,6 +2112,12 @@ bool ROSflightIO::calibrateAirspeedSrvCallback(
   const std_srvs::srv::Trigger::Request::SharedPtr & req,
   const std_srvs::srv::Trigger::Response::SharedPtr & res)
 {
+  if (!airspeed_received_) {
+    res->success = false;
+    res->message = "No airspeed sensor reported since configuring";
+    return true;
+  }
+
   mavlink_message_t msg;
   mavlink_msg_rosflight_cmd_pack(1, 50, &msg, ROSFLIGHT_CMD_AIRSPEED_CALIBRATION);
   mavrosflight_->comm.send_message(msg);
@@ -1125,6 +2128,12 @@ bool ROSflightIO::calibrateAirspeedSrvCallback(
 bool ROSflightIO::calibrateBaroSrvCallback(const std_srvs::srv::Trigger::Request::SharedPtr & req,
                                            const std_srvs::srv::Trigger::Response::SharedPtr & res)
 {
+  if (!baro_received_) {
+    res->success = false;
+    res->message = "No barometer reported since configuring";
+    return true;
+  }
+
   mavlink_message_t msg;
   mavlink_msg_rosflight_cmd_pack(1, 50, &msg, ROSFLIGHT_CMD_BARO_CALIBRATION);
   mavrosflight_->comm.send_message(msg);
@@ -1153,4 +2162,88 @@ bool ROSflightIO::rebootToBootloaderSrvCallback(
   return true;
 }
 
+bool ROSflightIO::attitudeAtTimeSrvCallback(
+  const rosflight_msgs::srv::AttitudeAtTime::Request::SharedPtr & req,
+  const rosflight_msgs::srv::AttitudeAtTime::Response::SharedPtr & res)
+{
+  rclcpp::Time stamp(req->stamp);
+  if (stamp.nanoseconds() == 0) {
+    rosflight_io::AttitudeHistory::Sample latest;
+    if (!attitude_history_.latest(latest)) {
+      res->success = false;
+      return true;
+    }
+    stamp = rclcpp::Time(latest.stamp_ns);
+  }
+  res->success = attitude_at(stamp, res->attitude);
+  return true;
+}
+
+void ROSflightIO::provisionSrvCallback(
+  const std::shared_ptr<rmw_request_id_t> & header,
+  const rosflight_msgs::srv::Provision::Request::SharedPtr & req)
+{
+  rosflight_msgs::srv::Provision::Response res;
+  res.success = false;
+  if (provision_step_ != PROVISION_IDLE) {
+    res.message = "Provisioning is already in progress";
+    provision_srv_->send_response(*header, res);
+    return;
+  }
+  for (const std::string & calibration : req->calibrations) {
+    if (calibration_command(calibration) < 0) {
+      res.message = "Unknown calibration " + calibration;
+      provision_srv_->send_response(*header, res);
+      return;
+    }
+  }
+
+  provision_request_ = *req;
+  provision_header_ = header;
+  provision_start_ = std::chrono::steady_clock::now();
+  start_provision_step(PROVISION_CONNECT);
+
+  if (provision_timer_ == nullptr) {
+    provision_timer_ =
+      this->create_wall_timer(std::chrono::milliseconds(PROVISION_PERIOD_MS),
+                              std::bind(&ROSflightIO::provisionTimerCallback, this), nullptr);
+  } else {
+    provision_timer_->reset();
+  }
+}
+
+bool ROSflightIO::resetLoopTimeMonitorSrvCallback(
+  const std_srvs::srv::Trigger::Request::SharedPtr & req,
+  const std_srvs::srv::Trigger::Response::SharedPtr & res)
+{
+  loop_time_monitor_.clear();
+  if (loop_time_overrun_.exchange(false)) {
+    std_msgs::msg::Bool overrun_msg;
+    overrun_msg.data = false;
+    loop_time_overrun_pub_->publish(overrun_msg);
+  }
+  res->success = true;
+  return true;
+}
+
+bool ROSflightIO::attitude_at(const rclcpp::Time & stamp,
+                              rosflight_msgs::msg::Attitude & attitude) const
+{
+  rosflight_io::AttitudeHistory::Sample sample;
+  if (attitude_history_.lookup(stamp.nanoseconds(), attitude_max_extrapolation_ns_, sample)
+      != rosflight_io::AttitudeHistory::OK) {
+    return false;
+  }
+
+  attitude.header.stamp = stamp;
+  attitude.attitude.w = sample.attitude.w();
+  attitude.attitude.x = sample.attitude.x();
+  attitude.attitude.y = sample.attitude.y();
+  attitude.attitude.z = sample.attitude.z();
+  attitude.angular_velocity.x = sample.angular_velocity.x();
+  attitude.angular_velocity.y = sample.angular_velocity.y();
+  attitude.angular_velocity.z = sample.angular_velocity.z();
+  return true;
+}
+
 } // namespace rosflight_io
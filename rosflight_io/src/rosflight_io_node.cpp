@@ -38,13 +38,28 @@
  * \author Brandon Sutherland <brandonsutherland2@gmail.com>
  */
 
+#include <lifecycle_msgs/msg/state.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <rosflight_io/rosflight_io.hpp>
 
 int main(int argc, char ** argv)
 {
   rclcpp::init(argc, argv);
-  rclcpp::spin(std::make_shared<rosflight_io::ROSflightIO>());
+  auto node = std::make_shared<rosflight_io::ROSflightIO>();
+
+  // Without autostart the node waits to be brought up by a lifecycle manager. A standby is
+  // configured but not activated.
+  if (node->get_parameter_or("autostart", true)) {
+    if (node->configure().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE) {
+      rclcpp::shutdown();
+      return 1;
+    }
+    if (!node->get_parameter_or("standby", false)) {
+      node->activate();
+    }
+  }
+
+  rclcpp::spin(node->get_node_base_interface());
   rclcpp::shutdown();
   return 0;
 }
@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file rosflight_top.cpp
+ *
+ * Terminal dashboard for the live statistics segments published by rosflight_io and the SIL
+ * plugin. Attaches to the segments read-only and does not use ROS, so it keeps working when DDS is
+ * overloaded or misconfigured.
+ */
+
+#include <rosflight_io/mavrosflight/live_stats.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using mavrosflight::LiveStatsHistogram;
+using mavrosflight::LiveStatsReader;
+using mavrosflight::LiveStatsSegment;
+
+namespace
+{
+constexpr size_t NUM_BUCKETS = mavrosflight::LIVE_STATS_HISTOGRAM_BUCKETS;
+constexpr size_t NUM_MSG_IDS = mavrosflight::LIVE_STATS_NUM_MSG_IDS;
+constexpr size_t TOP_MSG_IDS = 6;
+
+/**
+ * \brief Copy of the counters of a segment, used to compute rates between two refreshes
+ */
+struct Snapshot
+{
+  int64_t time_ns = 0;
+  uint64_t rx_bytes = 0;
+  uint64_t rx_frames = 0;
+  uint64_t tx_bytes = 0;
+  uint64_t tx_frames = 0;
+  uint64_t sil_steps = 0;
+  uint64_t rx_msg_count[NUM_MSG_IDS] = {};
+  uint64_t dispatch_time[NUM_BUCKETS] = {};
+};
+
+struct Entry
+{
+  std::unique_ptr<LiveStatsReader> reader;
+  Snapshot previous;
+  bool has_previous = false;
+};
+
+void copy_histogram(const LiveStatsHistogram & histogram, uint64_t (&counts)[NUM_BUCKETS])
+{
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    counts[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+  }
+}
+
+Snapshot take_snapshot(const LiveStatsSegment & segment)
+{
+  Snapshot snapshot;
+  snapshot.time_ns = mavrosflight::LiveStats::now_ns();
+  snapshot.rx_bytes = segment.rx_bytes.load(std::memory_order_relaxed);
+  snapshot.rx_frames = segment.rx_frames.load(std::memory_order_relaxed);
+  snapshot.tx_bytes = segment.tx_bytes.load(std::memory_order_relaxed);
+  snapshot.tx_frames = segment.tx_frames.load(std::memory_order_relaxed);
+  snapshot.sil_steps = segment.sil_steps.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < NUM_MSG_IDS; i++) {
+    snapshot.rx_msg_count[i] = segment.rx_msg_count[i].load(std::memory_order_relaxed);
+  }
+  copy_histogram(segment.dispatch_time, snapshot.dispatch_time);
+  return snapshot;
+}
+
+double rate(uint64_t current, uint64_t previous, double dt)
+{
+  return dt > 0.0 ? (double) (current - previous) / dt : 0.0;
+}
+
+void print_io(const LiveStatsSegment & segment, const Snapshot & now, const Snapshot & prev,
+              double dt)
+{
+  printf("  link    rx %8.0f msg/s %9.1f kB/s   tx %8.0f msg/s %9.1f kB/s\n",
+         rate(now.rx_frames, prev.rx_frames, dt),
+         rate(now.rx_bytes, prev.rx_bytes, dt) / 1000.0, rate(now.tx_frames, prev.tx_frames, dt),
+         rate(now.tx_bytes, prev.tx_bytes, dt) / 1000.0);
+  printf("  errors  dropped %llu  lost %llu  tx errors %llu   write queue %u (max %u)\n",
+         (unsigned long long) segment.rx_dropped.load(std::memory_order_relaxed),
+         (unsigned long long) segment.rx_lost.load(std::memory_order_relaxed),
+         (unsigned long long) segment.tx_errors.load(std::memory_order_relaxed),
+         segment.write_queue_depth.load(std::memory_order_relaxed),
+         segment.write_queue_max.load(std::memory_order_relaxed));
+
+  // Dispatch latency over the last refresh interval
+  uint64_t dispatch[NUM_BUCKETS];
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    dispatch[i] = now.dispatch_time[i] - prev.dispatch_time[i];
+  }
+  printf("  dispatch  p50 <%6.0f us  p99 <%6.0f us\n",
+         LiveStatsHistogram::percentile_us(dispatch, 0.5),
+         LiveStatsHistogram::percentile_us(dispatch, 0.99));
+
+  if (segment.time_sync_initialized.load(std::memory_order_relaxed) != 0) {
+    printf("  time    offset %.6f s  rtt %.3f ms\n",
+           (double) segment.time_offset_ns.load(std::memory_order_relaxed) * 1e-9,
+           (double) segment.time_sync_rtt_ns.load(std::memory_order_relaxed) * 1e-6);
+  } else {
+    printf("  time    not synchronized\n");
+  }
+
+  int32_t total = segment.params_total.load(std::memory_order_relaxed);
+  printf("  params  %d/%d received  %u unsaved  %u pending sets\n",
+         segment.params_received.load(std::memory_order_relaxed), total,
+         segment.params_unsaved.load(std::memory_order_relaxed),
+         segment.param_set_queue_depth.load(std::memory_order_relaxed));
+
+  std::vector<std::pair<double, size_t>> msg_rates;
+  for (size_t i = 0; i < NUM_MSG_IDS; i++) {
+    double r = rate(now.rx_msg_count[i], prev.rx_msg_count[i], dt);
+    if (r > 0.0) {
+      msg_rates.emplace_back(r, i);
+    }
+  }
+  std::sort(msg_rates.rbegin(), msg_rates.rend());
+  printf("  msgid  ");
+  for (size_t i = 0; i < msg_rates.size() && i < TOP_MSG_IDS; i++) {
+    printf(" %3zu:%6.0f/s", msg_rates[i].second, msg_rates[i].first);
+  }
+  printf("\n");
+}
+
+void print_sil(const LiveStatsSegment & segment, const Snapshot & now, const Snapshot & prev,
+               double dt)
+{
+  printf("  steps   %8.0f /s   real time factor %.3f\n", rate(now.sil_steps, prev.sil_steps, dt),
+         (double) segment.sil_real_time_factor_ppm.load(std::memory_order_relaxed) * 1e-6);
+  printf("  %-10s %10s %10s %10s\n", "stage", "p50 (us)", "p99 (us)", "max (us)");
+  for (size_t i = 0; i < mavrosflight::LIVE_STATS_SIL_STAGES; i++) {
+    printf("  %-10s %10.1f %10.1f %10.1f\n", mavrosflight::LIVE_STATS_SIL_STAGE_NAMES[i],
+           (double) segment.sil_stage_p50_ns[i].load(std::memory_order_relaxed) * 1e-3,
+           (double) segment.sil_stage_p99_ns[i].load(std::memory_order_relaxed) * 1e-3,
+           (double) segment.sil_stage_max_ns[i].load(std::memory_order_relaxed) * 1e-3);
+  }
+}
+
+void print_usage(const char * program)
+{
+  printf("Usage: %s [-d seconds] [-1] [filter]\n"
+         "  -d seconds  refresh interval (default 1.0)\n"
+         "  -1          print one refresh and exit\n"
+         "  filter      only show segments whose node name contains this string\n",
+         program);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  double interval = 1.0;
+  bool once = false;
+  std::string filter;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "d:1h")) != -1) {
+    switch (opt) {
+      case 'd':
+        interval = std::atof(optarg);
+        break;
+      case '1':
+        once = true;
+        break;
+      default:
+        print_usage(argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (optind < argc) {
+    filter = argv[optind];
+  }
+  if (interval <= 0.0) {
+    interval = 1.0;
+  }
+
+  std::map<std::string, Entry> entries;
+  bool priming = once;
+  while (true) {
+    // Attach to new segments and forget segments that have been removed
+    std::vector<std::string> names = LiveStatsReader::list();
+    for (auto it = entries.begin(); it != entries.end();) {
+      if (std::find(names.begin(), names.end(), it->first) == names.end()) {
+        it = entries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    std::vector<std::string> errors;
+    for (const std::string & name : names) {
+      if (entries.count(name) != 0) {
+        continue;
+      }
+      auto reader = std::make_unique<LiveStatsReader>();
+      std::string error;
+      if (reader->attach(name, &error)) {
+        entries[name].reader = std::move(reader);
+      } else {
+        errors.push_back(name + ": " + error);
+      }
+    }
+
+    // With -1, take a first snapshot silently so the single refresh can show rates
+    if (priming) {
+      for (auto & [name, entry] : entries) {
+        entry.previous = take_snapshot(*entry.reader->segment());
+        entry.has_previous = true;
+      }
+      priming = false;
+      std::this_thread::sleep_for(std::chrono::duration<double>(interval));
+      continue;
+    }
+
+    if (!once) {
+      printf("\033[H\033[2J");
+    }
+    printf("rosflight_top - %zu segment(s)\n", entries.size());
+    for (const std::string & error : errors) {
+      printf("  skipped %s\n", error.c_str());
+    }
+
+    for (auto & [name, entry] : entries) {
+      const LiveStatsSegment & segment = *entry.reader->segment();
+      if (!filter.empty() && std::strstr(segment.name, filter.c_str()) == nullptr) {
+        continue;
+      }
+
+      Snapshot now = take_snapshot(segment);
+      double age =
+        (double) (now.time_ns - segment.last_update_ns.load(std::memory_order_relaxed)) * 1e-9;
+      const char * state = entry.reader->owner_alive() ? "" : "  [STALE: owner exited]";
+      printf("\n%s (pid %d, updated %.1f s ago)%s\n", segment.name, segment.pid, age, state);
+
+      // The first refresh has nothing to compare against, so it shows totals as zero rates
+      const Snapshot & prev = entry.has_previous ? entry.previous : now;
+      double dt = (double) (now.time_ns - prev.time_ns) * 1e-9;
+      if (segment.kind == mavrosflight::LIVE_STATS_KIND_IO) {
+        print_io(segment, now, prev, dt);
+      } else if (segment.kind == mavrosflight::LIVE_STATS_KIND_SIL) {
+        print_sil(segment, now, prev, dt);
+      }
+      entry.previous = now;
+      entry.has_previous = true;
+    }
+    fflush(stdout);
+
+    if (once) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(interval));
+  }
+
+  return 0;
+}
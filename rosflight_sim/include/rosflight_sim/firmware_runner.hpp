@@ -0,0 +1,121 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSFLIGHT_SIM_FIRMWARE_RUNNER_H
+#define ROSFLIGHT_SIM_FIRMWARE_RUNNER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <rosflight_io/mavrosflight/loopback_pipe.hpp>
+#include <rosflight_sim/synthetic_board.hpp>
+
+namespace rosflight_sim
+{
+/**
+ * @brief Runs the ROSflight firmware on a SyntheticBoard in a background thread.
+ *
+ * The firmware and its MAVLink headers stay inside firmware_runner.cpp, so this header can be
+ * included in the same translation unit as rosflight_io, which ships its own MAVLink headers.
+ */
+class FirmwareRunner
+{
+public:
+  /**
+   * @brief Creates and initializes the firmware
+   *
+   * @param pipe Loopback pipe the firmware talks over
+   * @param imu_rate_hz Rate of the synthetic IMU
+   */
+  explicit FirmwareRunner(mavrosflight::LoopbackPipe & pipe, double imu_rate_hz = 1000);
+  ~FirmwareRunner();
+
+  /**
+   * @brief Sets an integer firmware parameter by name. Only call this before start().
+   * @return True if the parameter exists
+   */
+  bool set_param(const std::string & name, int32_t value);
+
+  /**
+   * @brief Sets a float firmware parameter by name. Only call this before start().
+   * @return True if the parameter exists
+   */
+  bool set_param_float(const std::string & name, float value);
+
+  /**
+   * @brief Writes the firmware parameters to the board's memory, see SyntheticBoard::memory().
+   * Only call this before start().
+   * @return True if the firmware wrote the parameters
+   */
+  bool write_params();
+
+  /**
+   * @brief Starts calling the firmware's main loop in a background thread
+   */
+  void start();
+
+  /**
+   * @brief Stops the background thread
+   */
+  void stop();
+
+  /**
+   * @brief Whether the firmware is currently armed
+   */
+  bool armed() const { return armed_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Number of main loop iterations run so far
+   */
+  uint64_t loops() const { return loops_.load(std::memory_order_relaxed); }
+
+  SyntheticBoard & board() { return board_; }
+
+private:
+  struct Firmware;
+
+  void run();
+
+  SyntheticBoard board_;
+  std::unique_ptr<Firmware> firmware_;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> loops_{0};
+  std::atomic<bool> armed_{false};
+};
+
+} // namespace rosflight_sim
+
+#endif // ROSFLIGHT_SIM_FIRMWARE_RUNNER_H
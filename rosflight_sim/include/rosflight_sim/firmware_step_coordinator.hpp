@@ -0,0 +1,124 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSFLIGHT_SIM_FIRMWARE_STEP_COORDINATOR_H
+#define ROSFLIGHT_SIM_FIRMWARE_STEP_COORDINATOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gazebo/common/Events.hh>
+#include <gazebo/physics/physics.hh>
+
+#include <rosflight_sim/work_stealing_pool.hpp>
+
+namespace rosflight_sim
+{
+/**
+ * @brief Steps the firmware of every vehicle in a world in parallel.
+ *
+ * Gazebo calls the update of each vehicle's plugin one after another, so with several vehicles the
+ * firmware time adds up. The coordinator hooks the world update before any vehicle that uses it, so
+ * every step it first captures the state of all vehicles and then runs all their firmware on a
+ * WorkStealingPool. The vehicles' own updates then only apply the resulting forces.
+ *
+ * There is one coordinator per world, shared by its vehicles. It must be created before the first
+ * vehicle connects to the world update, so that its own update runs first.
+ */
+class FirmwareStepCoordinator
+{
+public:
+  /**
+   * @brief Gets the coordinator of a world, creating it if needed.
+   *
+   * @param world World the vehicles are in
+   * @param num_threads Threads used to step the firmware if the coordinator is created. Zero uses
+   * one per hardware thread.
+   */
+  static std::shared_ptr<FirmwareStepCoordinator> get(gazebo::physics::WorldPtr world,
+                                                      size_t num_threads);
+
+  ~FirmwareStepCoordinator();
+
+  /**
+   * @brief Adds a vehicle.
+   *
+   * @param capture Called on the Gazebo update thread at the start of each step, one vehicle at a
+   * time, to capture the vehicle's state
+   * @param step Runs the vehicle's firmware. Called in parallel with other vehicles' steps.
+   * @return Id to pass to remove_vehicle
+   */
+  int add_vehicle(std::function<void()> capture, std::function<void()> step);
+  void remove_vehicle(int id);
+
+private:
+  struct Vehicle
+  {
+    std::function<void()> capture;
+    std::function<void()> step;
+    std::chrono::nanoseconds step_time{0};
+  };
+
+  FirmwareStepCoordinator(const std::string & world_name, size_t num_threads);
+
+  void on_update();
+  void report();
+
+  /// How often the achieved speedup is logged
+  static constexpr std::chrono::seconds REPORT_PERIOD{10};
+
+  std::string world_name_;
+  WorkStealingPool pool_;
+  gazebo::event::ConnectionPtr update_connection_;
+
+  std::mutex mutex_;
+  std::map<int, Vehicle> vehicles_;
+  std::vector<Vehicle *> stepping_;
+  int next_id_ = 0;
+
+  // Since the last report: wall time of the parallel section, and the firmware time it contained
+  std::chrono::steady_clock::time_point last_report_;
+  std::chrono::nanoseconds parallel_time_{0};
+  std::chrono::nanoseconds firmware_time_{0};
+  uint64_t steps_ = 0;
+};
+
+} // namespace rosflight_sim
+
+#endif // ROSFLIGHT_SIM_FIRMWARE_STEP_COORDINATOR_H
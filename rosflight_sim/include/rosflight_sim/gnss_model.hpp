@@ -0,0 +1,119 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSFLIGHT_SIM_GNSS_MODEL_H
+#define ROSFLIGHT_SIM_GNSS_MODEL_H
+
+#include <eigen3/Eigen/Core>
+
+namespace rosflight_sim
+{
+/**
+ * @brief Local-tangent-plane GNSS model. Everything that depends only on the origin (the origin in
+ * ECEF, the local-to-ECEF rotation and the WGS84 radii of curvature) is computed once in
+ * set_origin(), so each fix costs one matrix-vector product for ECEF and a handful of multiplies
+ * for LLA.
+ *
+ * ECEF position and velocity are exact, since the tangent plane is an affine map of ECEF. LLA uses
+ * a second-order closed-form expansion about the origin. Compared against an exact
+ * ECEF-to-geodetic conversion, for points within 3 km of the origin altitude and latitudes up to
+ * 70 deg, the horizontal error is about 1.3 cm within 5 km of the origin and 8 cm within 10 km,
+ * and the vertical error stays below 4 mm. test/gnss_model_test.cpp holds both under 5% of the
+ * default GNSS noise within 5 km and under 10% within 10 km. The error grows with the cube of the
+ * distance, so the exact path should be used for flights much larger than that.
+ *
+ * The local frame is NWU, which matches the Gazebo world frame used by the rest of the sim.
+ */
+class GNSSModel
+{
+public:
+  /**
+   * @brief Position of a fix, in the formats reported by the GNSS receiver.
+   */
+  struct Fix
+  {
+    Eigen::Vector3d lla;      // latitude (rad), longitude (rad), height above ellipsoid (m)
+    Eigen::Vector3d ecef_pos; // (m)
+    Eigen::Vector3d ecef_vel; // (m/s)
+  };
+
+  /**
+   * @brief Precomputes the origin dependent terms of the model.
+   *
+   * @param latitude Latitude of the local origin (rad)
+   * @param longitude Longitude of the local origin (rad)
+   * @param altitude Height of the local origin above the WGS84 ellipsoid (m)
+   */
+  void set_origin(double latitude, double longitude, double altitude);
+
+  /**
+   * @brief Converts a local position and velocity into a GNSS fix.
+   *
+   * @param pos_NWU Position relative to the origin, in the local NWU frame (m)
+   * @param vel_NWU Velocity in the local NWU frame (m/s)
+   * @return GNSS fix
+   */
+  Fix compute_fix(const Eigen::Vector3d & pos_NWU, const Eigen::Vector3d & vel_NWU) const;
+
+  /**
+   * @brief Converts a geodetic position to ECEF on the WGS84 ellipsoid.
+   *
+   * @param latitude Latitude (rad)
+   * @param longitude Longitude (rad)
+   * @param altitude Height above the ellipsoid (m)
+   * @return ECEF position (m)
+   */
+  static Eigen::Vector3d lla_to_ecef(double latitude, double longitude, double altitude);
+
+private:
+  static constexpr double WGS84_A = 6378137.0;
+  static constexpr double WGS84_F = 1.0 / 298.257223563;
+  static constexpr double WGS84_E2 = WGS84_F * (2.0 - WGS84_F);
+
+  double origin_latitude_ = 0;
+  double origin_longitude_ = 0;
+  double origin_altitude_ = 0;
+  Eigen::Vector3d origin_ecef_ = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d R_NWU_to_ECEF_ = Eigen::Matrix3d::Identity();
+
+  // Coefficients of the LLA expansion, see set_origin()
+  double inv_meridian_radius_ = 0;   // 1 / (M + h0)
+  double inv_transverse_radius_ = 0; // 1 / (N + h0)
+  double inv_parallel_radius_ = 0;   // 1 / ((N + h0) cos(lat0))
+  double tan_latitude_ = 0;
+  double meridian_curvature_rate_ = 0;
+};
+
+} // namespace rosflight_sim
+
+#endif // ROSFLIGHT_SIM_GNSS_MODEL_H
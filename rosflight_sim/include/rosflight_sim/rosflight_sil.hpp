@@ -35,10 +35,17 @@
 #ifndef ROSFLIGHT_SIM_ROSFLIGHT_SIL_H
 #define ROSFLIGHT_SIM_ROSFLIGHT_SIL_H
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
 #include <gazebo/common/Plugin.hh>
 #include <gazebo/common/common.hh>
 #include <gazebo/gazebo.hh>
 #include <gazebo/physics/physics.hh>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
 #include <gazebo_ros/node.hpp>
 #include <geometry_msgs/msg/vector3.hpp>
 #include <nav_msgs/msg/odometry.hpp>
@@ -46,13 +53,16 @@
 
 #include <mavlink/mavlink.h>
 #include <rosflight.h>
+#include <rosflight_io/loop_time_monitor.hpp>
 #include <rosflight_sim/sil_board.hpp>
 
 #include <rosflight_sim/fixedwing_forces_and_moments.hpp>
 #include <rosflight_sim/mav_forces_and_moments.hpp>
 #include <rosflight_sim/multirotor_forces_and_moments.hpp>
 
+#include <rosflight_sim/firmware_step_coordinator.hpp>
 #include <rosflight_sim/gz_compat.hpp>
+#include <rosflight_sim/sil_profiler.hpp>
 
 namespace rosflight_sim
 {
@@ -72,6 +82,9 @@ public:
 protected:
   /**
    * @brief Determines what should happen when the reset action is called within Gazebo.
+   *
+   * Moves the vehicle back to its initial pose. When pipelined, also drops the step in flight and
+   * restarts the pipeline from step 1.
    */
   void Reset() override;
   /**
@@ -91,6 +104,34 @@ private:
    * Gazebo.
    */
   void publish_truth();
+  /**
+   * @brief Runs the firmware in pipelined mode, one Gazebo step behind the update thread.
+   */
+  void firmware_thread();
+  /**
+   * @brief Clears the pipeline buffers and step counters, and starts the firmware thread.
+   */
+  void start_pipeline();
+  /**
+   * @brief Stops the firmware thread, once it finishes the step it is on.
+   */
+  void stop_pipeline();
+  /**
+   * @brief Hands the state of this step to the firmware thread and returns the outputs the firmware
+   * computed from the previous step. Waits if the firmware hasn't finished the previous step yet.
+   *
+   * @param state Gazebo state at the start of this step
+   * @return Actuator outputs to apply during this step
+   */
+  const int * pipeline_exchange(const SILBoard::PhysicsState & state);
+  /**
+   * @brief Runs the firmware for one Gazebo step, and adds its wall time to the loop time monitor.
+   */
+  void run_firmware();
+  /**
+   * @brief Publishes the firmware step time percentiles and overruns on "diagnostics".
+   */
+  void publish_loop_time();
 
   rclcpp::Node::SharedPtr node_;
 
@@ -114,6 +155,30 @@ private:
 
   MAVForcesAndMoments * mav_dynamics_;
 
+  std::unique_ptr<SILProfiler> profiler_;
+
+  // Wall time of the firmware steps. The firmware's own loop time uses the simulated clock, which
+  // doesn't advance during a step, so it can't show how long the firmware actually takes.
+  std::unique_ptr<rosflight_io::LoopTimeMonitor> loop_time_monitor_;
+  std::atomic<bool> loop_time_overrun_{false};
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub_;
+  rclcpp::TimerBase::SharedPtr loop_time_timer_;
+
+  // Pipelined mode. Slots are double buffered by step parity, so the update thread can fill in the
+  // next step while the firmware thread is still reading the current one.
+  bool pipelined_ = false;
+  std::thread firmware_thread_;
+  std::atomic<bool> pipeline_running_{false};
+  SILBoard::PhysicsState state_slots_[2];
+  std::array<int, SILBoard::NUM_PWM_OUTPUTS> output_slots_[2]{};
+  std::atomic<uint64_t> published_step_{0}; // last step handed to the firmware thread
+  std::atomic<uint64_t> completed_step_{0}; // last step the firmware thread has finished
+  uint64_t step_ = 0;
+
+  // Parallel mode: the world's coordinator runs this vehicle's firmware alongside the others
+  std::shared_ptr<FirmwareStepCoordinator> coordinator_;
+  int coordinator_id_ = -1;
+
   // container for forces
   Eigen::Matrix<double, 6, 1> forces_, applied_forces_;
 
@@ -51,7 +51,9 @@
 #include <rosflight_msgs/msg/detail/gnss_full__struct.hpp>
 #include <rosflight_msgs/msg/rc_raw.hpp>
 
+#include <rosflight_sim/gnss_model.hpp>
 #include <rosflight_sim/gz_compat.hpp>
+#include <rosflight_sim/sil_profiler.hpp>
 #include <rosflight_sim/udp_board.hpp>
 
 namespace rosflight_sim
@@ -63,6 +65,23 @@ namespace rosflight_sim
  */
 class SILBoard : public UDPBoard
 {
+public:
+  static constexpr int NUM_PWM_OUTPUTS = 14; // assumes maximum of 14 channels
+
+  /**
+   * @brief Gazebo state the simulated sensors are computed from. The firmware only sees the state
+   * most recently passed to set_state, so it can run on a different thread than Gazebo.
+   */
+  struct PhysicsState
+  {
+    gazebo::common::Time sim_time;
+    GazeboPose world_pose;
+    GazeboVector relative_linear_vel;
+    GazeboVector world_linear_vel;
+    GazeboVector world_linear_accel;
+    GazeboVector relative_angular_vel;
+  };
+
 private:
   GazeboVector inertial_magnetic_field_;
 
@@ -108,6 +127,12 @@ private:
   double horizontal_gps_stdev_ = 0;
   double vertical_gps_stdev_ = 0;
   double gps_velocity_stdev_ = 0;
+  double horizontal_gps_walk_stdev_ = 0;
+  double vertical_gps_walk_stdev_ = 0;
+
+  bool gnss_exact_ = false;
+  GNSSModel gnss_model_;
+  Eigen::Vector3d gnss_walk_ = Eigen::Vector3d::Zero();
 
   double f_x = 0;
   double f_y = 0;
@@ -141,7 +166,11 @@ private:
   rclcpp::Time last_rc_message_;
 
   std::string mav_type_;
-  int pwm_outputs_[14] = {0}; // assumes maximum of 14 channels
+  int pwm_outputs_[NUM_PWM_OUTPUTS] = {0};
+
+  SILProfiler * profiler_ = nullptr;
+
+  PhysicsState state_;
 
   // Time variables
   gazebo::common::Time boot_time_;
@@ -236,6 +265,10 @@ public:
    * @return true if bytes are ready.
    */
   uint16_t serial_bytes_available() override;
+  /**
+   * @brief Writes to the UDP link. Overriden to time the write when profiling is enabled.
+   */
+  void serial_write(const uint8_t * src, size_t len, uint8_t qos) override;
 
   // sensors
   /**
@@ -415,7 +448,8 @@ public:
    */
   void memory_init() override{};
   /**
-   * @brief Reads data from memory file.
+   * @brief Reads data from memory file. If there is none yet, reads the memory image given by the
+   * memory_image parameter instead, if it is set.
    *
    * @param dest Memory location to read from (?)
    * @param len Length of memory to read (?)
@@ -556,6 +590,23 @@ public:
                     gazebo::physics::ModelPtr model, rclcpp::Node::SharedPtr node,
                     std::string mav_type);
   inline const int * get_outputs() const { return pwm_outputs_; }
+  /**
+   * @brief Reads the current state of the link from Gazebo. Must be called from the Gazebo update
+   * thread.
+   */
+  PhysicsState capture_state() const;
+  /**
+   * @brief Sets the state used by the sensors and the clock on the next firmware run.
+   *
+   * @param state State captured by capture_state
+   */
+  void set_state(const PhysicsState & state) { state_ = state; }
+  /**
+   * @brief Sets the profiler used to time sensor reads and serial I/O.
+   *
+   * @param profiler Profiler owned by the SIL plugin, or nullptr to disable profiling.
+   */
+  void set_profiler(SILProfiler * profiler) { profiler_ = profiler; }
   gazebo::common::SphericalCoordinates sph_coord_;
 };
 
@@ -0,0 +1,173 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSFLIGHT_SIM_SIL_PROFILER_H
+#define ROSFLIGHT_SIM_SIL_PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+#include <rclcpp/rclcpp.hpp>
+#include <rosflight_io/mavrosflight/live_stats.hpp>
+
+namespace rosflight_sim
+{
+class TraceWriter;
+
+/**
+ * @brief Low overhead timing of the SIL update loop. Time spent in each stage is accumulated over
+ * a Gazebo step, stored in a fixed size window of samples, and periodically reduced to
+ * percentiles and the achieved real-time factor, which are published as diagnostics. Optionally
+ * writes every timed section to a Chrome/Perfetto trace file (JSON trace event format). Vehicles
+ * in the same process share the trace file, each on its own track. The same statistics are also
+ * written to a shared-memory segment that rosflight_top can display.
+ *
+ * Stages can nest: the sensor reads and the UDP I/O happen inside the firmware stage, so the
+ * firmware time includes them.
+ *
+ * All methods must be called from the Gazebo update thread.
+ */
+class SILProfiler
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  enum Stage
+  {
+    FIRMWARE,
+    SENSORS,
+    COMM,
+    DYNAMICS,
+    TRUTH,
+    NUM_STAGES
+  };
+
+  /**
+   * @brief RAII timer for one section of a stage. Does nothing if the profiler is null, so the
+   * instrumented code doesn't need to check whether profiling is enabled.
+   */
+  class Scope
+  {
+  public:
+    Scope(SILProfiler * profiler, Stage stage)
+        : profiler_(profiler)
+        , stage_(stage)
+    {
+      if (profiler_ != nullptr) {
+        start_ = Clock::now();
+      }
+    }
+    ~Scope()
+    {
+      if (profiler_ != nullptr) {
+        profiler_->add_section(stage_, start_, Clock::now());
+      }
+    }
+    Scope(const Scope &) = delete;
+    Scope & operator=(const Scope &) = delete;
+
+  private:
+    SILProfiler * profiler_;
+    Stage stage_;
+    Clock::time_point start_;
+  };
+
+  /**
+   * @brief Creates the profiler and its diagnostics publisher. Reads the sil_profile_* params.
+   *
+   * @param node ROS node of the SIL plugin
+   */
+  explicit SILProfiler(rclcpp::Node::SharedPtr node);
+  ~SILProfiler();
+
+  /**
+   * @brief Marks the start of a Gazebo step.
+   */
+  void begin_step();
+  /**
+   * @brief Marks the end of a Gazebo step. Publishes a report if the report period has elapsed.
+   *
+   * @param sim_time Simulation time at this step (s)
+   */
+  void end_step(double sim_time);
+  /**
+   * @brief Adds a timed section to the current step.
+   */
+  void add_section(Stage stage, Clock::time_point start, Clock::time_point end);
+
+  static const char * stage_name(Stage stage);
+
+private:
+  struct TraceEvent
+  {
+    Stage stage;
+    int64_t start_ns;
+    int64_t duration_ns;
+  };
+
+  void publish_report(Clock::time_point now, double sim_time);
+  void flush_trace();
+
+  rclcpp::Node::SharedPtr node_;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr profile_pub_;
+
+  // Per step totals, in nanoseconds. Index NUM_STAGES holds the whole step.
+  std::array<int64_t, NUM_STAGES + 1> step_ns_{};
+  std::array<std::vector<int64_t>, NUM_STAGES + 1> samples_;
+  std::vector<int64_t> scratch_;
+  size_t window_size_ = 0;
+  size_t num_samples_ = 0;
+  size_t next_sample_ = 0;
+
+  Clock::time_point step_start_;
+  Clock::time_point last_report_time_;
+  Clock::duration report_period_;
+  double last_report_sim_time_ = -1.0;
+  uint64_t steps_since_report_ = 0;
+  int64_t busy_ns_ = 0;
+
+  std::shared_ptr<TraceWriter> trace_; //!< shared by the profilers writing to the same file
+  std::vector<TraceEvent> trace_events_;
+  int trace_tid_ = 0;
+
+  mavrosflight::LiveStats live_stats_;
+};
+
+} // namespace rosflight_sim
+
+#endif // ROSFLIGHT_SIM_SIL_PROFILER_H
@@ -0,0 +1,203 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSFLIGHT_SIM_SYNTHETIC_BOARD_H
+#define ROSFLIGHT_SIM_SYNTHETIC_BOARD_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "board.h"
+
+#include <rosflight_io/mavrosflight/loopback_pipe.hpp>
+
+namespace rosflight_sim
+{
+/**
+ * @brief ROSflight firmware board with synthetic sensors and no physics. The vehicle sits level
+ * and still, the clock is the host's steady clock, and the serial port is the flight controller
+ * end of an in-memory loopback pipe. Used to run the firmware against rosflight_io without Gazebo.
+ *
+ * RC inputs and PWM outputs are thread safe, so another thread can drive the sticks and watch the
+ * actuators while the firmware runs.
+ */
+class SyntheticBoard : public rosflight_firmware::Board
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t NUM_RC_CHANNELS = 8;
+  static constexpr size_t NUM_PWM_CHANNELS = 14;
+
+  /**
+   * @brief Creates the board
+   *
+   * @param pipe Loopback pipe used as the serial port
+   * @param imu_rate_hz Rate at which the synthetic IMU produces samples
+   */
+  explicit SyntheticBoard(mavrosflight::LoopbackPipe & pipe, double imu_rate_hz = 1000);
+
+  /**
+   * @brief Sets an RC channel, in the normalized [0, 1] range returned by rc_read
+   */
+  void set_rc(uint8_t channel, float value);
+
+  /**
+   * @brief Last value written to a PWM channel by the firmware, in the range passed to pwm_write
+   */
+  float output(uint8_t channel) const;
+
+  /**
+   * @brief Time at which any PWM channel last changed value, or the clock's epoch if none has
+   */
+  Clock::time_point last_output_change() const;
+
+  /**
+   * @brief Number of IMU samples handed to the firmware
+   */
+  uint64_t imu_samples() const { return imu_samples_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Contents of the non-volatile memory, as last written by the firmware
+   */
+  const std::vector<uint8_t> & memory() const { return memory_; }
+
+  // setup
+  void init_board() override;
+  void board_reset(bool bootloader) override {}
+
+  // clock
+  uint32_t clock_millis() override;
+  uint64_t clock_micros() override;
+  void clock_delay(uint32_t milliseconds) override;
+
+  // serial
+  void serial_init(uint32_t baud_rate, uint32_t dev) override {}
+  void serial_write(const uint8_t * src, size_t len, uint8_t qos) override;
+  uint16_t serial_bytes_available() override;
+  uint8_t serial_read() override;
+  void serial_flush() override {}
+
+  // sensors
+  void sensors_init() override {}
+  uint16_t num_sensor_errors() override { return 0; }
+
+  bool imu_has_new_data() override;
+  bool imu_read(float accel[3], float * temperature, float gyro[3], uint64_t * time_us) override;
+  void imu_not_responding_error() override {}
+
+  bool mag_present() override { return false; }
+  bool mag_read(float mag[3]) override { return false; }
+  bool mag_has_new_data() override { return false; }
+
+  bool baro_present() override { return false; }
+  bool baro_read(float * pressure, float * temperature) override { return false; }
+  bool baro_has_new_data() override { return false; }
+
+  bool diff_pressure_present() override { return false; }
+  bool diff_pressure_read(float * diff_pressure, float * temperature) override { return false; }
+  bool diff_pressure_has_new_data() override { return false; }
+
+  bool sonar_present() override { return false; }
+  bool sonar_read(float * range) override { return false; }
+  bool sonar_has_new_data() override { return false; }
+
+  bool gnss_present() override { return false; }
+  bool gnss_read(rosflight_firmware::GNSSData * gnss,
+                 rosflight_firmware::GNSSFull * gnss_full) override
+  {
+    return false;
+  }
+  bool gnss_has_new_data() override { return false; }
+
+  bool battery_present() override { return false; }
+  bool battery_has_new_data() override { return false; }
+  bool battery_read(float * voltage, float * current) override { return false; }
+  void battery_voltage_set_multiplier(double multiplier) override {}
+  void battery_current_set_multiplier(double multiplier) override {}
+
+  // PWM
+  void pwm_init(uint32_t refresh_rate, uint16_t idle_pwm) override;
+  void pwm_write(uint8_t channel, float value) override;
+  void pwm_disable() override;
+
+  // RC
+  float rc_read(uint8_t chan) override;
+  void rc_init(rc_type_t rc_type) override {}
+  bool rc_lost() override { return false; }
+  bool rc_has_new_data() override;
+
+  // non-volatile memory, kept in RAM so every run starts from default parameters
+  void memory_init() override {}
+  bool memory_read(void * dest, size_t len) override;
+  bool memory_write(const void * src, size_t len) override;
+
+  // LEDs
+  void led0_on() override {}
+  void led0_off() override {}
+  void led0_toggle() override {}
+  void led1_on() override {}
+  void led1_off() override {}
+  void led1_toggle() override {}
+
+  // backup memory
+  void backup_memory_init() override {}
+  bool backup_memory_read(void * dest, size_t len) override { return false; }
+  void backup_memory_write(const void * src, size_t len) override {}
+  void backup_memory_clear(size_t len) override {}
+
+private:
+  static constexpr uint64_t RC_UPDATE_PERIOD_US = 20000;
+
+  mavrosflight::LoopbackPipe & pipe_;
+  Clock::time_point boot_time_;
+
+  uint64_t imu_update_period_us_;
+  uint64_t next_imu_update_time_us_ = 0;
+  uint64_t next_rc_update_time_us_ = 0;
+  std::atomic<uint64_t> imu_samples_{0};
+
+  std::array<std::atomic<float>, NUM_RC_CHANNELS> rc_values_;
+  std::array<std::atomic<float>, NUM_PWM_CHANNELS> pwm_outputs_;
+  std::atomic<Clock::rep> last_output_change_{0};
+
+  std::vector<uint8_t> memory_;
+};
+
+} // namespace rosflight_sim
+
+#endif // ROSFLIGHT_SIM_SYNTHETIC_BOARD_H
@@ -0,0 +1,105 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSFLIGHT_SIM_WORK_STEALING_POOL_H
+#define ROSFLIGHT_SIM_WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rosflight_sim
+{
+/**
+ * @brief Fixed-size thread pool for running a batch of independent tasks and waiting for all of
+ * them.
+ *
+ * Each batch is split into one contiguous range of task indices per thread. A thread works through
+ * its own range first, then steals what is left of the others', so one slow task doesn't leave the
+ * other threads idle. The calling thread takes part as the first worker.
+ */
+class WorkStealingPool
+{
+public:
+  /**
+   * @brief Starts the pool.
+   *
+   * @param num_threads Number of threads working on each batch, including the calling thread. Zero
+   * uses one per hardware thread.
+   */
+  explicit WorkStealingPool(size_t num_threads);
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool & operator=(const WorkStealingPool &) = delete;
+
+  /**
+   * @brief Runs task(i) for every i in [0, count) and returns once all of them have finished.
+   * Must not be called from more than one thread at a time.
+   */
+  void run(size_t count, const std::function<void(size_t)> & task);
+
+  size_t num_threads() const { return num_queues_; }
+
+private:
+  struct alignas(64) Queue
+  {
+    std::atomic<size_t> next{0};
+    size_t end = 0;
+  };
+
+  void worker(size_t index);
+  void drain(size_t index);
+
+  size_t num_queues_;
+  std::unique_ptr<Queue[]> queues_;
+  const std::function<void(size_t)> * task_ = nullptr;
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  uint64_t batch_ = 0;
+  size_t busy_workers_ = 0;
+  bool stop_ = false;
+};
+
+} // namespace rosflight_sim
+
+#endif // ROSFLIGHT_SIM_WORK_STEALING_POOL_H
@@ -17,45 +17,21 @@ from launch.substitutions import FindExecutable
 def generate_launch_description():
     """Initialized rosflight firmware for flying a fixedwing UAV in the sim"""
 
-    # Call load parameter file service
-    param_load_service_exec = ExecuteProcess(
+    # Load the parameters, calibrate the IMU and write the parameters, each step waiting on the
+    # firmware's acknowledgement
+    provision_service_exec = ExecuteProcess(
         cmd=[[
             FindExecutable(name='ros2'),
             ' service call ',
-            '/param_load_from_file ',
-            'rosflight_msgs/srv/ParamFile ',
-            '"{filename: "' + os.path.join(
-                get_package_share_directory('rosflight_sim'), 'params/fixedwing_firmware.yaml"}'
-            ) + '"'
-        ]],
-        shell=True
-    )
-
-    # Call calibrate IMU service
-    imu_cal_service_exec = ExecuteProcess(
-        cmd=[[
-            FindExecutable(name='ros2'),
-            ' service call ',
-            '/calibrate_imu ',
-            'std_srvs/srv/Trigger '
-        ]],
-        shell=True
-    )
-
-    # Save params
-    write_params_service_exec = ExecuteProcess(
-        cmd=[[
-            'sleep 10 ; ',
-            FindExecutable(name='ros2'),
-            ' service call ',
-            '/param_write ',
-            'std_srvs/srv/Trigger '
+            '/provision ',
+            'rosflight_msgs/srv/Provision ',
+            '"{params_file: "' + os.path.join(
+                get_package_share_directory('rosflight_sim'), 'params/fixedwing_firmware.yaml"'
+            ) + ', calibrations: [imu]}"'
         ]],
         shell=True
     )
 
     return LaunchDescription([
-        param_load_service_exec,
-        imu_cal_service_exec,
-        write_params_service_exec
+        provision_service_exec
     ])
@@ -0,0 +1,298 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file alloc_check.cpp
+ *
+ * Checks that the steady-state hot paths do not allocate. The firmware runs on a SyntheticBoard
+ * and talks to an in-process ROSflightIO node over an in-memory loopback pipe, as in
+ * e2e_benchmark, while offboard commands are published at a fixed rate. After a warm-up, every
+ * allocation in the process is counted per thread over a number of windows. Allocations made
+ * inside a mavrosflight::HotPath scope (the MavlinkComm read and write paths, the rosflight_io
+ * message handlers and command callback, and the firmware step) fail the check, and their call
+ * stacks are printed so the code responsible can be found.
+ *
+ * Allocations outside the hot paths, e.g. by the ROS executor or the middleware, are reported
+ * per thread but do not fail the check.
+ */
+
+#include <getopt.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+#include <rosflight_msgs/msg/command.hpp>
+#include <sensor_msgs/msg/imu.hpp>
+
+#include <rosflight_io/alloc_tracker.hpp>
+#include <rosflight_io/mavrosflight/loopback_pipe.hpp>
+#include <rosflight_io/mavrosflight/mavlink_loopback.hpp>
+#include <rosflight_io/rosflight_io.hpp>
+#include <rosflight_sim/firmware_runner.hpp>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+using rosflight_io::AllocTracker;
+
+// RC channel used to arm the firmware
+constexpr uint8_t ARM_CHANNEL = 5;
+
+struct Options
+{
+  double warmup = 5.0;
+  double window = 1.0;
+  int windows = 5;
+  double imu_rate = 1000.0;
+  double command_rate = 50.0;
+  double startup_timeout = 20.0;
+};
+
+/**
+ * @brief Keeps rosflight_io's IMU publisher matched and publishes offboard commands
+ */
+class TrafficProbe : public rclcpp::Node
+{
+public:
+  TrafficProbe()
+      : Node("alloc_check")
+  {
+    imu_sub_ = this->create_subscription<sensor_msgs::msg::Imu>(
+      "imu/data", rclcpp::QoS(100), [this](const sensor_msgs::msg::Imu::ConstSharedPtr &) {
+        imu_count_.fetch_add(1, std::memory_order_relaxed);
+      });
+    command_pub_ = this->create_publisher<rosflight_msgs::msg::Command>("command", 1);
+  }
+
+  void publish_command(float value)
+  {
+    rosflight_msgs::msg::Command msg;
+    msg.header.stamp = this->now();
+    msg.mode = rosflight_msgs::msg::Command::MODE_PASS_THROUGH;
+    msg.ignore = rosflight_msgs::msg::Command::IGNORE_NONE;
+    msg.x = value;
+    msg.y = value;
+    msg.z = value;
+    msg.f = 0.0f;
+    command_pub_->publish(msg);
+  }
+
+  uint64_t imu_count() const { return imu_count_.load(std::memory_order_relaxed); }
+
+private:
+  rclcpp::Subscription<sensor_msgs::msg::Imu>::SharedPtr imu_sub_;
+  rclcpp::Publisher<rosflight_msgs::msg::Command>::SharedPtr command_pub_;
+  std::atomic<uint64_t> imu_count_{0};
+};
+
+template<typename Predicate>
+bool wait_for(Predicate predicate, double timeout_s)
+{
+  auto deadline = Clock::now() + std::chrono::duration<double>(timeout_s);
+  while (!predicate()) {
+    if (Clock::now() > deadline || !rclcpp::ok()) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return true;
+}
+
+/**
+ * @brief Publishes alternating offboard commands at the command rate for the given time
+ */
+void drive(TrafficProbe & probe, const Options & options, double seconds)
+{
+  auto period = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(1.0 / options.command_rate));
+  auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                              std::chrono::duration<double>(seconds));
+  bool positive = true;
+  for (auto next = Clock::now(); next < end && rclcpp::ok(); next += period) {
+    std::this_thread::sleep_until(next);
+    probe.publish_command(positive ? 0.25f : -0.25f);
+    positive = !positive;
+  }
+}
+
+void print_usage(const char * program)
+{
+  printf("Usage: %s [options]\n"
+         "  --warmup S                  time to run before counting (default 5)\n"
+         "  --window S                  length of each counting window (default 1)\n"
+         "  --windows N                 number of counting windows (default 5)\n"
+         "  --imu-rate R                synthetic IMU rate in Hz (default 1000)\n"
+         "  --command-rate R            offboard command rate in Hz (default 50)\n"
+         "  --startup-timeout S         time allowed for the link to come up (default 20)\n",
+         program);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  enum
+  {
+    OPT_WARMUP = 256,
+    OPT_WINDOW,
+    OPT_WINDOWS,
+    OPT_IMU_RATE,
+    OPT_COMMAND_RATE,
+    OPT_STARTUP_TIMEOUT
+  };
+  const option long_options[] = {
+    {"warmup", required_argument, nullptr, OPT_WARMUP},
+    {"window", required_argument, nullptr, OPT_WINDOW},
+    {"windows", required_argument, nullptr, OPT_WINDOWS},
+    {"imu-rate", required_argument, nullptr, OPT_IMU_RATE},
+    {"command-rate", required_argument, nullptr, OPT_COMMAND_RATE},
+    {"startup-timeout", required_argument, nullptr, OPT_STARTUP_TIMEOUT},
+    {"help", no_argument, nullptr, 'h'},
+    {nullptr, 0, nullptr, 0}};
+
+  // Let rclcpp strip its own arguments first
+  std::vector<std::string> args = rclcpp::init_and_remove_ros_arguments(argc, argv);
+  std::vector<char *> c_args;
+  for (auto & arg : args) { c_args.push_back(&arg[0]); }
+  c_args.push_back(nullptr);
+
+  Options options;
+  int opt;
+  while ((opt = getopt_long((int) args.size(), c_args.data(), "h", long_options, nullptr))
+         != -1) {
+    switch (opt) {
+      case OPT_WARMUP:
+        options.warmup = std::atof(optarg);
+        break;
+      case OPT_WINDOW:
+        options.window = std::atof(optarg);
+        break;
+      case OPT_WINDOWS:
+        options.windows = std::atoi(optarg);
+        break;
+      case OPT_IMU_RATE:
+        options.imu_rate = std::atof(optarg);
+        break;
+      case OPT_COMMAND_RATE:
+        options.command_rate = std::atof(optarg);
+        break;
+      case OPT_STARTUP_TIMEOUT:
+        options.startup_timeout = std::atof(optarg);
+        break;
+      default:
+        print_usage(argv[0]);
+        rclcpp::shutdown();
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (options.command_rate <= 0 || options.imu_rate <= 0 || options.window <= 0
+      || options.windows <= 0) {
+    fprintf(stderr, "--command-rate, --imu-rate, --window and --windows must be positive\n");
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  // Flight controller: fixed-wing passthrough, so offboard commands reach the mixer every step
+  mavrosflight::LoopbackPipe pipe;
+  rosflight_sim::FirmwareRunner firmware(pipe, options.imu_rate);
+  firmware.set_param("FIXED_WING", 1);
+  firmware.set_param("MIXER", 10);
+  firmware.set_param("ARM_CHANNEL", ARM_CHANNEL);
+  firmware.start();
+
+  // Ground station: the real rosflight_io node on the other end of the pipe
+  auto comm = std::make_unique<mavrosflight::MavlinkLoopback>(pipe);
+  auto io = std::make_shared<rosflight_io::ROSflightIO>(comm.get());
+  io->configure();
+  io->activate();
+  auto probe = std::make_shared<TrafficProbe>();
+
+  rclcpp::executors::MultiThreadedExecutor executor;
+  executor.add_node(io->get_node_base_interface());
+  executor.add_node(probe);
+  std::thread spin_thread([&executor]() { executor.spin(); });
+
+  int result = 0;
+  auto finish = [&]() {
+    executor.cancel();
+    spin_thread.join();
+    firmware.stop();
+    rclcpp::shutdown();
+    return result;
+  };
+
+  printf("Waiting for the link to come up...\n");
+  if (!wait_for([&]() { return probe->imu_count() > 0; }, options.startup_timeout)) {
+    fprintf(stderr, "No IMU messages from rosflight_io after %.0f s\n", options.startup_timeout);
+    result = 1;
+    return finish();
+  }
+
+  firmware.board().set_rc(ARM_CHANNEL, 1.0f);
+  if (!wait_for([&]() { return firmware.armed(); }, 5.0)) {
+    printf("Firmware did not arm, checking the disarmed paths\n");
+  }
+
+  // Warm up, so buffers, pools and lazily created publishers reach their steady-state size
+  printf("Warming up for %.1f s\n", options.warmup);
+  drive(*probe, options, options.warmup);
+
+  uint64_t hot_allocations = 0;
+  for (int i = 0; i < options.windows && rclcpp::ok(); i++) {
+    AllocTracker::start_window();
+    drive(*probe, options, options.window);
+    AllocTracker::Window window = AllocTracker::stop_window();
+
+    printf("\nWindow %d of %d, %.2f s, %lu hot path allocations\n", i + 1, options.windows,
+           window.seconds, (unsigned long) window.hot_allocations);
+    AllocTracker::print(window, stdout);
+    hot_allocations += window.hot_allocations;
+  }
+
+  if (hot_allocations > 0) {
+    fprintf(stderr, "\nFAIL: %lu allocations on the hot paths after warm-up\n",
+            (unsigned long) hot_allocations);
+    result = 1;
+  } else {
+    printf("\nPASS: no allocations on the hot paths after warm-up\n");
+  }
+
+  return finish();
+}
@@ -0,0 +1,386 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file e2e_benchmark.cpp
+ *
+ * End-to-end benchmark of rosflight_io against the ROSflight firmware, without Gazebo. The
+ * firmware runs on a SyntheticBoard and talks to an in-process ROSflightIO node over an in-memory
+ * loopback pipe, so the whole path from ROS topic to actuator and from sensor to ROS topic is
+ * exercised: MAVLink encoding and parsing on both sides, the firmware main loop and mixer, and
+ * the rosflight_io handlers and publishers.
+ *
+ * It measures:
+ *  - command to actuator latency: from publishing a Command to the firmware writing a changed PWM
+ *    output, using the passthrough fixed-wing mixer so servos follow offboard commands directly
+ *  - telemetry to publish latency: from the IMU sample time, as stamped by rosflight_io, to the
+ *    sensor_msgs/Imu message arriving at a subscriber
+ *  - telemetry throughput: IMU messages received per second and bytes per second on the link
+ *
+ * The exit code is nonzero if the link never comes up, no command reaches the actuators, or a
+ * latency limit given on the command line is exceeded, so it can gate CI.
+ */
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+#include <rosflight_msgs/msg/command.hpp>
+#include <sensor_msgs/msg/imu.hpp>
+
+#include <rosflight_io/mavrosflight/loopback_pipe.hpp>
+#include <rosflight_io/mavrosflight/mavlink_loopback.hpp>
+#include <rosflight_io/rosflight_io.hpp>
+#include <rosflight_sim/firmware_runner.hpp>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// RC channels used by the benchmark: arm switch high, override switches left low
+constexpr uint8_t ARM_CHANNEL = 5;
+constexpr uint8_t OVERRIDE_CHANNEL = 6;
+
+struct Options
+{
+  double duration = 10.0;
+  double imu_rate = 1000.0;
+  double command_rate = 50.0;
+  double startup_timeout = 20.0;
+  double max_command_latency_ms = 0.0;
+  double max_telemetry_latency_ms = 0.0;
+};
+
+double to_ms(Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); }
+
+double percentile(std::vector<double> & samples, double p)
+{
+  if (samples.empty()) {
+    return 0.0;
+  }
+  std::sort(samples.begin(), samples.end());
+  auto index = (size_t) (p / 100.0 * (double) (samples.size() - 1) + 0.5);
+  return samples[std::min(index, samples.size() - 1)];
+}
+
+void print_latency(const char * name, std::vector<double> & samples_ms)
+{
+  printf("%-22s n=%-7zu p50=%8.3f  p90=%8.3f  p99=%8.3f  max=%8.3f ms\n", name, samples_ms.size(),
+         percentile(samples_ms, 50), percentile(samples_ms, 90), percentile(samples_ms, 99),
+         percentile(samples_ms, 100));
+}
+
+/**
+ * @brief Subscribes to rosflight_io's IMU output and records how late each message arrives
+ */
+class TelemetryProbe : public rclcpp::Node
+{
+public:
+  TelemetryProbe()
+      : Node("e2e_benchmark")
+  {
+    imu_sub_ = this->create_subscription<sensor_msgs::msg::Imu>(
+      "imu/data", rclcpp::QoS(100),
+      std::bind(&TelemetryProbe::imu_callback, this, std::placeholders::_1));
+    command_pub_ = this->create_publisher<rosflight_msgs::msg::Command>("command", 1);
+  }
+
+  void publish_command(float value)
+  {
+    rosflight_msgs::msg::Command msg;
+    msg.header.stamp = this->now();
+    msg.mode = rosflight_msgs::msg::Command::MODE_PASS_THROUGH;
+    msg.ignore = rosflight_msgs::msg::Command::IGNORE_NONE;
+    msg.x = value;
+    msg.y = value;
+    msg.z = value;
+    msg.f = 0.0f;
+    command_pub_->publish(msg);
+  }
+
+  uint64_t imu_count() const { return imu_count_.load(std::memory_order_relaxed); }
+
+  void start_recording()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latencies_ms_.clear();
+    recording_ = true;
+  }
+
+  std::vector<double> stop_recording()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    recording_ = false;
+    return latencies_ms_;
+  }
+
+private:
+  void imu_callback(const sensor_msgs::msg::Imu::ConstSharedPtr & msg)
+  {
+    rclcpp::Time received = system_clock_.now();
+    imu_count_.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (recording_) {
+      rclcpp::Time stamp(msg->header.stamp, RCL_SYSTEM_TIME);
+      latencies_ms_.push_back((received - stamp).seconds() * 1e3);
+    }
+  }
+
+  rclcpp::Subscription<sensor_msgs::msg::Imu>::SharedPtr imu_sub_;
+  rclcpp::Publisher<rosflight_msgs::msg::Command>::SharedPtr command_pub_;
+  rclcpp::Clock system_clock_{RCL_SYSTEM_TIME};
+
+  std::atomic<uint64_t> imu_count_{0};
+  std::mutex mutex_;
+  bool recording_ = false;
+  std::vector<double> latencies_ms_;
+};
+
+template<typename Predicate>
+bool wait_for(Predicate predicate, double timeout_s)
+{
+  auto deadline = Clock::now() + std::chrono::duration<double>(timeout_s);
+  while (!predicate()) {
+    if (Clock::now() > deadline || !rclcpp::ok()) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return true;
+}
+
+void print_usage(const char * program)
+{
+  printf("Usage: %s [options]\n"
+         "  --duration S                measurement time (default 10)\n"
+         "  --imu-rate R                synthetic IMU rate in Hz (default 1000)\n"
+         "  --command-rate R            offboard command rate in Hz (default 50)\n"
+         "  --startup-timeout S         time allowed for the link to come up (default 20)\n"
+         "  --max-command-latency MS    fail if the p99 command latency exceeds MS\n"
+         "  --max-telemetry-latency MS  fail if the p99 telemetry latency exceeds MS\n",
+         program);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  enum
+  {
+    OPT_DURATION = 256,
+    OPT_IMU_RATE,
+    OPT_COMMAND_RATE,
+    OPT_STARTUP_TIMEOUT,
+    OPT_MAX_COMMAND_LATENCY,
+    OPT_MAX_TELEMETRY_LATENCY
+  };
+  const option long_options[] = {
+    {"duration", required_argument, nullptr, OPT_DURATION},
+    {"imu-rate", required_argument, nullptr, OPT_IMU_RATE},
+    {"command-rate", required_argument, nullptr, OPT_COMMAND_RATE},
+    {"startup-timeout", required_argument, nullptr, OPT_STARTUP_TIMEOUT},
+    {"max-command-latency", required_argument, nullptr, OPT_MAX_COMMAND_LATENCY},
+    {"max-telemetry-latency", required_argument, nullptr, OPT_MAX_TELEMETRY_LATENCY},
+    {"help", no_argument, nullptr, 'h'},
+    {nullptr, 0, nullptr, 0}};
+
+  // Let rclcpp strip its own arguments first
+  std::vector<std::string> args = rclcpp::init_and_remove_ros_arguments(argc, argv);
+  std::vector<char *> c_args;
+  for (auto & arg : args) { c_args.push_back(&arg[0]); }
+  c_args.push_back(nullptr);
+
+  Options options;
+  int opt;
+  while ((opt = getopt_long((int) args.size(), c_args.data(), "h", long_options, nullptr))
+         != -1) {
+    switch (opt) {
+      case OPT_DURATION:
+        options.duration = std::atof(optarg);
+        break;
+      case OPT_IMU_RATE:
+        options.imu_rate = std::atof(optarg);
+        break;
+      case OPT_COMMAND_RATE:
+        options.command_rate = std::atof(optarg);
+        break;
+      case OPT_STARTUP_TIMEOUT:
+        options.startup_timeout = std::atof(optarg);
+        break;
+      case OPT_MAX_COMMAND_LATENCY:
+        options.max_command_latency_ms = std::atof(optarg);
+        break;
+      case OPT_MAX_TELEMETRY_LATENCY:
+        options.max_telemetry_latency_ms = std::atof(optarg);
+        break;
+      default:
+        print_usage(argv[0]);
+        rclcpp::shutdown();
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (options.command_rate <= 0 || options.imu_rate <= 0) {
+    fprintf(stderr, "--command-rate and --imu-rate must be positive\n");
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  // Flight controller: fixed-wing passthrough, so servo outputs follow offboard commands directly
+  mavrosflight::LoopbackPipe pipe;
+  rosflight_sim::FirmwareRunner firmware(pipe, options.imu_rate);
+  firmware.set_param("FIXED_WING", 1);
+  firmware.set_param("MIXER", 10);
+  firmware.set_param("ARM_CHANNEL", ARM_CHANNEL);
+  firmware.set_param("RC_ATT_OVRD_CHN", OVERRIDE_CHANNEL);
+  firmware.set_param("RC_THR_OVRD_CHN", OVERRIDE_CHANNEL);
+  firmware.start();
+
+  // Ground station: the real rosflight_io node on the other end of the pipe
+  auto comm = std::make_unique<mavrosflight::MavlinkLoopback>(pipe);
+  auto io = std::make_shared<rosflight_io::ROSflightIO>(comm.get());
+  io->configure();
+  io->activate();
+  auto probe = std::make_shared<TelemetryProbe>();
+
+  rclcpp::executors::MultiThreadedExecutor executor;
+  executor.add_node(io->get_node_base_interface());
+  executor.add_node(probe);
+  std::thread spin_thread([&executor]() { executor.spin(); });
+
+  int result = 0;
+  auto finish = [&]() {
+    executor.cancel();
+    spin_thread.join();
+    firmware.stop();
+    rclcpp::shutdown();
+    return result;
+  };
+
+  printf("Waiting for the link to come up...\n");
+  if (!wait_for([&]() { return probe->imu_count() > 0; }, options.startup_timeout)) {
+    fprintf(stderr, "No IMU messages from rosflight_io after %.0f s\n", options.startup_timeout);
+    result = 1;
+    return finish();
+  }
+  // Give the time synchronization a moment to converge before trusting the stamps
+  std::this_thread::sleep_for(std::chrono::seconds(2));
+
+  firmware.board().set_rc(ARM_CHANNEL, 1.0f);
+  if (!wait_for([&]() { return firmware.armed(); }, 5.0)) {
+    printf("Firmware did not arm, measuring disarmed servo outputs\n");
+  }
+
+  // Measurement
+  auto & board = firmware.board();
+  auto period = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(1.0 / options.command_rate));
+  std::vector<double> command_latencies_ms;
+  size_t commands_sent = 0;
+
+  uint64_t imu_count_start = probe->imu_count();
+  uint64_t imu_samples_start = board.imu_samples();
+  uint64_t bytes_start = pipe.bytes_to_gcs() + pipe.bytes_to_fcu();
+  auto start = Clock::now();
+  auto end = start + std::chrono::duration_cast<Clock::duration>(
+                       std::chrono::duration<double>(options.duration));
+  probe->start_recording();
+
+  auto next_command = start;
+  while (Clock::now() < end && rclcpp::ok()) {
+    std::this_thread::sleep_until(next_command);
+    next_command += period;
+
+    // Alternate the commanded deflection so every command changes the servo outputs
+    float value = (commands_sent % 2 == 0) ? 0.25f : -0.25f;
+    auto sent = Clock::now();
+    probe->publish_command(value);
+    commands_sent++;
+
+    // Outputs are timestamped by the board when written, so polling here does not add latency
+    while (Clock::now() < next_command) {
+      auto changed = board.last_output_change();
+      if (changed >= sent) {
+        command_latencies_ms.push_back(to_ms(changed - sent));
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  std::vector<double> telemetry_latencies_ms = probe->stop_recording();
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  uint64_t imu_received = probe->imu_count() - imu_count_start;
+  uint64_t imu_sampled = board.imu_samples() - imu_samples_start;
+  uint64_t bytes = pipe.bytes_to_gcs() + pipe.bytes_to_fcu() - bytes_start;
+
+  // Report
+  printf("\nrosflight_io <-> firmware over loopback, %.1f s, firmware %s\n", elapsed,
+         firmware.armed() ? "armed" : "disarmed");
+  print_latency("command -> actuator", command_latencies_ms);
+  printf("%-22s %zu of %zu commands reached the actuators\n", "", command_latencies_ms.size(),
+         commands_sent);
+  print_latency("imu -> publish", telemetry_latencies_ms);
+  printf("%-22s %.1f msg/s received, %.1f samples/s sampled by the firmware\n", "imu throughput",
+         (double) imu_received / elapsed, (double) imu_sampled / elapsed);
+  printf("%-22s %.1f kB/s\n", "link throughput", (double) bytes / elapsed / 1e3);
+  printf("%-22s %.0f loops/s\n", "firmware main loop", (double) firmware.loops() / elapsed);
+
+  if (command_latencies_ms.empty()) {
+    fprintf(stderr, "FAIL: no command reached the actuators\n");
+    result = 1;
+  }
+  if (options.max_command_latency_ms > 0
+      && percentile(command_latencies_ms, 99) > options.max_command_latency_ms) {
+    fprintf(stderr, "FAIL: p99 command latency above %.3f ms\n", options.max_command_latency_ms);
+    result = 1;
+  }
+  if (options.max_telemetry_latency_ms > 0
+      && percentile(telemetry_latencies_ms, 99) > options.max_telemetry_latency_ms) {
+    fprintf(stderr, "FAIL: p99 telemetry latency above %.3f ms\n",
+            options.max_telemetry_latency_ms);
+    result = 1;
+  }
+
+  return finish();
+}
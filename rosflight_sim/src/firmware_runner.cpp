@@ -0,0 +1,106 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <mavlink/mavlink.h>
+#include <rosflight.h>
+
+#include <rosflight_io/mavrosflight/hot_path.hpp>
+#include <rosflight_sim/firmware_runner.hpp>
+
+namespace rosflight_sim
+{
+struct FirmwareRunner::Firmware
+{
+  explicit Firmware(SyntheticBoard & board)
+      : comm(board)
+      , firmware(board, comm)
+  {}
+
+  rosflight_firmware::Mavlink comm;
+  rosflight_firmware::ROSflight firmware;
+};
+
+FirmwareRunner::FirmwareRunner(mavrosflight::LoopbackPipe & pipe, double imu_rate_hz)
+    : board_(pipe, imu_rate_hz)
+    , firmware_(new Firmware(board_))
+{
+  firmware_->firmware.init();
+}
+
+FirmwareRunner::~FirmwareRunner() { stop(); }
+
+bool FirmwareRunner::set_param(const std::string & name, int32_t value)
+{
+  return firmware_->firmware.params_.set_param_by_name_int(name.c_str(), value);
+}
+
+bool FirmwareRunner::set_param_float(const std::string & name, float value)
+{
+  return firmware_->firmware.params_.set_param_by_name_float(name.c_str(), value);
+}
+
+bool FirmwareRunner::write_params() { return firmware_->firmware.params_.write(); }
+
+void FirmwareRunner::start()
+{
+  if (running_.exchange(true)) {
+    return;
+  }
+  thread_ = std::thread(&FirmwareRunner::run, this);
+}
+
+void FirmwareRunner::stop()
+{
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void FirmwareRunner::run()
+{
+  while (running_.load(std::memory_order_relaxed)) {
+    {
+      mavrosflight::HotPath hot_path("sil.firmware_step");
+      firmware_->firmware.run();
+      armed_.store(firmware_->firmware.state_manager_.state().armed, std::memory_order_relaxed);
+      loops_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The flight controller spins its main loop flat out; yield so rosflight_io keeps a core
+    // on small CI machines
+    std::this_thread::yield();
+  }
+}
+
+} // namespace rosflight_sim
@@ -0,0 +1,137 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <rosflight_sim/firmware_step_coordinator.hpp>
+#include <rosflight_sim/gz_compat.hpp>
+
+namespace rosflight_sim
+{
+namespace
+{
+std::mutex registry_mutex;
+std::map<std::string, std::weak_ptr<FirmwareStepCoordinator>> registry;
+} // namespace
+
+std::shared_ptr<FirmwareStepCoordinator>
+FirmwareStepCoordinator::get(gazebo::physics::WorldPtr world, size_t num_threads)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  const std::string name = world->Name();
+  std::shared_ptr<FirmwareStepCoordinator> coordinator = registry[name].lock();
+  if (coordinator == nullptr) {
+    coordinator.reset(new FirmwareStepCoordinator(name, num_threads));
+    registry[name] = coordinator;
+  }
+  return coordinator;
+}
+
+FirmwareStepCoordinator::FirmwareStepCoordinator(const std::string & world_name,
+                                                 size_t num_threads)
+    : world_name_(world_name)
+    , pool_(num_threads)
+    , last_report_(std::chrono::steady_clock::now())
+{
+  update_connection_ = gazebo::event::Events::ConnectWorldUpdateBegin(
+    [this](const gazebo::common::UpdateInfo &) { on_update(); });
+  gzmsg << "[rosflight_sim] Stepping the firmware of world \"" << world_name_ << "\" on "
+        << pool_.num_threads() << " threads.\n";
+}
+
+FirmwareStepCoordinator::~FirmwareStepCoordinator()
+{
+  GZ_COMPAT_DISCONNECT_WORLD_UPDATE_BEGIN(update_connection_);
+}
+
+int FirmwareStepCoordinator::add_vehicle(std::function<void()> capture, std::function<void()> step)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  Vehicle & vehicle = vehicles_[next_id_];
+  vehicle.capture = std::move(capture);
+  vehicle.step = std::move(step);
+  return next_id_++;
+}
+
+void FirmwareStepCoordinator::remove_vehicle(int id)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  vehicles_.erase(id);
+}
+
+void FirmwareStepCoordinator::on_update()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (vehicles_.empty()) {
+    return;
+  }
+
+  stepping_.clear();
+  for (auto & entry : vehicles_) {
+    entry.second.capture();
+    stepping_.push_back(&entry.second);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  pool_.run(stepping_.size(), [this](size_t i) {
+    auto step_start = std::chrono::steady_clock::now();
+    stepping_[i]->step();
+    stepping_[i]->step_time = std::chrono::steady_clock::now() - step_start;
+  });
+  auto end = std::chrono::steady_clock::now();
+
+  parallel_time_ += end - start;
+  for (Vehicle * vehicle : stepping_) {
+    firmware_time_ += vehicle->step_time;
+  }
+  steps_++;
+
+  if (end - last_report_ >= REPORT_PERIOD) {
+    report();
+    last_report_ = end;
+  }
+}
+
+void FirmwareStepCoordinator::report()
+{
+  if (parallel_time_.count() > 0) {
+    // Speedup over stepping the same firmware serially on the update thread
+    double speedup = (double) firmware_time_.count() / (double) parallel_time_.count();
+    gzmsg << "[rosflight_sim] World \"" << world_name_ << "\": " << vehicles_.size()
+          << " vehicles, firmware step " << parallel_time_.count() / 1e3 / steps_
+          << " us, speedup " << speedup << "x on " << pool_.num_threads() << " threads.\n";
+  }
+  parallel_time_ = std::chrono::nanoseconds(0);
+  firmware_time_ = std::chrono::nanoseconds(0);
+  steps_ = 0;
+}
+
+} // namespace rosflight_sim
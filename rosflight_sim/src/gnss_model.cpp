@@ -0,0 +1,105 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+
+#include <rosflight_sim/gnss_model.hpp>
+
+namespace rosflight_sim
+{
+void GNSSModel::set_origin(double latitude, double longitude, double altitude)
+{
+  origin_latitude_ = latitude;
+  origin_longitude_ = longitude;
+  origin_altitude_ = altitude;
+  origin_ecef_ = lla_to_ecef(latitude, longitude, altitude);
+
+  double s_lat = std::sin(latitude);
+  double c_lat = std::cos(latitude);
+  double s_lon = std::sin(longitude);
+  double c_lon = std::cos(longitude);
+
+  // Columns are the north, west and up unit vectors of the origin, expressed in ECEF
+  R_NWU_to_ECEF_ << -s_lat * c_lon, s_lon, c_lat * c_lon, -s_lat * s_lon, -c_lon, c_lat * s_lon,
+    c_lat, 0.0, s_lat;
+
+  // Meridian (M) and prime vertical (N) radii of curvature at the origin
+  double w2 = 1.0 - WGS84_E2 * s_lat * s_lat;
+  double N = WGS84_A / std::sqrt(w2);
+  double M = N * (1.0 - WGS84_E2) / w2;
+
+  inv_meridian_radius_ = 1.0 / (M + altitude);
+  inv_transverse_radius_ = 1.0 / (N + altitude);
+  inv_parallel_radius_ = inv_transverse_radius_ / c_lat;
+  tan_latitude_ = s_lat / c_lat;
+  // dM/dlat / M, which bends the latitude scale as the vehicle moves north
+  meridian_curvature_rate_ =
+    1.5 * WGS84_E2 * s_lat * c_lat / w2 * inv_meridian_radius_ * inv_meridian_radius_;
+}
+
+GNSSModel::Fix GNSSModel::compute_fix(const Eigen::Vector3d & pos_NWU,
+                                      const Eigen::Vector3d & vel_NWU) const
+{
+  Fix fix;
+  fix.ecef_pos = origin_ecef_ + R_NWU_to_ECEF_ * pos_NWU;
+  fix.ecef_vel = R_NWU_to_ECEF_ * vel_NWU;
+
+  double n = pos_NWU.x();
+  double e = -pos_NWU.y();
+  double u = pos_NWU.z();
+
+  // Second order expansion of the tangent plane about the origin. The quadratic terms account for
+  // the Earth curving away from the plane and for the change in radius with height.
+  fix.lla.x() = origin_latitude_ + n * inv_meridian_radius_
+    - 0.5 * tan_latitude_ * e * e * inv_meridian_radius_ * inv_transverse_radius_
+    - n * u * inv_meridian_radius_ * inv_meridian_radius_ - meridian_curvature_rate_ * n * n;
+  fix.lla.y() = origin_longitude_
+    + e * inv_parallel_radius_ * (1.0 + (n * tan_latitude_ - u) * inv_transverse_radius_);
+  fix.lla.z() = origin_altitude_ + u
+    + 0.5 * (n * n * inv_meridian_radius_ + e * e * inv_transverse_radius_);
+
+  return fix;
+}
+
+Eigen::Vector3d GNSSModel::lla_to_ecef(double latitude, double longitude, double altitude)
+{
+  double s_lat = std::sin(latitude);
+  double c_lat = std::cos(latitude);
+  double N = WGS84_A / std::sqrt(1.0 - WGS84_E2 * s_lat * s_lat);
+  double r = (N + altitude) * c_lat;
+
+  return {r * std::cos(longitude), r * std::sin(longitude),
+          (N * (1.0 - WGS84_E2) + altitude) * s_lat};
+}
+
+} // namespace rosflight_sim
@@ -0,0 +1,140 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file make_memory_image.cpp
+ *
+ * Builds the non-volatile memory image of a configured firmware, without running the simulator.
+ * The firmware is initialized on a SyntheticBoard, the parameters in a parameter file (in the
+ * format written by rosflight_io's param_save_to_file) are applied directly, and the memory the
+ * firmware writes is saved to a file. SIL vehicles given that file in their memory_image parameter
+ * boot with those parameters, without any parameter traffic over MAVLink.
+ *
+ * Usage: make_memory_image <params.yaml> <image.bin>
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <yaml-cpp/yaml.h>
+
+#include <rosflight_io/mavrosflight/loopback_pipe.hpp>
+#include <rosflight_sim/firmware_runner.hpp>
+
+namespace
+{
+// MAV_PARAM_TYPE values used in parameter files. The MAVLink headers are not included here, for
+// the same reason FirmwareRunner hides the firmware.
+constexpr int PARAM_TYPE_INT32 = 6;
+constexpr int PARAM_TYPE_FLOAT = 9;
+
+bool apply_params(rosflight_sim::FirmwareRunner & firmware, const std::string & filename)
+{
+  YAML::Node root;
+  try {
+    root = YAML::LoadFile(filename);
+  } catch (const YAML::Exception & e) {
+    std::fprintf(stderr, "Could not load %s: %s\n", filename.c_str(), e.what());
+    return false;
+  }
+  if (!root.IsSequence()) {
+    std::fprintf(stderr, "%s is not a list of parameters\n", filename.c_str());
+    return false;
+  }
+
+  bool ok = true;
+  int count = 0;
+  for (const auto & item : root) {
+    if (!item.IsMap() || !item["name"] || !item["type"] || !item["value"]) {
+      std::fprintf(stderr, "Skipping malformed entry in %s\n", filename.c_str());
+      ok = false;
+      continue;
+    }
+    std::string name = item["name"].as<std::string>();
+    int type = item["type"].as<int>();
+    bool known = false;
+    if (type == PARAM_TYPE_INT32) {
+      known = firmware.set_param(name, item["value"].as<int32_t>());
+    } else if (type == PARAM_TYPE_FLOAT) {
+      known = firmware.set_param_float(name, item["value"].as<float>());
+    } else {
+      std::fprintf(stderr, "%s has unsupported type %d\n", name.c_str(), type);
+      ok = false;
+      continue;
+    }
+    if (!known) {
+      std::fprintf(stderr, "%s is not a firmware parameter\n", name.c_str());
+      ok = false;
+      continue;
+    }
+    count++;
+  }
+
+  std::printf("Applied %d parameters from %s\n", count, filename.c_str());
+  return ok;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  if (argc != 3) {
+    std::fprintf(stderr, "Usage: %s <params.yaml> <image.bin>\n", argv[0]);
+    return 2;
+  }
+
+  // Nothing reads the other end of the pipe; the firmware's startup messages just collect in it
+  mavrosflight::LoopbackPipe pipe;
+  rosflight_sim::FirmwareRunner firmware(pipe);
+
+  if (!apply_params(firmware, argv[1])) {
+    return 1;
+  }
+  if (!firmware.write_params()) {
+    std::fprintf(stderr, "The firmware did not write its parameters\n");
+    return 1;
+  }
+
+  const std::vector<uint8_t> & memory = firmware.board().memory();
+  std::ofstream image(argv[2], std::ios::binary);
+  image.write((const char *) memory.data(), (long) memory.size());
+  image.close();
+  if (!image) {
+    std::fprintf(stderr, "Could not write %s\n", argv[2]);
+    return 1;
+  }
+
+  std::printf("Wrote %zu byte memory image to %s\n", memory.size(), argv[2]);
+  return 0;
+}
@@ -34,10 +34,14 @@
 
 #pragma GCC diagnostic ignored "-Wwrite-strings"
 
+#include <algorithm>
+#include <chrono>
 #include <sstream>
 
 #include <eigen3/Eigen/Core>
 
+#include <rosflight_io/loop_time_diagnostics.hpp>
+#include <rosflight_io/mavrosflight/hot_path.hpp>
 #include <rosflight_sim/rosflight_sil.hpp>
 
 namespace rosflight_sim
@@ -49,7 +53,14 @@ ROSflightSIL::ROSflightSIL()
     , mav_dynamics_()
 {}
 
-ROSflightSIL::~ROSflightSIL() { GZ_COMPAT_DISCONNECT_WORLD_UPDATE_BEGIN(updateConnection_); }
+ROSflightSIL::~ROSflightSIL()
+{
+  GZ_COMPAT_DISCONNECT_WORLD_UPDATE_BEGIN(updateConnection_);
+  if (coordinator_ != nullptr) {
+    coordinator_->remove_vehicle(coordinator_id_);
+  }
+  stop_pipeline();
+}
 
 void ROSflightSIL::Load(gazebo::physics::ModelPtr _model, sdf::ElementPtr _sdf)
 {
@@ -88,10 +99,54 @@ void ROSflightSIL::Load(gazebo::physics::ModelPtr _model, sdf::ElementPtr _sdf)
     gzthrow("unknown or unsupported mav type\n")
   }
 
+  pipelined_ = node_->get_parameter_or<bool>("sil_pipelined", false);
+  bool parallel = node_->get_parameter_or<bool>("sil_parallel_firmware", false);
+  if (parallel && pipelined_) {
+    gzwarn << "[rosflight_sim] sil_pipelined and sil_parallel_firmware are exclusive, using "
+              "sil_parallel_firmware.\n";
+    pipelined_ = false;
+  }
+
+  if (node_->get_parameter_or<bool>("sil_profile", false)) {
+    profiler_ = std::make_unique<SILProfiler>(node_);
+    // The profiler is only used from the Gazebo update thread, which doesn't run the board when
+    // pipelined or parallel
+    if (!pipelined_ && !parallel) {
+      board_.set_profiler(profiler_.get());
+    }
+  }
+
+  double loop_time_period = node_->get_parameter_or<double>("sil_loop_time_report_period", 1.0);
+  if (loop_time_period > 0.0) {
+    loop_time_monitor_ = std::make_unique<rosflight_io::LoopTimeMonitor>(
+      (size_t) std::max(node_->get_parameter_or<int>("sil_loop_time_window", 1000), 1),
+      (uint32_t) std::max(node_->get_parameter_or<int>("sil_loop_time_budget_us", 1000), 0));
+    diagnostics_pub_ =
+      node_->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("diagnostics", 1);
+    loop_time_timer_ = node_->create_wall_timer(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(loop_time_period)),
+      std::bind(&ROSflightSIL::publish_loop_time, this));
+  }
+
   // Initialize the Firmware
   board_.gazebo_setup(link_, world_, model_, node_, mav_type_);
   firmware_.init();
 
+  if (pipelined_) {
+    start_pipeline();
+    gzmsg << "[rosflight_sim] Running the firmware pipelined, one step behind physics.\n";
+  }
+
+  if (parallel) {
+    // Must happen before connecting OnUpdate, so the coordinator's update runs first
+    coordinator_ = FirmwareStepCoordinator::get(
+      world_, (size_t) std::max(0, node_->get_parameter_or<int>("sil_parallel_threads", 0)));
+    coordinator_id_ = coordinator_->add_vehicle(
+      [this] { board_.set_state(board_.capture_state()); },
+      [this] { run_firmware(); });
+  }
+
   // Connect the update function to the simulation
   updateConnection_ =
     gazebo::event::Events::ConnectWorldUpdateBegin(boost::bind(&ROSflightSIL::OnUpdate, this, _1));
@@ -136,6 +191,13 @@ void ROSflightSIL::declare_SIL_params()
   node_->declare_parameter("sonar_max_range", rclcpp::PARAMETER_DOUBLE);
 
   node_->declare_parameter("imu_update_rate", rclcpp::PARAMETER_DOUBLE);
+  node_->declare_parameter("mag_update_rate", rclcpp::PARAMETER_DOUBLE);
+  node_->declare_parameter("gnss_update_rate", rclcpp::PARAMETER_DOUBLE);
+  node_->declare_parameter("baro_update_rate", rclcpp::PARAMETER_DOUBLE);
+  node_->declare_parameter("diff_pressure_update_rate", rclcpp::PARAMETER_DOUBLE);
+  node_->declare_parameter("sonar_update_rate", rclcpp::PARAMETER_DOUBLE);
+  node_->declare_parameter("rc_update_rate", rclcpp::PARAMETER_DOUBLE);
+  node_->declare_parameter("battery_update_rate", rclcpp::PARAMETER_DOUBLE);
 
   node_->declare_parameter("inclination", rclcpp::PARAMETER_DOUBLE);
   node_->declare_parameter("declination", rclcpp::PARAMETER_DOUBLE);
@@ -147,14 +209,46 @@ void ROSflightSIL::declare_SIL_params()
   node_->declare_parameter("horizontal_gps_stdev", rclcpp::PARAMETER_DOUBLE);
   node_->declare_parameter("vertical_gps_stdev", rclcpp::PARAMETER_DOUBLE);
   node_->declare_parameter("gps_velocity_stdev", rclcpp::PARAMETER_DOUBLE);
+  node_->declare_parameter("horizontal_gps_walk_stdev", rclcpp::PARAMETER_DOUBLE);
+  node_->declare_parameter("vertical_gps_walk_stdev", rclcpp::PARAMETER_DOUBLE);
+  node_->declare_parameter("gnss_exact", rclcpp::PARAMETER_BOOL);
+
+  node_->declare_parameter("memory_image", rclcpp::PARAMETER_STRING);
+
+  node_->declare_parameter("sil_pipelined", rclcpp::PARAMETER_BOOL);
+  node_->declare_parameter("sil_parallel_firmware", rclcpp::PARAMETER_BOOL);
+  node_->declare_parameter("sil_parallel_threads", rclcpp::PARAMETER_INTEGER);
+  node_->declare_parameter("sil_profile", rclcpp::PARAMETER_BOOL);
+  node_->declare_parameter("sil_profile_period", rclcpp::PARAMETER_DOUBLE);
+  node_->declare_parameter("sil_profile_window", rclcpp::PARAMETER_INTEGER);
+  node_->declare_parameter("sil_profile_trace_file", rclcpp::PARAMETER_STRING);
+  node_->declare_parameter("sil_loop_time_budget_us", rclcpp::PARAMETER_INTEGER);
+  node_->declare_parameter("sil_loop_time_window", rclcpp::PARAMETER_INTEGER);
+  node_->declare_parameter("sil_loop_time_report_period", rclcpp::PARAMETER_DOUBLE);
 }
 
 // This gets called by the world update event.
 void ROSflightSIL::OnUpdate(const gazebo::common::UpdateInfo & _info)
 {
-  // We run twice so that that functions that take place when we don't have new IMU data get run
-  firmware_.run();
-  firmware_.run();
+  if (profiler_) {
+    profiler_->begin_step();
+  }
+
+  const int * outputs;
+  {
+    // When pipelined, this only times how long the firmware holds up the physics
+    SILProfiler::Scope scope(profiler_.get(), SILProfiler::FIRMWARE);
+    if (coordinator_ != nullptr) {
+      // Already stepped by the coordinator at the start of this world update
+      outputs = board_.get_outputs();
+    } else if (pipelined_) {
+      outputs = pipeline_exchange(board_.capture_state());
+    } else {
+      board_.set_state(board_.capture_state());
+      run_firmware();
+      outputs = board_.get_outputs();
+    }
+  }
 
   Eigen::Matrix3d NWU_to_NED;
   NWU_to_NED << 1, 0, 0, 0, -1, 0, 0, 0, -1;
@@ -171,21 +265,141 @@ void ROSflightSIL::OnUpdate(const gazebo::common::UpdateInfo & _info)
   state.omega = NWU_to_NED * vec3_to_eigen_from_gazebo(omega);
   state.t = _info.simTime.Double();
 
-  forces_ = mav_dynamics_->update_forces_and_torques(state, board_.get_outputs());
+  {
+    SILProfiler::Scope scope(profiler_.get(), SILProfiler::DYNAMICS);
+    forces_ = mav_dynamics_->update_forces_and_torques(state, outputs);
 
-  // apply the forces and torques to the joint (apply in NWU)
-  GazeboVector force = vec3_to_gazebo_from_eigen(NWU_to_NED * forces_.block<3, 1>(0, 0));
-  GazeboVector torque = vec3_to_gazebo_from_eigen(NWU_to_NED * forces_.block<3, 1>(3, 0));
-  link_->AddRelativeForce(force);
-  link_->AddRelativeTorque(torque);
+    // apply the forces and torques to the joint (apply in NWU)
+    GazeboVector force = vec3_to_gazebo_from_eigen(NWU_to_NED * forces_.block<3, 1>(0, 0));
+    GazeboVector torque = vec3_to_gazebo_from_eigen(NWU_to_NED * forces_.block<3, 1>(3, 0));
+    link_->AddRelativeForce(force);
+    link_->AddRelativeTorque(torque);
+  }
+
+  {
+    SILProfiler::Scope scope(profiler_.get(), SILProfiler::TRUTH);
+    publish_truth();
+  }
 
-  publish_truth();
+  if (profiler_) {
+    profiler_->end_step(_info.simTime.Double());
+  }
+}
+
+namespace
+{
+// Waits for a step counter to reach a value. Spins at first, since the other thread is usually
+// about to get there, then sleeps so a paused simulation doesn't hold a core. Returns false if the
+// pipeline was stopped.
+bool wait_for_step(const std::atomic<uint64_t> & counter, uint64_t step,
+                   const std::atomic<bool> & running)
+{
+  for (int spins = 0; counter.load(std::memory_order_acquire) != step; spins++) {
+    if (!running.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    if (spins < 1000) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+  return true;
+}
+} // namespace
+
+void ROSflightSIL::start_pipeline()
+{
+  step_ = 0;
+  published_step_ = 0;
+  completed_step_ = 0;
+  state_slots_[0] = state_slots_[1] = SILBoard::PhysicsState();
+  // The first step applies the outputs the firmware holds now, e.g. the ones it set up during init
+  std::copy(board_.get_outputs(), board_.get_outputs() + SILBoard::NUM_PWM_OUTPUTS,
+            output_slots_[0].begin());
+  output_slots_[1].fill(0);
+
+  pipeline_running_ = true;
+  firmware_thread_ = std::thread(&ROSflightSIL::firmware_thread, this);
+}
+
+void ROSflightSIL::stop_pipeline()
+{
+  if (firmware_thread_.joinable()) {
+    pipeline_running_ = false;
+    firmware_thread_.join();
+  }
+}
+
+const int * ROSflightSIL::pipeline_exchange(const SILBoard::PhysicsState & state)
+{
+  uint64_t step = ++step_;
+  state_slots_[step % 2] = state;
+
+  // The outputs applied in this step come from the previous step's state, so wait for them
+  wait_for_step(completed_step_, step - 1, pipeline_running_);
+  const int * outputs = output_slots_[(step - 1) % 2].data();
+
+  published_step_.store(step, std::memory_order_release);
+  return outputs;
+}
+
+void ROSflightSIL::firmware_thread()
+{
+  for (uint64_t step = 1; wait_for_step(published_step_, step, pipeline_running_); step++) {
+    board_.set_state(state_slots_[step % 2]);
+    run_firmware();
+    std::copy(board_.get_outputs(), board_.get_outputs() + SILBoard::NUM_PWM_OUTPUTS,
+              output_slots_[step % 2].begin());
+    completed_step_.store(step, std::memory_order_release);
+  }
+}
+
+void ROSflightSIL::run_firmware()
+{
+  mavrosflight::HotPath hot_path("sil.firmware_step");
+  auto start = std::chrono::steady_clock::now();
+  // We run twice so that that functions that take place when we don't have new IMU data get run
+  firmware_.run();
+  firmware_.run();
+  if (loop_time_monitor_ == nullptr) {
+    return;
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  auto step_us =
+    (uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  int64_t end_ns =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(end.time_since_epoch()).count();
+  if (loop_time_monitor_->add(end_ns, step_us, board_.num_sensor_errors())
+      && !loop_time_overrun_.exchange(true)) {
+    gzwarn << "[rosflight_sim] Firmware step of " << step_us << " us is over budget.\n";
+  }
+}
+
+void ROSflightSIL::publish_loop_time()
+{
+  std::string name = std::string(node_->get_fully_qualified_name()) + ": SIL firmware loop time";
+  diagnostic_msgs::msg::DiagnosticArray msg;
+  msg.header.stamp = node_->get_clock()->now();
+  msg.status.push_back(rosflight_io::loop_time_status(loop_time_monitor_->summary(), name,
+                                                      node_->get_namespace(),
+                                                      "Firmware not stepped yet"));
+  diagnostics_pub_->publish(msg);
 }
 
 void ROSflightSIL::Reset()
 {
+  // Finish the firmware step in flight before the reset, so no state from before it is still
+  // queued, then start again from step 1 once the physics is back at the initial pose
+  stop_pipeline();
+
   link_->SetWorldPose(initial_pose_);
   link_->ResetPhysicsStates();
+
+  if (pipelined_) {
+    start_pipeline();
+  }
 }
 
 void ROSflightSIL::wind_callback(const geometry_msgs::msg::Vector3 & msg)
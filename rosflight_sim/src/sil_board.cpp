@@ -148,6 +148,9 @@ void SILBoard::gazebo_setup(gazebo::physics::LinkPtr link, gazebo::physics::Worl
   horizontal_gps_stdev_ = node_->get_parameter_or<double>("horizontal_gps_stdev", 1.0);
   vertical_gps_stdev_ = node_->get_parameter_or<double>("vertical_gps_stdev", 3.0);
   gps_velocity_stdev_ = node_->get_parameter_or<double>("gps_velocity_stdev", 0.1);
+  horizontal_gps_walk_stdev_ = node_->get_parameter_or<double>("horizontal_gps_walk_stdev", 0.0);
+  vertical_gps_walk_stdev_ = node_->get_parameter_or<double>("vertical_gps_walk_stdev", 0.0);
+  gnss_exact_ = node_->get_parameter_or<bool>("gnss_exact", false);
 
   // Configure Noise
   normal_distribution_ = std::normal_distribution<double>(0.0, 1.0);
@@ -174,24 +177,39 @@ void SILBoard::gazebo_setup(gazebo::physics::LinkPtr link, gazebo::physics::Worl
   last_time_ = GZ_COMPAT_GET_SIM_TIME(world_);
   next_imu_update_time_us_ = 0;
   next_mag_update_time_us_ = 0;
+  state_ = capture_state();
+}
+
+SILBoard::PhysicsState SILBoard::capture_state() const
+{
+  PhysicsState state;
+  state.sim_time = GZ_COMPAT_GET_SIM_TIME(world_);
+  state.world_pose = GZ_COMPAT_GET_WORLD_POSE(link_);
+  state.relative_linear_vel = GZ_COMPAT_GET_RELATIVE_LINEAR_VEL(link_);
+  state.world_linear_vel = GZ_COMPAT_GET_WORLD_LINEAR_VEL(link_);
+  state.world_linear_accel = GZ_COMPAT_GET_WORLD_LINEAR_ACCEL(link_);
+  state.relative_angular_vel = GZ_COMPAT_GET_RELATIVE_ANGULAR_VEL(link_);
+  return state;
 }
 
 // clock
 
 uint32_t SILBoard::clock_millis()
 {
-  uint32_t millis = (uint32_t) ((GZ_COMPAT_GET_SIM_TIME(world_) - boot_time_).Double() * 1e3);
+  uint32_t millis = (uint32_t) ((state_.sim_time - boot_time_).Double() * 1e3);
   return millis;
 }
 
 uint64_t SILBoard::clock_micros()
 {
-  uint64_t micros = (uint64_t) ((GZ_COMPAT_GET_SIM_TIME(world_) - boot_time_).Double() * 1e6);
+  uint64_t micros = (uint64_t) ((state_.sim_time - boot_time_).Double() * 1e6);
   return micros;
 }
 
 uint8_t SILBoard::serial_read()
 {
+  SILProfiler::Scope scope(profiler_, SILProfiler::COMM);
+
   auto next_message = serial_delay_queue_.front();
   serial_delay_queue_.pop();
   return std::get<1>(next_message);
@@ -199,6 +217,8 @@ uint8_t SILBoard::serial_read()
 
 uint16_t SILBoard::serial_bytes_available()
 {
+  SILProfiler::Scope scope(profiler_, SILProfiler::COMM);
+
   // Get current time. Doesn't use ROS time as ROS time proved to be inconsistent and lead to slower
   // serial communication.
   auto current_time = std::chrono::high_resolution_clock::now().time_since_epoch().count();
@@ -213,6 +233,12 @@ uint16_t SILBoard::serial_bytes_available()
     && (current_time - std::get<0>(serial_delay_queue_.front())) > serial_delay_ns_;
 }
 
+void SILBoard::serial_write(const uint8_t * src, size_t len, uint8_t qos)
+{
+  SILProfiler::Scope scope(profiler_, SILProfiler::COMM);
+  UDPBoard::serial_write(src, len, qos);
+}
+
 // sensors
 /// TODO these sensors have noise, no bias
 /// noise params are hard coded
@@ -241,6 +267,9 @@ void SILBoard::sensors_init()
   sph_coord_.SetElevationReference(origin_altitude_);
   // Force x-axis to be north-aligned. I promise, I will change everything to ENU in the next commit
   sph_coord_.SetHeadingOffset(Ang(M_PI / 2.0));
+
+  gnss_model_.set_origin(deg2Rad(origin_latitude_), deg2Rad(origin_longitude_), origin_altitude_);
+  gnss_walk_.setZero();
 }
 
 uint16_t SILBoard::num_sensor_errors() { return 0; }
@@ -271,7 +300,9 @@ bool SILBoard::gnss_has_new_data()
 {
   uint64_t now_us = clock_micros();
   if (now_us >= next_gnss_update_time_us_) {
-    next_gnss_update_time_us_ = now_us + gnss_update_period_us_;
+    // Receivers report on fixed epochs, so snap to the next multiple of the period instead of
+    // letting the sim step size skew the update rate.
+    next_gnss_update_time_us_ = (now_us / gnss_update_period_us_ + 1) * gnss_update_period_us_;
     return true;
   } else {
     return false;
@@ -335,16 +366,18 @@ bool SILBoard::battery_has_new_data()
 
 bool SILBoard::imu_read(float accel[3], float * temperature, float gyro[3], uint64_t * time_us)
 {
-  GazeboQuaternion q_I_NWU = GZ_COMPAT_GET_ROT(GZ_COMPAT_GET_WORLD_POSE(link_));
-  GazeboVector current_vel = GZ_COMPAT_GET_RELATIVE_LINEAR_VEL(link_);
+  SILProfiler::Scope scope(profiler_, SILProfiler::SENSORS);
+
+  GazeboQuaternion q_I_NWU = GZ_COMPAT_GET_ROT(state_.world_pose);
+  GazeboVector current_vel = state_.relative_linear_vel;
   GazeboVector y_acc;
-  GazeboPose local_pose = GZ_COMPAT_GET_WORLD_POSE(link_);
+  GazeboPose local_pose = state_.world_pose;
 
   // this is James's egregious hack to overcome wild imu while sitting on the ground
   if (GZ_COMPAT_GET_LENGTH(current_vel) < 0.05) {
     y_acc = q_I_NWU.RotateVectorReverse(-gravity_);
   } else if (local_pose.Z() < 0.5) {
-    y_acc = q_I_NWU.RotateVectorReverse(GZ_COMPAT_GET_WORLD_LINEAR_ACCEL(link_) - gravity_);
+    y_acc = q_I_NWU.RotateVectorReverse(state_.world_linear_accel - gravity_);
   } else {
     y_acc.Set(f_x / mass_, -f_y / mass_, -f_z / mass_);
   }
@@ -380,7 +413,7 @@ bool SILBoard::imu_read(float accel[3], float * temperature, float gyro[3], uint
   accel[1] = (float) -GZ_COMPAT_GET_Y(y_acc);
   accel[2] = (float) -GZ_COMPAT_GET_Z(y_acc);
 
-  GazeboVector y_gyro = GZ_COMPAT_GET_RELATIVE_ANGULAR_VEL(link_);
+  GazeboVector y_gyro = state_.relative_angular_vel;
 
   // Normal Noise from motors
   if (motors_spinning()) {
@@ -425,7 +458,9 @@ void SILBoard::imu_not_responding_error()
 
 bool SILBoard::mag_read(float mag[3])
 {
-  GazeboPose I_to_B = GZ_COMPAT_GET_WORLD_POSE(link_);
+  SILProfiler::Scope scope(profiler_, SILProfiler::SENSORS);
+
+  GazeboPose I_to_B = state_.world_pose;
   GazeboVector noise;
   GZ_COMPAT_SET_X(noise, mag_stdev_ * normal_distribution_(noise_generator_));
   GZ_COMPAT_SET_Y(noise, mag_stdev_ * normal_distribution_(noise_generator_));
@@ -460,8 +495,10 @@ bool SILBoard::baro_present() { return true; }
 
 bool SILBoard::baro_read(float * pressure, float * temperature)
 {
+  SILProfiler::Scope scope(profiler_, SILProfiler::SENSORS);
+
   // pull z measurement out of Gazebo
-  GazeboPose current_state_NWU = GZ_COMPAT_GET_WORLD_POSE(link_);
+  GazeboPose current_state_NWU = state_.world_pose;
 
   // Invert measurement model for pressure and temperature
   double alt = GZ_COMPAT_GET_Z(GZ_COMPAT_GET_POS(current_state_NWU)) + origin_altitude_;
@@ -496,8 +533,10 @@ bool SILBoard::diff_pressure_present()
 
 bool SILBoard::diff_pressure_read(float * diff_pressure, float * temperature)
 {
+  SILProfiler::Scope scope(profiler_, SILProfiler::SENSORS);
+
   // Calculate Airspeed
-  GazeboVector vel = GZ_COMPAT_GET_RELATIVE_LINEAR_VEL(link_);
+  GazeboVector vel = state_.relative_linear_vel;
 
   double Va = GZ_COMPAT_GET_LENGTH(vel);
 
@@ -519,7 +558,9 @@ bool SILBoard::sonar_present() { return true; }
 
 bool SILBoard::sonar_read(float * range)
 {
-  GazeboPose current_state_NWU = GZ_COMPAT_GET_WORLD_POSE(link_);
+  SILProfiler::Scope scope(profiler_, SILProfiler::SENSORS);
+
+  GazeboPose current_state_NWU = state_.world_pose;
   double alt = GZ_COMPAT_GET_Z(GZ_COMPAT_GET_POS(current_state_NWU));
 
   if (alt < sonar_min_range_) {
@@ -537,6 +578,8 @@ bool SILBoard::battery_present() { return true; }
 
 bool SILBoard::battery_read(float * voltage, float * current)
 {
+  SILProfiler::Scope scope(profiler_, SILProfiler::SENSORS);
+
   *voltage = 15 * battery_voltage_multiplier;
   *current = 1 * battery_current_multiplier;
   return true;
@@ -615,6 +658,28 @@ bool SILBoard::memory_read(void * dest, size_t len)
   std::ifstream memory_file;
   memory_file.open(directory + "/mem.bin", std::ios::binary);
 
+  // A memory image made by make_memory_image stands in for a missing memory file, so parameter
+  // writes made since the first boot are kept
+  std::string image = node_->get_parameter_or<std::string>("memory_image", "");
+  if (!memory_file.is_open() && !image.empty()) {
+    std::ifstream image_file(image, std::ios::binary | std::ios::ate);
+    if (!image_file.is_open()) {
+      RCLCPP_ERROR(node_->get_logger(), "Unable to load memory image %s", image.c_str());
+      return false;
+    }
+    if ((size_t) image_file.tellg() != len) {
+      RCLCPP_ERROR(node_->get_logger(),
+                   "Memory image %s is %ld bytes, but the firmware expects %zu. Was it made with "
+                   "a different firmware version?",
+                   image.c_str(), (long) image_file.tellg(), len);
+      return false;
+    }
+    image_file.seekg(0);
+    image_file.read((char *) dest, (long) len);
+    RCLCPP_INFO(node_->get_logger(), "Loaded memory image %s", image.c_str());
+    return true;
+  }
+
   if (!memory_file.is_open()) {
     RCLCPP_ERROR(node_->get_logger(), "Unable to load rosflight memory file %s/mem.bin",
                  directory.c_str());
@@ -690,24 +755,49 @@ bool SILBoard::gnss_present() { return true; }
 bool SILBoard::gnss_read(rosflight_firmware::GNSSData * gnss,
                          rosflight_firmware::GNSSFull * gnss_full)
 {
+  SILProfiler::Scope scope(profiler_, SILProfiler::SENSORS);
+
   using Vec3 = ignition::math::Vector3d;
   using Coord = gazebo::common::SphericalCoordinates::CoordinateType;
 
-  GazeboPose local_pose = GZ_COMPAT_GET_WORLD_POSE(link_);
+  GazeboPose local_pose = state_.world_pose;
   Vec3 pos_noise(horizontal_gps_stdev_ * normal_distribution_(noise_generator_),
                  horizontal_gps_stdev_ * normal_distribution_(noise_generator_),
                  vertical_gps_stdev_ * normal_distribution_(noise_generator_));
-  Vec3 local_pos = GZ_COMPAT_GET_POS(local_pose) + pos_noise;
 
-  Vec3 local_vel = GZ_COMPAT_GET_WORLD_LINEAR_VEL(link_);
+  // Random walk of the position error (multipath, atmospheric delay), scaled so that the walk
+  // stdev params are independent of the update rate
+  double walk_scale = std::sqrt(1.0 / gnss_update_rate_);
+  double horizontal_walk = horizontal_gps_walk_stdev_ * walk_scale;
+  double vertical_walk = vertical_gps_walk_stdev_ * walk_scale;
+  gnss_walk_.x() += horizontal_walk * normal_distribution_(noise_generator_);
+  gnss_walk_.y() += horizontal_walk * normal_distribution_(noise_generator_);
+  gnss_walk_.z() += vertical_walk * normal_distribution_(noise_generator_);
+
+  Vec3 local_pos = GZ_COMPAT_GET_POS(local_pose) + pos_noise
+    + Vec3(gnss_walk_.x(), gnss_walk_.y(), gnss_walk_.z());
+
+  Vec3 local_vel = state_.world_linear_vel;
   Vec3 vel_noise(gps_velocity_stdev_ * normal_distribution_(noise_generator_),
                  gps_velocity_stdev_ * normal_distribution_(noise_generator_),
                  gps_velocity_stdev_ * normal_distribution_(noise_generator_));
   local_vel += vel_noise;
 
-  Vec3 ecef_pos = sph_coord_.PositionTransform(local_pos, Coord::LOCAL, Coord::ECEF);
-  Vec3 ecef_vel = sph_coord_.VelocityTransform(local_vel, Coord::LOCAL, Coord::ECEF);
-  Vec3 lla = sph_coord_.PositionTransform(local_pos, Coord::LOCAL, Coord::SPHERICAL);
+  Vec3 ecef_pos;
+  Vec3 ecef_vel;
+  Vec3 lla;
+  if (gnss_exact_) {
+    ecef_pos = sph_coord_.PositionTransform(local_pos, Coord::LOCAL, Coord::ECEF);
+    ecef_vel = sph_coord_.VelocityTransform(local_vel, Coord::LOCAL, Coord::ECEF);
+    lla = sph_coord_.PositionTransform(local_pos, Coord::LOCAL, Coord::SPHERICAL);
+  } else {
+    GNSSModel::Fix fix =
+      gnss_model_.compute_fix(Eigen::Vector3d(local_pos.X(), local_pos.Y(), local_pos.Z()),
+                              Eigen::Vector3d(local_vel.X(), local_vel.Y(), local_vel.Z()));
+    ecef_pos.Set(fix.ecef_pos.x(), fix.ecef_pos.y(), fix.ecef_pos.z());
+    ecef_vel.Set(fix.ecef_vel.x(), fix.ecef_vel.y(), fix.ecef_vel.z());
+    lla.Set(fix.lla.x(), fix.lla.y(), fix.lla.z());
+  }
 
   gnss->lat = (int) std::round(rad2Deg(lla.X()) * 1e7);
   gnss->lon = (int) std::round(rad2Deg(lla.Y()) * 1e7);
@@ -720,10 +810,10 @@ bool SILBoard::gnss_read(rosflight_firmware::GNSSData * gnss,
   gnss->vel_d = (int) std::round(-local_vel.Z() * 1e3);
 
   gnss->fix_type = rosflight_firmware::GNSSFixType::GNSS_FIX_TYPE_3D_FIX;
-  gnss->time_of_week = GZ_COMPAT_GET_SIM_TIME(world_).Double() * 1000;
-  gnss->time = GZ_COMPAT_GET_SIM_TIME(world_).Double();
+  gnss->time_of_week = state_.sim_time.Double() * 1000;
+  gnss->time = state_.sim_time.Double();
   gnss->nanos =
-    (uint64_t) std::round((GZ_COMPAT_GET_SIM_TIME(world_).Double() - (double) gnss->time) * 1e9);
+    (uint64_t) std::round((state_.sim_time.Double() - (double) gnss->time) * 1e9);
 
   gnss->h_acc = (int) std::round(horizontal_gps_stdev_ * 1000.0);
   gnss->v_acc = (int) std::round(vertical_gps_stdev_ * 1000.0);
@@ -739,15 +829,9 @@ bool SILBoard::gnss_read(rosflight_firmware::GNSSData * gnss,
 
   gnss->rosflight_timestamp = clock_micros();
 
-  using Vec3 = ignition::math::Vector3d;
-  using Vec3 = ignition::math::Vector3d;
-  using Coord = gazebo::common::SphericalCoordinates::CoordinateType;
-
-  // TODO: Do a better job of simulating the wander of GPS
-
   gnss_full->lat = (int) std::round(rad2Deg(lla.X()) * 1e7);
   gnss_full->lon = (int) std::round(rad2Deg(lla.Y()) * 1e7);
-  gnss_full->height = (int) std::round(rad2Deg(lla.Z()) * 1e3);
+  gnss_full->height = (int) std::round(lla.Z() * 1e3);
   gnss_full->height_msl = gnss_full->height; // TODO
 
   // For now, we have defined the Gazebo Local Frame as NWU.  This should be
@@ -757,7 +841,7 @@ bool SILBoard::gnss_read(rosflight_firmware::GNSSData * gnss,
   gnss_full->vel_d = (int) std::round(-local_vel.Z() * 1e3);
 
   gnss_full->fix_type = rosflight_firmware::GNSSFixType::GNSS_FIX_TYPE_3D_FIX;
-  gnss_full->time_of_week = GZ_COMPAT_GET_SIM_TIME(world_).Double() * 1000;
+  gnss_full->time_of_week = state_.sim_time.Double() * 1000;
   gnss_full->num_sat = 15;
   // TODO
   gnss_full->year = 0;
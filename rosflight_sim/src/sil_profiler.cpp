@@ -0,0 +1,311 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <unistd.h>
+
+#include <rosflight_io/loop_time_diagnostics.hpp>
+#include <rosflight_sim/sil_profiler.hpp>
+
+namespace rosflight_sim
+{
+namespace
+{
+constexpr size_t TRACE_BUFFER_SIZE = 4096;
+
+static_assert(SILProfiler::NUM_STAGES + 1 == mavrosflight::LIVE_STATS_SIL_STAGES,
+              "live stats SIL stages must match the profiler stages");
+
+int64_t to_ns(SILProfiler::Clock::duration d)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+}
+
+std::mutex trace_writers_mutex;
+std::map<std::string, std::weak_ptr<TraceWriter>> trace_writers; //!< by path
+
+using rosflight_io::key_value;
+} // namespace
+
+/**
+ * @brief A trace file shared by every profiler in the process that writes to the same path, so
+ * that each vehicle doesn't truncate and overwrite the others' events
+ */
+class TraceWriter
+{
+public:
+  /**
+   * @brief The writer for a path, opened and truncated by the first profiler to ask for it
+   * @return nullptr if the file could not be opened
+   */
+  static std::shared_ptr<TraceWriter> open(const std::string & path)
+  {
+    std::lock_guard<std::mutex> lock(trace_writers_mutex);
+    std::shared_ptr<TraceWriter> writer = trace_writers[path].lock();
+    if (writer == nullptr) {
+      writer = std::make_shared<TraceWriter>(path);
+      if (!writer->file_.is_open()) {
+        return nullptr;
+      }
+      trace_writers[path] = writer;
+    }
+    return writer;
+  }
+
+  explicit TraceWriter(const std::string & path)
+      : file_(path, std::ios::out | std::ios::trunc)
+  {
+    // The closing bracket is optional in the JSON array format, so the file is valid even if
+    // Gazebo is killed
+    file_ << "[\n";
+  }
+
+  /**
+   * @brief Appends whole lines of events, so lines from different vehicles don't interleave
+   */
+  void write(const std::string & lines)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_ << lines;
+    file_.flush();
+  }
+
+private:
+  std::mutex mutex_;
+  std::ofstream file_;
+};
+
+SILProfiler::SILProfiler(rclcpp::Node::SharedPtr node)
+    : node_(std::move(node))
+{
+  int window = node_->get_parameter_or<int>("sil_profile_window", 1000);
+  window_size_ = (size_t) std::max(window, 1);
+  for (auto & samples : samples_) {
+    samples.assign(window_size_, 0);
+  }
+  scratch_.resize(window_size_);
+
+  double period = node_->get_parameter_or<double>("sil_profile_period", 1.0);
+  report_period_ =
+    std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(period));
+
+  profile_pub_ = node_->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("sil_profile", 1);
+
+  auto trace_path = node_->get_parameter_or<std::string>("sil_profile_trace_file", "");
+  if (!trace_path.empty()) {
+    trace_ = TraceWriter::open(trace_path);
+    if (trace_ == nullptr) {
+      RCLCPP_ERROR(node_->get_logger(), "Unable to open SIL profile trace file %s",
+                   trace_path.c_str());
+    } else {
+      // Each vehicle gets its own track in the trace viewer
+      static std::atomic<int> next_tid{1};
+      trace_tid_ = next_tid++;
+      trace_events_.reserve(TRACE_BUFFER_SIZE);
+
+      trace_->write(R"({"name":"thread_name","ph":"M","pid":)" + std::to_string(getpid())
+                    + R"(,"tid":)" + std::to_string(trace_tid_) + R"(,"args":{"name":")"
+                    + node_->get_fully_qualified_name() + "\"}},\n");
+    }
+  }
+
+  if (!live_stats_.open(node_->get_fully_qualified_name(), mavrosflight::LIVE_STATS_KIND_SIL)) {
+    RCLCPP_WARN(node_->get_logger(), "Unable to create SIL live statistics segment");
+  }
+
+  last_report_time_ = Clock::now();
+}
+
+SILProfiler::~SILProfiler()
+{
+  if (trace_ != nullptr) {
+    flush_trace();
+  }
+}
+
+const char * SILProfiler::stage_name(Stage stage)
+{
+  switch (stage) {
+    case FIRMWARE:
+      return "firmware";
+    case SENSORS:
+      return "sensors";
+    case COMM:
+      return "comm";
+    case DYNAMICS:
+      return "dynamics";
+    case TRUTH:
+      return "truth";
+    default:
+      return "step";
+  }
+}
+
+void SILProfiler::begin_step()
+{
+  step_ns_.fill(0);
+  step_start_ = Clock::now();
+}
+
+void SILProfiler::add_section(Stage stage, Clock::time_point start, Clock::time_point end)
+{
+  int64_t duration_ns = to_ns(end - start);
+  step_ns_[stage] += duration_ns;
+
+  if (trace_ != nullptr) {
+    trace_events_.push_back({stage, to_ns(start.time_since_epoch()), duration_ns});
+    if (trace_events_.size() >= TRACE_BUFFER_SIZE) {
+      flush_trace();
+    }
+  }
+}
+
+void SILProfiler::end_step(double sim_time)
+{
+  Clock::time_point now = Clock::now();
+  step_ns_[NUM_STAGES] = to_ns(now - step_start_);
+  busy_ns_ += step_ns_[NUM_STAGES];
+
+  for (size_t i = 0; i <= NUM_STAGES; i++) {
+    samples_[i][next_sample_] = step_ns_[i];
+  }
+  next_sample_ = (next_sample_ + 1) % window_size_;
+  num_samples_ = std::min(num_samples_ + 1, window_size_);
+  steps_since_report_++;
+
+  if (mavrosflight::LiveStatsSegment * stats = live_stats_.segment()) {
+    stats->sil_steps.fetch_add(1, std::memory_order_relaxed);
+    stats->sil_step_time.record(step_ns_[NUM_STAGES]);
+    stats->last_update_ns.store(mavrosflight::LiveStats::now_ns(), std::memory_order_relaxed);
+  }
+
+  if (last_report_sim_time_ < 0.0) {
+    last_report_sim_time_ = sim_time;
+    last_report_time_ = now;
+    steps_since_report_ = 0;
+    busy_ns_ = 0;
+  } else if (now - last_report_time_ >= report_period_) {
+    publish_report(now, sim_time);
+  }
+}
+
+void SILProfiler::publish_report(Clock::time_point now, double sim_time)
+{
+  double wall_elapsed = std::chrono::duration<double>(now - last_report_time_).count();
+  double sim_elapsed = sim_time - last_report_sim_time_;
+
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  status.name = std::string(node_->get_fully_qualified_name()) + ": SIL step profile";
+  status.hardware_id = node_->get_namespace();
+
+  // Real-time factor as seen by this vehicle, including time spent in physics and other plugins.
+  // Load is the fraction of wall time spent in this plugin's update.
+  double real_time_factor = sim_elapsed / wall_elapsed;
+  mavrosflight::LiveStatsSegment * stats = live_stats_.segment();
+  if (stats != nullptr) {
+    stats->sil_real_time_factor_ppm.store((int64_t) (real_time_factor * 1e6),
+                                          std::memory_order_relaxed);
+  }
+  status.message = "RTF " + std::to_string(real_time_factor);
+  status.values.push_back(key_value("real_time_factor", real_time_factor));
+  status.values.push_back(key_value("step_rate", (double) steps_since_report_ / wall_elapsed));
+  status.values.push_back(key_value("plugin_load", (double) busy_ns_ * 1e-9 / wall_elapsed));
+
+  for (size_t i = 0; i <= NUM_STAGES; i++) {
+    std::copy(samples_[i].begin(), samples_[i].begin() + (long) num_samples_, scratch_.begin());
+    auto begin = scratch_.begin();
+    auto end = scratch_.begin() + (long) num_samples_;
+
+    // Successive partitions only need to search the part above the previous percentile
+    auto p50 = begin + (long) (0.50 * (double) (num_samples_ - 1));
+    auto p90 = begin + (long) (0.90 * (double) (num_samples_ - 1));
+    auto p99 = begin + (long) (0.99 * (double) (num_samples_ - 1));
+    std::nth_element(begin, p50, end);
+    std::nth_element(p50, p90, end);
+    std::nth_element(p90, p99, end);
+    int64_t max = *std::max_element(p99, end);
+
+    std::string name = stage_name((Stage) i);
+    status.values.push_back(key_value(name + "_p50_us", (double) *p50 * 1e-3));
+    status.values.push_back(key_value(name + "_p90_us", (double) *p90 * 1e-3));
+    status.values.push_back(key_value(name + "_p99_us", (double) *p99 * 1e-3));
+    status.values.push_back(key_value(name + "_max_us", (double) max * 1e-3));
+
+    if (stats != nullptr) {
+      stats->sil_stage_p50_ns[i].store(*p50, std::memory_order_relaxed);
+      stats->sil_stage_p99_ns[i].store(*p99, std::memory_order_relaxed);
+      stats->sil_stage_max_ns[i].store(max, std::memory_order_relaxed);
+    }
+  }
+
+  diagnostic_msgs::msg::DiagnosticArray msg;
+  msg.header.stamp = node_->get_clock()->now();
+  msg.status.push_back(status);
+  profile_pub_->publish(msg);
+
+  if (trace_ != nullptr) {
+    flush_trace();
+  }
+
+  last_report_time_ = now;
+  last_report_sim_time_ = sim_time;
+  steps_since_report_ = 0;
+  busy_ns_ = 0;
+}
+
+void SILProfiler::flush_trace()
+{
+  char line[160];
+  int pid = getpid();
+  std::string lines;
+  lines.reserve(trace_events_.size() * 100);
+  for (const TraceEvent & event : trace_events_) {
+    // Trace event timestamps are in microseconds
+    snprintf(line, sizeof(line),
+             R"({"name":"%s","cat":"sil","ph":"X","ts":%.3f,"dur":%.3f,"pid":%d,"tid":%d},)"
+             "\n",
+             stage_name(event.stage), (double) event.start_ns * 1e-3,
+             (double) event.duration_ns * 1e-3, pid, trace_tid_);
+    lines += line;
+  }
+  trace_->write(lines);
+  trace_events_.clear();
+}
+
+} // namespace rosflight_sim
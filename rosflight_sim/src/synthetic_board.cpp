@@ -0,0 +1,192 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include <rosflight_sim/synthetic_board.hpp>
+
+namespace rosflight_sim
+{
+SyntheticBoard::SyntheticBoard(mavrosflight::LoopbackPipe & pipe, double imu_rate_hz)
+    : pipe_(pipe)
+    , boot_time_(Clock::now())
+    , imu_update_period_us_(imu_rate_hz > 0 ? (uint64_t) (1e6 / imu_rate_hz) : 1000)
+{
+  // Sticks centered, throttle and switches low
+  for (auto & value : rc_values_) { value = 0.5f; }
+  rc_values_[2] = 0.0f;
+  for (size_t i = 4; i < NUM_RC_CHANNELS; i++) { rc_values_[i] = 0.0f; }
+
+  for (auto & value : pwm_outputs_) { value = 0.0f; }
+}
+
+void SyntheticBoard::set_rc(uint8_t channel, float value)
+{
+  if (channel < NUM_RC_CHANNELS) {
+    rc_values_[channel].store(value, std::memory_order_relaxed);
+  }
+}
+
+float SyntheticBoard::output(uint8_t channel) const
+{
+  if (channel >= NUM_PWM_CHANNELS) {
+    return 0.0f;
+  }
+  return pwm_outputs_[channel].load(std::memory_order_relaxed);
+}
+
+SyntheticBoard::Clock::time_point SyntheticBoard::last_output_change() const
+{
+  return Clock::time_point(Clock::duration(last_output_change_.load(std::memory_order_acquire)));
+}
+
+void SyntheticBoard::init_board() { boot_time_ = Clock::now(); }
+
+uint32_t SyntheticBoard::clock_millis() { return (uint32_t) (clock_micros() / 1000); }
+
+uint64_t SyntheticBoard::clock_micros()
+{
+  auto elapsed = Clock::now() - boot_time_;
+  return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+void SyntheticBoard::clock_delay(uint32_t milliseconds)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+}
+
+void SyntheticBoard::serial_write(const uint8_t * src, size_t len, uint8_t qos)
+{
+  pipe_.fcu_write(src, len);
+}
+
+uint16_t SyntheticBoard::serial_bytes_available()
+{
+  return (uint16_t) std::min<size_t>(pipe_.fcu_bytes_available(), UINT16_MAX);
+}
+
+uint8_t SyntheticBoard::serial_read()
+{
+  uint8_t byte = 0;
+  pipe_.fcu_read(&byte, 1);
+  return byte;
+}
+
+bool SyntheticBoard::imu_has_new_data()
+{
+  uint64_t now_us = clock_micros();
+  if (now_us >= next_imu_update_time_us_) {
+    next_imu_update_time_us_ = now_us + imu_update_period_us_;
+    return true;
+  } else {
+    return false;
+  }
+}
+
+bool SyntheticBoard::imu_read(float accel[3], float * temperature, float gyro[3],
+                              uint64_t * time_us)
+{
+  // Level and at rest, so the accelerometer only measures the reaction to gravity (NED)
+  accel[0] = 0.0f;
+  accel[1] = 0.0f;
+  accel[2] = -9.80665f;
+  gyro[0] = 0.0f;
+  gyro[1] = 0.0f;
+  gyro[2] = 0.0f;
+  *temperature = 25.0f;
+  *time_us = clock_micros();
+
+  imu_samples_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void SyntheticBoard::pwm_init(uint32_t refresh_rate, uint16_t idle_pwm)
+{
+  for (auto & value : pwm_outputs_) { value.store(0.0f, std::memory_order_relaxed); }
+}
+
+void SyntheticBoard::pwm_write(uint8_t channel, float value)
+{
+  if (channel >= NUM_PWM_CHANNELS) {
+    return;
+  }
+
+  float previous = pwm_outputs_[channel].exchange(value, std::memory_order_relaxed);
+  if (previous != value) {
+    last_output_change_.store(Clock::now().time_since_epoch().count(), std::memory_order_release);
+  }
+}
+
+void SyntheticBoard::pwm_disable()
+{
+  for (uint8_t i = 0; i < NUM_PWM_CHANNELS; i++) { pwm_write(i, 0.0f); }
+}
+
+float SyntheticBoard::rc_read(uint8_t chan)
+{
+  if (chan >= NUM_RC_CHANNELS) {
+    return 0.0f;
+  }
+  return rc_values_[chan].load(std::memory_order_relaxed);
+}
+
+bool SyntheticBoard::rc_has_new_data()
+{
+  uint64_t now_us = clock_micros();
+  if (now_us >= next_rc_update_time_us_) {
+    next_rc_update_time_us_ = now_us + RC_UPDATE_PERIOD_US;
+    return true;
+  } else {
+    return false;
+  }
+}
+
+bool SyntheticBoard::memory_read(void * dest, size_t len)
+{
+  if (memory_.size() < len) {
+    return false;
+  }
+  memcpy(dest, memory_.data(), len);
+  return true;
+}
+
+bool SyntheticBoard::memory_write(const void * src, size_t len)
+{
+  const auto * bytes = static_cast<const uint8_t *>(src);
+  memory_.assign(bytes, bytes + len);
+  return true;
+}
+
+} // namespace rosflight_sim
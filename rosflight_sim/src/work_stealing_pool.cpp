@@ -0,0 +1,121 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include <rosflight_sim/work_stealing_pool.hpp>
+
+namespace rosflight_sim
+{
+WorkStealingPool::WorkStealingPool(size_t num_threads)
+    : num_queues_(num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency()))
+    , queues_(new Queue[num_queues_])
+{
+  for (size_t i = 1; i < num_queues_; i++) {
+    threads_.emplace_back(&WorkStealingPool::worker, this, i);
+  }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for (std::thread & thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkStealingPool::run(size_t count, const std::function<void(size_t)> & task)
+{
+  // Hand out contiguous ranges, spreading the remainder over the first queues
+  size_t begin = 0;
+  for (size_t i = 0; i < num_queues_; i++) {
+    size_t size = count / num_queues_ + (i < count % num_queues_ ? 1 : 0);
+    queues_[i].end = begin + size;
+    queues_[i].next.store(begin, std::memory_order_relaxed);
+    begin += size;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    busy_workers_ = threads_.size();
+    batch_++;
+  }
+  start_cv_.notify_all();
+
+  drain(0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this] { return busy_workers_ == 0; });
+  task_ = nullptr;
+}
+
+void WorkStealingPool::worker(size_t index)
+{
+  uint64_t batch = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_cv_.wait(lock, [this, batch] { return stop_ || batch_ != batch; });
+      if (stop_) {
+        return;
+      }
+      batch = batch_;
+    }
+
+    drain(index);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--busy_workers_ == 0) {
+      done_cv_.notify_one();
+    }
+  }
+}
+
+void WorkStealingPool::drain(size_t index)
+{
+  // Own queue first, then the others in turn
+  for (size_t i = 0; i < num_queues_; i++) {
+    Queue & queue = queues_[(index + i) % num_queues_];
+    size_t task;
+    while ((task = queue.next.fetch_add(1, std::memory_order_relaxed)) < queue.end) {
+      (*task_)(task);
+    }
+  }
+}
+
+} // namespace rosflight_sim
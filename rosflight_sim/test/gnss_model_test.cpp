@@ -0,0 +1,223 @@
+/*
+ * Software License Agreement (BSD-3 License)
+ *
+ * Copyright (c) 2024 BYU MAGICC Lab.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file gnss_model_test.cpp
+ *
+ * Checks the documented accuracy of GNSSModel. The ECEF positions are compared with reference
+ * points whose ECEF coordinates follow directly from the WGS84 axes. For LLA, points around origins
+ * at several latitudes and altitudes are converted to ECEF with an independent exact transform,
+ * then back to geodetic with an iterative ECEF-to-geodetic solution, and compared with the fix
+ * computed by the model. The LLA error must stay a small fraction of the simulated GNSS noise.
+ */
+
+#include <rosflight_sim/gnss_model.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include <eigen3/Eigen/Dense>
+
+namespace
+{
+constexpr double WGS84_A = 6378137.0;
+constexpr double WGS84_F = 1.0 / 298.257223563;
+constexpr double WGS84_E2 = WGS84_F * (2.0 - WGS84_F);
+constexpr double WGS84_B = 6356752.314245; // semi-minor axis, as published
+
+// Defaults of horizontal_gps_stdev and vertical_gps_stdev, see params/params.md
+constexpr double HORIZONTAL_GPS_STDEV = 1.0;
+constexpr double VERTICAL_GPS_STDEV = 3.0;
+
+double deg2rad(double deg) { return deg * M_PI / 180.0; }
+
+double transverse_radius(double latitude)
+{
+  double s_lat = std::sin(latitude);
+  return WGS84_A / std::sqrt(1.0 - WGS84_E2 * s_lat * s_lat);
+}
+
+double meridian_radius(double latitude)
+{
+  double s_lat = std::sin(latitude);
+  double w2 = 1.0 - WGS84_E2 * s_lat * s_lat;
+  return WGS84_A * (1.0 - WGS84_E2) / (w2 * std::sqrt(w2));
+}
+
+// Exact conversion of a local NWU offset to ECEF, through the ENU tangent plane of the origin
+Eigen::Vector3d nwu_to_ecef(const Eigen::Vector3d & origin_lla, const Eigen::Vector3d & pos_NWU)
+{
+  double s_lat = std::sin(origin_lla.x());
+  double c_lat = std::cos(origin_lla.x());
+  double s_lon = std::sin(origin_lla.y());
+  double c_lon = std::cos(origin_lla.y());
+  double e = -pos_NWU.y();
+  double n = pos_NWU.x();
+  double u = pos_NWU.z();
+
+  double N = transverse_radius(origin_lla.x());
+  double r = (N + origin_lla.z()) * c_lat;
+  Eigen::Vector3d origin(r * c_lon, r * s_lon, (N * (1.0 - WGS84_E2) + origin_lla.z()) * s_lat);
+
+  return origin
+    + Eigen::Vector3d(-s_lon * e - s_lat * c_lon * n + c_lat * c_lon * u,
+                      c_lon * e - s_lat * s_lon * n + c_lat * s_lon * u, c_lat * n + s_lat * u);
+}
+
+// Iterates the geodetic latitude to convergence, which is exact to well below a micrometer
+Eigen::Vector3d ecef_to_lla(const Eigen::Vector3d & ecef)
+{
+  double p = std::hypot(ecef.x(), ecef.y());
+  double latitude = std::atan2(ecef.z(), p * (1.0 - WGS84_E2));
+  double altitude = 0.0;
+  for (int i = 0; i < 10; i++) {
+    double N = transverse_radius(latitude);
+    altitude = p / std::cos(latitude) - N;
+    latitude = std::atan2(ecef.z(), p * (1.0 - WGS84_E2 * N / (N + altitude)));
+  }
+  return {latitude, std::atan2(ecef.y(), ecef.x()), altitude};
+}
+
+struct Error
+{
+  double horizontal = 0;
+  double vertical = 0;
+};
+
+// Largest error of the model over points up to radius from the origin, in meters
+Error max_error(double radius)
+{
+  Error max;
+  for (int origin_latitude = -70; origin_latitude <= 70; origin_latitude += 10) {
+    for (double origin_altitude : {0.0, 1500.0}) {
+      Eigen::Vector3d origin(deg2rad(origin_latitude), deg2rad(-111.6), origin_altitude);
+      rosflight_sim::GNSSModel model;
+      model.set_origin(origin.x(), origin.y(), origin.z());
+
+      for (int i = 0; i < 16; i++) {
+        for (double height : {-100.0, 0.0, 1000.0, 3000.0}) {
+          Eigen::Vector3d pos_NWU(radius * std::cos(i * M_PI / 8.0),
+                                  radius * std::sin(i * M_PI / 8.0), height);
+          Eigen::Vector3d ecef = nwu_to_ecef(origin, pos_NWU);
+          Eigen::Vector3d exact = ecef_to_lla(ecef);
+          rosflight_sim::GNSSModel::Fix fix = model.compute_fix(pos_NWU, Eigen::Vector3d::Zero());
+
+          double radius_N = transverse_radius(exact.x()) + exact.z();
+          double radius_M = meridian_radius(exact.x()) + exact.z();
+          double north = (fix.lla.x() - exact.x()) * radius_M;
+          double east = (fix.lla.y() - exact.y()) * radius_N * std::cos(exact.x());
+          max.horizontal = std::max(max.horizontal, std::hypot(north, east));
+          max.vertical = std::max(max.vertical, std::abs(fix.lla.z() - exact.z()));
+        }
+      }
+    }
+  }
+  return max;
+}
+
+// LLA error within radius of the origin, against a fraction of the GNSS noise
+bool check_lla(double radius, double noise_fraction)
+{
+  Error error = max_error(radius);
+  double horizontal_bound = noise_fraction * HORIZONTAL_GPS_STDEV;
+  double vertical_bound = noise_fraction * VERTICAL_GPS_STDEV;
+  bool pass = error.horizontal < horizontal_bound && error.vertical < vertical_bound;
+  printf("%s: %.0f km from the origin, horizontal %.2f cm (bound %.1f), vertical %.2f mm (bound "
+         "%.0f)\n",
+         pass ? "PASS" : "FAIL", radius * 1e-3, error.horizontal * 1e2, horizontal_bound * 1e2,
+         error.vertical * 1e3, vertical_bound * 1e3);
+  return pass;
+}
+
+struct EcefReference
+{
+  double latitude;  // deg
+  double longitude; // deg
+  double altitude;
+  Eigen::Vector3d pos_NWU;
+  Eigen::Vector3d ecef;
+};
+
+// ECEF position of the model, and of the exact transform used for the LLA checks, at points on the
+// WGS84 axes
+bool check_ecef()
+{
+  const double a = WGS84_A;
+  const double b = WGS84_B;
+  const double s = std::sqrt(0.5);
+  const EcefReference references[] = {
+    {0.0, 0.0, 0.0, {0.0, 0.0, 0.0}, {a, 0.0, 0.0}},
+    {0.0, 90.0, 0.0, {0.0, 0.0, 0.0}, {0.0, a, 0.0}},
+    {0.0, 180.0, 1500.0, {0.0, 0.0, 0.0}, {-(a + 1500.0), 0.0, 0.0}},
+    {0.0, 45.0, 0.0, {0.0, 0.0, 0.0}, {a * s, a * s, 0.0}},
+    {90.0, 0.0, 0.0, {0.0, 0.0, 0.0}, {0.0, 0.0, b}},
+    {-90.0, 0.0, 100.0, {0.0, 0.0, 0.0}, {0.0, 0.0, -(b + 100.0)}},
+    // Offsets along north, west and up from an origin on the equator
+    {0.0, 0.0, 0.0, {1000.0, 0.0, 0.0}, {a, 0.0, 1000.0}},
+    {0.0, 0.0, 0.0, {0.0, 1000.0, 0.0}, {a, -1000.0, 0.0}},
+    {0.0, 0.0, 0.0, {0.0, 0.0, 1000.0}, {a + 1000.0, 0.0, 0.0}},
+    {0.0, 90.0, 0.0, {500.0, -200.0, 30.0}, {-200.0, a + 30.0, 500.0}},
+    // North from the north pole points along -x at longitude 0
+    {90.0, 0.0, 0.0, {1000.0, 0.0, 0.0}, {-1000.0, 0.0, b}},
+  };
+
+  double max_model = 0;
+  double max_exact = 0;
+  for (const EcefReference & ref : references) {
+    Eigen::Vector3d origin(deg2rad(ref.latitude), deg2rad(ref.longitude), ref.altitude);
+    rosflight_sim::GNSSModel model;
+    model.set_origin(origin.x(), origin.y(), origin.z());
+    rosflight_sim::GNSSModel::Fix fix = model.compute_fix(ref.pos_NWU, Eigen::Vector3d::Zero());
+    max_model = std::max(max_model, (fix.ecef_pos - ref.ecef).norm());
+    max_exact = std::max(max_exact, (nwu_to_ecef(origin, ref.pos_NWU) - ref.ecef).norm());
+  }
+
+  // Rounding of coordinates around 6e6 m, and of the published semi-minor axis
+  const double bound = 1e-5;
+  bool pass = max_model < bound && max_exact < bound;
+  printf("%s: ECEF reference points, model %.1e m, exact transform %.1e m (bound %.0e)\n",
+         pass ? "PASS" : "FAIL", max_model, max_exact, bound);
+  return pass;
+}
+
+} // namespace
+
+int main()
+{
+  bool pass = check_ecef();
+  // Under 5% of the GNSS noise within 5 km, and under 10% within 10 km
+  pass = check_lla(5000.0, 0.05) && pass;
+  pass = check_lla(10000.0, 0.1) && pass;
+  return pass ? 0 : 1;
+}